@@ -77,13 +77,31 @@
         "cflags_cc!": [ "-fno-exceptions -std=c++11 -pthread" ],
         "sources": [
             "src/sword_backend/mutex.cpp",
+            "src/sword_backend/thread_pool.cpp",
             "src/sword_backend/file_system_helper.cpp",
             "src/sword_backend/module_helper.cpp",
             "src/sword_backend/dict_helper.cpp",
             "src/sword_backend/module_store.cpp",
+            "src/sword_backend/sword_mgr_pool.cpp",
+            "src/sword_backend/sword_file_lock.cpp",
+            "src/sword_backend/reloadable_sword_mgr.cpp",
+            "src/sword_backend/module_config_snapshot.cpp",
+            "src/sword_backend/local_module_catalog.cpp",
+            "src/sword_backend/module_descriptor.cpp",
+            "src/sword_backend/mapped_file.cpp",
+            "src/sword_backend/strongs_table.cpp",
+            "src/sword_backend/lemma_statistics.cpp",
+            "src/sword_backend/dict_key_index.cpp",
+            "src/sword_backend/versification_mapping.cpp",
             "src/sword_backend/string_helper.cpp",
             "src/sword_backend/strongs_entry.cpp",
             "src/sword_backend/repository_interface.cpp",
+            "src/sword_backend/repository_catalog.cpp",
+            "src/sword_backend/repository_refresh_scheduler.cpp",
+            "src/sword_backend/remote_index_validator.cpp",
+            "src/sword_backend/mods_archive_reader.cpp",
+            "src/sword_backend/archive_stream_extractor.cpp",
+            "src/sword_backend/streaming_module_installer.cpp",
             "src/sword_backend/module_search.cpp",
             "src/sword_backend/module_installer.cpp",
             "src/sword_backend/sword_status_reporter.cpp",
@@ -93,8 +111,9 @@
             "src/napi_module/install_module_worker.cpp",
             "src/napi_module/module_search_worker.cpp",
             "src/napi_module/napi_sword_helper.cpp",
+            "src/napi_module/batch_request_processor.cpp",
             "src/napi_module/node_sword_interface.cpp",
-            "src/napi_module/api_lock.cpp",
+            "src/napi_module/shared_backend.cpp",
             "src/napi_module/binding.cpp"
         ],
         "conditions":[
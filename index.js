@@ -36,9 +36,6 @@ if (process.platform === 'ios') {
 
 const { Mutex } = require('async-mutex');
 
-// Create a mutex instance
-const searchMutex = new Mutex();
-
 /**
 * An object representation of a Bible verse.
 * @typedef VerseObject
@@ -103,10 +100,66 @@ const searchMutex = new Mutex();
 * @property {StrongsReference[]} references - The "see also" references of the Strong's entry
 */
 
+/**
+* The occurrences of a Strong's number in a module.
+* @typedef LemmaStatistics
+* @type {Object}
+* @property {String} strongsKey - The Strong's key without leading zeros (like G2316)
+* @property {Number} occurrences - The total number of occurrences in the module
+* @property {Object} bookOccurrences - An object that maps the OSIS book names to the number of occurrences in the book
+* @property {Object[]} surfaceForms - The words tagged with the Strong's number as objects with text and occurrences, most frequent first
+*/
+
+/**
+* A page of dictionary keys.
+* @typedef DictKeyPage
+* @type {Object}
+* @property {Number} totalCount - The total number of keys matching the query
+* @property {String[]} keys - The keys of the requested page in case-insensitive sort order
+*/
+
+/**
+* A search hit in a dictionary or commentary module.
+* @typedef EntrySearchResult
+* @type {Object}
+* @property {String} key - The dictionary key or the first verse of the commentary entry
+* @property {String} endKey - The last verse of a commentary entry that covers several verses (otherwise the same as key)
+* @property {String} content - The entry text, filtered like the verse texts of a module search
+*/
+
+/**
+* A page of the results of a dictionary or commentary search.
+* @typedef EntrySearchPage
+* @type {Object}
+* @property {Number} totalCount - The total number of results of the search
+* @property {EntrySearchResult[]} results - The results of the requested page
+*/
+
+/**
+* A single operation of a batch request.
+* @typedef BatchOperation
+* @type {Object}
+* @property {String} operation - The name of the operation. Supported operations: getLocalModule, getReferenceText, getChapterText,
+*                                getBookText, getVersesFromReferences, getReferencesFromReferenceRange, getBookList, getBookChapterCount,
+*                                getChapterVerseCount, getBookIntroduction, moduleHasBook, getRawModuleEntry, getStrongsEntry, mapVerseReference
+* @property {Array} args - The arguments of the operation. These are the same as for the respective function of NodeSwordInterface,
+*                          except for mapVerseReference, which expects (sourceModuleCode, sourceOsisRef, targetModuleCode, allowRange).
+*/
+
+/**
+* The result of a single batch operation.
+* @typedef BatchResult
+* @type {Object}
+* @property {*} result - The result of the operation (only set if the operation was successful)
+* @property {String} error - The error message (only set if the operation failed)
+*/
+
 /** This is the main class of node-sword-interface and it provides a set of static functions that wrap SWORD library functionality. */
 class NodeSwordInterface {
   /**
    * Creates an instance of NodeSwordInterface.
+   * All instances that use the same SWORD home directory share one native backend (module store, repository configuration),
+   * also across worker_threads. The timeoutMillis value of the first instance created for a home directory applies.
    * @param {String} customHomeDir - Optional custom home directory for SWORD data.
    * @param {String} localesBasePath - Optional base path for locales (default: __dirname).
    * @param {Number} timeoutMillis - Optional timeout in milliseconds for repository operations (default: 20000).
@@ -114,6 +167,9 @@ class NodeSwordInterface {
   constructor(customHomeDir=undefined, localesBasePath=__dirname, timeoutMillis=20000) {
     const localesDir = path.join(localesBasePath, './locales.d');
     this.nativeInterface = new nodeSwordInterfaceModule.NodeSwordInterface(customHomeDir, localesDir, timeoutMillis);
+
+    // Each instance serializes its own searches, instances may search in parallel
+    this.searchMutex = new Mutex();
   }
 
   /**
@@ -136,6 +192,10 @@ class NodeSwordInterface {
    * This function works asynchronously and returns a Promise object. The Promise delivers a detailed status object which contains one
    * entry for each of the repositories of the master repo list as well as one result entry.
    *
+   * The repositories are refreshed in parallel (see setRepositoryRefreshOptions). A progress event is sent as soon as a repository
+   * is finished. The message of the progress event contains the name of that repository.
+   * Repositories whose module index has not changed since the last update are not downloaded again.
+   *
    * @param {Function} progressCB - Optional callback function that is called on progress events.
    * @return {Promise}
    */
@@ -153,6 +213,7 @@ class NodeSwordInterface {
 
   /**
    * Refreshes the repository configuration for a single repository.
+   * Failed refreshes are retried like in updateRepositoryConfig (see setRepositoryRefreshOptions).
    *
    * @param {String} repoName - The name of the repository to refresh.
    * @return {Promise} - Resolves with a boolean indicating whether the update was successful.
@@ -215,6 +276,8 @@ class NodeSwordInterface {
 
   /**
    * Returns all updated modules from all repositories or one specific repository.
+   * The result is cached until the repositories are refreshed or modules are installed or uninstalled,
+   * so this function can be called frequently (e.g. on every startup).
    *  
    * @param {String} repositoryName - The name of the repository from which updates shall retrieved. Default: 'all'
    * @param {Boolean} includeBeta - Whether modules from the CrossWire Beta repository should also be included.
@@ -273,6 +336,12 @@ class NodeSwordInterface {
    * This operation may take some time depending on the available bandwidth and geographical
    * distance to the SWORD repository server.
    *
+   * If the repository publishes module packages (like the CrossWire repositories), the package is extracted
+   * while it is downloaded. Otherwise the module files are downloaded one by one.
+   *
+   * If a package download is cancelled or interrupted, the part that has already been downloaded is kept
+   * and the next installation of the same module continues the download where it stopped.
+   *
    * This function works asynchronously and returns a Promise object.
    * 
    * If the installation fails, the Promise will be rejected with the following status codes (based on SWORD):
@@ -301,7 +370,34 @@ class NodeSwordInterface {
   }
 
   /**
-   * Cancels an ongoing module installation.
+   * Installs several modules at once. Up to maxParallelInstalls modules are downloaded at the same time
+   * and the local module database is only reloaded once after all modules have been installed.
+   * The progress events report the overall progress based on the bytes of all modules.
+   *
+   * This function works asynchronously and returns a Promise object. The Promise delivers one result
+   * object per module ({ repositoryName, moduleCode, result }). The result is 0 if the module has been
+   * installed successfully, otherwise it contains the status code (see installModule).
+   *
+   * @param {Object[]} modules - The modules to install, given as objects with the properties repositoryName and moduleCode.
+   * @param {Function} progressCB - Callback function that is called on progress events.
+   * @param {Number} maxParallelInstalls - The maximum number of modules that are downloaded at the same time.
+   * @return {Promise}
+   */
+  async installModules(modules, progressCB=undefined, maxParallelInstalls=3) {
+    if (progressCB === undefined) {
+      progressCB = function(progress) {};
+    }
+
+    return new Promise((resolve, reject) => {
+      this.nativeInterface.installModules(modules, maxParallelInstalls, progressCB, function(results) {
+        resolve(results);
+      });
+    });
+  }
+
+  /**
+   * Cancels an ongoing module installation (including all installations of installModules).
+   * Package downloads that have already been started are resumed on the next installation of the module.
    */
   cancelInstallation() {
     return this.nativeInterface.cancelInstallation();
@@ -335,6 +431,17 @@ class NodeSwordInterface {
     this.nativeInterface.refreshLocalModules();
   }
 
+  /**
+   * Refreshes a single module of the local module database. If the module's .conf file exists in the user's SWORD
+   * directory, the module is (re)loaded from it, otherwise the module is removed from the local module database.
+   * This is much faster than refreshLocalModules, because the other modules are not reloaded.
+   *
+   * @param {String} moduleCode - The module code of the SWORD module.
+   */
+  refreshLocalModule(moduleCode) {
+    this.nativeInterface.refreshLocalModule(moduleCode);
+  }
+
   /**
    * Persistently saves the unlock key of the corresponding module in the module's .conf file
    * (in ~/.sword/mods.d/<modname>.conf)
@@ -369,6 +476,34 @@ class NodeSwordInterface {
     return this.nativeInterface.mapVerseReference(sourceOsisRef, sourceModuleName, targetModuleName, allowRange);
   }
 
+  /**
+   * Maps a list of verse references from one module's versification to another module's versification.
+   * The mapping table of the two versification systems is computed once and then used for all references.
+   *
+   * @param {String[]} sourceOsisRefs - The OSIS references in the source module's versification.
+   * @param {String} sourceModuleName - The module code of the source SWORD module.
+   * @param {String} targetModuleName - The module code of the target SWORD module.
+   * @param {Boolean} [allowRange=false] - If true, may return verse ranges. If false, returns only the first verse of a possible range.
+   * @return {String[]} The mapped OSIS references in the same order as the source references.
+   */
+  mapVerseReferences(sourceOsisRefs, sourceModuleName, targetModuleName, allowRange = false) {
+    return this.nativeInterface.mapVerseReferences(sourceOsisRefs, sourceModuleName, targetModuleName, allowRange);
+  }
+
+  /**
+   * Maps all verses of a chapter from one module's versification to another module's versification.
+   *
+   * @param {String} sourceModuleName - The module code of the source SWORD module.
+   * @param {String} targetModuleName - The module code of the target SWORD module.
+   * @param {String} bookCode - The OSIS book code of the chapter (e.g. "Ps").
+   * @param {Number} chapter - The chapter number in the source module's versification.
+   * @param {Boolean} [allowRange=false] - If true, may return verse ranges. If false, returns only the first verse of a possible range.
+   * @return {Object} An object that maps the OSIS references of the chapter's verses to the mapped OSIS references.
+   */
+  mapChapterVerseReferences(sourceModuleName, targetModuleName, bookCode, chapter, allowRange = false) {
+    return this.nativeInterface.mapChapterVerseReferences(sourceModuleName, targetModuleName, bookCode, chapter, allowRange);
+  }
+
   /**
    * Returns the description of a module.
    *
@@ -474,6 +609,18 @@ class NodeSwordInterface {
     return this.nativeInterface.getReferencesFromReferenceRange(referenceRange);
   }
 
+  /**
+   * Executes a list of read operations in one native call. All operations share the module lookups and the API lock,
+   * which avoids the overhead of many individual calls (e.g. when rendering a passage with its verse counts, book introduction
+   * and Strong's entries). An operation that fails does not affect the other operations of the batch.
+   *
+   * @param {BatchOperation[]} operations - The list of operations (like [{ operation: 'getChapterText', args: ['KJV', 'Gen', 1] }])
+   * @return {BatchResult[]} An array of results in the same order as the operations.
+   */
+  executeBatch(operations) {
+    return this.nativeInterface.executeBatch(operations);
+  }
+
   /**
    * Returns the list of books available in the given module. By default the book codes will be in OSIS format.
    * 
@@ -640,6 +787,45 @@ class NodeSwordInterface {
     return this.nativeInterface.getDictModuleKeys(moduleCode);
   }
 
+  /**
+   * Returns a page of the keys of a dictionary module that start with the given prefix (case-insensitive).
+   * The keys are looked up in a sorted key index, which is built with the first query for a module version.
+   *
+   * @param {String} moduleCode
+   * @param {String} prefix - An empty prefix matches all keys.
+   * @param {Number} startIndex - The index of the first key of the page within the matching keys (default: 0).
+   * @param {Number} maxCount - The maximum number of keys of the page (default: 0, which means all remaining keys).
+   * @return {DictKeyPage}
+   */
+  getDictModuleKeysWithPrefix(moduleCode, prefix, startIndex=0, maxCount=0) {
+    return this.nativeInterface.getDictModuleKeysWithPrefix(moduleCode, prefix, startIndex, maxCount);
+  }
+
+  /**
+   * Returns a page of the keys of a dictionary module between fromKey and toKey (both inclusive, case-insensitive).
+   *
+   * @param {String} moduleCode
+   * @param {String} fromKey - An empty key starts with the first key.
+   * @param {String} toKey - An empty key ends with the last key.
+   * @param {Number} startIndex - The index of the first key of the page within the matching keys (default: 0).
+   * @param {Number} maxCount - The maximum number of keys of the page (default: 0, which means all remaining keys).
+   * @return {DictKeyPage}
+   */
+  getDictModuleKeyRange(moduleCode, fromKey, toKey, startIndex=0, maxCount=0) {
+    return this.nativeInterface.getDictModuleKeyRange(moduleCode, fromKey, toKey, startIndex, maxCount);
+  }
+
+  /**
+   * Looks up a key of a dictionary module case-insensitively.
+   *
+   * @param {String} moduleCode
+   * @param {String} key
+   * @return {String} The key as it is stored in the module or undefined if the module has no such key.
+   */
+  findDictModuleKey(moduleCode, key) {
+    return this.nativeInterface.findDictModuleKey(moduleCode, key);
+  }
+
   /**
    * Returns the results of a module search.
    *
@@ -666,11 +852,11 @@ class NodeSwordInterface {
       progressCB = function(progress) {};
     }
 
-    if (searchMutex.isLocked()) {
+    if (this.searchMutex.isLocked()) {
       throw new Error("Module search in progress. Wait until it is finished.");
     }
 
-    const release = await searchMutex.acquire();
+    const release = await this.searchMutex.acquire();
 
     try {
       return new Promise((resolve, reject) => {
@@ -693,6 +879,58 @@ class NodeSwordInterface {
     }
   }
 
+  /**
+   * Returns a page of the results of a search in a dictionary (lexicon) or commentary module.
+   * The search uses the search index of the module if there is one. Only the entries of the requested page are read.
+   * A running search can be terminated with terminateModuleSearch.
+   *
+   * @param {String} moduleCode - The module code of the SWORD module.
+   * @param {String} searchTerm - The term to search for.
+   * @param {Function} progressCB - Optional callback function that is called on progress events.
+   * @param {String} searchType - Options: phrase, multiWord
+   * @param {Boolean} isCaseSensitive - Whether the search is case sensitive
+   * @param {Number} startIndex - The index of the first result of the page.
+   * @param {Number} maxCount - The maximum number of results of the page (0 means all remaining results).
+   * @return {Promise<EntrySearchPage>}
+   */
+  async getEntrySearchResults(moduleCode,
+                              searchTerm,
+                              progressCB = undefined,
+                              searchType = "phrase",
+                              isCaseSensitive = false,
+                              startIndex = 0,
+                              maxCount = 0) {
+
+    if (progressCB === undefined) {
+      progressCB = function(progress) {};
+    }
+
+    if (this.searchMutex.isLocked()) {
+      throw new Error("Module search in progress. Wait until it is finished.");
+    }
+
+    const release = await this.searchMutex.acquire();
+
+    try {
+      return new Promise((resolve, reject) => {
+        this.nativeInterface.getEntrySearchResults(moduleCode,
+                                                   searchTerm,
+                                                   searchType,
+                                                   isCaseSensitive,
+                                                   startIndex,
+                                                   maxCount,
+                                                   progressCB,
+                                                   function(searchPage) {
+          release();
+          resolve(searchPage);
+        });
+      });
+    } catch (error) {
+      release();
+      throw error;
+    }
+  }
+
   /**
    * Terminates the currently ongoing module search.
    */
@@ -732,6 +970,9 @@ class NodeSwordInterface {
   /**
    * Returns the Strong's entry for a given key.
    *
+   * The first call for a version of a Strong's module parses all its entries once and stores them in a table
+   * in the user's SWORD directory. Subsequent calls read the entries from that table.
+   *
    * @param {String} strongsKey - The Strong's key for the requested entry.
    * @return {StrongsEntry} A StrongsEntry object.
    */
@@ -739,6 +980,51 @@ class NodeSwordInterface {
     return this.nativeInterface.getStrongsEntry(strongsKey);
   }
 
+  /**
+   * Returns the Strong's entries for the given keys in one call. Duplicate and invalid keys are skipped.
+   *
+   * @param {String[]} strongsKeys - The Strong's keys of the requested entries.
+   * @return {Object} An object that maps the Strong's keys (without leading zeros, like G2316) to StrongsEntry objects.
+   */
+  getStrongsEntries(strongsKeys) {
+    return this.nativeInterface.getStrongsEntries(strongsKeys);
+  }
+
+  /**
+   * Returns the Strong's entries of all lemmas used in a chapter of the given module.
+   *
+   * @param {String} moduleCode - The module code of the SWORD module.
+   * @param {String} bookCode - The book code of the SWORD module.
+   * @param {Number} chapter - The chapter whose lemmas shall be resolved.
+   * @return {Object} An object that maps the Strong's keys (without leading zeros, like G2316) to StrongsEntry objects.
+   */
+  getChapterStrongsEntries(moduleCode, bookCode, chapter) {
+    return this.nativeInterface.getChapterStrongsEntries(moduleCode, bookCode, chapter);
+  }
+
+  /**
+   * Returns the occurrences of a Strong's number in a module with Strong's numbers, including the distribution
+   * over the books and the words it is translated with.
+   *
+   * The statistics of all Strong's numbers of a module are built with the first call for a module version,
+   * which reads the whole module once. They are stored in the user's SWORD directory, so subsequent calls return immediately.
+   *
+   * @param {String} moduleCode - The module code of the SWORD module.
+   * @param {String} strongsKey - The Strong's key (like G2316 or H0430).
+   * @return {Promise<LemmaStatistics>}
+   */
+  getLemmaStatistics(moduleCode, strongsKey) {
+    return new Promise((resolve, reject) => {
+      this.nativeInterface.getLemmaStatistics(moduleCode, strongsKey, function(lemmaStatistics) {
+        if (lemmaStatistics !== null) {
+          resolve(lemmaStatistics);
+        } else {
+          reject(new Error("Could not get the lemma statistics of " + moduleCode));
+        }
+      });
+    });
+  }
+
   /**
    * Returns an object representation of a locally installed SWORD module. If the requested `moduleCode` is not available
    * `undefined` will be returned.
@@ -812,6 +1098,54 @@ class NodeSwordInterface {
     return this.nativeInterface.unZip(filePath, destPath);
   }
 
+  /**
+   * Extracts a tar.gz file to a destination path without blocking the JavaScript thread.
+   * The archive is decompressed and extracted in a single pass while it is read.
+   *
+   * This function works asynchronously and returns a Promise object.
+   *
+   * @param {String} filePath - The path to the tar.gz file.
+   * @param {String} destPath - The destination path where the file should be extracted.
+   * @param {Function} progressCB - Callback function that is called on progress events.
+   * @return {Promise} Resolves with true if successful, false otherwise.
+   */
+  async unTarGZAsync(filePath, destPath, progressCB=undefined) {
+    if (progressCB === undefined) {
+      progressCB = function(progress) {};
+    }
+
+    return new Promise((resolve, reject) => {
+      this.nativeInterface.unTarGZAsync(filePath, destPath, progressCB, function(result) {
+        resolve(result);
+      });
+    });
+  }
+
+  /**
+   * Extracts a zip file to a destination path without blocking the JavaScript thread.
+   * The entries of the zip file are extracted by up to maxParallelEntries threads.
+   * The checksums of all entries are verified.
+   *
+   * This function works asynchronously and returns a Promise object.
+   *
+   * @param {String} filePath - The path to the zip file.
+   * @param {String} destPath - The destination path where the file should be extracted.
+   * @param {Function} progressCB - Callback function that is called on progress events.
+   * @param {Number} maxParallelEntries - The maximum number of entries that are extracted at the same time.
+   * @return {Promise} Resolves with true if successful, false otherwise.
+   */
+  async unZipAsync(filePath, destPath, progressCB=undefined, maxParallelEntries=4) {
+    if (progressCB === undefined) {
+      progressCB = function(progress) {};
+    }
+
+    return new Promise((resolve, reject) => {
+      this.nativeInterface.unZipAsync(filePath, destPath, maxParallelEntries, progressCB, function(result) {
+        resolve(result);
+      });
+    });
+  }
+
   /**
    * Returns the version of the SWORD library
    * @return {String} SWORD library version.
@@ -827,6 +1161,38 @@ class NodeSwordInterface {
   getSwordPath() {
     return this.nativeInterface.getSwordPath();
   }
+
+  /**
+   * Sets the number of native worker threads used for background operations (repository refresh, module installation, search, lemma statistics and archive extraction).
+   * The worker threads are shared by all instances of NodeSwordInterface. This function only has an effect if it is called
+   * before the first background operation has been started. By default, the number of CPU cores is used.
+   * @param {Number} workerCount - The number of worker threads (at least 1).
+   * @return {Boolean} True if the worker count has been applied, false if the worker threads are already running.
+   */
+  setWorkerThreadCount(workerCount) {
+    return this.nativeInterface.setWorkerThreadCount(workerCount);
+  }
+
+  /**
+   * Returns the number of native worker threads used for background operations.
+   * @return {Number} The number of worker threads.
+   */
+  getWorkerThreadCount() {
+    return this.nativeInterface.getWorkerThreadCount();
+  }
+
+  /**
+   * Configures how the repositories are refreshed by updateRepositoryConfig and updateSingleRepositoryConfig. Repositories that fail
+   * to refresh are retried with an exponential backoff until the retries or the deadline of the repository are used up.
+   * A transfer that is still running when the deadline is reached is aborted.
+   * @param {Number} maxConcurrency - The maximum number of repositories that are refreshed at the same time (default: 4).
+   * @param {Number} maxRetries - The number of retries after a failed refresh of a repository (default: 2).
+   * @param {Number} sourceDeadlineMillis - The time budget of a repository including all retries in milliseconds.
+   *                                        0 uses three times the network timeout (default: 0).
+   */
+  setRepositoryRefreshOptions(maxConcurrency, maxRetries, sourceDeadlineMillis=0) {
+    this.nativeInterface.setRepositoryRefreshOptions(maxConcurrency, maxRetries, sourceDeadlineMillis);
+  }
 }
 
 module.exports = NodeSwordInterface;
@@ -0,0 +1,331 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+#include "swmodule.h"
+
+#include "batch_request_processor.hpp"
+#include "napi_sword_helper.hpp"
+#include "module_store.hpp"
+#include "module_helper.hpp"
+#include "text_processor.hpp"
+#include "strongs_entry.hpp"
+
+using namespace std;
+using namespace sword;
+
+Napi::Array BatchRequestProcessor::executeBatch(const Napi::Env& env, Napi::Array operations)
+{
+    Napi::Array results = Napi::Array::New(env, operations.Length());
+
+    // Module pointers are only valid as long as the module store is not refreshed.
+    // The API lock is held for the whole batch, so they can be shared between the operations of one batch.
+    this->_moduleCache.clear();
+
+    for (unsigned int i = 0; i < operations.Length(); i++) {
+        Napi::Value currentOperation = operations[i];
+        results.Set(i, this->executeOperation(env, currentOperation));
+    }
+
+    this->_moduleCache.clear();
+    return results;
+}
+
+Napi::Object BatchRequestProcessor::executeOperation(const Napi::Env& env, Napi::Value operation)
+{
+    Napi::Object result = Napi::Object::New(env);
+    string errorMessage = "";
+
+    if (!operation.IsObject()) {
+        result["error"] = "Batch operation must be an object!";
+        return result;
+    }
+
+    Napi::Object operationObject = operation.As<Napi::Object>();
+    Napi::Value operationName = operationObject.Get("operation");
+    Napi::Value operationArgs = operationObject.Get("args");
+
+    if (!operationName.IsString()) {
+        result["error"] = "Batch operation without operation name!";
+        return result;
+    }
+
+    Napi::Array args = Napi::Array::New(env);
+    if (operationArgs.IsArray()) {
+        args = operationArgs.As<Napi::Array>();
+    } else if (!operationArgs.IsUndefined()) {
+        result["error"] = "The args of a batch operation must be an array!";
+        return result;
+    }
+
+    Napi::Value operationResult = this->executeModuleOperation(env, string(operationName.As<Napi::String>()), args, errorMessage);
+
+    if (errorMessage != "") {
+        result["error"] = errorMessage;
+    } else {
+        result["result"] = operationResult;
+    }
+
+    return result;
+}
+
+Napi::Value BatchRequestProcessor::executeModuleOperation(const Napi::Env& env,
+                                                          const string& operationName,
+                                                          Napi::Array& args,
+                                                          string& errorMessage)
+{
+    // getStrongsEntry and getReferencesFromReferenceRange are the only operations that do not refer to a module
+    if (operationName == "getStrongsEntry") {
+        if (!this->validateArgs(args, { ParamType::string }, errorMessage)) {
+            return env.Null();
+        }
+
+        string strongsKey = string(args.Get((uint32_t)0).As<Napi::String>());
+        StrongsEntry* strongsEntry = this->_textProcessor.getStrongsEntry(strongsKey);
+
+        if (strongsEntry == 0) {
+            errorMessage = "getStrongsEntry returned 0 for '" + strongsKey + "'";
+            return env.Null();
+        }
+
+        Napi::Object strongsObject = Napi::Object::New(env);
+        this->_napiSwordHelper.strongsEntryToNapiObject(env, strongsEntry, strongsObject);
+        delete strongsEntry;
+        return strongsObject;
+
+    } else if (operationName == "getReferencesFromReferenceRange") {
+        if (!this->validateArgs(args, { ParamType::string }, errorMessage)) {
+            return env.Null();
+        }
+
+        vector<string> references = this->_textProcessor.getReferencesFromReferenceRange(string(args.Get((uint32_t)0).As<Napi::String>()));
+        return this->_napiSwordHelper.getNapiArrayFromStringVector(env, references);
+    }
+
+    // All other operations take the module name as first argument
+    if (args.Length() < 1 || !args.Get((uint32_t)0).IsString()) {
+        errorMessage = "String expected for argument 1";
+        return env.Null();
+    }
+
+    string moduleName = string(args.Get((uint32_t)0).As<Napi::String>());
+    SWModule* swordModule = this->getModule(moduleName);
+
+    if (swordModule == 0) {
+        errorMessage = "getLocalModule returned 0 for '" + moduleName + "'";
+        return env.Null();
+    }
+
+    if (operationName == "getLocalModule") {
+        if (!this->validateArgs(args, { ParamType::string }, errorMessage)) {
+            return env.Null();
+        }
+
+        Napi::Object moduleObject = Napi::Object::New(env);
+        this->_napiSwordHelper.swordModuleToNapiObject(env, swordModule, moduleObject);
+        return moduleObject;
+
+    } else if (operationName == "getReferenceText") {
+        if (!this->validateArgs(args, { ParamType::string, ParamType::string }, errorMessage)) {
+            return env.Null();
+        }
+
+        Verse rawVerse = this->_textProcessor.getReferenceText(swordModule, string(args.Get(1).As<Napi::String>()));
+        Napi::Object verseObject = Napi::Object::New(env);
+        this->_napiSwordHelper.verseTextToNapiObject(moduleName, rawVerse, verseObject);
+        return verseObject;
+
+    } else if (operationName == "getChapterText") {
+        if (!this->validateArgs(args, { ParamType::string, ParamType::string, ParamType::number }, errorMessage)) {
+            return env.Null();
+        }
+
+        vector<Verse> chapterText = this->_textProcessor.getChapterText(swordModule,
+                                                                        string(args.Get(1).As<Napi::String>()),
+                                                                        args.Get(2).As<Napi::Number>().Int32Value());
+
+        return this->_napiSwordHelper.getNapiVerseObjectsFromRawList(env, moduleName, chapterText);
+
+    } else if (operationName == "getBookText") {
+        if (!this->validateArgs(args, { ParamType::string, ParamType::string, ParamType::number, ParamType::number }, errorMessage)) {
+            return env.Null();
+        }
+
+        vector<Verse> bookText = this->_textProcessor.getBookText(swordModule,
+                                                                  string(args.Get(1).As<Napi::String>()),
+                                                                  args.Get(2).As<Napi::Number>().Int32Value(),
+                                                                  args.Get(3).As<Napi::Number>().Int32Value());
+
+        return this->_napiSwordHelper.getNapiVerseObjectsFromRawList(env, moduleName, bookText);
+
+    } else if (operationName == "getVersesFromReferences") {
+        if (!this->validateArgs(args, { ParamType::string, ParamType::array }, errorMessage)) {
+            return env.Null();
+        }
+
+        Napi::Array inputReferences = args.Get(1).As<Napi::Array>();
+        vector<string> references;
+
+        for (unsigned int i = 0; i < inputReferences.Length(); i++) {
+            Napi::Value currentInputReference = inputReferences[i];
+
+            if (!currentInputReference.IsString()) {
+                errorMessage = "String expected for reference " + to_string(i + 1);
+                return env.Null();
+            }
+
+            references.push_back(string(currentInputReference.As<Napi::String>()));
+        }
+
+        vector<Verse> rawVerses = this->_textProcessor.getVersesFromReferences(swordModule, references);
+        return this->_napiSwordHelper.getNapiVerseObjectsFromRawList(env, moduleName, rawVerses);
+
+    } else if (operationName == "getBookList") {
+        if (!this->validateArgs(args, { ParamType::string }, errorMessage)) {
+            return env.Null();
+        }
+
+        vector<string> bookList = this->_moduleHelper.getBookList(swordModule);
+        return this->_napiSwordHelper.getNapiArrayFromStringVector(env, bookList);
+
+    } else if (operationName == "getBookChapterCount") {
+        if (!this->validateArgs(args, { ParamType::string, ParamType::string }, errorMessage)) {
+            return env.Null();
+        }
+
+        return Napi::Number::New(env, this->_moduleHelper.getBookChapterCount(swordModule, string(args.Get(1).As<Napi::String>())));
+
+    } else if (operationName == "getChapterVerseCount") {
+        if (!this->validateArgs(args, { ParamType::string, ParamType::string, ParamType::number }, errorMessage)) {
+            return env.Null();
+        }
+
+        return Napi::Number::New(env, this->_moduleHelper.getChapterVerseCount(swordModule,
+                                                                               string(args.Get(1).As<Napi::String>()),
+                                                                               args.Get(2).As<Napi::Number>().Int32Value()));
+
+    } else if (operationName == "getBookIntroduction") {
+        if (!this->validateArgs(args, { ParamType::string, ParamType::string }, errorMessage)) {
+            return env.Null();
+        }
+
+        return Napi::String::New(env, this->_textProcessor.getBookIntroduction(swordModule, string(args.Get(1).As<Napi::String>())));
+
+    } else if (operationName == "moduleHasBook") {
+        if (!this->validateArgs(args, { ParamType::string, ParamType::string }, errorMessage)) {
+            return env.Null();
+        }
+
+        return Napi::Boolean::New(env, this->_moduleHelper.moduleHasBook(swordModule, string(args.Get(1).As<Napi::String>())));
+
+    } else if (operationName == "getRawModuleEntry") {
+        if (!this->validateArgs(args, { ParamType::string, ParamType::string, ParamType::boolean }, errorMessage)) {
+            return env.Null();
+        }
+
+        swordModule->setKey(string(args.Get(1).As<Napi::String>()).c_str());
+
+        if (!swordModule->hasEntry(swordModule->getKey())) {
+            return env.Undefined();
+        }
+
+        string rawEntry = swordModule->getRawEntry();
+
+        if (args.Get(2).As<Napi::Boolean>().Value()) {
+            this->_textProcessor.processImageUrls(rawEntry, swordModule);
+        }
+
+        return Napi::String::New(env, rawEntry);
+
+    } else if (operationName == "mapVerseReference") {
+        if (!this->validateArgs(args, { ParamType::string, ParamType::string, ParamType::string, ParamType::boolean }, errorMessage)) {
+            return env.Null();
+        }
+
+        // For consistency with all other operations the source module comes first here
+        string sourceOsisRef = string(args.Get(1).As<Napi::String>());
+        string targetModuleName = string(args.Get(2).As<Napi::String>());
+        bool allowRange = args.Get(3).As<Napi::Boolean>().Value();
+        SWModule* targetModule = this->getModule(targetModuleName);
+
+        if (targetModule == 0) {
+            errorMessage = "getLocalModule returned 0 for '" + targetModuleName + "'";
+            return env.Null();
+        }
+
+        return Napi::String::New(env, this->_textProcessor.mapVerseReference(sourceOsisRef, swordModule, targetModule, allowRange));
+    }
+
+    errorMessage = "Unknown batch operation '" + operationName + "'";
+    return env.Null();
+}
+
+bool BatchRequestProcessor::validateArgs(Napi::Array& args, vector<ParamType> paramSpec, string& errorMessage)
+{
+    if (args.Length() != paramSpec.size()) {
+        errorMessage = "Expected " + to_string(paramSpec.size()) + " arguments, but got " + to_string(args.Length()) + "!";
+        return false;
+    }
+
+    for (unsigned int i = 0; i < paramSpec.size(); i++) {
+        Napi::Value currentArg = args.Get(i);
+        bool argValid = true;
+
+        switch (paramSpec[i]) {
+            case ParamType::string:
+                argValid = currentArg.IsString();
+                errorMessage = "String expected for argument " + to_string(i + 1);
+                break;
+            case ParamType::number:
+                argValid = currentArg.IsNumber();
+                errorMessage = "Number expected for argument " + to_string(i + 1);
+                break;
+            case ParamType::boolean:
+                argValid = currentArg.IsBoolean();
+                errorMessage = "Boolean expected for argument " + to_string(i + 1);
+                break;
+            case ParamType::array:
+                argValid = currentArg.IsArray();
+                errorMessage = "Array expected for argument " + to_string(i + 1);
+                break;
+            default:
+                argValid = false;
+                errorMessage = "Unsupported argument type for argument " + to_string(i + 1);
+                break;
+        }
+
+        if (!argValid) {
+            return false;
+        }
+    }
+
+    errorMessage = "";
+    return true;
+}
+
+SWModule* BatchRequestProcessor::getModule(const string& moduleName)
+{
+    map<string, SWModule*>::iterator it = this->_moduleCache.find(moduleName);
+
+    if (it != this->_moduleCache.end()) {
+        return it->second;
+    }
+
+    SWModule* swordModule = this->_moduleStore.getLocalModule(moduleName);
+    this->_moduleCache[moduleName] = swordModule;
+    return swordModule;
+}
@@ -0,0 +1,74 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef _BATCH_REQUEST_PROCESSOR
+#define _BATCH_REQUEST_PROCESSOR
+
+#include <napi.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "node_sword_interface.hpp"
+
+namespace sword {
+    class SWModule;
+};
+
+class ModuleStore;
+class ModuleHelper;
+class TextProcessor;
+class NapiSwordHelper;
+
+/**
+ * The BatchRequestProcessor executes a list of typed read operations within one native call.
+ * Each operation is an object of the form { operation: <name>, args: [ ... ] } and each result
+ * is either { result: <value> } or { error: <message> }, so that one failing operation does not
+ * affect the others. Module lookups are shared between all operations of a batch.
+ */
+class BatchRequestProcessor {
+public:
+    BatchRequestProcessor(ModuleStore& moduleStore,
+                          ModuleHelper& moduleHelper,
+                          TextProcessor& textProcessor,
+                          NapiSwordHelper& napiSwordHelper)
+        : _moduleStore(moduleStore), _moduleHelper(moduleHelper), _textProcessor(textProcessor), _napiSwordHelper(napiSwordHelper) {}
+
+    virtual ~BatchRequestProcessor() {}
+
+    Napi::Array executeBatch(const Napi::Env& env, Napi::Array operations);
+
+private:
+    Napi::Object executeOperation(const Napi::Env& env, Napi::Value operation);
+    Napi::Value executeModuleOperation(const Napi::Env& env,
+                                       const std::string& operationName,
+                                       Napi::Array& args,
+                                       std::string& errorMessage);
+
+    bool validateArgs(Napi::Array& args, std::vector<ParamType> paramSpec, std::string& errorMessage);
+    sword::SWModule* getModule(const std::string& moduleName);
+
+    std::map<std::string, sword::SWModule*> _moduleCache;
+
+    ModuleStore& _moduleStore;
+    ModuleHelper& _moduleHelper;
+    TextProcessor& _textProcessor;
+    NapiSwordHelper& _napiSwordHelper;
+};
+
+#endif // _BATCH_REQUEST_PROCESSOR
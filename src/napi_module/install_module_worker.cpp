@@ -16,7 +16,6 @@
    along with node-sword-interface. See the file COPYING.
    If not, see <http://www.gnu.org/licenses/>. */
 
-#include "api_lock.hpp"
 #include "worker.hpp"
 #include "install_module_worker.hpp"
 
@@ -57,6 +56,7 @@ void InstallModuleWorker::swordUpdateCB(double dltotal, double dlnow)
 
 void InstallModuleWorker::Execute(const ExecutionProgress& progress)
 {
+    std::unique_lock<std::mutex> jobLock = this->lockJob();
     this->_executionProgress = &progress;
 
     std::function<void(long, long, const char*)> _swordPreStatusCB = std::bind(
@@ -74,17 +74,18 @@ void InstallModuleWorker::Execute(const ExecutionProgress& progress)
         std::placeholders::_2
     );
 
-    SwordStatusReporter& statusReporter = this->_repoInterface.getStatusReporter();
-    statusReporter.setCallBacks(&_swordPreStatusCB, &_swordUpdateCB);
+    this->_statusReporter.setCallBacks(&_swordPreStatusCB, &_swordUpdateCB);
 
     this->_totalPercent = 0;
     this->_filePercent = 0;
 
     // Always use repository-specific installation
-    this->_result = this->_moduleInstaller.installModule(this->_repoName, this->_moduleName);
+    this->runInThreadPool(TaskPriority::network, [this]() {
+        this->_result = this->_moduleInstaller.installModule(this->_repoName, this->_moduleName, &this->_statusReporter);
+    });
 
-    statusReporter.resetCallbacks();
-    unlockApi();
+    this->_statusReporter.resetCallbacks();
+    this->flushExecutionProgress();
 }
 
 void InstallModuleWorker::OnOK()
@@ -92,4 +93,45 @@ void InstallModuleWorker::OnOK()
     Napi::HandleScope scope(this->Env());
     Napi::Number result = Napi::Number::New(this->Env(), this->_result);
     Callback().Call({ result });
-}
\ No newline at end of file
+}
+
+void InstallModulesWorker::progressCallback(unsigned int totalPercent, std::string message)
+{
+    this->sendExecutionProgress(totalPercent, 0, message);
+}
+
+void InstallModulesWorker::Execute(const ExecutionProgress& progress)
+{
+    std::unique_lock<std::mutex> jobLock = this->lockJob();
+    this->_executionProgress = &progress;
+
+    std::function<void(unsigned int, std::string)> _progressCallback = std::bind(
+        &InstallModulesWorker::progressCallback,
+        this,
+        std::placeholders::_1,
+        std::placeholders::_2
+    );
+
+    this->runInThreadPool(TaskPriority::network, [this, &_progressCallback]() {
+        this->_moduleInstaller.installModules(this->_requests, &_progressCallback, this->_maxParallelInstalls);
+    });
+
+    this->flushExecutionProgress();
+}
+
+void InstallModulesWorker::OnOK()
+{
+    Napi::Env env = this->Env();
+    Napi::HandleScope scope(env);
+    Napi::Array results = Napi::Array::New(env, this->_requests.size());
+
+    for (unsigned int i = 0; i < this->_requests.size(); i++) {
+        Napi::Object result = Napi::Object::New(env);
+        result["repositoryName"] = this->_requests[i].repoName;
+        result["moduleCode"] = this->_requests[i].moduleName;
+        result["result"] = this->_requests[i].result;
+        results.Set(i, result);
+    }
+
+    Callback().Call({ results });
+}
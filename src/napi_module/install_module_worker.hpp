@@ -53,6 +53,35 @@ private:
     long _totalBytes = 0;
     int _totalPercent = 0;
     int _filePercent = 0;
+
+    // Each installation reports to its own status reporter, so that concurrent installations do not replace each other's callbacks
+    SwordStatusReporter _statusReporter;
+};
+
+class InstallModulesWorker : public ProgressWorker {
+public:
+    InstallModulesWorker(RepositoryInterface& repoInterface,
+                         ModuleInstaller& moduleInstaller,
+                         const Napi::Function& jsProgressCallback,
+                         const Napi::Function& callback,
+                         std::vector<ModuleInstallRequest> requests,
+                         unsigned int maxParallelInstalls)
+
+        : ProgressWorker(repoInterface,
+                         jsProgressCallback,
+                         callback),
+                         _moduleInstaller(moduleInstaller),
+                         _requests(requests),
+                         _maxParallelInstalls(maxParallelInstalls) {}
+
+    void progressCallback(unsigned int totalPercent, std::string message);
+    void Execute(const ExecutionProgress& progress);
+    void OnOK();
+
+private:
+    ModuleInstaller& _moduleInstaller;
+    std::vector<ModuleInstallRequest> _requests;
+    unsigned int _maxParallelInstalls;
 };
 
 #endif // _INSTALL_MODULE_WORKER
\ No newline at end of file
@@ -16,7 +16,6 @@
    along with node-sword-interface. See the file COPYING.
    If not, see <http://www.gnu.org/licenses/>. */
 
-#include "api_lock.hpp"
 #include "worker.hpp"
 #include "module_search_worker.hpp"
 #include "common_defs.hpp"
@@ -31,22 +30,36 @@ void ModuleSearchWorker::Execute(const ExecutionProgress& progress)
                                                                   this,
                                                                   std::placeholders::_1,
                                                                   std::placeholders::_2);
-    setModuleSearchProgressCB(&searchProgressCB);
-    this->_stdSearchResults = this->_moduleSearch.getModuleSearchResults(this->_moduleName,
-                                                                         this->_searchTerm,
-                                                                         this->_searchType,
-                                                                         this->_searchScope,
-                                                                         this->_isCaseSensitive,
-                                                                         this->_useExtendedVerseBoundaries,
-                                                                         this->_filterOnWordBoundaries); // Pass the parameter
+    this->_moduleSearch.setProgressCallback(&searchProgressCB);
+
+    this->runInThreadPool(TaskPriority::search, [this]() {
+        if (this->_isEntrySearch) {
+            this->_entrySearchPage = this->_moduleSearch.getEntrySearchResults(this->_moduleName,
+                                                                               this->_searchTerm,
+                                                                               this->_searchType,
+                                                                               this->_isCaseSensitive,
+                                                                               this->_startIndex,
+                                                                               this->_maxCount);
+            return;
+        }
+
+        this->_stdSearchResults = this->_moduleSearch.getModuleSearchResults(this->_moduleName,
+                                                                             this->_searchTerm,
+                                                                             this->_searchType,
+                                                                             this->_searchScope,
+                                                                             this->_isCaseSensitive,
+                                                                             this->_useExtendedVerseBoundaries,
+                                                                             this->_filterOnWordBoundaries); // Pass the parameter
+    });
     
     if (this->_searchTerminated) {
       this->_stdSearchResults.clear();
+      this->_entrySearchPage = EntrySearchPage();
     }
 
-    setModuleSearchProgressCB(0);
+    this->_moduleSearch.setProgressCallback(0);
+    this->flushExecutionProgress();
     this->_searchMutex.unlock();
-    unlockApi();
 }
 
 void ModuleSearchWorker::searchProgressCB(char percent, void* userData)
@@ -57,6 +70,13 @@ void ModuleSearchWorker::searchProgressCB(char percent, void* userData)
 void ModuleSearchWorker::OnOK()
 {
     Napi::HandleScope scope(this->Env());
+
+    if (this->_isEntrySearch) {
+        Napi::Object napiSearchPage = this->_napiSwordHelper->getNapiEntrySearchPage(this->Env(), this->_entrySearchPage);
+        Callback().Call({ napiSearchPage });
+        return;
+    }
+
     this->_napiSearchResults = this->_napiSwordHelper->getNapiVerseObjectsFromRawList(this->Env(), this->_moduleName, this->_stdSearchResults);
     Callback().Call({ this->_napiSearchResults });
 }
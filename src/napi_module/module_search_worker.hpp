@@ -56,6 +56,39 @@ public:
         this->_napiSwordHelper = new NapiSwordHelper(moduleHelper, moduleStore);
     }
 
+    // Search in a dictionary or commentary module, which returns a page of entries instead of verses
+    ModuleSearchWorker(ModuleHelper& moduleHelper,
+                       ModuleSearch& moduleSearch,
+                       ModuleStore& moduleStore,
+                       RepositoryInterface & repoInterface,
+                       Mutex& searchMutex,
+                       const Napi::Function& jsProgressCallback,
+                       const Napi::Function& callback,
+                       std::string moduleName,
+                       std::string searchTerm,
+                       SearchType searchType,
+                       bool isCaseSensitive,
+                       unsigned int startIndex,
+                       unsigned int maxCount)
+
+        : ProgressWorker(repoInterface, jsProgressCallback, callback),
+        _searchMutex(searchMutex),
+        _moduleSearch(moduleSearch),
+        _moduleName(moduleName),
+        _searchTerm(searchTerm),
+        _searchType(searchType),
+        _searchScope(SearchScope::BIBLE),
+        _isCaseSensitive(isCaseSensitive),
+        _useExtendedVerseBoundaries(false),
+        _filterOnWordBoundaries(false),
+        _searchTerminated(false),
+        _isEntrySearch(true),
+        _startIndex(startIndex),
+        _maxCount(maxCount) {
+
+        this->_napiSwordHelper = new NapiSwordHelper(moduleHelper, moduleStore);
+    }
+
     void searchProgressCB(char percent, void* userData);
     void Execute(const ExecutionProgress& progress);    
     void OnOK();
@@ -66,6 +99,7 @@ private:
     ModuleSearch& _moduleSearch;
     NapiSwordHelper* _napiSwordHelper;
     std::vector<Verse> _stdSearchResults;
+    EntrySearchPage _entrySearchPage;
     Napi::Array _napiSearchResults;
     std::string _moduleName;
     std::string _searchTerm;
@@ -75,6 +109,9 @@ private:
     bool _useExtendedVerseBoundaries;
     bool _filterOnWordBoundaries; // New member variable
     bool _searchTerminated;
+    bool _isEntrySearch = false;
+    unsigned int _startIndex = 0;
+    unsigned int _maxCount = 0;
 };
 
 #endif // _MODULE_SEARCH_WORKER
\ No newline at end of file
@@ -59,96 +59,43 @@ void NapiSwordHelper::swordModuleToNapiObject(const Napi::Env& env, SWModule* sw
         return;
     }
 
-    object["name"] = swModule->getName();
-    object["type"] = swModule->getType();
+    shared_ptr<const ModuleDescriptor> descriptor = this->_moduleDescriptorCache.getDescriptor(swModule);
+    napi_property_attributes attributes = static_cast<napi_property_attributes>(napi_writable | napi_enumerable | napi_configurable);
+
+    // All properties are defined with a single call instead of one property access per entry
+    vector<Napi::PropertyDescriptor> properties = {
+        Napi::PropertyDescriptor::Value("name", Napi::String::New(env, descriptor->name), attributes),
+        Napi::PropertyDescriptor::Value("type", Napi::String::New(env, descriptor->type), attributes),
+        Napi::PropertyDescriptor::Value("category", Napi::String::New(env, descriptor->category), attributes),
+        Napi::PropertyDescriptor::Value("description", Napi::String::New(env, descriptor->description), attributes),
+        Napi::PropertyDescriptor::Value("language", Napi::String::New(env, descriptor->language), attributes),
+        Napi::PropertyDescriptor::Value("location", Napi::String::New(env, descriptor->location), attributes),
+        Napi::PropertyDescriptor::Value("abbreviation", Napi::String::New(env, descriptor->abbreviation), attributes),
+        Napi::PropertyDescriptor::Value("about", Napi::String::New(env, descriptor->about), attributes),
+        Napi::PropertyDescriptor::Value("distributionLicense", Napi::String::New(env, descriptor->distributionLicense), attributes),
+        Napi::PropertyDescriptor::Value("shortCopyright", Napi::String::New(env, descriptor->shortCopyright), attributes),
+        Napi::PropertyDescriptor::Value("version", Napi::String::New(env, descriptor->version), attributes),
+        Napi::PropertyDescriptor::Value("lastUpdate", Napi::String::New(env, descriptor->lastUpdate), attributes),
+        Napi::PropertyDescriptor::Value("isRightToLeft", Napi::Boolean::New(env, descriptor->isRightToLeft), attributes),
+        Napi::PropertyDescriptor::Value("repository", Napi::String::New(env, descriptor->repository), attributes),
+        Napi::PropertyDescriptor::Value("size", Napi::Number::New(env, descriptor->size), attributes),
+        Napi::PropertyDescriptor::Value("locked", Napi::Boolean::New(env, descriptor->locked), attributes),
+        Napi::PropertyDescriptor::Value("unlockInfo", Napi::String::New(env, descriptor->unlockInfo), attributes),
+        Napi::PropertyDescriptor::Value("inUserDir", Napi::Boolean::New(env, descriptor->inUserDir), attributes),
+        Napi::PropertyDescriptor::Value("hasStrongs", Napi::Boolean::New(env, descriptor->hasStrongs), attributes),
+        Napi::PropertyDescriptor::Value("hasFootnotes", Napi::Boolean::New(env, descriptor->hasFootnotes), attributes),
+        Napi::PropertyDescriptor::Value("hasHeadings", Napi::Boolean::New(env, descriptor->hasHeadings), attributes),
+        Napi::PropertyDescriptor::Value("hasRedLetterWords", Napi::Boolean::New(env, descriptor->hasRedLetterWords), attributes),
+        Napi::PropertyDescriptor::Value("hasCrossReferences", Napi::Boolean::New(env, descriptor->hasCrossReferences), attributes),
+        Napi::PropertyDescriptor::Value("hasGreekStrongsKeys", Napi::Boolean::New(env, descriptor->hasGreekStrongsKeys), attributes),
+        Napi::PropertyDescriptor::Value("hasHebrewStrongsKeys", Napi::Boolean::New(env, descriptor->hasHebrewStrongsKeys), attributes)
+    };
 
-    if (swModule->getConfigEntry("Category")) {
-        object["category"] = string(swModule->getConfigEntry("Category"));
-    } else {
-        object["category"] = "";
-    }
-
-    object["description"] = swModule->getDescription();
-    object["language"] = swModule->getLanguage();
-    object["location"] = this->_moduleStore.getModuleDataPath(swModule);
-  
-    object["abbreviation"] = this->getConfigEntry(swModule, "Abbreviation", env);
-    object["about"] = this->getConfigEntry(swModule, "About", env);
-    object["distributionLicense"] = this->getConfigEntry(swModule, "DistributionLicense", env);
-    object["shortCopyright"] = this->getConfigEntry(swModule, "ShortCopyright", env);
-    object["version"] = this->getConfigEntry(swModule, "Version", env);
-
-    if (swModule->getConfigEntry("SwordVersionDate")) {
-        object["lastUpdate"] = this->getConfigEntry(swModule, "SwordVersionDate", env);
-    } else {
-        object["lastUpdate"] = "";
-    }
-
-    if (swModule->getConfigEntry("Direction")) {
-        string direction = string(swModule->getConfigEntry("Direction"));
-        object["isRightToLeft"] = Napi::Boolean::New(env, (direction == "RtoL"));
-    } else {
-        object["isRightToLeft"] = Napi::Boolean::New(env, false);
-    }
-
-    if (swModule->getConfigEntry("InstallSourceCaption")) {
-        object["repository"] = string(swModule->getConfigEntry("InstallSourceCaption"));
-    } else {
-        object["repository"] = "";
-    }
-
-    if (swModule->getConfigEntry("InstallSize")) {
-        std::string configInstallSize = string(swModule->getConfigEntry("InstallSize"));
-
-        int moduleSize = -1;
-        if (configInstallSize.length() > 0 &&
-            configInstallSize.find_first_not_of("0123456789") == std::string::npos) {
-            moduleSize = std::stoi(configInstallSize);
-        }
-
-        object["size"] = Napi::Number::New(env, moduleSize);
-    } else {
-        object["size"] = Napi::Number::New(env, -1);
-    }
-
-    bool moduleIsLocked = swModule->getConfigEntry("CipherKey");
-    
-    object["locked"] = Napi::Boolean::New(env, moduleIsLocked);
-    if (moduleIsLocked && swModule->getConfigEntry("UnlockInfo")) {
-        object["unlockInfo"] = swModule->getConfigEntry("UnlockInfo");
-    } else {
-        object["unlockInfo"] = "";
-    }
-
-    object["inUserDir"] = Napi::Boolean::New(env, this->_moduleStore.isModuleInUserDir(swModule));
-    object["hasStrongs"] = Napi::Boolean::New(env, this->_moduleHelper.moduleHasGlobalOption(swModule, "Strongs"));
-    object["hasFootnotes"] = Napi::Boolean::New(env, this->_moduleHelper.moduleHasGlobalOption(swModule, "Footnotes"));
-    object["hasHeadings"] = Napi::Boolean::New(env, this->_moduleHelper.moduleHasGlobalOption(swModule, "Headings"));
-    object["hasRedLetterWords"] = Napi::Boolean::New(env, this->_moduleHelper.moduleHasGlobalOption(swModule, "RedLetter"));
-    object["hasCrossReferences"] = Napi::Boolean::New(env, this->_moduleHelper.moduleHasGlobalOption(swModule, "Scripref"));
-
-    object["hasGreekStrongsKeys"] = Napi::Boolean::New(env, this->_moduleHelper.moduleHasFeature(swModule, "GreekDef"));
-    object["hasHebrewStrongsKeys"] = Napi::Boolean::New(env, this->_moduleHelper.moduleHasFeature(swModule, "HebrewDef"));
-    
     // Add module history entries
-    std::vector<std::string> historyEntries = this->_moduleHelper.getModuleHistoryEntries(swModule);
-    object["history"] = this->getNapiArrayFromStringVector(env, historyEntries);
-}
-
-Napi::String NapiSwordHelper::getConfigEntry(sword::SWModule* swModule, std::string key, const Napi::Env& env)
-{
-    std::string configEntry = "";
+    vector<string> historyEntries = descriptor->history;
+    properties.push_back(Napi::PropertyDescriptor::Value("history", this->getNapiArrayFromStringVector(env, historyEntries), attributes));
 
-    if (swModule == 0) {
-        cerr << "swModule is 0! Cannot get config entry!" << endl;
-    } else {
-        if (swModule->getConfigEntry(key.c_str())) {
-            configEntry = swModule->getConfigEntry(key.c_str());
-        }
-    }
-
-    Napi::String napiConfigEntry = Napi::String::New(env, configEntry);
-    return napiConfigEntry;
+    object.DefineProperties(properties);
 }
 
 void NapiSwordHelper::verseTextToNapiObject(string moduleCode, Verse rawVerse, Napi::Object& object)
@@ -204,3 +151,45 @@ void NapiSwordHelper::strongsEntryToNapiObject(const Napi::Env& env, StrongsEntr
 
     object["references"] = referencesArray;
 }
+
+Napi::Object NapiSwordHelper::getNapiStrongsEntryMap(const Napi::Env& env, vector<StrongsEntry*>& strongsEntries)
+{
+    Napi::Object strongsEntryMap = Napi::Object::New(env);
+
+    for (unsigned int i = 0; i < strongsEntries.size(); i++) {
+        Napi::Object strongsEntryObject = Napi::Object::New(env);
+        this->strongsEntryToNapiObject(env, strongsEntries[i], strongsEntryObject);
+        strongsEntryMap.Set(strongsEntries[i]->key, strongsEntryObject);
+
+        delete strongsEntries[i];
+    }
+
+    strongsEntries.clear();
+    return strongsEntryMap;
+}
+
+Napi::Object NapiSwordHelper::getNapiDictKeyPage(const Napi::Env& env, DictKeyPage& dictKeyPage)
+{
+    Napi::Object dictKeyPageObject = Napi::Object::New(env);
+    dictKeyPageObject["totalCount"] = Napi::Number::New(env, dictKeyPage.totalCount);
+    dictKeyPageObject["keys"] = this->getNapiArrayFromStringVector(env, dictKeyPage.keys);
+    return dictKeyPageObject;
+}
+
+Napi::Object NapiSwordHelper::getNapiEntrySearchPage(const Napi::Env& env, EntrySearchPage& entrySearchPage)
+{
+    Napi::Object entrySearchPageObject = Napi::Object::New(env);
+    Napi::Array resultArray = Napi::Array::New(env, entrySearchPage.results.size());
+
+    for (unsigned int i = 0; i < entrySearchPage.results.size(); i++) {
+        Napi::Object resultObject = Napi::Object::New(env);
+        resultObject["key"] = entrySearchPage.results[i].key;
+        resultObject["endKey"] = entrySearchPage.results[i].endKey;
+        resultObject["content"] = entrySearchPage.results[i].content;
+        resultArray.Set(i, resultObject);
+    }
+
+    entrySearchPageObject["totalCount"] = Napi::Number::New(env, entrySearchPage.totalCount);
+    entrySearchPageObject["results"] = resultArray;
+    return entrySearchPageObject;
+}
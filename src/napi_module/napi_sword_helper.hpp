@@ -23,6 +23,8 @@
 #include <iostream>
 
 #include "strongs_entry.hpp"
+#include "module_descriptor.hpp"
+#include "dict_key_index.hpp"
 #include "common_defs.hpp"
 
 using namespace std;
@@ -37,7 +39,7 @@ class ModuleStore;
 class NapiSwordHelper {
 public:
     NapiSwordHelper(ModuleHelper& moduleHelper, ModuleStore& moduleStore)
-        : _moduleHelper(moduleHelper), _moduleStore(moduleStore) {}
+        : _moduleHelper(moduleHelper), _moduleStore(moduleStore), _moduleDescriptorCache(moduleHelper, moduleStore) {}
 
     virtual ~NapiSwordHelper() {}
 
@@ -45,13 +47,16 @@ public:
     Napi::Array getNapiVerseObjectsFromRawList(const Napi::Env& env, std::string moduleCode, std::vector<Verse>& verses);
     void swordModuleToNapiObject(const Napi::Env& env, sword::SWModule* swModule, Napi::Object& object);
     void strongsEntryToNapiObject(const Napi::Env& env, StrongsEntry* strongsEntry, Napi::Object& object);
+    // Returns an object that maps the keys to the entries and deletes the entries
+    Napi::Object getNapiStrongsEntryMap(const Napi::Env& env, std::vector<StrongsEntry*>& strongsEntries);
+    Napi::Object getNapiDictKeyPage(const Napi::Env& env, DictKeyPage& dictKeyPage);
+    Napi::Object getNapiEntrySearchPage(const Napi::Env& env, EntrySearchPage& entrySearchPage);
     void verseTextToNapiObject(std::string moduleCode, Verse rawVerse, Napi::Object& object);
 
 private:
-    Napi::String getConfigEntry(sword::SWModule* swModule, std::string key, const Napi::Env& env);
-
     ModuleHelper& _moduleHelper;
     ModuleStore& _moduleStore;
+    ModuleDescriptorCache _moduleDescriptorCache;
 };
 
 #endif // _NAPI_SWORD_HELPER
@@ -22,7 +22,6 @@
 #include <iostream>
 #include <mutex>
 
-#include "api_lock.hpp"
 #include "swmodule.h"
 #include "node_sword_interface.hpp"
 #include "napi_sword_helper.hpp"
@@ -35,9 +34,13 @@
 #include "module_installer.hpp"
 #include "module_helper.hpp"
 #include "dict_helper.hpp"
+#include "strongs_table.hpp"
 #include "text_processor.hpp"
 #include "module_search.hpp"
 #include "mutex.hpp"
+#include "thread_pool.hpp"
+#include "batch_request_processor.hpp"
+#include "shared_backend.hpp"
 
 using namespace std;
 using namespace sword;
@@ -65,10 +68,6 @@ using namespace sword;
     } \
 }
 
-static Mutex searchMutex;
-
-Napi::FunctionReference NodeSwordInterface::constructor;
-
 Napi::Object NodeSwordInterface::Init(Napi::Env env, Napi::Object exports)
 {
     Napi::HandleScope scope(env);
@@ -106,26 +105,45 @@ Napi::Object NodeSwordInterface::Init(Napi::Env env, Napi::Object exports)
         InstanceMethod("getBookIntroduction", &NodeSwordInterface::getBookIntroduction),
         InstanceMethod("moduleHasBook", &NodeSwordInterface::moduleHasBook),
         InstanceMethod("getDictModuleKeys", &NodeSwordInterface::getDictModuleKeys),
+        InstanceMethod("getDictModuleKeysWithPrefix", &NodeSwordInterface::getDictModuleKeysWithPrefix),
+        InstanceMethod("getDictModuleKeyRange", &NodeSwordInterface::getDictModuleKeyRange),
+        InstanceMethod("findDictModuleKey", &NodeSwordInterface::findDictModuleKey),
         InstanceMethod("getModuleSearchResults", &NodeSwordInterface::getModuleSearchResults),
+        InstanceMethod("getEntrySearchResults", &NodeSwordInterface::getEntrySearchResults),
         InstanceMethod("terminateModuleSearch", &NodeSwordInterface::terminateModuleSearch),
         InstanceMethod("getStrongsEntry", &NodeSwordInterface::getStrongsEntry),
+        InstanceMethod("getStrongsEntries", &NodeSwordInterface::getStrongsEntries),
+        InstanceMethod("getChapterStrongsEntries", &NodeSwordInterface::getChapterStrongsEntries),
+        InstanceMethod("getLemmaStatistics", &NodeSwordInterface::getLemmaStatistics),
         InstanceMethod("installModule", &NodeSwordInterface::installModule),
+        InstanceMethod("installModules", &NodeSwordInterface::installModules),
         InstanceMethod("cancelInstallation", &NodeSwordInterface::cancelInstallation),
         InstanceMethod("uninstallModule", &NodeSwordInterface::uninstallModule),
         InstanceMethod("refreshLocalModules", &NodeSwordInterface::refreshLocalModules),
+        InstanceMethod("refreshLocalModule", &NodeSwordInterface::refreshLocalModule),
         InstanceMethod("saveModuleUnlockKey", &NodeSwordInterface::saveModuleUnlockKey),
         InstanceMethod("isModuleReadable", &NodeSwordInterface::isModuleReadable),
         InstanceMethod("mapVerseReference", &NodeSwordInterface::mapVerseReference),
+        InstanceMethod("mapVerseReferences", &NodeSwordInterface::mapVerseReferences),
+        InstanceMethod("mapChapterVerseReferences", &NodeSwordInterface::mapChapterVerseReferences),
         InstanceMethod("getSwordTranslation", &NodeSwordInterface::getSwordTranslation),
         InstanceMethod("getBookAbbreviation", &NodeSwordInterface::getBookAbbreviation),
         InstanceMethod("getSwordVersion", &NodeSwordInterface::getSwordVersion),
         InstanceMethod("getSwordPath", &NodeSwordInterface::getSwordPath),
         InstanceMethod("unTarGZ", &NodeSwordInterface::unTarGZ),
-        InstanceMethod("unZip", &NodeSwordInterface::unZip)
+        InstanceMethod("unZip", &NodeSwordInterface::unZip),
+        InstanceMethod("unTarGZAsync", &NodeSwordInterface::unTarGZAsync),
+        InstanceMethod("unZipAsync", &NodeSwordInterface::unZipAsync),
+        InstanceMethod("setWorkerThreadCount", &NodeSwordInterface::setWorkerThreadCount),
+        InstanceMethod("getWorkerThreadCount", &NodeSwordInterface::getWorkerThreadCount),
+        InstanceMethod("setRepositoryRefreshOptions", &NodeSwordInterface::setRepositoryRefreshOptions),
+        InstanceMethod("executeBatch", &NodeSwordInterface::executeBatch)
     });
 
-    constructor = Napi::Persistent(func);
-    constructor.SuppressDestruct();
+    // The constructor reference is kept per environment, so that the addon can be loaded in several worker_threads
+    NodeSwordInterfaceAddonData* addonData = new NodeSwordInterfaceAddonData();
+    addonData->constructor = Napi::Persistent(func);
+    env.SetInstanceData<NodeSwordInterfaceAddonData>(addonData);
 
     exports.Set("NodeSwordInterface", func);
     return exports;
@@ -158,8 +176,7 @@ NodeSwordInterface::NodeSwordInterface(const Napi::CallbackInfo& info) : Napi::O
     bool homeDirError = false;
     bool localeDirError = false;
 
-    initLock();
-    searchMutex.init();
+    this->_backend = 0;
     this->_currentModuleSearchWorker = 0;
 
     if (info[0].IsString()) {
@@ -187,15 +204,38 @@ NodeSwordInterface::NodeSwordInterface(const Napi::CallbackInfo& info) : Napi::O
     }
 
     if (!homeDirError && !localeDirError) { // We only proceed if there has not been any issue with the homeDir or localeDir
-        this->_moduleStore = new ModuleStore(this->customHomeDir);
-        this->_moduleHelper = new ModuleHelper(*(this->_moduleStore));
-        this->_dictHelper = new DictHelper(*(this->_moduleStore));
-        this->_repoInterface = new RepositoryInterface(this->_swordStatusReporter, *(this->_moduleHelper), *(this->_moduleStore), this->customHomeDir, timeoutMillis);
-        this->_moduleInstaller = new ModuleInstaller(*(this->_repoInterface), *(this->_moduleStore), this->customHomeDir);
+        // The module store, repository interface and installer are shared with all other instances using the same home directory
+        this->_backend = SharedBackend::getInstance(this->customHomeDir, timeoutMillis);
+        this->_moduleStore = this->_backend->getModuleStore();
+        this->_moduleHelper = this->_backend->getModuleHelper();
+        this->_dictHelper = this->_backend->getDictHelper();
+        this->_lemmaStatistics = this->_backend->getLemmaStatistics();
+        this->_repoInterface = this->_backend->getRepoInterface();
+        this->_moduleInstaller = this->_backend->getModuleInstaller();
+
+        // Text processing options and search state are specific to this instance
         this->_napiSwordHelper = new NapiSwordHelper(*(this->_moduleHelper), *(this->_moduleStore));
-        this->_textProcessor = new TextProcessor(*(this->_moduleStore), *(this->_moduleHelper));
+        this->_textProcessor = new TextProcessor(*(this->_moduleStore), *(this->_moduleHelper), *(this->_backend->getStrongsTableCache()));
         this->_moduleSearch = new ModuleSearch(*(this->_moduleStore), *(this->_moduleHelper), *(this->_textProcessor));
         this->_swordTranslationHelper = new SwordTranslationHelper(localeDir);
+        this->_batchRequestProcessor = new BatchRequestProcessor(*(this->_moduleStore), *(this->_moduleHelper), *(this->_textProcessor), *(this->_napiSwordHelper));
+
+        // Searches read from leased managers of the module store, so only the searches of this instance need to be serialized
+        this->_searchMutex.init();
+    }
+}
+
+void NodeSwordInterface::lockApi()
+{
+    if (this->_backend != 0) {
+        this->_backend->lockApi();
+    }
+}
+
+void NodeSwordInterface::unlockApi()
+{
+    if (this->_backend != 0) {
+        this->_backend->unlockApi();
     }
 }
 
@@ -265,7 +305,9 @@ Napi::Value NodeSwordInterface::updateRepositoryConfig(const Napi::CallbackInfo&
                                                                         progressCallback,
                                                                         callback,
                                                                         force.Value());
+    worker->useJobLock(this->_backend);
     worker->Queue();
+    unlockApi();
     return info.Env().Undefined();
 }
 
@@ -278,7 +320,9 @@ Napi::Value NodeSwordInterface::updateSingleRepositoryConfig(const Napi::Callbac
     RefreshSingleRemoteSourceWorker* worker = new RefreshSingleRemoteSourceWorker(*(this->_repoInterface),
                                                                                   callback,
                                                                                   string(repoName));
+    worker->useJobLock(this->_backend);
     worker->Queue();
+    unlockApi();
     return info.Env().Undefined();
 }
 
@@ -741,6 +785,18 @@ Napi::Value NodeSwordInterface::getReferencesFromReferenceRange(const Napi::Call
     return napiReferences;
 }
 
+Napi::Value NodeSwordInterface::executeBatch(const Napi::CallbackInfo& info)
+{
+    lockApi();
+    INIT_SCOPE_AND_VALIDATE(ParamType::array);
+    Napi::Array operations = info[0].As<Napi::Array>();
+
+    Napi::Array results = this->_batchRequestProcessor->executeBatch(info.Env(), operations);
+
+    unlockApi();
+    return results;
+}
+
 Napi::Value NodeSwordInterface::getBookList(const Napi::CallbackInfo& info)
 {
     lockApi();
@@ -825,6 +881,76 @@ Napi::Value NodeSwordInterface::getDictModuleKeys(const Napi::CallbackInfo& info
     return dictModuleKeyArray;
 }
 
+Napi::Value NodeSwordInterface::getDictModuleKeysWithPrefix(const Napi::CallbackInfo& info)
+{
+    lockApi();
+    Napi::Env env = info.Env();
+    INIT_SCOPE_AND_VALIDATE(ParamType::string, ParamType::string, ParamType::number, ParamType::number);
+    Napi::String moduleName = info[0].As<Napi::String>();
+    Napi::String prefix = info[1].As<Napi::String>();
+    Napi::Number startIndex = info[2].As<Napi::Number>();
+    Napi::Number maxCount = info[3].As<Napi::Number>();
+    ASSERT_SW_MODULE_EXISTS(moduleName);
+
+    DictKeyPage dictKeyPage = this->_dictHelper->getKeysWithPrefix(moduleName,
+                                                                   prefix,
+                                                                   startIndex.Uint32Value(),
+                                                                   maxCount.Uint32Value());
+
+    Napi::Object dictKeyPageObject = this->_napiSwordHelper->getNapiDictKeyPage(env, dictKeyPage);
+
+    unlockApi();
+    return dictKeyPageObject;
+}
+
+Napi::Value NodeSwordInterface::getDictModuleKeyRange(const Napi::CallbackInfo& info)
+{
+    lockApi();
+    Napi::Env env = info.Env();
+    INIT_SCOPE_AND_VALIDATE(ParamType::string, // moduleName
+                            ParamType::string, // fromKey
+                            ParamType::string, // toKey
+                            ParamType::number, // startIndex
+                            ParamType::number); // maxCount
+    Napi::String moduleName = info[0].As<Napi::String>();
+    Napi::String fromKey = info[1].As<Napi::String>();
+    Napi::String toKey = info[2].As<Napi::String>();
+    Napi::Number startIndex = info[3].As<Napi::Number>();
+    Napi::Number maxCount = info[4].As<Napi::Number>();
+    ASSERT_SW_MODULE_EXISTS(moduleName);
+
+    DictKeyPage dictKeyPage = this->_dictHelper->getKeysInRange(moduleName,
+                                                                fromKey,
+                                                                toKey,
+                                                                startIndex.Uint32Value(),
+                                                                maxCount.Uint32Value());
+
+    Napi::Object dictKeyPageObject = this->_napiSwordHelper->getNapiDictKeyPage(env, dictKeyPage);
+
+    unlockApi();
+    return dictKeyPageObject;
+}
+
+Napi::Value NodeSwordInterface::findDictModuleKey(const Napi::CallbackInfo& info)
+{
+    lockApi();
+    Napi::Env env = info.Env();
+    INIT_SCOPE_AND_VALIDATE(ParamType::string, ParamType::string);
+    Napi::String moduleName = info[0].As<Napi::String>();
+    Napi::String key = info[1].As<Napi::String>();
+    ASSERT_SW_MODULE_EXISTS(moduleName);
+
+    string dictKey = this->_dictHelper->findKey(moduleName, key);
+
+    if (dictKey.size() == 0) {
+        unlockApi();
+        return env.Undefined();
+    }
+
+    unlockApi();
+    return Napi::String::New(env, dictKey);
+}
+
 Napi::Value NodeSwordInterface::getModuleSearchResults(const Napi::CallbackInfo& info)
 {
     lockApi();
@@ -882,7 +1008,7 @@ Napi::Value NodeSwordInterface::getModuleSearchResults(const Napi::CallbackInfo&
                                                               *(this->_moduleSearch),
                                                               *(this->_moduleStore),
                                                               *(this->_repoInterface),
-                                                              searchMutex,
+                                                              this->_searchMutex,
                                                               jsProgressCallback,
                                                               callback,
                                                               moduleName,
@@ -893,6 +1019,65 @@ Napi::Value NodeSwordInterface::getModuleSearchResults(const Napi::CallbackInfo&
                                                               useExtendedVerseBoundaries,
                                                               filterOnWordBoundaries); // Pass the new parameter
     this->_currentModuleSearchWorker->Queue();
+    unlockApi();
+    return env.Undefined();
+}
+
+Napi::Value NodeSwordInterface::getEntrySearchResults(const Napi::CallbackInfo& info)
+{
+    lockApi();
+    Napi::Env env = info.Env();
+    INIT_SCOPE_AND_VALIDATE(ParamType::string, // moduleName
+                            ParamType::string, // searchTerm
+                            ParamType::string, // searchType
+                            ParamType::boolean, // isCaseSensitive
+                            ParamType::number, // startIndex
+                            ParamType::number, // maxCount
+                            ParamType::function, // progressCallback
+                            ParamType::function); // final Callback
+
+    Napi::String moduleName = info[0].As<Napi::String>();
+    Napi::String searchTerm = info[1].As<Napi::String>();
+    string searchTypeString = string(info[2].As<Napi::String>());
+    Napi::Boolean isCaseSensitive = info[3].As<Napi::Boolean>();
+    Napi::Number startIndex = info[4].As<Napi::Number>();
+    Napi::Number maxCount = info[5].As<Napi::Number>();
+    Napi::Function jsProgressCallback = info[6].As<Napi::Function>();
+    Napi::Function callback = info[7].As<Napi::Function>();
+    ASSERT_SW_MODULE_EXISTS(moduleName);
+
+    SearchType searchType = SearchType::multiWord;
+
+    if (searchTypeString == "phrase") {
+        searchType = SearchType::phrase;
+    } else if (searchTypeString == "multiWord") {
+        searchType = SearchType::multiWord;
+    } else {
+        THROW_JS_EXCEPTION("Unknown search type!");
+    }
+
+    SWModule* swordModule = this->_moduleStore->getLocalModule(moduleName);
+    string moduleType = string(swordModule->getType());
+
+    if (moduleType != "Lexicons / Dictionaries" && moduleType != "Commentaries") {
+        THROW_JS_EXCEPTION("The given module is not a dictionary or commentary module!");
+    }
+
+    this->_currentModuleSearchWorker = new ModuleSearchWorker(*(this->_moduleHelper),
+                                                              *(this->_moduleSearch),
+                                                              *(this->_moduleStore),
+                                                              *(this->_repoInterface),
+                                                              this->_searchMutex,
+                                                              jsProgressCallback,
+                                                              callback,
+                                                              moduleName,
+                                                              searchTerm,
+                                                              searchType,
+                                                              isCaseSensitive,
+                                                              startIndex.Uint32Value(),
+                                                              maxCount.Uint32Value());
+    this->_currentModuleSearchWorker->Queue();
+    unlockApi();
     return env.Undefined();
 }
 
@@ -930,6 +1115,67 @@ Napi::Value NodeSwordInterface::getStrongsEntry(const Napi::CallbackInfo& info)
     return napiObject;
 }
 
+Napi::Value NodeSwordInterface::getStrongsEntries(const Napi::CallbackInfo& info)
+{
+    lockApi();
+    Napi::Env env = info.Env();
+    INIT_SCOPE_AND_VALIDATE(ParamType::array);
+    Napi::Array inputStrongsKeys = info[0].As<Napi::Array>();
+
+    vector<string> strongsKeys;
+    for (unsigned int i = 0; i < inputStrongsKeys.Length(); i++) {
+        Napi::Value currentStrongsKey = inputStrongsKeys[i];
+        strongsKeys.push_back(string(currentStrongsKey.As<Napi::String>()));
+    }
+
+    vector<StrongsEntry*> strongsEntries = this->_textProcessor->getStrongsEntries(strongsKeys);
+    Napi::Object strongsEntryMap = this->_napiSwordHelper->getNapiStrongsEntryMap(env, strongsEntries);
+
+    unlockApi();
+    return strongsEntryMap;
+}
+
+Napi::Value NodeSwordInterface::getChapterStrongsEntries(const Napi::CallbackInfo& info)
+{
+    lockApi();
+    Napi::Env env = info.Env();
+    INIT_SCOPE_AND_VALIDATE(ParamType::string, ParamType::string, ParamType::number);
+    Napi::String moduleName = info[0].As<Napi::String>();
+    Napi::String bookCode = info[1].As<Napi::String>();
+    Napi::Number chapterNumber = info[2].As<Napi::Number>();
+    ASSERT_SW_MODULE_EXISTS(moduleName);
+
+    vector<string> strongsKeys = this->_textProcessor->getChapterStrongsKeys(moduleName, bookCode, chapterNumber.Int32Value());
+    vector<StrongsEntry*> strongsEntries = this->_textProcessor->getStrongsEntries(strongsKeys);
+    Napi::Object strongsEntryMap = this->_napiSwordHelper->getNapiStrongsEntryMap(env, strongsEntries);
+
+    unlockApi();
+    return strongsEntryMap;
+}
+
+Napi::Value NodeSwordInterface::getLemmaStatistics(const Napi::CallbackInfo& info)
+{
+    lockApi();
+    INIT_SCOPE_AND_VALIDATE(ParamType::string, ParamType::string, ParamType::function);
+    Napi::String moduleName = info[0].As<Napi::String>();
+    Napi::String strongsKey = info[1].As<Napi::String>();
+    Napi::Function callback = info[2].As<Napi::Function>();
+    ASSERT_SW_MODULE_EXISTS(moduleName);
+
+    if (!StrongsEntry::isValidStrongsKey(StrongsEntry::getNormalizedStrongsKey(strongsKey))) {
+        THROW_JS_EXCEPTION("Invalid Strong's key: " + string(strongsKey));
+    }
+
+    LemmaStatisticsWorker* worker = new LemmaStatisticsWorker(*(this->_repoInterface),
+                                                              *(this->_lemmaStatistics),
+                                                              callback,
+                                                              moduleName,
+                                                              strongsKey);
+    worker->Queue();
+    unlockApi();
+    return info.Env().Undefined();
+}
+
 Napi::Value NodeSwordInterface::installModule(const Napi::CallbackInfo& info)
 {
     lockApi();
@@ -957,7 +1203,52 @@ Napi::Value NodeSwordInterface::installModule(const Napi::CallbackInfo& info)
                                                           callback,
                                                           repoName,
                                                           moduleName);
+    worker->useJobLock(this->_backend);
     worker->Queue();
+    unlockApi();
+    return info.Env().Undefined();
+}
+
+Napi::Value NodeSwordInterface::installModules(const Napi::CallbackInfo& info)
+{
+    lockApi();
+    INIT_SCOPE_AND_VALIDATE(ParamType::array, ParamType::number, ParamType::function, ParamType::function);
+    Napi::Array modules = info[0].As<Napi::Array>();
+    Napi::Number maxParallelInstalls = info[1].As<Napi::Number>();
+    Napi::Function progressCallback = info[2].As<Napi::Function>();
+    Napi::Function callback = info[3].As<Napi::Function>();
+
+    if (maxParallelInstalls.Int32Value() < 1) {
+        THROW_JS_EXCEPTION("The number of parallel installations must be at least 1!");
+    }
+
+    vector<ModuleInstallRequest> requests;
+
+    for (unsigned int i = 0; i < modules.Length(); i++) {
+        Napi::Value currentModule = modules[i];
+
+        if (!currentModule.IsObject() ||
+            !currentModule.As<Napi::Object>().Get("repositoryName").IsString() ||
+            !currentModule.As<Napi::Object>().Get("moduleCode").IsString()) {
+
+            THROW_JS_EXCEPTION("Every module must be given as object with the string properties repositoryName and moduleCode!");
+        }
+
+        ModuleInstallRequest request;
+        request.repoName = currentModule.As<Napi::Object>().Get("repositoryName").As<Napi::String>().Utf8Value();
+        request.moduleName = currentModule.As<Napi::Object>().Get("moduleCode").As<Napi::String>().Utf8Value();
+        requests.push_back(request);
+    }
+
+    InstallModulesWorker* worker = new InstallModulesWorker(*(this->_repoInterface),
+                                                            *(this->_moduleInstaller),
+                                                            progressCallback,
+                                                            callback,
+                                                            requests,
+                                                            maxParallelInstalls.Uint32Value());
+    worker->useJobLock(this->_backend);
+    worker->Queue();
+    unlockApi();
     return info.Env().Undefined();
 }
 
@@ -976,7 +1267,9 @@ Napi::Value NodeSwordInterface::uninstallModule(const Napi::CallbackInfo& info)
     Napi::String moduleName = info[0].As<Napi::String>();
     Napi::Function callback = info[1].As<Napi::Function>();
     UninstallModuleWorker* worker = new UninstallModuleWorker(*(this->_repoInterface), *(this->_moduleInstaller), callback, moduleName);
+    worker->useJobLock(this->_backend);
     worker->Queue();
+    unlockApi();
     return info.Env().Undefined();
 }
 
@@ -988,8 +1281,20 @@ Napi::Value NodeSwordInterface::refreshLocalModules(const Napi::CallbackInfo& in
     return info.Env().Undefined();
 }
 
+Napi::Value NodeSwordInterface::refreshLocalModule(const Napi::CallbackInfo& info)
+{
+    lockApi();
+    INIT_SCOPE_AND_VALIDATE(ParamType::string);
+    Napi::String moduleName = info[0].As<Napi::String>();
+    this->_moduleInstaller->reloadModule(string(moduleName));
+    unlockApi();
+    return info.Env().Undefined();
+}
+
 Napi::Value NodeSwordInterface::saveModuleUnlockKey(const Napi::CallbackInfo& info)
 {
+    // Saving the key refreshes the remote sources, which must not overlap with a running repository refresh or installation
+    lock_guard<mutex> jobLock(this->_backend->getJobMutex());
     lockApi();
     INIT_SCOPE_AND_VALIDATE(ParamType::string, ParamType::string);
 
@@ -1151,11 +1456,67 @@ Napi::Value NodeSwordInterface::mapVerseReference(const Napi::CallbackInfo& info
     return Napi::String::New(env, result);
 }
 
+Napi::Value NodeSwordInterface::mapVerseReferences(const Napi::CallbackInfo& info)
+{
+    lockApi();
+    Napi::Env env = info.Env();
+    INIT_SCOPE_AND_VALIDATE(ParamType::array, // sourceOsisRefs
+                            ParamType::string, // sourceModuleName
+                            ParamType::string, // targetModuleName
+                            ParamType::boolean); // allowRange
+    Napi::Array inputOsisRefs = info[0].As<Napi::Array>();
+    Napi::String sourceModuleName = info[1].As<Napi::String>();
+    Napi::String targetModuleName = info[2].As<Napi::String>();
+    Napi::Boolean allowRange = info[3].As<Napi::Boolean>();
+
+    vector<string> sourceOsisRefs;
+    for (unsigned int i = 0; i < inputOsisRefs.Length(); i++) {
+        Napi::Value currentOsisRef = inputOsisRefs[i];
+        sourceOsisRefs.push_back(string(currentOsisRef.As<Napi::String>()));
+    }
+
+    vector<string> targetOsisRefs = this->_textProcessor->mapVerseReferences(sourceOsisRefs, sourceModuleName, targetModuleName, allowRange);
+    Napi::Array targetOsisRefArray = this->_napiSwordHelper->getNapiArrayFromStringVector(env, targetOsisRefs);
+
+    unlockApi();
+    return targetOsisRefArray;
+}
+
+Napi::Value NodeSwordInterface::mapChapterVerseReferences(const Napi::CallbackInfo& info)
+{
+    lockApi();
+    Napi::Env env = info.Env();
+    INIT_SCOPE_AND_VALIDATE(ParamType::string, // sourceModuleName
+                            ParamType::string, // targetModuleName
+                            ParamType::string, // bookCode
+                            ParamType::number, // chapter
+                            ParamType::boolean); // allowRange
+    Napi::String sourceModuleName = info[0].As<Napi::String>();
+    Napi::String targetModuleName = info[1].As<Napi::String>();
+    Napi::String bookCode = info[2].As<Napi::String>();
+    Napi::Number chapter = info[3].As<Napi::Number>();
+    Napi::Boolean allowRange = info[4].As<Napi::Boolean>();
+
+    vector<pair<string, string>> chapterMapping = this->_textProcessor->mapChapterVerseReferences(sourceModuleName,
+                                                                                                  targetModuleName,
+                                                                                                  bookCode,
+                                                                                                  chapter.Int32Value(),
+                                                                                                  allowRange);
+    Napi::Object chapterMappingObject = Napi::Object::New(env);
+
+    for (unsigned int i = 0; i < chapterMapping.size(); i++) {
+        chapterMappingObject.Set(chapterMapping[i].first, chapterMapping[i].second);
+    }
+
+    unlockApi();
+    return chapterMappingObject;
+}
+
 Napi::Value NodeSwordInterface::unTarGZ(const Napi::CallbackInfo& info)
 {
+    lockApi();
     Napi::Env env = info.Env();
     INIT_SCOPE_AND_VALIDATE(ParamType::string, ParamType::string);
-    lockApi();
 
     string filePath = info[0].As<Napi::String>().Utf8Value();
     string destPath = info[1].As<Napi::String>().Utf8Value();
@@ -1169,9 +1530,9 @@ Napi::Value NodeSwordInterface::unTarGZ(const Napi::CallbackInfo& info)
 
 Napi::Value NodeSwordInterface::unZip(const Napi::CallbackInfo& info)
 {
+    lockApi();
     Napi::Env env = info.Env();
     INIT_SCOPE_AND_VALIDATE(ParamType::string, ParamType::string);
-    lockApi();
 
     string filePath = info[0].As<Napi::String>().Utf8Value();
     string destPath = info[1].As<Napi::String>().Utf8Value();
@@ -1182,3 +1543,105 @@ Napi::Value NodeSwordInterface::unZip(const Napi::CallbackInfo& info)
     unlockApi();
     return Napi::Boolean::New(env, ret);
 }
+
+Napi::Value NodeSwordInterface::unTarGZAsync(const Napi::CallbackInfo& info)
+{
+    lockApi();
+    INIT_SCOPE_AND_VALIDATE(ParamType::string, ParamType::string, ParamType::function, ParamType::function);
+
+    string filePath = info[0].As<Napi::String>().Utf8Value();
+    string destPath = info[1].As<Napi::String>().Utf8Value();
+    Napi::Function progressCallback = info[2].As<Napi::Function>();
+    Napi::Function callback = info[3].As<Napi::Function>();
+
+    ExtractArchiveWorker* worker = new ExtractArchiveWorker(*(this->_repoInterface),
+                                                            progressCallback,
+                                                            callback,
+                                                            ArchiveFormat::tarGz,
+                                                            filePath,
+                                                            destPath,
+                                                            1);
+    worker->Queue();
+    unlockApi();
+    return info.Env().Undefined();
+}
+
+Napi::Value NodeSwordInterface::unZipAsync(const Napi::CallbackInfo& info)
+{
+    lockApi();
+    INIT_SCOPE_AND_VALIDATE(ParamType::string, ParamType::string, ParamType::number, ParamType::function, ParamType::function);
+
+    string filePath = info[0].As<Napi::String>().Utf8Value();
+    string destPath = info[1].As<Napi::String>().Utf8Value();
+    Napi::Number maxParallelEntries = info[2].As<Napi::Number>();
+    Napi::Function progressCallback = info[3].As<Napi::Function>();
+    Napi::Function callback = info[4].As<Napi::Function>();
+
+    if (maxParallelEntries.Int32Value() < 1) {
+        THROW_JS_EXCEPTION("The number of parallel entries must be at least 1!");
+    }
+
+    ExtractArchiveWorker* worker = new ExtractArchiveWorker(*(this->_repoInterface),
+                                                            progressCallback,
+                                                            callback,
+                                                            ArchiveFormat::zip,
+                                                            filePath,
+                                                            destPath,
+                                                            maxParallelEntries.Uint32Value());
+    worker->Queue();
+    unlockApi();
+    return info.Env().Undefined();
+}
+
+Napi::Value NodeSwordInterface::setWorkerThreadCount(const Napi::CallbackInfo& info)
+{
+    lockApi();
+    INIT_SCOPE_AND_VALIDATE(ParamType::number);
+    Napi::Number workerCount = info[0].As<Napi::Number>();
+
+    if (workerCount.Int32Value() < 1) {
+        THROW_JS_EXCEPTION("The worker thread count must be at least 1!");
+    }
+
+    bool ret = ThreadPool::getInstance().setWorkerCount(workerCount.Uint32Value());
+
+    unlockApi();
+    return Napi::Boolean::New(info.Env(), ret);
+}
+
+Napi::Value NodeSwordInterface::getWorkerThreadCount(const Napi::CallbackInfo& info)
+{
+    lockApi();
+    Napi::Env env = info.Env();
+    Napi::HandleScope scope(env);
+
+    Napi::Number workerCount = Napi::Number::New(env, ThreadPool::getInstance().getWorkerCount());
+    unlockApi();
+    return workerCount;
+}
+
+Napi::Value NodeSwordInterface::setRepositoryRefreshOptions(const Napi::CallbackInfo& info)
+{
+    lockApi();
+    INIT_SCOPE_AND_VALIDATE(ParamType::number, ParamType::number, ParamType::number);
+    Napi::Number maxConcurrency = info[0].As<Napi::Number>();
+    Napi::Number maxRetries = info[1].As<Napi::Number>();
+    Napi::Number sourceDeadlineMillis = info[2].As<Napi::Number>();
+
+    if (maxConcurrency.Int32Value() < 1) {
+        THROW_JS_EXCEPTION("The maximum concurrency must be at least 1!");
+    }
+
+    if (maxRetries.Int32Value() < 0 || sourceDeadlineMillis.Int64Value() < 0) {
+        THROW_JS_EXCEPTION("The retry count and the source deadline must not be negative!");
+    }
+
+    RepositoryRefreshOptions refreshOptions = this->_repoInterface->getRefreshOptions();
+    refreshOptions.maxConcurrency = maxConcurrency.Uint32Value();
+    refreshOptions.maxRetries = maxRetries.Uint32Value();
+    refreshOptions.sourceDeadlineMillis = (long)sourceDeadlineMillis.Int64Value();
+    this->_repoInterface->setRefreshOptions(refreshOptions);
+
+    unlockApi();
+    return info.Env().Undefined();
+}
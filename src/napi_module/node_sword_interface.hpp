@@ -22,6 +22,7 @@
 #include <napi.h>
 #include "sword_status_reporter.hpp"
 #include "sword_translation_helper.hpp"
+#include "mutex.hpp"
 
 class RepositoryInterface;
 class ModuleStore;
@@ -30,8 +31,11 @@ class TextProcessor;
 class NapiSwordHelper;
 class ModuleHelper;
 class DictHelper;
+class LemmaStatistics;
 class ModuleSearch;
 class ModuleSearchWorker;
+class BatchRequestProcessor;
+class SharedBackend;
 enum class ModuleType;
 
 enum class ParamType {
@@ -42,13 +46,20 @@ enum class ParamType {
     function
 };
 
+// Data that is kept per environment (main thread or worker thread)
+class NodeSwordInterfaceAddonData {
+public:
+    Napi::FunctionReference constructor;
+};
+
 class NodeSwordInterface : public Napi::ObjectWrap<NodeSwordInterface> {
 public:
     static Napi::Object Init(Napi::Env env, Napi::Object exports);
     NodeSwordInterface(const Napi::CallbackInfo& info);
 
 private:
-    static Napi::FunctionReference constructor;
+    void lockApi();
+    void unlockApi();
 
     Napi::Value updateRepositoryConfig(const Napi::CallbackInfo& info);
     Napi::Value updateSingleRepositoryConfig(const Napi::CallbackInfo& info);
@@ -81,25 +92,37 @@ private:
     Napi::Value getBibleText(const Napi::CallbackInfo& info);
     Napi::Value getVersesFromReferences(const Napi::CallbackInfo& info);
     Napi::Value getReferencesFromReferenceRange(const Napi::CallbackInfo& info);
+    Napi::Value executeBatch(const Napi::CallbackInfo& info);
     Napi::Value getBookList(const Napi::CallbackInfo& info);
     Napi::Value getBookChapterCount(const Napi::CallbackInfo& info);
     Napi::Value getChapterVerseCount(const Napi::CallbackInfo& info);
     Napi::Value getBookIntroduction(const Napi::CallbackInfo& info);
     Napi::Value moduleHasBook(const Napi::CallbackInfo& info);
     Napi::Value getDictModuleKeys(const Napi::CallbackInfo& info);
+    Napi::Value getDictModuleKeysWithPrefix(const Napi::CallbackInfo& info);
+    Napi::Value getDictModuleKeyRange(const Napi::CallbackInfo& info);
+    Napi::Value findDictModuleKey(const Napi::CallbackInfo& info);
 
     Napi::Value getModuleSearchResults(const Napi::CallbackInfo& info);
+    Napi::Value getEntrySearchResults(const Napi::CallbackInfo& info);
     Napi::Value terminateModuleSearch(const Napi::CallbackInfo& info);
     Napi::Value getStrongsEntry(const Napi::CallbackInfo& info);
+    Napi::Value getStrongsEntries(const Napi::CallbackInfo& info);
+    Napi::Value getChapterStrongsEntries(const Napi::CallbackInfo& info);
+    Napi::Value getLemmaStatistics(const Napi::CallbackInfo& info);
 
     Napi::Value installModule(const Napi::CallbackInfo& info);
+    Napi::Value installModules(const Napi::CallbackInfo& info);
     Napi::Value cancelInstallation(const Napi::CallbackInfo& info);
     Napi::Value uninstallModule(const Napi::CallbackInfo& info);
     Napi::Value saveModuleUnlockKey(const Napi::CallbackInfo& info);
     Napi::Value isModuleReadable(const Napi::CallbackInfo& info);
     Napi::Value refreshLocalModules(const Napi::CallbackInfo& info);
+    Napi::Value refreshLocalModule(const Napi::CallbackInfo& info);
 
     Napi::Value mapVerseReference(const Napi::CallbackInfo& info);
+    Napi::Value mapVerseReferences(const Napi::CallbackInfo& info);
+    Napi::Value mapChapterVerseReferences(const Napi::CallbackInfo& info);
 
     Napi::Value getSwordTranslation(const Napi::CallbackInfo& info);
     Napi::Value getBookAbbreviation(const Napi::CallbackInfo& info);
@@ -107,13 +130,21 @@ private:
     Napi::Value getSwordPath(const Napi::CallbackInfo& info);
     Napi::Value unTarGZ(const Napi::CallbackInfo& info);
     Napi::Value unZip(const Napi::CallbackInfo& info);
+    Napi::Value unTarGZAsync(const Napi::CallbackInfo& info);
+    Napi::Value unZipAsync(const Napi::CallbackInfo& info);
+
+    Napi::Value setWorkerThreadCount(const Napi::CallbackInfo& info);
+    Napi::Value getWorkerThreadCount(const Napi::CallbackInfo& info);
+    Napi::Value setRepositoryRefreshOptions(const Napi::CallbackInfo& info);
 
     int validateParams(const Napi::CallbackInfo& info, std::vector<ParamType> paramSpec);
     ModuleType getModuleTypeFromString(std::string moduleTypeString);
     bool dirExists(const Napi::CallbackInfo& info, std::string dirName);
 
+    SharedBackend* _backend;
     ModuleHelper* _moduleHelper;
     DictHelper* _dictHelper;
+    LemmaStatistics* _lemmaStatistics;
     NapiSwordHelper* _napiSwordHelper;
     RepositoryInterface* _repoInterface;
     ModuleStore* _moduleStore;
@@ -121,8 +152,9 @@ private:
     TextProcessor* _textProcessor;
     ModuleSearch* _moduleSearch;
     SwordTranslationHelper* _swordTranslationHelper;
-    SwordStatusReporter _swordStatusReporter;
+    BatchRequestProcessor* _batchRequestProcessor;
     ModuleSearchWorker* _currentModuleSearchWorker;
+    Mutex _searchMutex;
 
     std::string customHomeDir;
 };
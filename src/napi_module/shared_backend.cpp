@@ -0,0 +1,98 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+#include "shared_backend.hpp"
+#include "module_store.hpp"
+#include "module_helper.hpp"
+#include "dict_helper.hpp"
+#include "strongs_table.hpp"
+#include "lemma_statistics.hpp"
+#include "repository_interface.hpp"
+#include "module_installer.hpp"
+#include "sword_file_lock.hpp"
+
+using namespace std;
+
+static mutex backendRegistryMutex;
+
+// Backends are never destroyed, since background operations of an environment that is shutting down
+// may still be using them. There is only one backend per SWORD home directory, so this is bounded.
+static map<string, SharedBackend*> backendRegistry;
+
+SharedBackend* SharedBackend::getInstance(string customHomeDir, long timeoutMillis)
+{
+    lock_guard<mutex> lock(backendRegistryMutex);
+
+    map<string, SharedBackend*>::iterator it = backendRegistry.find(customHomeDir);
+    if (it != backendRegistry.end()) {
+        return it->second;
+    }
+
+    SharedBackend* backend = new SharedBackend(customHomeDir, timeoutMillis);
+    backendRegistry[customHomeDir] = backend;
+    return backend;
+}
+
+SharedBackend::SharedBackend(string customHomeDir, long timeoutMillis)
+{
+    this->_moduleStore = new ModuleStore(customHomeDir);
+    this->_moduleHelper = new ModuleHelper(*(this->_moduleStore));
+    this->_dictKeyIndexCache = new DictKeyIndexCache(*(this->_moduleStore));
+    this->_dictHelper = new DictHelper(*(this->_moduleStore), *(this->_dictKeyIndexCache));
+    this->_strongsTableCache = new StrongsTableCache(*(this->_moduleStore));
+    this->_lemmaStatistics = new LemmaStatistics(*(this->_moduleStore));
+    this->_repoInterface = new RepositoryInterface(this->_swordStatusReporter, *(this->_moduleHelper), *(this->_moduleStore), customHomeDir, timeoutMillis);
+    this->_moduleInstaller = new ModuleInstaller(*(this->_repoInterface), *(this->_moduleStore), customHomeDir);
+}
+
+void SharedBackend::lockApi()
+{
+    {
+        unique_lock<mutex> lock(this->_apiLockMutex);
+
+        while (this->_apiLocked) {
+            this->_apiUnlocked.wait(lock);
+        }
+
+        this->_apiLocked = true;
+        this->_apiLockOwner = this_thread::get_id();
+    }
+
+    // Background operations replace modules under the manager lock, so the modules used by this call stay valid until it is unlocked
+    this->_moduleStore->lockMgr();
+
+    // The synchronous calls read SWORD files through the global FileMgr during the whole call
+    SwordFileLock::lock();
+}
+
+void SharedBackend::unlockApi()
+{
+    {
+        lock_guard<mutex> lock(this->_apiLockMutex);
+
+        if (!this->_apiLocked || this->_apiLockOwner != this_thread::get_id()) {
+            return;
+        }
+
+        SwordFileLock::unlock();
+        this->_moduleStore->unlockMgr();
+        this->_apiLocked = false;
+    }
+
+    this->_apiUnlocked.notify_one();
+}
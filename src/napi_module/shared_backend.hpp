@@ -0,0 +1,94 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef _SHARED_BACKEND
+#define _SHARED_BACKEND
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "mutex.hpp"
+#include "sword_status_reporter.hpp"
+
+class ModuleStore;
+class ModuleHelper;
+class DictHelper;
+class DictKeyIndexCache;
+class StrongsTableCache;
+class LemmaStatistics;
+class RepositoryInterface;
+class ModuleInstaller;
+
+/**
+ * The SharedBackend holds the native state that is independent of a JavaScript environment (module store, repository
+ * interface, installer). There is one SharedBackend per SWORD home directory and process, which is shared by all
+ * NodeSwordInterface instances of all environments (main thread and worker_threads).
+ *
+ * Access from the different environments is serialized by the API lock of the backend. It is only held for the duration
+ * of a synchronous API call and also takes the manager lock of the module store, so that background operations cannot
+ * replace modules that are used by the call.
+ *
+ * Background operations never hold the API lock while they are running. The ones that change the repository configuration
+ * or the installed modules (repository refresh, installation, uninstallation) hold the job lock instead, which makes them
+ * mutually exclusive without blocking the synchronous API calls. Lock order: job lock, API lock, manager lock, SWORD file lock.
+ */
+class SharedBackend {
+public:
+    // The timeout is only considered when the backend for the given home directory is created.
+    static SharedBackend* getInstance(std::string customHomeDir, long timeoutMillis);
+
+    void lockApi();
+    void unlockApi();
+
+    std::mutex& getJobMutex() { return this->_jobMutex; }
+
+    ModuleStore* getModuleStore() { return this->_moduleStore; }
+    ModuleHelper* getModuleHelper() { return this->_moduleHelper; }
+    DictHelper* getDictHelper() { return this->_dictHelper; }
+    StrongsTableCache* getStrongsTableCache() { return this->_strongsTableCache; }
+    LemmaStatistics* getLemmaStatistics() { return this->_lemmaStatistics; }
+    RepositoryInterface* getRepoInterface() { return this->_repoInterface; }
+    ModuleInstaller* getModuleInstaller() { return this->_moduleInstaller; }
+
+private:
+    SharedBackend(std::string customHomeDir, long timeoutMillis);
+    virtual ~SharedBackend() {}
+
+    ModuleStore* _moduleStore;
+    ModuleHelper* _moduleHelper;
+    DictHelper* _dictHelper;
+    DictKeyIndexCache* _dictKeyIndexCache;
+    StrongsTableCache* _strongsTableCache;
+    LemmaStatistics* _lemmaStatistics;
+    RepositoryInterface* _repoInterface;
+    ModuleInstaller* _moduleInstaller;
+    SwordStatusReporter _swordStatusReporter;
+
+    // The API lock is not a plain mutex, because unlocking must be a no-op if the lock is not held by the calling thread
+    bool _apiLocked = false;
+    std::thread::id _apiLockOwner;
+    std::mutex _apiLockMutex;
+    std::condition_variable _apiUnlocked;
+
+    std::mutex _jobMutex;
+};
+
+#endif // _SHARED_BACKEND
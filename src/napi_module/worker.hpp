@@ -22,16 +22,29 @@
 #include <napi.h>
 #include <iostream>
 #include <map>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 
-#include "api_lock.hpp"
 #include "napi_sword_helper.hpp"
 #include "repository_interface.hpp"
 #include "sword_status_reporter.hpp"
 #include "common_defs.hpp"
 #include "module_installer.hpp"
+#include "thread_pool.hpp"
+#include "archive_stream_extractor.hpp"
+#include "percentage_calc.hpp"
+#include "lemma_statistics.hpp"
+#include "shared_backend.hpp"
 
 using namespace std;
 
+// Minimum interval between two progress events that only carry a changed percentage
+#define PROGRESS_MIN_INTERVAL_MILLIS 50
+
+// Marks the progress slots as empty
+#define NO_PROGRESS 0xFFFFFFFF
+
 class SwordProgressFeedback {
 public:
     int totalPercent;
@@ -55,8 +68,33 @@ public:
         Napi::HandleScope scope(this->Env());
     }
 
+    // Makes this worker hold the job lock of the given backend while it is executing, so that it does not overlap
+    // with other operations that change the repositories or the installed modules (see SharedBackend).
+    void useJobLock(SharedBackend* backend) {
+        this->_jobBackend = backend;
+    }
+
 protected:
+    // Blocks the worker thread until the other jobs of the backend are finished. The lock is held until the returned object is destroyed.
+    std::unique_lock<std::mutex> lockJob() {
+        if (this->_jobBackend == 0) {
+            return std::unique_lock<std::mutex>();
+        }
+
+        return std::unique_lock<std::mutex>(this->_jobBackend->getJobMutex());
+    }
+
+    // Runs the given work on the shared thread pool and blocks the calling (libuv) thread until it is done.
+    // This keeps the number of concurrently running backend operations bounded by the pool size and lets the
+    // pool order them by priority. The job lock must be taken before, since it would otherwise occupy a pool thread.
+    void runInThreadPool(TaskPriority priority, std::function<void()> work) {
+        ThreadPool& threadPool = ThreadPool::getInstance();
+        std::future<void> result = threadPool.submit<void>(priority, work);
+        threadPool.waitFor(result);
+    }
+
     RepositoryInterface& _repoInterface;
+    SharedBackend* _jobBackend = 0;
 };
 
 class ProgressWorker : public BaseWorker {
@@ -65,7 +103,10 @@ public:
                    const Napi::Function& jsProgressCallback,
                    const Napi::Function& callback)
         : BaseWorker(repoInterface, callback),
-        _jsProgressCallback(Napi::Persistent(jsProgressCallback)) {}
+        _jsProgressCallback(Napi::Persistent(jsProgressCallback)),
+        _latestProgress(NO_PROGRESS),
+        _lastSentProgress(NO_PROGRESS),
+        _lastSendTime(0) {}
 
     void OnProgress(const SwordProgressFeedback* progressFeedback, size_t /* count */) {
         Napi::HandleScope scope(this->Env());
@@ -81,19 +122,84 @@ public:
     }
 
 protected:
+    // Progress updates are coalesced: An update that does not change the percentages is dropped and percentage-only updates
+    // are rate limited. Updates with a message and the final 100% update are always sent. Since the progress callbacks may
+    // be invoked from several threads at once (e.g. when refreshing the repositories), the state is kept in atomics.
     virtual void sendExecutionProgress(int totalPercent, int filePercent, std::string message) {
-        if (this->_executionProgress != 0) {
-            SwordProgressFeedback feedback;
+        if (this->_executionProgress == 0) {
+            return;
+        }
 
-            feedback.totalPercent = totalPercent;
-            feedback.filePercent = filePercent;
-            feedback.message = message;
-            this->_executionProgress->Send(&feedback, 1);
-        }        
+        uint32_t progress = this->packProgress(totalPercent, filePercent);
+        long long now = this->getCurrentTimeMillis();
+        this->_latestProgress.store(progress);
+
+        if (message == "") {
+            if (progress == this->_lastSentProgress.load()) {
+                return;
+            }
+
+            if (totalPercent < 100) {
+                long long lastSendTime = this->_lastSendTime.load();
+
+                if ((now - lastSendTime) < PROGRESS_MIN_INTERVAL_MILLIS) {
+                    // The latest value stays in _latestProgress and is delivered by a later update or by flushExecutionProgress()
+                    return;
+                }
+
+                if (!this->_lastSendTime.compare_exchange_strong(lastSendTime, now)) {
+                    // Another thread has just sent an update
+                    return;
+                }
+            } else {
+                this->_lastSendTime.store(now);
+            }
+        } else {
+            this->_lastSendTime.store(now);
+        }
+
+        this->_lastSentProgress.store(progress);
+        this->doSendExecutionProgress(totalPercent, filePercent, message);
+    }
+
+    // Delivers the latest progress value if it has been held back by the rate limit. Should be called at the end of Execute().
+    void flushExecutionProgress() {
+        if (this->_executionProgress == 0) {
+            return;
+        }
+
+        uint32_t latestProgress = this->_latestProgress.load();
+
+        if (latestProgress != NO_PROGRESS && latestProgress != this->_lastSentProgress.exchange(latestProgress)) {
+            this->doSendExecutionProgress(latestProgress >> 16, latestProgress & 0xFFFF, "");
+        }
     }
 
     Napi::FunctionReference _jsProgressCallback;
     const ExecutionProgress* _executionProgress = 0;
+
+private:
+    void doSendExecutionProgress(int totalPercent, int filePercent, std::string message) {
+        SwordProgressFeedback feedback;
+
+        feedback.totalPercent = totalPercent;
+        feedback.filePercent = filePercent;
+        feedback.message = message;
+        this->_executionProgress->Send(&feedback, 1);
+    }
+
+    uint32_t packProgress(int totalPercent, int filePercent) {
+        return ((uint32_t)(totalPercent & 0xFFFF) << 16) | (uint32_t)(filePercent & 0xFFFF);
+    }
+
+    long long getCurrentTimeMillis() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    std::atomic<uint32_t> _latestProgress;
+    std::atomic<uint32_t> _lastSentProgress;
+    std::atomic<long long> _lastSendTime;
 };
 
 class RefreshRemoteSourcesWorker : public ProgressWorker {
@@ -106,19 +212,26 @@ public:
         : ProgressWorker(repoInterface, jsProgressCallback, callback),
           _forced(forced) {}
     
-    void progressCallback(unsigned int progressPercentage) {
-        this->sendExecutionProgress(progressPercentage, 0, "");
+    // Invoked as soon as a source is finished, with the name of that source as message
+    void sourceCallback(std::string repoName, bool successful, unsigned int progressPercentage) {
+        this->sendExecutionProgress(progressPercentage, 0, repoName);
     }
 
     void Execute(const ExecutionProgress& progress) {
+        std::unique_lock<std::mutex> jobLock = this->lockJob();
         this->_executionProgress = &progress;
-        std::function<void(unsigned int)> _progressCallback = std::bind(&RefreshRemoteSourcesWorker::progressCallback,
-                                                                        this,
-                                                                        std::placeholders::_1);
-
-        int ret = this->_repoInterface.refreshRemoteSources(this->_forced, &this->_repoUpdateStatus, &_progressCallback);
-        this->_isSuccessful = (ret == 0);
-        unlockApi();
+        std::function<void(std::string, bool, unsigned int)> _sourceCallback = std::bind(&RefreshRemoteSourcesWorker::sourceCallback,
+                                                                                         this,
+                                                                                         std::placeholders::_1,
+                                                                                         std::placeholders::_2,
+                                                                                         std::placeholders::_3);
+
+        this->runInThreadPool(TaskPriority::network, [this, &_sourceCallback]() {
+            int ret = this->_repoInterface.refreshRemoteSources(this->_forced, &this->_repoUpdateStatus, 0, &_sourceCallback);
+            this->_isSuccessful = (ret == 0);
+        });
+
+        this->flushExecutionProgress();
     }
 
     void OnOK() {
@@ -149,9 +262,11 @@ public:
         : BaseWorker(repoInterface, callback), _repoName(repoName) {}
 
     void Execute(const ExecutionProgress& progress) {
-        int ret = this->_repoInterface.refreshIndividualRemoteSource(this->_repoName, nullptr);
-        this->_isSuccessful = (ret == 0);
-        unlockApi();
+        std::unique_lock<std::mutex> jobLock = this->lockJob();
+        this->runInThreadPool(TaskPriority::network, [this]() {
+            int ret = this->_repoInterface.refreshIndividualRemoteSource(this->_repoName, nullptr);
+            this->_isSuccessful = (ret == 0);
+        });
     }
 
     void OnOK() {
@@ -171,9 +286,11 @@ public:
         : BaseWorker(repoInterface, callback), _moduleInstaller(moduleInstaller), _moduleName(moduleName) {}
 
     void Execute(const ExecutionProgress& progress) {
-        int ret = this->_moduleInstaller.uninstallModule(this->_moduleName);
-        this->_isSuccessful = (ret == 0);
-        unlockApi();
+        std::unique_lock<std::mutex> jobLock = this->lockJob();
+        this->runInThreadPool(TaskPriority::indexing, [this]() {
+            int ret = this->_moduleInstaller.uninstallModule(this->_moduleName);
+            this->_isSuccessful = (ret == 0);
+        });
     }
 
     void OnOK() {
@@ -188,5 +305,113 @@ private:
     std::string _moduleName;
 };
 
+class ExtractArchiveWorker : public ProgressWorker {
+public:
+    ExtractArchiveWorker(RepositoryInterface& repoInterface,
+                         const Napi::Function& jsProgressCallback,
+                         const Napi::Function& callback,
+                         ArchiveFormat format,
+                         std::string filePath,
+                         std::string destPath,
+                         unsigned int maxParallelEntries)
+
+        : ProgressWorker(repoInterface, jsProgressCallback, callback),
+          _format(format), _filePath(filePath), _destPath(destPath), _maxParallelEntries(maxParallelEntries) {}
+
+    void progressCallback(unsigned long long totalBytes, unsigned long long completedBytes) {
+        this->sendExecutionProgress(calculateIntPercentage<double>((double)completedBytes, (double)totalBytes), 0, "");
+    }
+
+    void Execute(const ExecutionProgress& progress) {
+        this->_executionProgress = &progress;
+        std::function<void(unsigned long long, unsigned long long)> _progressCallback = std::bind(&ExtractArchiveWorker::progressCallback,
+                                                                                                  this,
+                                                                                                  std::placeholders::_1,
+                                                                                                  std::placeholders::_2);
+
+        // The extraction is usually awaited by the user, so it does not queue behind indexing or network tasks
+        this->runInThreadPool(TaskPriority::interactive, [this, &_progressCallback]() {
+            FileSystemHelper fsHelper;
+
+            if (this->_format == ArchiveFormat::zip) {
+                this->_isSuccessful = fsHelper.unZip(this->_filePath, this->_destPath, &_progressCallback, this->_maxParallelEntries);
+            } else {
+                this->_isSuccessful = fsHelper.unTarGZ(this->_filePath, this->_destPath, &_progressCallback);
+            }
+        });
+
+        this->flushExecutionProgress();
+    }
+
+    void OnOK() {
+        Napi::HandleScope scope(this->Env());
+        Napi::Boolean isSuccessful = Napi::Boolean::New(this->Env(), this->_isSuccessful);
+        Callback().Call({ isSuccessful });
+    }
+
+private:
+    ArchiveFormat _format;
+    std::string _filePath;
+    std::string _destPath;
+    unsigned int _maxParallelEntries;
+    bool _isSuccessful = false;
+};
+
+class LemmaStatisticsWorker : public BaseWorker {
+public:
+    LemmaStatisticsWorker(RepositoryInterface& repoInterface,
+                          LemmaStatistics& lemmaStatistics,
+                          const Napi::Function& callback,
+                          std::string moduleName,
+                          std::string strongsKey)
+        : BaseWorker(repoInterface, callback), _lemmaStatistics(lemmaStatistics), _moduleName(moduleName), _strongsKey(strongsKey) {}
+
+    void Execute(const ExecutionProgress& progress) {
+        // The first query for a module builds its statistics, which reads the whole module
+        this->runInThreadPool(TaskPriority::indexing, [this]() {
+            this->_isSuccessful = this->_lemmaStatistics.getLemmaStatistics(this->_moduleName, this->_strongsKey, this->_entry);
+        });
+    }
+
+    void OnOK() {
+        Napi::Env env = this->Env();
+        Napi::HandleScope scope(env);
+
+        if (!this->_isSuccessful) {
+            Callback().Call({ env.Null() });
+            return;
+        }
+
+        Napi::Object napiEntry = Napi::Object::New(env);
+        napiEntry["strongsKey"] = this->_entry.strongsKey;
+        napiEntry["occurrences"] = Napi::Number::New(env, this->_entry.occurrences);
+
+        Napi::Object bookOccurrences = Napi::Object::New(env);
+        for (unsigned int i = 0; i < this->_entry.bookOccurrences.size(); i++) {
+            bookOccurrences.Set(this->_entry.bookOccurrences[i].first, Napi::Number::New(env, this->_entry.bookOccurrences[i].second));
+        }
+
+        Napi::Array surfaceForms = Napi::Array::New(env, this->_entry.surfaceForms.size());
+        for (unsigned int i = 0; i < this->_entry.surfaceForms.size(); i++) {
+            Napi::Object surfaceForm = Napi::Object::New(env);
+            surfaceForm["text"] = this->_entry.surfaceForms[i].first;
+            surfaceForm["occurrences"] = Napi::Number::New(env, this->_entry.surfaceForms[i].second);
+            surfaceForms.Set(i, surfaceForm);
+        }
+
+        napiEntry["bookOccurrences"] = bookOccurrences;
+        napiEntry["surfaceForms"] = surfaceForms;
+
+        Callback().Call({ napiEntry });
+    }
+
+private:
+    LemmaStatistics& _lemmaStatistics;
+    std::string _moduleName;
+    std::string _strongsKey;
+    LemmaStatisticsEntry _entry;
+    bool _isSuccessful = false;
+};
+
 #endif // _WORKER
 
@@ -6,10 +6,17 @@
 #include "dict_helper.hpp"
 #include "module_installer.hpp"
 #include "strongs_entry.hpp"
+#include "strongs_table.hpp"
 #include "module_search.hpp"
+#include "repository_refresh_scheduler.hpp"
+#include "streaming_module_installer.hpp"
+#include "mutex.hpp"
 
 #include <vector>
 #include <iostream>
+#include <map>
+#include <thread>
+#include <chrono>
 #include <swmodule.h>
 #include <swmgr.h>
 #include <localemgr.h>
@@ -222,6 +229,97 @@ void test_update_single_repository_config(RepositoryInterface& repoInterface)
     cout << "=== End of Update Single Repository Config Test ===" << endl;
 }
 
+void test_repository_refresh_scheduler()
+{
+    cout << "=== Repository Refresh Scheduler Test ===" << endl;
+
+    // Stand-in for the remote sources: "Slow" exceeds its deadline, "Flaky" fails on its first attempt and "Down" never succeeds
+    map<string, unsigned int> attempts;
+    Mutex attemptsMutex;
+    attemptsMutex.init();
+
+    std::function<int(string, long)> refreshFunction = [&attempts, &attemptsMutex](string sourceName, long remainingMillis) {
+        attemptsMutex.lock();
+        unsigned int attempt = ++attempts[sourceName];
+        attemptsMutex.unlock();
+
+        if (sourceName == "Slow") {
+            // Like a hanging transfer, the slow source is aborted once its budget is used up
+            if (remainingMillis > 0 && remainingMillis < 2000) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(remainingMillis));
+                return -1;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(2000));
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+
+        if (sourceName == "Down" || (sourceName == "Flaky" && attempt == 1)) {
+            return -1;
+        }
+
+        return 0;
+    };
+
+    RepositoryRefreshOptions options;
+    options.maxConcurrency = 2;
+    options.maxRetries = 2;
+    options.initialBackoffMillis = 100;
+    options.sourceDeadlineMillis = 1000;
+
+    vector<string> sourceNames = { "Slow", "Flaky", "Down", "Fast1", "Fast2" };
+    RepositoryRefreshScheduler scheduler(options, refreshFunction);
+
+    unsigned int failedSourceCount = scheduler.run(sourceNames, [&attempts](string sourceName, int result) {
+        cout << "  " << sourceName << ": " << (result == 0 ? "OK" : "FAILED") << " after " << attempts[sourceName] << " attempt(s)" << endl;
+    });
+
+    cout << "Failed sources: " << failedSourceCount << " (expected: 2)" << endl;
+    cout << "=== End of Repository Refresh Scheduler Test ===" << endl;
+}
+
+class CancellingStatusReporter : public sword::StatusReporter {
+public:
+    CancellingStatusReporter(std::atomic<bool>& cancelled, unsigned long cancelAfterBytes)
+        : _cancelled(cancelled), _cancelAfterBytes(cancelAfterBytes) {}
+
+    virtual void update(unsigned long totalBytes, unsigned long completedBytes) {
+        if (this->_cancelAfterBytes > 0 && completedBytes >= this->_cancelAfterBytes) {
+            this->_cancelled = true;
+        }
+    }
+
+private:
+    std::atomic<bool>& _cancelled;
+    unsigned long _cancelAfterBytes;
+};
+
+void test_resumable_module_download(string swordDir, string moduleName, string moduleVersion)
+{
+    cout << "=== Resumable Module Download Test ===" << endl;
+
+    // Expects an HTTP server with Range support serving packages/rawzip/<moduleName>.zip on localhost:8000
+    sword::InstallSource source("HTTP");
+    source.caption = "Local";
+    source.source = "localhost:8000";
+    source.directory = "/raw";
+
+    StreamingModuleInstaller installer;
+    std::atomic<bool> cancelled(false);
+
+    CancellingStatusReporter cancellingReporter(cancelled, 1000000);
+    int result = installer.installModule(&source, moduleName, moduleVersion, swordDir, &cancellingReporter, cancelled);
+    cout << "First attempt: " << result << " (expected: -9)" << endl;
+
+    cancelled = false;
+    CancellingStatusReporter statusReporter(cancelled, 0);
+    result = installer.installModule(&source, moduleName, moduleVersion, swordDir, &statusReporter, cancelled);
+    cout << "Resumed attempt: " << result << " (expected: 0)" << endl;
+
+    cout << "=== End of Resumable Module Download Test ===" << endl;
+}
+
 void test_verse_reference_mapping(ModuleInstaller& module_installer, ModuleStore& module_store, TextProcessor& text_processor)
 {
     cout << "=== Verse Reference Mapping Test ===" << endl;
@@ -307,6 +405,22 @@ void test_verse_reference_mapping(ModuleInstaller& module_installer, ModuleStore
     string result11 = text_processor.mapVerseReference("Mark.4.41", "KJV", "VulgClementine");
     cout << "KJV Mark.4.41 -> VulgClementine (Vulg): " << result11 << endl;
 
+    // --- Batch mapping tests ---
+    cout << endl << "--- Batch Mapping Tests ---" << endl;
+
+    // Test 12: Several references in one call (same results as Test 3, 7 and 11)
+    vector<string> sourceRefs = { "Ps.51.1", "Mark.9.1", "Mark.4.41" };
+    vector<string> result12 = text_processor.mapVerseReferences(sourceRefs, "KJV", "VulgClementine");
+    for (unsigned int i = 0; i < result12.size(); i++) {
+        cout << "KJV " << sourceRefs[i] << " -> VulgClementine (Vulg, batch): " << result12[i] << endl;
+    }
+
+    // Test 13: Whole chapter (KJV Ps.51 -> Vulg Ps.50)
+    vector<pair<string, string>> result13 = text_processor.mapChapterVerseReferences("KJV", "VulgClementine", "Ps", 51, true);
+    for (unsigned int i = 0; i < result13.size(); i++) {
+        cout << "KJV " << result13[i].first << " -> VulgClementine (Vulg, chapter): " << result13[i].second << endl;
+    }
+
     cout << "=== End of Mapping Test ===" << endl;
 }
 
@@ -345,12 +459,14 @@ int main(int argc, char** argv)
 {
     ModuleStore moduleStore;
     ModuleHelper moduleHelper(moduleStore);
-    DictHelper dictHelper(moduleStore);
+    DictKeyIndexCache dictKeyIndexCache(moduleStore);
+    DictHelper dictHelper(moduleStore, dictKeyIndexCache);
     SwordStatusReporter statusReporter;
     long timeoutMillis = 20000;
     RepositoryInterface repoInterface(statusReporter, moduleHelper, moduleStore, "", timeoutMillis);
     ModuleInstaller moduleInstaller(repoInterface, moduleStore);
-    TextProcessor textProcessor(moduleStore, moduleHelper);
+    StrongsTableCache strongsTableCache(moduleStore);
+    TextProcessor textProcessor(moduleStore, moduleHelper, strongsTableCache);
     ModuleSearch moduleSearch(moduleStore, moduleHelper, textProcessor);
 
     /*std::vector<sword::SWModule*> localModules = moduleStore.getAllLocalModules();
@@ -366,6 +482,10 @@ int main(int argc, char** argv)
 
     //test_unlock_key(moduleInstaller, moduleStore, textProcessor);
 
+    //test_repository_refresh_scheduler();
+
+    //test_resumable_module_download("/tmp/sword", "KJV", "2.11");
+
     /*show_repos(repoInterface);*/
 
     //show_modules(repoInterface);
@@ -0,0 +1,728 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+
+// Std includes
+#include <iostream>
+#include <cstring>
+
+// Sword includes
+#include <filemgr.h>
+
+// Own includes
+#include "archive_stream_extractor.hpp"
+
+using namespace std;
+using namespace sword;
+
+#define TAR_BLOCK_SIZE 512
+#define ZIP_LOCAL_HEADER_SIZE 30
+#define ZIP_LOCAL_HEADER_SIGNATURE 0x04034b50
+#define ZIP_CENTRAL_HEADER_SIGNATURE 0x02014b50
+#define ZIP_END_OF_CENTRAL_DIR_SIGNATURE 0x06054b50
+#define ZIP_DATA_DESCRIPTOR_SIGNATURE 0x08074b50
+#define INFLATE_BUFFER_SIZE 65536
+
+static unsigned int getLittleEndian16(const string& buffer, unsigned int offset)
+{
+    return (unsigned int)(unsigned char)buffer[offset] |
+           ((unsigned int)(unsigned char)buffer[offset + 1] << 8);
+}
+
+static unsigned long getLittleEndian32(const string& buffer, unsigned int offset)
+{
+    return (unsigned long)(unsigned char)buffer[offset] |
+           ((unsigned long)(unsigned char)buffer[offset + 1] << 8) |
+           ((unsigned long)(unsigned char)buffer[offset + 2] << 16) |
+           ((unsigned long)(unsigned char)buffer[offset + 3] << 24);
+}
+
+static string getTarHeaderField(const string& header, unsigned int offset, unsigned int length)
+{
+    const char* field = header.c_str() + offset;
+    size_t fieldLength = 0;
+
+    while (fieldLength < length && field[fieldLength] != '\0') {
+        fieldLength++;
+    }
+
+    return string(field, fieldLength);
+}
+
+static unsigned long long getTarHeaderNumber(const string& header, unsigned int offset, unsigned int length)
+{
+    unsigned long long number = 0;
+
+    // GNU tar stores large numbers in base-256 encoding, which is marked by the highest bit of the first byte
+    if ((unsigned char)header[offset] & 0x80) {
+        for (unsigned int i = 1; i < length; i++) {
+            number = (number << 8) | (unsigned char)header[offset + i];
+        }
+
+        return number;
+    }
+
+    for (unsigned int i = 0; i < length; i++) {
+        char c = header[offset + i];
+
+        if (c >= '0' && c <= '7') {
+            number = (number << 3) | (unsigned long long)(c - '0');
+        } else if (c != ' ' || number != 0) {
+            break;
+        }
+    }
+
+    return number;
+}
+
+ArchiveStreamExtractor::ArchiveStreamExtractor(ArchiveFormat format, string destPath)
+    : _format(format), _destPath(destPath), _inflateBuffer(INFLATE_BUFFER_SIZE)
+{
+    memset(&this->_zStream, 0, sizeof(this->_zStream));
+
+    // tar.gz archives are inflated as one gzip stream (windowBits + 16),
+    // the entries of a zip archive are raw deflate streams (negative windowBits).
+    int windowBits = (format == ArchiveFormat::tarGz) ? (MAX_WBITS + 16) : -MAX_WBITS;
+
+    if (inflateInit2(&this->_zStream, windowBits) == Z_OK) {
+        this->_zStreamInitialized = true;
+    } else {
+        this->fail("Could not initialize zlib");
+    }
+}
+
+ArchiveStreamExtractor::~ArchiveStreamExtractor()
+{
+    this->closeOutputFile();
+
+    if (this->_zStreamInitialized) {
+        inflateEnd(&this->_zStream);
+    }
+}
+
+bool ArchiveStreamExtractor::write(const char* data, size_t length)
+{
+    if (this->_failed) {
+        return false;
+    }
+
+    if (this->_format == ArchiveFormat::zip) {
+        return this->writeZip(data, length);
+    } else {
+        return this->writeTarGz(data, length);
+    }
+}
+
+bool ArchiveStreamExtractor::finish()
+{
+    if (this->_failed) {
+        return false;
+    }
+
+    if (this->_format == ArchiveFormat::zip) {
+        // The central directory follows the last entry, so reaching it means that all entries have been received
+        if (this->_state != ParserState::complete) {
+            return this->fail("The zip archive is truncated");
+        }
+    } else {
+        // zlib has verified the CRC32 and length stored in the gzip trailer when the stream ended
+        if (!this->_gzipStreamEnded) {
+            return this->fail("The gzip stream is truncated");
+        }
+
+        if (this->_state != ParserState::complete &&
+            (this->_state != ParserState::header || !this->_headerBuffer.empty())) {
+
+            return this->fail("The tar archive is truncated");
+        }
+    }
+
+    this->closeOutputFile();
+    return true;
+}
+
+// ZIP
+
+bool ArchiveStreamExtractor::writeZip(const char* data, size_t length)
+{
+    size_t position = 0;
+
+    while (position < length && !this->_failed) {
+        const char* chunk = data + position;
+        size_t chunkLength = length - position;
+
+        switch (this->_state) {
+            case ParserState::header:
+            {
+                // The signature decides how many header bytes are needed
+                size_t requiredLength = (this->_headerBuffer.size() < 4) ? 4 : ZIP_LOCAL_HEADER_SIZE;
+                size_t copyLength = min(requiredLength - this->_headerBuffer.size(), chunkLength);
+                this->_headerBuffer.append(chunk, copyLength);
+                position += copyLength;
+
+                if (this->_headerBuffer.size() == requiredLength && !this->processZipHeader()) {
+                    return false;
+                }
+                break;
+            }
+
+            case ParserState::entryName:
+            {
+                size_t requiredLength = this->_zipNameLength + this->_zipExtraLength;
+                size_t copyLength = min(requiredLength - this->_headerBuffer.size(), chunkLength);
+                this->_headerBuffer.append(chunk, copyLength);
+                position += copyLength;
+
+                if (this->_headerBuffer.size() == requiredLength && !this->processZipEntryName()) {
+                    return false;
+                }
+                break;
+            }
+
+            case ParserState::entryData:
+            {
+                size_t consumed = 0;
+                if (!this->writeZipEntryData(chunk, chunkLength, consumed)) {
+                    return false;
+                }
+
+                position += consumed;
+                break;
+            }
+
+            case ParserState::dataDescriptor:
+            {
+                // The data descriptor signature is optional, so its first four bytes decide about the length
+                size_t requiredLength = 4;
+                if (this->_headerBuffer.size() >= 4) {
+                    bool hasSignature = (getLittleEndian32(this->_headerBuffer, 0) == ZIP_DATA_DESCRIPTOR_SIGNATURE);
+                    requiredLength = hasSignature ? 16 : 12;
+                }
+
+                size_t copyLength = min(requiredLength - this->_headerBuffer.size(), chunkLength);
+                this->_headerBuffer.append(chunk, copyLength);
+                position += copyLength;
+
+                if (this->_headerBuffer.size() == requiredLength && requiredLength > 4 && !this->processZipDataDescriptor()) {
+                    return false;
+                }
+                break;
+            }
+
+            default:
+                // The central directory is not needed, since all entries have already been extracted
+                return true;
+        }
+    }
+
+    return !this->_failed;
+}
+
+bool ArchiveStreamExtractor::processZipHeader()
+{
+    unsigned long signature = getLittleEndian32(this->_headerBuffer, 0);
+
+    if (signature == ZIP_CENTRAL_HEADER_SIGNATURE || signature == ZIP_END_OF_CENTRAL_DIR_SIGNATURE) {
+        this->_state = ParserState::complete;
+        this->_headerBuffer.clear();
+        return true;
+    }
+
+    if (signature != ZIP_LOCAL_HEADER_SIGNATURE) {
+        return this->fail("Invalid zip entry signature");
+    }
+
+    if (this->_headerBuffer.size() < ZIP_LOCAL_HEADER_SIZE) {
+        // Wait for the remaining header bytes
+        return true;
+    }
+
+    this->_zipFlags = getLittleEndian16(this->_headerBuffer, 6);
+    this->_zipMethod = getLittleEndian16(this->_headerBuffer, 8);
+    this->_zipExpectedCrc = getLittleEndian32(this->_headerBuffer, 14);
+    unsigned long compressedSize = getLittleEndian32(this->_headerBuffer, 18);
+    this->_zipExpectedSize = getLittleEndian32(this->_headerBuffer, 22);
+    this->_zipNameLength = getLittleEndian16(this->_headerBuffer, 26);
+    this->_zipExtraLength = getLittleEndian16(this->_headerBuffer, 28);
+
+    if (this->_zipFlags & 0x1) {
+        return this->fail("Encrypted zip entries are not supported");
+    }
+
+    if (this->_zipMethod != 0 && this->_zipMethod != Z_DEFLATED) {
+        return this->fail("Unsupported zip compression method " + to_string(this->_zipMethod));
+    }
+
+    if (compressedSize == 0xFFFFFFFF || this->_zipExpectedSize == 0xFFFFFFFF) {
+        return this->fail("zip64 archives are not supported");
+    }
+
+    // Stored entries are only delimited by the size in the local header
+    if (this->_zipMethod == 0 && (this->_zipFlags & 0x8)) {
+        return this->fail("Stored zip entries with data descriptor are not supported");
+    }
+
+    this->_entryRemaining = compressedSize;
+    this->_headerBuffer.clear();
+    this->_state = ParserState::entryName;
+
+    if (this->_zipNameLength + this->_zipExtraLength == 0) {
+        return this->fail("Invalid zip entry without name");
+    }
+
+    return true;
+}
+
+bool ArchiveStreamExtractor::processZipEntryName()
+{
+    this->_entryName = this->_headerBuffer.substr(0, this->_zipNameLength);
+    this->_headerBuffer.clear();
+    this->_entryWritten = 0;
+    this->_entryCrc = crc32(0L, Z_NULL, 0);
+
+    if (!this->isSafeEntryName(this->_entryName)) {
+        return this->fail("Unsafe entry name " + this->_entryName);
+    }
+
+    if (this->_entryName[this->_entryName.size() - 1] == '/') {
+        this->_entryKind = EntryKind::skip;
+        if (!this->createDirectory(this->_entryName)) {
+            return false;
+        }
+    } else {
+        this->_entryKind = EntryKind::file;
+        if (!this->openOutputFile(this->_entryName)) {
+            return false;
+        }
+    }
+
+    if (this->_zipMethod == Z_DEFLATED) {
+        inflateReset(&this->_zStream);
+    } else if (this->_entryRemaining == 0) {
+        return this->finishZipEntry();
+    }
+
+    this->_state = ParserState::entryData;
+    return true;
+}
+
+bool ArchiveStreamExtractor::writeZipEntryData(const char* data, size_t length, size_t& consumed)
+{
+    if (this->_zipMethod == 0) {
+        size_t copyLength = (size_t)min((unsigned long long)length, this->_entryRemaining);
+
+        if (!this->writeOutputFile(data, copyLength)) {
+            return false;
+        }
+
+        consumed = copyLength;
+        this->_entryRemaining -= copyLength;
+
+        if (this->_entryRemaining == 0) {
+            return this->finishZipEntry();
+        }
+
+        return true;
+    }
+
+    // Deflate streams are self-delimiting, so the compressed size is not needed (it is unknown with a data descriptor)
+    this->_zStream.next_in = (Bytef*)data;
+    this->_zStream.avail_in = (uInt)length;
+
+    for (;;) {
+        this->_zStream.next_out = (Bytef*)this->_inflateBuffer.data();
+        this->_zStream.avail_out = (uInt)this->_inflateBuffer.size();
+
+        int ret = inflate(&this->_zStream, Z_NO_FLUSH);
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+            return this->fail("Corrupt data in zip entry " + this->_entryName);
+        }
+
+        size_t producedLength = this->_inflateBuffer.size() - this->_zStream.avail_out;
+        if (producedLength > 0 && !this->writeOutputFile(this->_inflateBuffer.data(), producedLength)) {
+            return false;
+        }
+
+        if (ret == Z_STREAM_END) {
+            consumed = length - this->_zStream.avail_in;
+            return this->finishZipEntry();
+        }
+
+        if (this->_zStream.avail_in == 0 && this->_zStream.avail_out != 0) {
+            break;
+        }
+    }
+
+    consumed = length;
+    return true;
+}
+
+bool ArchiveStreamExtractor::finishZipEntry()
+{
+    this->_headerBuffer.clear();
+
+    if (this->_zipFlags & 0x8) {
+        this->_state = ParserState::dataDescriptor;
+        return true;
+    }
+
+    return this->processZipDataDescriptor();
+}
+
+bool ArchiveStreamExtractor::processZipDataDescriptor()
+{
+    unsigned long expectedCrc = this->_zipExpectedCrc;
+    unsigned long long expectedSize = this->_zipExpectedSize;
+
+    if (this->_zipFlags & 0x8) {
+        unsigned int offset = (getLittleEndian32(this->_headerBuffer, 0) == ZIP_DATA_DESCRIPTOR_SIGNATURE) ? 4 : 0;
+        expectedCrc = getLittleEndian32(this->_headerBuffer, offset);
+        expectedSize = getLittleEndian32(this->_headerBuffer, offset + 8);
+    }
+
+    this->_headerBuffer.clear();
+    this->closeOutputFile();
+
+    if (this->_entryKind == EntryKind::file) {
+        if (this->_entryCrc != expectedCrc || (this->_entryWritten & 0xFFFFFFFF) != expectedSize) {
+            return this->fail("Checksum mismatch in zip entry " + this->_entryName);
+        }
+
+        this->_extractedFiles.push_back(this->_entryName);
+    }
+
+    this->_state = ParserState::header;
+    return true;
+}
+
+// TAR.GZ
+
+bool ArchiveStreamExtractor::writeTarGz(const char* data, size_t length)
+{
+    this->_zStream.next_in = (Bytef*)data;
+    this->_zStream.avail_in = (uInt)length;
+
+    for (;;) {
+        if (this->_gzipStreamEnded) {
+            if (this->_zStream.avail_in == 0 || this->_state == ParserState::complete) {
+                // Trailing bytes after the end of the tar archive are ignored
+                break;
+            }
+
+            // Concatenated gzip members form a single stream
+            inflateReset(&this->_zStream);
+            this->_gzipStreamEnded = false;
+        }
+
+        this->_zStream.next_out = (Bytef*)this->_inflateBuffer.data();
+        this->_zStream.avail_out = (uInt)this->_inflateBuffer.size();
+
+        int ret = inflate(&this->_zStream, Z_NO_FLUSH);
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+            return this->fail("Corrupt gzip data");
+        }
+
+        size_t producedLength = this->_inflateBuffer.size() - this->_zStream.avail_out;
+        if (producedLength > 0 && !this->writeTar(this->_inflateBuffer.data(), producedLength)) {
+            return false;
+        }
+
+        if (ret == Z_STREAM_END) {
+            this->_gzipStreamEnded = true;
+        } else if (this->_zStream.avail_in == 0 && this->_zStream.avail_out != 0) {
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool ArchiveStreamExtractor::writeTar(const char* data, size_t length)
+{
+    size_t position = 0;
+
+    while (position < length && !this->_failed) {
+        const char* chunk = data + position;
+        size_t chunkLength = length - position;
+
+        switch (this->_state) {
+            case ParserState::header:
+            {
+                size_t copyLength = min(TAR_BLOCK_SIZE - this->_headerBuffer.size(), chunkLength);
+                this->_headerBuffer.append(chunk, copyLength);
+                position += copyLength;
+
+                if (this->_headerBuffer.size() == TAR_BLOCK_SIZE && !this->processTarHeader()) {
+                    return false;
+                }
+                break;
+            }
+
+            case ParserState::entryData:
+            {
+                size_t copyLength = (size_t)min((unsigned long long)chunkLength, this->_entryRemaining);
+
+                if (this->_entryKind == EntryKind::file) {
+                    if (!this->writeOutputFile(chunk, copyLength)) {
+                        return false;
+                    }
+                } else if (this->_entryKind == EntryKind::longName || this->_entryKind == EntryKind::paxHeader) {
+                    this->_entryContent.append(chunk, copyLength);
+                }
+
+                position += copyLength;
+                this->_entryRemaining -= copyLength;
+
+                if (this->_entryRemaining == 0) {
+                    this->finishTarEntry();
+                }
+                break;
+            }
+
+            case ParserState::entryPadding:
+            {
+                size_t skipLength = (size_t)min((unsigned long long)chunkLength, this->_entryPadding);
+                position += skipLength;
+                this->_entryPadding -= skipLength;
+
+                if (this->_entryPadding == 0) {
+                    this->_state = ParserState::header;
+                }
+                break;
+            }
+
+            default:
+                return true;
+        }
+    }
+
+    return !this->_failed;
+}
+
+bool ArchiveStreamExtractor::processTarHeader()
+{
+    string header = this->_headerBuffer;
+    this->_headerBuffer.clear();
+
+    bool isZeroBlock = true;
+    unsigned long checksum = 0;
+
+    for (unsigned int i = 0; i < TAR_BLOCK_SIZE; i++) {
+        unsigned char c = (unsigned char)header[i];
+
+        if (c != 0) {
+            isZeroBlock = false;
+        }
+
+        // The checksum field itself is counted as spaces
+        checksum += (i >= 148 && i < 156) ? ' ' : c;
+    }
+
+    if (isZeroBlock) {
+        // Two zero blocks mark the end of the archive
+        this->_zeroBlockCount++;
+        if (this->_zeroBlockCount >= 2) {
+            this->_state = ParserState::complete;
+        }
+
+        return true;
+    }
+
+    this->_zeroBlockCount = 0;
+
+    if (checksum != getTarHeaderNumber(header, 148, 8)) {
+        return this->fail("Invalid tar header checksum");
+    }
+
+    string entryName = getTarHeaderField(header, 0, 100);
+    if (header.compare(257, 5, "ustar") == 0) {
+        string prefix = getTarHeaderField(header, 345, 155);
+        if (!prefix.empty()) {
+            entryName = prefix + "/" + entryName;
+        }
+    }
+
+    if (!this->_longName.empty()) {
+        entryName = this->_longName;
+        this->_longName.clear();
+    }
+
+    char typeFlag = header[156];
+    this->_entryName = entryName;
+    this->_entryRemaining = getTarHeaderNumber(header, 124, 12);
+    this->_entryPadding = (TAR_BLOCK_SIZE - (this->_entryRemaining % TAR_BLOCK_SIZE)) % TAR_BLOCK_SIZE;
+    this->_entryContent.clear();
+    this->_entryWritten = 0;
+
+    if (typeFlag == '0' || typeFlag == '\0' || typeFlag == '7') {
+        if (!this->isSafeEntryName(entryName)) {
+            return this->fail("Unsafe entry name " + entryName);
+        }
+
+        this->_entryKind = EntryKind::file;
+        if (!this->openOutputFile(entryName)) {
+            return false;
+        }
+    } else if (typeFlag == '5') {
+        if (!this->isSafeEntryName(entryName)) {
+            return this->fail("Unsafe entry name " + entryName);
+        }
+
+        this->_entryKind = EntryKind::skip;
+        if (!this->createDirectory(entryName)) {
+            return false;
+        }
+    } else if (typeFlag == 'L') {
+        this->_entryKind = EntryKind::longName;
+    } else if (typeFlag == 'x') {
+        this->_entryKind = EntryKind::paxHeader;
+    } else {
+        // Links, devices and global pax headers are not extracted
+        this->_entryKind = EntryKind::skip;
+    }
+
+    if (this->_entryRemaining == 0) {
+        this->finishTarEntry();
+    } else {
+        this->_state = ParserState::entryData;
+    }
+
+    return true;
+}
+
+void ArchiveStreamExtractor::finishTarEntry()
+{
+    if (this->_entryKind == EntryKind::file) {
+        this->closeOutputFile();
+        this->_extractedFiles.push_back(this->_entryName);
+    } else if (this->_entryKind == EntryKind::longName) {
+        this->_longName = this->_entryContent.c_str();
+    } else if (this->_entryKind == EntryKind::paxHeader) {
+        // Pax records have the format "<length> <key>=<value>\n"
+        size_t position = 0;
+        while (position < this->_entryContent.size()) {
+            size_t space = this->_entryContent.find(' ', position);
+            if (space == string::npos) {
+                break;
+            }
+
+            unsigned long recordLength = strtoul(this->_entryContent.c_str() + position, 0, 10);
+            if (recordLength == 0 || position + recordLength > this->_entryContent.size()) {
+                break;
+            }
+
+            string record = this->_entryContent.substr(space + 1, position + recordLength - space - 2);
+            if (record.compare(0, 5, "path=") == 0) {
+                this->_longName = record.substr(5);
+            }
+
+            position += recordLength;
+        }
+    }
+
+    this->_entryContent.clear();
+    this->_state = (this->_entryPadding > 0) ? ParserState::entryPadding : ParserState::header;
+}
+
+// OUTPUT
+
+bool ArchiveStreamExtractor::openOutputFile(const string& entryName)
+{
+    this->closeOutputFile();
+
+    string filePath = this->_destPath + "/" + entryName;
+    FileMgr::createParent(filePath.c_str());
+
+    this->_outputFile = this->_fileSystemHelper.openFile(filePath, true);
+    if (this->_outputFile < 0) {
+        return this->fail("Could not create " + filePath);
+    }
+
+    return true;
+}
+
+bool ArchiveStreamExtractor::writeOutputFile(const char* data, size_t length)
+{
+    if (length == 0) {
+        return true;
+    }
+
+    if (this->_outputFile < 0) {
+        // Directory entries carry no data
+        return true;
+    }
+
+    if (!this->_fileSystemHelper.writeFile(this->_outputFile, data, (long)length)) {
+        return this->fail("Could not write " + this->_entryName);
+    }
+
+    this->_entryCrc = crc32(this->_entryCrc, (const Bytef*)data, (uInt)length);
+    this->_entryWritten += length;
+    this->_extractedBytes += length;
+    return true;
+}
+
+void ArchiveStreamExtractor::closeOutputFile()
+{
+    if (this->_outputFile >= 0) {
+        this->_fileSystemHelper.closeFile(this->_outputFile);
+        this->_outputFile = -1;
+    }
+}
+
+bool ArchiveStreamExtractor::createDirectory(const string& entryName)
+{
+    string dummyPath = this->_destPath + "/" + entryName + "/dummy";
+    FileMgr::createParent(dummyPath.c_str());
+    return true;
+}
+
+bool ArchiveStreamExtractor::isSafeEntryName(const string& entryName)
+{
+    if (entryName.empty() || entryName[0] == '/' || entryName[0] == '\\' || entryName.find(':') != string::npos) {
+        return false;
+    }
+
+    size_t start = 0;
+    while (start <= entryName.size()) {
+        size_t end = entryName.find_first_of("/\\", start);
+        if (end == string::npos) {
+            end = entryName.size();
+        }
+
+        if (entryName.compare(start, end - start, "..") == 0) {
+            return false;
+        }
+
+        start = end + 1;
+    }
+
+    return true;
+}
+
+bool ArchiveStreamExtractor::fail(const string& error)
+{
+    if (!this->_failed) {
+        this->_failed = true;
+        this->_lastError = error;
+        cerr << "Archive extraction failed: " << error << endl;
+    }
+
+    this->closeOutputFile();
+    return false;
+}
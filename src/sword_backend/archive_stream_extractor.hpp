@@ -0,0 +1,138 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+
+#ifndef _ARCHIVE_STREAM_EXTRACTOR
+#define _ARCHIVE_STREAM_EXTRACTOR
+
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+#include "file_system_helper.hpp"
+
+enum class ArchiveFormat {
+    zip,
+    tarGz
+};
+
+/**
+ * The ArchiveStreamExtractor unpacks a zip or tar.gz archive while its bytes arrive, e.g. from a download.
+ *
+ * The archive is consumed in chunks of arbitrary size and every entry is decompressed and written to the
+ * destination directory immediately, so that the archive itself never has to be stored on disk.
+ * The integrity of the archive is checked while extracting (CRC32 of every zip entry, gzip trailer,
+ * tar header checksums). finish() only succeeds if the archive was complete.
+ *
+ * Entries with absolute paths or parent directory references are rejected. Links and other special
+ * tar entries are skipped.
+ */
+class ArchiveStreamExtractor {
+public:
+    ArchiveStreamExtractor(ArchiveFormat format, std::string destPath);
+    virtual ~ArchiveStreamExtractor();
+
+    // Consumes the next chunk of the archive. Returns false as soon as the archive is found to be invalid.
+    bool write(const char* data, size_t length);
+
+    // Must be called after the last chunk. Returns true if the archive was complete and valid.
+    bool finish();
+
+    // The relative paths of the regular files that have been written
+    const std::vector<std::string>& getExtractedFiles() const { return this->_extractedFiles; }
+    unsigned long long getExtractedBytes() const { return this->_extractedBytes; }
+    const std::string& getLastError() const { return this->_lastError; }
+
+    // Returns false for entry names that would be written outside of the destination directory (absolute paths, drive letters, ..)
+    static bool isSafeEntryName(const std::string& entryName);
+
+private:
+    enum class EntryKind {
+        file,
+        longName,
+        paxHeader,
+        skip
+    };
+
+    enum class ParserState {
+        header,
+        entryName,
+        entryData,
+        entryPadding,
+        dataDescriptor,
+        complete
+    };
+
+    bool writeZip(const char* data, size_t length);
+    bool processZipHeader();
+    bool processZipEntryName();
+    bool writeZipEntryData(const char* data, size_t length, size_t& consumed);
+    bool finishZipEntry();
+    bool processZipDataDescriptor();
+
+    bool writeTarGz(const char* data, size_t length);
+    bool writeTar(const char* data, size_t length);
+    bool processTarHeader();
+    void finishTarEntry();
+
+    bool openOutputFile(const std::string& entryName);
+    bool writeOutputFile(const char* data, size_t length);
+    void closeOutputFile();
+    bool createDirectory(const std::string& entryName);
+    bool fail(const std::string& error);
+
+    ArchiveFormat _format;
+    std::string _destPath;
+    std::vector<std::string> _extractedFiles;
+    unsigned long long _extractedBytes = 0;
+    std::string _lastError;
+    bool _failed = false;
+
+    ParserState _state = ParserState::header;
+    std::string _headerBuffer;
+    std::string _entryName;
+    EntryKind _entryKind = EntryKind::skip;
+    std::string _entryContent;
+    unsigned long long _entryRemaining = 0;
+    unsigned long long _entryPadding = 0;
+    unsigned long long _entryWritten = 0;
+    unsigned long _entryCrc = 0;
+
+    // zip entry header fields
+    unsigned int _zipFlags = 0;
+    unsigned int _zipMethod = 0;
+    unsigned long _zipExpectedCrc = 0;
+    unsigned long long _zipExpectedSize = 0;
+    unsigned int _zipNameLength = 0;
+    unsigned int _zipExtraLength = 0;
+
+    // tar state
+    std::string _longName;
+    unsigned int _zeroBlockCount = 0;
+
+    z_stream _zStream;
+    bool _zStreamInitialized = false;
+    bool _gzipStreamEnded = false;
+    std::vector<char> _inflateBuffer;
+
+    // The output is written with a plain file descriptor, since the global FileMgr of SWORD is not thread-safe
+    FileSystemHelper _fileSystemHelper;
+    int _outputFile = -1;
+};
+
+#endif // _ARCHIVE_STREAM_EXTRACTOR
@@ -20,6 +20,7 @@
 #define _COMMON_DEFS
 
 #include <string>
+#include <vector>
 
 enum class QueryLimit {
     none,
@@ -47,4 +48,25 @@ public:
     std::string content;
 };
 
+// A search hit in a dictionary or commentary module
+class EntrySearchResult
+{
+public:
+    EntrySearchResult() {};
+    virtual ~EntrySearchResult() {};
+
+    // The dictionary key or the first verse of the commentary entry
+    std::string key;
+    // The last verse of a commentary entry that is linked to several verses (otherwise equal to key)
+    std::string endKey;
+    std::string content;
+};
+
+class EntrySearchPage
+{
+public:
+    unsigned int totalCount = 0;
+    std::vector<EntrySearchResult> results;
+};
+
 #endif // _COMMON_DEFS
\ No newline at end of file
@@ -67,3 +67,79 @@ std::vector<std::string> DictHelper::getKeyList(std::string moduleName)
 
     return keyList;
 }
+
+DictKeyPage DictHelper::getKeysWithPrefix(std::string moduleName, std::string prefix, unsigned int startIndex, unsigned int maxCount)
+{
+    sword::SWLD* module = this->getDictModule(moduleName);
+
+    if (module == 0) {
+        return DictKeyPage();
+    }
+
+    shared_ptr<DictKeyIndex> keyIndex = this->_keyIndexCache.getIndex(module);
+
+    if (!keyIndex) {
+        // The index is not available yet
+        return DictKeyIndex::scanKeysWithPrefix(module, prefix, startIndex, maxCount);
+    }
+
+    return keyIndex->getKeysWithPrefix(prefix, startIndex, maxCount);
+}
+
+DictKeyPage DictHelper::getKeysInRange(std::string moduleName, std::string fromKey, std::string toKey, unsigned int startIndex, unsigned int maxCount)
+{
+    sword::SWLD* module = this->getDictModule(moduleName);
+
+    if (module == 0) {
+        return DictKeyPage();
+    }
+
+    shared_ptr<DictKeyIndex> keyIndex = this->_keyIndexCache.getIndex(module);
+
+    if (!keyIndex) {
+        // The index is not available yet
+        return DictKeyIndex::scanKeysInRange(module, fromKey, toKey, startIndex, maxCount);
+    }
+
+    return keyIndex->getKeysInRange(fromKey, toKey, startIndex, maxCount);
+}
+
+std::string DictHelper::findKey(std::string moduleName, std::string key)
+{
+    sword::SWLD* module = this->getDictModule(moduleName);
+
+    if (module == 0) {
+        return "";
+    }
+
+    shared_ptr<DictKeyIndex> keyIndex = this->_keyIndexCache.getIndex(module);
+
+    if (!keyIndex) {
+        // The index is not available yet
+        return DictKeyIndex::scanForKey(module, key);
+    }
+
+    return keyIndex->findKey(key);
+}
+
+sword::SWLD* DictHelper::getDictModule(std::string moduleName)
+{
+    if (moduleName.size() == 0) {
+        cerr << "getDictModule: Cannot work with empty moduleName!" << endl;
+        return 0;
+    }
+
+    SWModule* module = this->_moduleStore.getLocalModule(moduleName);
+
+    if (module == 0) {
+        cerr << "getLocalModule returned zero pointer for " << moduleName << endl;
+        return 0;
+    }
+
+    if (strcmp(module->getType(), "Lexicons / Dictionaries") != 0) {
+        cerr << "Given module is not a lexicon/dictionary!" << endl;
+        return 0;
+    }
+
+    return static_cast<sword::SWLD*>(module);
+}
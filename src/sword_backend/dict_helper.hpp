@@ -23,17 +23,31 @@
 #include <vector>
 
 #include "module_store.hpp"
+#include "dict_key_index.hpp"
+
+namespace sword {
+    class SWLD;
+};
 
 class DictHelper {
 public:
-    DictHelper(ModuleStore& moduleStore) : _moduleStore(moduleStore) {}
+    DictHelper(ModuleStore& moduleStore, DictKeyIndexCache& keyIndexCache) : _moduleStore(moduleStore), _keyIndexCache(keyIndexCache) {}
 
     std::vector<std::string> getKeyList(std::string moduleName);
 
+    // The following functions use the sorted key index of the module and match keys case-insensitively.
+    // A maxCount of 0 returns all keys starting at startIndex.
+    DictKeyPage getKeysWithPrefix(std::string moduleName, std::string prefix, unsigned int startIndex, unsigned int maxCount);
+    DictKeyPage getKeysInRange(std::string moduleName, std::string fromKey, std::string toKey, unsigned int startIndex, unsigned int maxCount);
+    std::string findKey(std::string moduleName, std::string key);
+
     virtual ~DictHelper(){}
 
 private:
+    sword::SWLD* getDictModule(std::string moduleName);
+
     ModuleStore& _moduleStore;
+    DictKeyIndexCache& _keyIndexCache;
 };
 
 #endif // _DICT_HELPER
\ No newline at end of file
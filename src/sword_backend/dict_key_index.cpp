@@ -0,0 +1,451 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+// Std includes
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+// Sword includes
+#include <swmodule.h>
+#include <swld.h>
+
+// Own includes
+#include "dict_key_index.hpp"
+#include "string_helper.hpp"
+#include "module_store.hpp"
+#include "thread_pool.hpp"
+#include "sword_file_lock.hpp"
+
+using namespace std;
+using namespace sword;
+
+// Layout of the index file (integers in native byte order):
+//
+// Header:    "NSDK", uint32 format version, module version, uint32 key count
+// Positions: uint32 record offset for every key, sorted by the case-folded key (byte-wise)
+// Records:   case-folded key, original key
+//
+// Strings are stored as uint32 length followed by the string data.
+
+#define DICT_KEY_INDEX_MAGIC "NSDK"
+#define DICT_KEY_INDEX_VERSION 1
+
+DictKeyIndex::DictKeyIndex(string indexFilePath, string moduleVersion)
+    : _indexFilePath(indexFilePath), _moduleVersion(moduleVersion)
+{
+}
+
+bool DictKeyIndex::open()
+{
+    if (!this->_mappedFile.open(this->_indexFilePath)) {
+        return false;
+    }
+
+    const char* data = this->_mappedFile.getData();
+    unsigned long long size = this->_mappedFile.getSize();
+    unsigned int formatVersion = 0;
+    unsigned int versionLength = 0;
+    bool valid = (size >= 12 && memcmp(data, DICT_KEY_INDEX_MAGIC, 4) == 0);
+
+    if (valid) {
+        memcpy(&formatVersion, data + 4, 4);
+        memcpy(&versionLength, data + 8, 4);
+
+        valid = (formatVersion == DICT_KEY_INDEX_VERSION &&
+                 12ULL + versionLength + 4 <= size &&
+                 string(data + 12, versionLength) == this->_moduleVersion);
+    }
+
+    if (valid) {
+        memcpy(&this->_keyCount, data + 12 + versionLength, 4);
+        this->_positionsOffset = 12ULL + versionLength + 4;
+        valid = (this->_positionsOffset + (unsigned long long)this->_keyCount * 4 <= size);
+    }
+
+    if (!valid) {
+        // Indexes of other module versions are replaced with the next build
+        this->_mappedFile.close();
+        this->_keyCount = 0;
+        return false;
+    }
+
+    this->_ready.store(true);
+    return true;
+}
+
+vector<pair<string, string>> DictKeyIndex::readSortedKeys(SWLD* module, std::function<bool(const string& foldedKey)> filter)
+{
+    long entryCount = 0;
+    vector<pair<string, string>> keys;
+
+    {
+        SwordFileLock fileLock;
+        entryCount = module->getEntryCount();
+    }
+
+    // The file lock is taken for every key, so that a build in the background does not block the API calls
+    for (long i = 0; i < entryCount; i++) {
+        string stringKey;
+
+        {
+            SwordFileLock fileLock;
+            const char* key = module->getKeyForEntry(i);
+
+            if (key == 0) {
+                continue;
+            }
+
+            stringKey = string(key);
+        }
+
+        string foldedKey = StringHelper::foldCase(stringKey);
+
+        if (filter(foldedKey)) {
+            keys.push_back(make_pair(foldedKey, stringKey));
+        }
+    }
+
+    // The folded keys are compared byte-wise, like the binary search on the mapped file does it
+    sort(keys.begin(), keys.end());
+    return keys;
+}
+
+bool DictKeyIndex::build(SWLD* module)
+{
+    if (module == 0) {
+        return false;
+    }
+
+    vector<pair<string, string>> keys = DictKeyIndex::readSortedKeys(module, [](const string&) { return true; });
+
+    vector<char> index;
+
+    auto appendUInt32 = [&index](unsigned int value) {
+        index.insert(index.end(), (const char*)&value, (const char*)&value + 4);
+    };
+
+    auto appendString = [&index, &appendUInt32](const string& value) {
+        appendUInt32((unsigned int)value.size());
+        index.insert(index.end(), value.begin(), value.end());
+    };
+
+    index.insert(index.end(), DICT_KEY_INDEX_MAGIC, DICT_KEY_INDEX_MAGIC + 4);
+    appendUInt32(DICT_KEY_INDEX_VERSION);
+    appendString(this->_moduleVersion);
+    appendUInt32((unsigned int)keys.size());
+
+    unsigned long long positionsOffset = index.size();
+    index.resize(index.size() + keys.size() * 4);
+
+    for (unsigned int i = 0; i < keys.size(); i++) {
+        unsigned int recordOffset = (unsigned int)index.size();
+        memcpy(&index[positionsOffset + (unsigned long long)i * 4], &recordOffset, 4);
+
+        appendString(keys[i].first);
+        appendString(keys[i].second);
+    }
+
+    // The current mapping refers to the file that is replaced
+    this->_mappedFile.close();
+
+    if (!MappedFile::writeFile(this->_indexFilePath, index)) {
+        return false;
+    }
+
+    return this->open();
+}
+
+bool DictKeyIndex::getRecord(unsigned int position, const char*& foldedKey, unsigned int& foldedKeyLength, string* key)
+{
+    const char* data = this->_mappedFile.getData();
+    unsigned long long size = this->_mappedFile.getSize();
+    unsigned int recordOffset = 0;
+    unsigned int keyLength = 0;
+
+    memcpy(&recordOffset, data + this->_positionsOffset + (unsigned long long)position * 4, 4);
+
+    if ((unsigned long long)recordOffset + 4 > size) {
+        return false;
+    }
+
+    memcpy(&foldedKeyLength, data + recordOffset, 4);
+    foldedKey = data + recordOffset + 4;
+
+    unsigned long long keyOffset = (unsigned long long)recordOffset + 4 + foldedKeyLength;
+
+    if (keyOffset + 4 > size) {
+        return false;
+    }
+
+    if (key != 0) {
+        memcpy(&keyLength, data + keyOffset, 4);
+
+        if (keyOffset + 4 + keyLength > size) {
+            return false;
+        }
+
+        key->assign(data + keyOffset + 4, keyLength);
+    }
+
+    return true;
+}
+
+int DictKeyIndex::compareFoldedKey(unsigned int position, const string& foldedKey, bool prefixOnly)
+{
+    const char* recordKey = 0;
+    unsigned int recordKeyLength = 0;
+
+    if (!this->getRecord(position, recordKey, recordKeyLength)) {
+        cerr << "DictKeyIndex: Invalid record at position " << position << " in " << this->_indexFilePath << endl;
+        return 0;
+    }
+
+    if (prefixOnly && recordKeyLength > foldedKey.size()) {
+        recordKeyLength = (unsigned int)foldedKey.size();
+    }
+
+    // Same ordering as std::string, which the index was sorted with
+    int result = string::traits_type::compare(recordKey, foldedKey.c_str(), min((size_t)recordKeyLength, foldedKey.size()));
+
+    if (result == 0) {
+        result = (int)(recordKeyLength > foldedKey.size()) - (int)(recordKeyLength < foldedKey.size());
+    }
+
+    return result;
+}
+
+unsigned int DictKeyIndex::lowerBound(const string& foldedKey)
+{
+    unsigned int begin = 0;
+    unsigned int end = this->_keyCount;
+
+    while (begin < end) {
+        unsigned int middle = begin + (end - begin) / 2;
+
+        if (this->compareFoldedKey(middle, foldedKey) < 0) {
+            begin = middle + 1;
+        } else {
+            end = middle;
+        }
+    }
+
+    return begin;
+}
+
+unsigned int DictKeyIndex::upperBound(const string& foldedKey)
+{
+    unsigned int begin = 0;
+    unsigned int end = this->_keyCount;
+
+    while (begin < end) {
+        unsigned int middle = begin + (end - begin) / 2;
+
+        if (this->compareFoldedKey(middle, foldedKey) <= 0) {
+            begin = middle + 1;
+        } else {
+            end = middle;
+        }
+    }
+
+    return begin;
+}
+
+unsigned int DictKeyIndex::prefixUpperBound(const string& foldedPrefix)
+{
+    unsigned int begin = 0;
+    unsigned int end = this->_keyCount;
+
+    while (begin < end) {
+        unsigned int middle = begin + (end - begin) / 2;
+
+        if (this->compareFoldedKey(middle, foldedPrefix, true) <= 0) {
+            begin = middle + 1;
+        } else {
+            end = middle;
+        }
+    }
+
+    return begin;
+}
+
+DictKeyPage DictKeyIndex::getPage(unsigned int begin, unsigned int end, unsigned int startIndex, unsigned int maxCount)
+{
+    DictKeyPage page;
+
+    if (end <= begin) {
+        return page;
+    }
+
+    page.totalCount = end - begin;
+
+    if (startIndex >= page.totalCount) {
+        return page;
+    }
+
+    unsigned int pageEnd = end;
+    if (maxCount > 0 && maxCount < page.totalCount - startIndex) {
+        pageEnd = begin + startIndex + maxCount;
+    }
+
+    for (unsigned int position = begin + startIndex; position < pageEnd; position++) {
+        const char* foldedKey = 0;
+        unsigned int foldedKeyLength = 0;
+        string key;
+
+        if (this->getRecord(position, foldedKey, foldedKeyLength, &key)) {
+            page.keys.push_back(key);
+        }
+    }
+
+    return page;
+}
+
+DictKeyPage DictKeyIndex::getKeysWithPrefix(string prefix, unsigned int startIndex, unsigned int maxCount)
+{
+    if (!this->_mappedFile.isOpen()) {
+        return DictKeyPage();
+    }
+
+    string foldedPrefix = StringHelper::foldCase(prefix);
+    unsigned int begin = this->lowerBound(foldedPrefix);
+    unsigned int end = this->prefixUpperBound(foldedPrefix);
+
+    return this->getPage(begin, end, startIndex, maxCount);
+}
+
+DictKeyPage DictKeyIndex::getKeysInRange(string fromKey, string toKey, unsigned int startIndex, unsigned int maxCount)
+{
+    if (!this->_mappedFile.isOpen()) {
+        return DictKeyPage();
+    }
+
+    unsigned int begin = this->lowerBound(StringHelper::foldCase(fromKey));
+    unsigned int end = this->_keyCount;
+
+    if (toKey.size() > 0) {
+        end = this->upperBound(StringHelper::foldCase(toKey));
+    }
+
+    return this->getPage(begin, end, startIndex, maxCount);
+}
+
+string DictKeyIndex::findKey(string key)
+{
+    if (!this->_mappedFile.isOpen()) {
+        return "";
+    }
+
+    string foldedKey = StringHelper::foldCase(key);
+    unsigned int position = this->lowerBound(foldedKey);
+
+    if (position >= this->_keyCount || this->compareFoldedKey(position, foldedKey) != 0) {
+        return "";
+    }
+
+    const char* recordKey = 0;
+    unsigned int recordKeyLength = 0;
+    string originalKey;
+
+    this->getRecord(position, recordKey, recordKeyLength, &originalKey);
+    return originalKey;
+}
+
+DictKeyPage DictKeyIndex::getScanPage(const vector<pair<string, string>>& keys, unsigned int startIndex, unsigned int maxCount)
+{
+    DictKeyPage page;
+    page.totalCount = (unsigned int)keys.size();
+
+    for (unsigned int i = startIndex; i < keys.size() && (maxCount == 0 || i - startIndex < maxCount); i++) {
+        page.keys.push_back(keys[i].second);
+    }
+
+    return page;
+}
+
+DictKeyPage DictKeyIndex::scanKeysWithPrefix(SWLD* module, string prefix, unsigned int startIndex, unsigned int maxCount)
+{
+    string foldedPrefix = StringHelper::foldCase(prefix);
+
+    vector<pair<string, string>> keys = DictKeyIndex::readSortedKeys(module, [&foldedPrefix](const string& foldedKey) {
+        return (foldedKey.compare(0, foldedPrefix.size(), foldedPrefix) == 0);
+    });
+
+    return DictKeyIndex::getScanPage(keys, startIndex, maxCount);
+}
+
+DictKeyPage DictKeyIndex::scanKeysInRange(SWLD* module, string fromKey, string toKey, unsigned int startIndex, unsigned int maxCount)
+{
+    string foldedFromKey = StringHelper::foldCase(fromKey);
+    string foldedToKey = StringHelper::foldCase(toKey);
+
+    vector<pair<string, string>> keys = DictKeyIndex::readSortedKeys(module, [&](const string& foldedKey) {
+        return (foldedKey >= foldedFromKey && (toKey.size() == 0 || foldedKey <= foldedToKey));
+    });
+
+    return DictKeyIndex::getScanPage(keys, startIndex, maxCount);
+}
+
+string DictKeyIndex::scanForKey(SWLD* module, string key)
+{
+    string foldedKey = StringHelper::foldCase(key);
+
+    vector<pair<string, string>> keys = DictKeyIndex::readSortedKeys(module, [&foldedKey](const string& currentFoldedKey) {
+        return (currentFoldedKey == foldedKey);
+    });
+
+    return keys.empty() ? "" : keys[0].second;
+}
+
+shared_ptr<DictKeyIndex> DictKeyIndexCache::getIndex(sword::SWLD* module)
+{
+    lock_guard<mutex> lock(this->_indexesMutex);
+
+    string moduleName = string(module->getName());
+    const char* moduleVersion = module->getConfigEntry("Version");
+    string currentVersion = (moduleVersion != 0) ? string(moduleVersion) : "";
+    shared_ptr<DictKeyIndex>& keyIndex = this->_indexes[moduleName];
+
+    // An index that is still being built or could not be built is kept as well, so that the build is not repeated
+    if (keyIndex && keyIndex->getModuleVersion() == currentVersion) {
+        return keyIndex->isReady() ? keyIndex : shared_ptr<DictKeyIndex>();
+    }
+
+    string indexFilePath = this->_moduleStore.getUserSwordDir() + "/." + moduleName + ".keys";
+    keyIndex = make_shared<DictKeyIndex>(indexFilePath, currentVersion);
+
+    if (keyIndex->open()) {
+        return keyIndex;
+    }
+
+    // The build reads all keys of the module. Like the Strong's tables, it runs in the background on a module of a leased SWMgr.
+    shared_ptr<DictKeyIndex> pendingIndex = keyIndex;
+    ModuleStore& moduleStore = this->_moduleStore;
+
+    ThreadPool::getInstance().submit<void>(TaskPriority::indexing, [pendingIndex, &moduleStore, moduleName]() {
+        SwordMgrLease lease = moduleStore.acquireMgr();
+        SWModule* module = lease.getModule(moduleName);
+        SWLD* dictModule = (module != 0 && strcmp(module->getType(), "Lexicons / Dictionaries") == 0) ? static_cast<SWLD*>(module) : 0;
+
+        if (!pendingIndex->build(dictModule)) {
+            cerr << "Could not build the key index of " << moduleName << endl;
+        }
+    });
+
+    return shared_ptr<DictKeyIndex>();
+}
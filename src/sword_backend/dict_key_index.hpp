@@ -0,0 +1,127 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef _DICT_KEY_INDEX
+#define _DICT_KEY_INDEX
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
+
+#include "mapped_file.hpp"
+
+namespace sword {
+    class SWLD;
+};
+
+class ModuleStore;
+
+// A page of dictionary keys and the number of keys matching the query
+class DictKeyPage {
+public:
+    unsigned int totalCount = 0;
+    std::vector<std::string> keys;
+};
+
+/**
+ * A sorted index of the keys of a dictionary module (SWLD), which supports case-insensitive prefix and range queries.
+ *
+ * The index is built once per module version and stored as a file that is memory-mapped when it is opened.
+ * The keys are sorted by their case-folded form (see StringHelper::foldCase) and queries use a binary search
+ * on the mapped file, so only the keys of the requested page are copied.
+ *
+ * The build may run on another thread. The index must not be queried before isReady() returns true.
+ * Until then, the static scan functions answer the same queries directly from the module.
+ */
+class DictKeyIndex {
+public:
+    DictKeyIndex(std::string indexFilePath, std::string moduleVersion);
+    virtual ~DictKeyIndex() {}
+
+    // Opens an existing index file of the module version
+    bool open();
+
+    // Builds the index file from the given module and opens it
+    bool build(sword::SWLD* module);
+
+    bool isReady() const { return this->_ready.load(); }
+    std::string getModuleVersion() const { return this->_moduleVersion; }
+    unsigned int getKeyCount() const { return this->_keyCount; }
+
+    DictKeyPage getKeysWithPrefix(std::string prefix, unsigned int startIndex, unsigned int maxCount);
+
+    // Returns the keys between fromKey and toKey (both inclusive). An empty toKey means up to the last key.
+    DictKeyPage getKeysInRange(std::string fromKey, std::string toKey, unsigned int startIndex, unsigned int maxCount);
+
+    // Returns the original key that matches the given key case-insensitively or an empty string
+    std::string findKey(std::string key);
+
+    // Same queries as above, answered by reading all keys of the module
+    static DictKeyPage scanKeysWithPrefix(sword::SWLD* module, std::string prefix, unsigned int startIndex, unsigned int maxCount);
+    static DictKeyPage scanKeysInRange(sword::SWLD* module, std::string fromKey, std::string toKey, unsigned int startIndex, unsigned int maxCount);
+    static std::string scanForKey(sword::SWLD* module, std::string key);
+
+private:
+    // Returns the pairs of case-folded and original key of the module, sorted like the index
+    static std::vector<std::pair<std::string, std::string>> readSortedKeys(sword::SWLD* module,
+                                                                           std::function<bool(const std::string& foldedKey)> filter);
+    static DictKeyPage getScanPage(const std::vector<std::pair<std::string, std::string>>& keys, unsigned int startIndex, unsigned int maxCount);
+
+    // Positions refer to the sorted keys. The upper bound functions return the first position after the matching keys.
+    unsigned int lowerBound(const std::string& foldedKey);
+    unsigned int upperBound(const std::string& foldedKey);
+    unsigned int prefixUpperBound(const std::string& foldedPrefix);
+    DictKeyPage getPage(unsigned int begin, unsigned int end, unsigned int startIndex, unsigned int maxCount);
+
+    bool getRecord(unsigned int position, const char*& foldedKey, unsigned int& foldedKeyLength, std::string* key=0);
+    int compareFoldedKey(unsigned int position, const std::string& foldedKey, bool prefixOnly=false);
+
+    std::string _indexFilePath;
+    std::string _moduleVersion;
+    unsigned int _keyCount = 0;
+    unsigned long long _positionsOffset = 0;
+    MappedFile _mappedFile;
+    std::atomic<bool> _ready{false};
+};
+
+/**
+ * The key indexes of all dictionary modules of a module store.
+ *
+ * Like the StrongsTableCache, there must only be one cache per module store (the SharedBackend owns it),
+ * so that every index is only built once.
+ */
+class DictKeyIndexCache {
+public:
+    DictKeyIndexCache(ModuleStore& moduleStore) : _moduleStore(moduleStore) {}
+    virtual ~DictKeyIndexCache() {}
+
+    // Returns the key index of the module. If there is no index for the module version yet, it is built
+    // in the background and an empty pointer is returned until it is ready.
+    std::shared_ptr<DictKeyIndex> getIndex(sword::SWLD* module);
+
+private:
+    ModuleStore& _moduleStore;
+    std::map<std::string, std::shared_ptr<DictKeyIndex>> _indexes;
+    std::mutex _indexesMutex;
+};
+
+#endif // _DICT_KEY_INDEX
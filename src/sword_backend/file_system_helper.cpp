@@ -42,12 +42,21 @@
 #include <sstream>
 #include <vector>
 
-#include <zipcomprs.h>
+#include <thread>
+#include <future>
+#include <atomic>
+#include <mutex>
+
 #include "unzip/unzip.h"
 #include <filemgr.h>
 #include <fcntl.h>
 
 #include "file_system_helper.hpp"
+#include "archive_stream_extractor.hpp"
+#include "thread_pool.hpp"
+
+// Large blocks keep the number of read and write calls low when extracting big module files
+#define EXTRACTION_BUFFER_SIZE (1024 * 1024)
 
 using namespace std;
 
@@ -257,6 +266,86 @@ bool FileSystemHelper::fileExists(string fileName)
     return exists;
 }
 
+int FileSystemHelper::openFile(string filePath, bool forWriting, bool append)
+{
+    int flags = O_RDONLY;
+
+    if (forWriting) {
+        flags = O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC);
+    }
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__ANDROID__)
+    return open(filePath.c_str(), flags, 0644);
+#elif _WIN32
+    wstring wFilePath = this->convertUtf8StringToUtf16(filePath);
+
+    return _wopen(wFilePath.c_str(), flags | O_BINARY, _S_IREAD | _S_IWRITE);
+#endif
+}
+
+long FileSystemHelper::readFile(int fd, char* buffer, long size)
+{
+#if defined(__linux__) || defined(__APPLE__) || defined(__ANDROID__)
+    return (long)read(fd, buffer, (size_t)size);
+#elif _WIN32
+    return (long)_read(fd, buffer, (unsigned int)size);
+#endif
+}
+
+bool FileSystemHelper::writeFile(int fd, const char* data, long size)
+{
+    // Like FileMgr::write, partial writes are continued until all data is written
+    while (size > 0) {
+#if defined(__linux__) || defined(__APPLE__) || defined(__ANDROID__)
+        long writtenBytes = (long)write(fd, data, (size_t)size);
+#elif _WIN32
+        long writtenBytes = (long)_write(fd, data, (unsigned int)size);
+#endif
+
+        if (writtenBytes <= 0) {
+            return false;
+        }
+
+        data += writtenBytes;
+        size -= writtenBytes;
+    }
+
+    return true;
+}
+
+void FileSystemHelper::closeFile(int fd)
+{
+    if (fd < 0) {
+        return;
+    }
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__ANDROID__)
+    close(fd);
+#elif _WIN32
+    _close(fd);
+#endif
+}
+
+long long FileSystemHelper::getFileSize(string filePath)
+{
+#if defined(__linux__) || defined(__APPLE__) || defined(__ANDROID__)
+    struct stat fileStat;
+
+    if (stat(filePath.c_str(), &fileStat) != 0) {
+        return -1;
+    }
+#elif _WIN32
+    wstring wFilePath = this->convertUtf8StringToUtf16(filePath);
+    struct _stat64 fileStat;
+
+    if (_wstat64(wFilePath.c_str(), &fileStat) != 0) {
+        return -1;
+    }
+#endif
+
+    return (long long)fileStat.st_size;
+}
+
 int FileSystemHelper::makeDirectory(string dirName)
 {
 #if defined(__linux__) || defined(__APPLE__) || defined(__ANDROID__)
@@ -409,31 +498,67 @@ void FileSystemHelper::removeDir(std::string dirName)
 #endif
 #endif
 
-bool FileSystemHelper::unTarGZ(std::string filePath, std::string destPath)
+bool FileSystemHelper::unTarGZ(std::string filePath,
+                               std::string destPath,
+                               std::function<void(unsigned long long totalBytes, unsigned long long completedBytes)>* progressCallback)
 {
-    sword::FileDesc* fd = sword::FileMgr::getSystemFileMgr()->open(filePath.c_str(), sword::FileMgr::RDONLY);
-    if (!fd) {
+    // The archive is read with a plain file descriptor, since the global FileMgr of SWORD is not thread-safe
+    long long fileSize = this->getFileSize(filePath);
+    int fd = this->openFile(filePath, false);
+    if (fd < 0 || fileSize < 0) {
+        this->closeFile(fd);
         return false;
     }
 
-    char ret = sword::ZipCompress::unTarGZ(fd->getFd(), destPath.c_str());
-    sword::FileMgr::getSystemFileMgr()->close(fd);
+    unsigned long long totalBytes = (unsigned long long)fileSize;
+
+    // The archive is decompressed and extracted in a single pass while it is read
+    ArchiveStreamExtractor extractor(ArchiveFormat::tarGz, destPath);
+    vector<char> buffer(EXTRACTION_BUFFER_SIZE);
+    unsigned long long completedBytes = 0;
+    bool successful = true;
+    long readBytes = 0;
+
+    while ((readBytes = this->readFile(fd, buffer.data(), (long)buffer.size())) > 0) {
+        if (!extractor.write(buffer.data(), (size_t)readBytes)) {
+            successful = false;
+            break;
+        }
+
+        completedBytes += readBytes;
+        if (progressCallback != 0) {
+            (*progressCallback)(totalBytes, completedBytes);
+        }
+    }
 
-    return (ret == 0);
+    this->closeFile(fd);
+
+    return (successful && readBytes == 0 && extractor.finish());
 }
 
-bool FileSystemHelper::unZip(std::string filePath, std::string destPath)
+bool FileSystemHelper::unZip(std::string filePath,
+                             std::string destPath,
+                             std::function<void(unsigned long long totalBytes, unsigned long long completedBytes)>* progressCallback,
+                             unsigned int maxParallelEntries)
 {
     unzFile uf = unzOpen(filePath.c_str());
     if (uf == NULL) {
         return false;
     }
 
+    if (destPath.empty() || (destPath.back() != '/' && destPath.back() != '\\')) {
+        destPath += '/';
+    }
+
+    // The entry list is read from the central directory first, so that the entries can be distributed to several threads
+    vector<ZipEntry> entries;
+    unsigned long long totalBytes = 0;
+
     int err = unzGoToFirstFile(uf);
     while (err == UNZ_OK) {
         char filename[256];
-        unz_file_info file_info;
-        err = unzGetCurrentFileInfo(uf, &file_info, filename, sizeof(filename), NULL, 0, NULL, 0);
+        unz_file_info64 file_info;
+        err = unzGetCurrentFileInfo64(uf, &file_info, filename, sizeof(filename), NULL, 0, NULL, 0);
 
         if (err != UNZ_OK) break;
 
@@ -446,11 +571,14 @@ bool FileSystemHelper::unZip(std::string filePath, std::string destPath)
             continue;
         }
 
-        string fullPath = destPath;
-        if (fullPath.back() != '/' && fullPath.back() != '\\') {
-            fullPath += '/';
+        // Truncated names and names leaving the destination directory (e.g. ../ or absolute paths) are rejected
+        if (file_info.size_filename >= sizeof(filename) || !ArchiveStreamExtractor::isSafeEntryName(string(filename))) {
+            cerr << "Unsafe zip entry name " << filename << endl;
+            unzClose(uf);
+            return false;
         }
-        fullPath += filename;
+
+        string fullPath = destPath + filename;
 
         // Check if directory
         if (filename[filenameLen - 1] == '/') {
@@ -458,22 +586,17 @@ bool FileSystemHelper::unZip(std::string filePath, std::string destPath)
             string dummy = fullPath + "dummy";
             sword::FileMgr::createParent(dummy.c_str());
         } else {
-            // It's a file
-            sword::FileMgr::createParent(fullPath.c_str());
-            
-            err = unzOpenCurrentFile(uf);
-            if (err == UNZ_OK) {
-                sword::FileDesc* fd = sword::FileMgr::getSystemFileMgr()->open(fullPath.c_str(), sword::FileMgr::WRONLY | sword::FileMgr::CREAT | sword::FileMgr::TRUNC);
-                if (fd) {
-                    char buf[4096];
-                    int readBytes;
-                    while ((readBytes = unzReadCurrentFile(uf, buf, sizeof(buf))) > 0) {
-                        sword::FileMgr::write(fd->getFd(), buf, readBytes);
-                    }
-                    sword::FileMgr::getSystemFileMgr()->close(fd);
-                }
-                unzCloseCurrentFile(uf);
-            }
+            ZipEntry entry;
+            entry.fullPath = fullPath;
+            entry.uncompressedSize = file_info.uncompressed_size;
+
+            unz64_file_pos position;
+            unzGetFilePos64(uf, &position);
+            entry.positionInZipDirectory = position.pos_in_zip_directory;
+            entry.numberOfFile = position.num_of_file;
+
+            totalBytes += entry.uncompressedSize;
+            entries.push_back(entry);
         }
 
         err = unzGoToNextFile(uf);
@@ -481,5 +604,125 @@ bool FileSystemHelper::unZip(std::string filePath, std::string destPath)
 
     unzClose(uf);
 
-    return true;
+    if (err != UNZ_END_OF_LIST_OF_FILE) {
+        return false;
+    }
+
+    atomic<unsigned int> nextEntry(0);
+    atomic<bool> successful(true);
+    unsigned long long completedBytes = 0;
+    mutex progressMutex;
+
+    std::function<void(unsigned long long)> reportProgress = [&](unsigned long long newBytes) {
+        lock_guard<mutex> lock(progressMutex);
+        completedBytes += newBytes;
+
+        if (progressCallback != 0) {
+            (*progressCallback)(totalBytes, completedBytes);
+        }
+    };
+
+    // minizip handles must not be shared between threads, so every lane opens the zip file itself
+    std::function<int()> laneTask = [&]() {
+        unzFile laneFile = unzOpen(filePath.c_str());
+        if (laneFile == NULL) {
+            successful = false;
+            return -1;
+        }
+
+        vector<char> buffer(EXTRACTION_BUFFER_SIZE);
+
+        for (;;) {
+            unsigned int entryIndex = nextEntry++;
+            if (entryIndex >= entries.size() || !successful) {
+                break;
+            }
+
+            if (!this->extractZipEntry(laneFile, entries[entryIndex], buffer, reportProgress)) {
+                successful = false;
+                break;
+            }
+        }
+
+        unzClose(laneFile);
+        return 0;
+    };
+
+    unsigned int laneCount = (maxParallelEntries > 0) ? maxParallelEntries : 1;
+    if (laneCount > entries.size()) {
+        laneCount = (entries.size() > 0) ? (unsigned int)entries.size() : 1;
+    }
+
+    // The extraction is interactive work: The pool never lets indexing or network tasks occupy all of its workers,
+    // so the lanes do not wait behind them. With a single lane everything runs on the calling thread.
+    vector<future<int>> laneFutures;
+    for (unsigned int i = 1; i < laneCount; i++) {
+        laneFutures.push_back(ThreadPool::getInstance().submit<int>(TaskPriority::interactive, laneTask));
+    }
+
+    // The calling thread works on the entries as well
+    laneTask();
+
+    for (unsigned int i = 0; i < laneFutures.size(); i++) {
+        ThreadPool::getInstance().waitFor(laneFutures[i]);
+    }
+
+    return successful;
+}
+
+bool FileSystemHelper::extractZipEntry(void* zipFile,
+                                       ZipEntry& entry,
+                                       std::vector<char>& buffer,
+                                       std::function<void(unsigned long long)>& reportProgress)
+{
+    unzFile uf = (unzFile)zipFile;
+    unz64_file_pos position;
+    position.pos_in_zip_directory = entry.positionInZipDirectory;
+    position.num_of_file = entry.numberOfFile;
+
+    if (unzGoToFilePos64(uf, &position) != UNZ_OK || unzOpenCurrentFile(uf) != UNZ_OK) {
+        cerr << "Could not open zip entry " << entry.fullPath << endl;
+        return false;
+    }
+
+    // The lanes write with plain file descriptors, since the global FileMgr of SWORD is not thread-safe
+    sword::FileMgr::createParent(entry.fullPath.c_str());
+    int fd = this->openFile(entry.fullPath, true);
+    bool successful = (fd >= 0);
+
+    // The decompressed data is collected in a large buffer, so that the file is written in few large blocks
+    int readBytes = 0;
+    while (successful) {
+        size_t bufferedBytes = 0;
+
+        while (bufferedBytes < buffer.size() &&
+               (readBytes = unzReadCurrentFile(uf, buffer.data() + bufferedBytes, (unsigned)(buffer.size() - bufferedBytes))) > 0) {
+
+            bufferedBytes += readBytes;
+        }
+
+        if (readBytes < 0) {
+            successful = false;
+        } else if (bufferedBytes > 0) {
+            successful = this->writeFile(fd, buffer.data(), (long)bufferedBytes);
+            reportProgress(bufferedBytes);
+        }
+
+        if (readBytes == 0) {
+            break;
+        }
+    }
+
+    this->closeFile(fd);
+
+    // unzCloseCurrentFile reports a CRC mismatch once the entry has been read completely
+    if (unzCloseCurrentFile(uf) != UNZ_OK) {
+        successful = false;
+    }
+
+    if (!successful) {
+        cerr << "Could not extract zip entry " << entry.fullPath << endl;
+    }
+
+    return successful;
 }
@@ -19,6 +19,10 @@
 #ifndef _FILE_SYSTEM_HELPER
 #define _FILE_SYSTEM_HELPER
 
+#include <string>
+#include <vector>
+#include <functional>
+
 class FileSystemHelper
 {
 public:
@@ -48,18 +52,49 @@ public:
     std::string getUserSwordDir();
     std::string getSystemSwordDir();
     std::vector<std::string> getFilesInDir(std::string dirName);
-    bool unTarGZ(std::string filePath, std::string destPath);
-    bool unZip(std::string filePath, std::string destPath);
+
+    // The progressCallback receives the total and the completed bytes (compressed bytes for tar.gz, uncompressed bytes for zip).
+    // The entries of a zip file are independent of each other and are extracted by up to maxParallelEntries threads.
+    bool unTarGZ(std::string filePath,
+                 std::string destPath,
+                 std::function<void(unsigned long long totalBytes, unsigned long long completedBytes)>* progressCallback=0);
+
+    bool unZip(std::string filePath,
+               std::string destPath,
+               std::function<void(unsigned long long totalBytes, unsigned long long completedBytes)>* progressCallback=0,
+               unsigned int maxParallelEntries=1);
+
     std::string getPathSeparator();
     
     bool fileExists(std::string fileName);
 
+    // Files written by the addon itself are accessed via plain file descriptors instead of SWORD's FileMgr,
+    // so that they can be written without the SwordFileLock. openFile returns -1 on failure.
+    int openFile(std::string filePath, bool forWriting, bool append=false);
+    long readFile(int fd, char* buffer, long size);
+    bool writeFile(int fd, const char* data, long size);
+    void closeFile(int fd);
+    long long getFileSize(std::string filePath);
+
 #if defined(_WIN32)
     std::wstring convertUtf8StringToUtf16(const std::string& str);
     std::string convertUtf16StringToUtf8(const std::wstring& wstr);
 #endif
 
 private:
+    class ZipEntry {
+    public:
+        std::string fullPath;
+        unsigned long long uncompressedSize = 0;
+        unsigned long long positionInZipDirectory = 0;
+        unsigned long long numberOfFile = 0;
+    };
+
+    bool extractZipEntry(void* zipFile,
+                         ZipEntry& entry,
+                         std::vector<char>& buffer,
+                         std::function<void(unsigned long long)>& reportProgress);
+
     int makeDirectory(std::string dirName);
     int renameFile(std::string oldFileName, std::string newFileName);
 
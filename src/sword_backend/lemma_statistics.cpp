@@ -0,0 +1,408 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+// Std includes
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+
+// Sword includes
+#include <swmodule.h>
+#include <swmgr.h>
+#include <versekey.h>
+
+// Own includes
+#include "lemma_statistics.hpp"
+#include "module_store.hpp"
+#include "strongs_entry.hpp"
+#include "string_helper.hpp"
+#include "mapped_file.hpp"
+#include "sword_file_lock.hpp"
+
+using namespace std;
+using namespace sword;
+
+// Layout of the statistics file (integers in native byte order):
+//
+// Header:  "NSLS", uint32 format version, module version, uint32 book count, book names, uint32 entry count
+// Entries: Strong's key, uint32 occurrences, uint32 book count, pairs of uint32 book index and uint32 occurrences,
+//          uint32 surface form count, pairs of surface form and uint32 occurrences
+//
+// Strings are stored as uint32 length followed by the string data.
+
+#define LEMMA_STATISTICS_MAGIC "NSLS"
+#define LEMMA_STATISTICS_VERSION 1
+
+bool LemmaStatistics::getLemmaStatistics(string moduleName, string strongsKey, LemmaStatisticsEntry& entry)
+{
+    // The statistics are built with a SWMgr of the pool, since this is usually called from a worker thread
+    SwordMgrLease lease = this->_moduleStore.acquireMgr();
+    SWModule* module = lease.getModule(moduleName);
+
+    if (module == 0) {
+        cerr << "getLemmaStatistics: Module " << moduleName << " not found!" << endl;
+        return false;
+    }
+
+    shared_ptr<ModuleLemmaStatistics> statistics = this->getModuleLemmaStatistics(module);
+    string normalizedKey = StrongsEntry::getNormalizedStrongsKey(strongsKey);
+    unordered_map<string, LemmaStatisticsEntry>::const_iterator it = statistics->entries.find(normalizedKey);
+
+    if (it != statistics->entries.end()) {
+        entry = it->second;
+    } else {
+        entry = LemmaStatisticsEntry();
+        entry.strongsKey = normalizedKey;
+    }
+
+    return true;
+}
+
+shared_ptr<LemmaStatistics::ModuleLemmaStatistics> LemmaStatistics::getModuleLemmaStatistics(SWModule* module)
+{
+    string moduleName = string(module->getName());
+    const char* version = module->getConfigEntry("Version");
+    string moduleVersion = (version != 0) ? string(version) : "";
+    shared_ptr<ModuleStatisticsSlot> slot;
+
+    {
+        lock_guard<mutex> lock(this->_moduleStatisticsMutex);
+        shared_ptr<ModuleStatisticsSlot>& moduleSlot = this->_moduleStatistics[moduleName];
+
+        if (!moduleSlot) {
+            moduleSlot = make_shared<ModuleStatisticsSlot>();
+        }
+
+        slot = moduleSlot;
+    }
+
+    // Building the statistics takes a few seconds, so the lock of the module slot is held instead of the lock of all modules
+    lock_guard<mutex> lock(slot->buildMutex);
+    shared_ptr<ModuleLemmaStatistics>& statistics = slot->statistics;
+
+    if (statistics && statistics->moduleVersion == moduleVersion) {
+        return statistics;
+    }
+
+    string filePath = this->getStatisticsFilePath(moduleName);
+    statistics = make_shared<ModuleLemmaStatistics>();
+
+    if (this->readModuleLemmaStatistics(filePath, *statistics) && statistics->moduleVersion == moduleVersion) {
+        return statistics;
+    }
+
+    statistics = this->buildModuleLemmaStatistics(module, moduleVersion);
+    this->writeModuleLemmaStatistics(filePath, *statistics);
+
+    return statistics;
+}
+
+shared_ptr<LemmaStatistics::ModuleLemmaStatistics> LemmaStatistics::buildModuleLemmaStatistics(SWModule* module, string moduleVersion)
+{
+    shared_ptr<ModuleLemmaStatistics> statistics = make_shared<ModuleLemmaStatistics>();
+    statistics->moduleVersion = moduleVersion;
+
+    unordered_map<string, map<unsigned int, unsigned int>> bookOccurrences;
+    unordered_map<string, map<string, unsigned int>> surfaceForms;
+    string lastKey;
+    string lastBookName;
+
+    {
+        SwordFileLock fileLock;
+        module->setKey("Gen 1:1");
+    }
+
+    // The file lock is only held while reading, so that the synchronous API calls are not blocked by the build
+    for (;;) {
+        VerseKey currentVerseKey(module->getKey());
+        string currentKey(module->getKey()->getShortText());
+
+        // Stop at the end of the module
+        if (currentKey == lastKey) {
+            break;
+        }
+
+        string currentBookName(currentVerseKey.getOSISBookName());
+        if (currentBookName != lastBookName) {
+            statistics->books.push_back(currentBookName);
+            lastBookName = currentBookName;
+        }
+
+        string verseText;
+
+        {
+            SwordFileLock fileLock;
+            verseText = string(module->getRawEntry());
+        }
+
+        this->addLemmasFromText(verseText, (unsigned int)statistics->books.size() - 1, bookOccurrences, surfaceForms);
+
+        lastKey = currentKey;
+
+        {
+            SwordFileLock fileLock;
+            module->increment();
+        }
+    }
+
+    for (unordered_map<string, map<unsigned int, unsigned int>>::iterator it = bookOccurrences.begin(); it != bookOccurrences.end(); it++) {
+        LemmaStatisticsEntry& entry = statistics->entries[it->first];
+        entry.strongsKey = it->first;
+
+        // The book indices are in the order of the module, so the map already has the right order
+        for (map<unsigned int, unsigned int>::iterator book = it->second.begin(); book != it->second.end(); book++) {
+            entry.bookOccurrences.push_back(make_pair(statistics->books[book->first], book->second));
+            entry.occurrences += book->second;
+        }
+
+        map<string, unsigned int>& forms = surfaceForms[it->first];
+        entry.surfaceForms.assign(forms.begin(), forms.end());
+
+        stable_sort(entry.surfaceForms.begin(), entry.surfaceForms.end(),
+                    [](const pair<string, unsigned int>& a, const pair<string, unsigned int>& b) {
+                        return a.second > b.second;
+                    });
+    }
+
+    return statistics;
+}
+
+void LemmaStatistics::addLemmasFromText(const string& text,
+                                        unsigned int bookIndex,
+                                        unordered_map<string, map<unsigned int, unsigned int>>& bookOccurrences,
+                                        unordered_map<string, map<string, unsigned int>>& surfaceForms)
+{
+    // A word element looks like this: <w lemma="strong:G2316" morph="robinson:N-NSM">God</w>
+    static const string wordStart = "<w ";
+    static const string wordEnd = "</w>";
+    static const string lemmaAttribute = "lemma=\"";
+    static const string strongsPrefix = "strong:";
+
+    size_t position = text.find(wordStart);
+
+    while (position != string::npos) {
+        size_t tagEnd = text.find('>', position);
+        if (tagEnd == string::npos) {
+            break;
+        }
+
+        string tag = text.substr(position, tagEnd - position + 1);
+        size_t nextPosition = tagEnd + 1;
+        size_t lemmaStart = tag.find(lemmaAttribute);
+
+        if (lemmaStart != string::npos) {
+            lemmaStart += lemmaAttribute.size();
+            size_t lemmaEnd = tag.find('"', lemmaStart);
+            string lemma = tag.substr(lemmaStart, (lemmaEnd == string::npos) ? string::npos : lemmaEnd - lemmaStart);
+            string surfaceForm;
+
+            // Self-closing word elements do not have a surface form
+            if (tag.size() < 2 || tag[tag.size() - 2] != '/') {
+                size_t closingTag = text.find(wordEnd, tagEnd);
+
+                if (closingTag != string::npos) {
+                    surfaceForm = text.substr(tagEnd + 1, closingTag - tagEnd - 1);
+                    surfaceForm = StringHelper::removeTags(surfaceForm);
+                    StringHelper::trim(surfaceForm);
+                    nextPosition = closingTag + wordEnd.size();
+                }
+            }
+
+            // A lemma attribute may contain several keys, like lemma="strong:H0853 strong:H01254"
+            vector<string> lemmaKeys = StringHelper::split(lemma, " ");
+
+            for (unsigned int i = 0; i < lemmaKeys.size(); i++) {
+                if (lemmaKeys[i].compare(0, strongsPrefix.size(), strongsPrefix) != 0) {
+                    continue;
+                }
+
+                string strongsKey = StrongsEntry::getNormalizedStrongsKey(lemmaKeys[i].substr(strongsPrefix.size()));
+
+                if (!StrongsEntry::isValidStrongsKey(strongsKey)) {
+                    continue;
+                }
+
+                bookOccurrences[strongsKey][bookIndex]++;
+
+                if (surfaceForm.size() > 0) {
+                    surfaceForms[strongsKey][surfaceForm]++;
+                }
+            }
+        }
+
+        position = text.find(wordStart, nextPosition);
+    }
+}
+
+string LemmaStatistics::getStatisticsFilePath(string moduleName)
+{
+    return this->_moduleStore.getUserSwordDir() + "/." + moduleName + ".lemmas";
+}
+
+bool LemmaStatistics::readModuleLemmaStatistics(string filePath, ModuleLemmaStatistics& statistics)
+{
+    MappedFile mappedFile;
+    if (!mappedFile.open(filePath, 8)) {
+        return false;
+    }
+
+    const char* data = mappedFile.getData();
+    unsigned long long size = mappedFile.getSize();
+    unsigned long long offset = 0;
+
+    auto readUInt32 = [&](unsigned int& value) {
+        if (offset + 4 > size) {
+            return false;
+        }
+
+        memcpy(&value, data + offset, 4);
+        offset += 4;
+        return true;
+    };
+
+    auto readString = [&](string& value) {
+        unsigned int length = 0;
+        if (!readUInt32(length) || offset + length > size) {
+            return false;
+        }
+
+        value.assign(data + offset, length);
+        offset += length;
+        return true;
+    };
+
+    unsigned int formatVersion = 0;
+    unsigned int bookCount = 0;
+    unsigned int entryCount = 0;
+
+    if (memcmp(data, LEMMA_STATISTICS_MAGIC, 4) != 0) {
+        return false;
+    }
+
+    offset = 4;
+
+    if (!readUInt32(formatVersion) || formatVersion != LEMMA_STATISTICS_VERSION ||
+        !readString(statistics.moduleVersion) ||
+        !readUInt32(bookCount)) {
+        return false;
+    }
+
+    for (unsigned int i = 0; i < bookCount; i++) {
+        string book;
+        if (!readString(book)) {
+            return false;
+        }
+
+        statistics.books.push_back(book);
+    }
+
+    if (!readUInt32(entryCount)) {
+        return false;
+    }
+
+    statistics.entries.reserve(entryCount);
+
+    for (unsigned int i = 0; i < entryCount; i++) {
+        LemmaStatisticsEntry entry;
+        unsigned int entryBookCount = 0;
+        unsigned int surfaceFormCount = 0;
+
+        if (!readString(entry.strongsKey) || !readUInt32(entry.occurrences) || !readUInt32(entryBookCount)) {
+            return false;
+        }
+
+        for (unsigned int j = 0; j < entryBookCount; j++) {
+            unsigned int bookIndex = 0;
+            unsigned int occurrences = 0;
+
+            if (!readUInt32(bookIndex) || !readUInt32(occurrences) || bookIndex >= statistics.books.size()) {
+                return false;
+            }
+
+            entry.bookOccurrences.push_back(make_pair(statistics.books[bookIndex], occurrences));
+        }
+
+        if (!readUInt32(surfaceFormCount)) {
+            return false;
+        }
+
+        for (unsigned int j = 0; j < surfaceFormCount; j++) {
+            string surfaceForm;
+            unsigned int occurrences = 0;
+
+            if (!readString(surfaceForm) || !readUInt32(occurrences)) {
+                return false;
+            }
+
+            entry.surfaceForms.push_back(make_pair(surfaceForm, occurrences));
+        }
+
+        statistics.entries[entry.strongsKey] = entry;
+    }
+
+    return true;
+}
+
+bool LemmaStatistics::writeModuleLemmaStatistics(string filePath, const ModuleLemmaStatistics& statistics)
+{
+    vector<char> data;
+    map<string, unsigned int> bookIndices;
+
+    auto appendUInt32 = [&data](unsigned int value) {
+        data.insert(data.end(), (const char*)&value, (const char*)&value + 4);
+    };
+
+    auto appendString = [&data, &appendUInt32](const string& value) {
+        appendUInt32((unsigned int)value.size());
+        data.insert(data.end(), value.begin(), value.end());
+    };
+
+    data.insert(data.end(), LEMMA_STATISTICS_MAGIC, LEMMA_STATISTICS_MAGIC + 4);
+    appendUInt32(LEMMA_STATISTICS_VERSION);
+    appendString(statistics.moduleVersion);
+    appendUInt32((unsigned int)statistics.books.size());
+
+    for (unsigned int i = 0; i < statistics.books.size(); i++) {
+        appendString(statistics.books[i]);
+        bookIndices[statistics.books[i]] = i;
+    }
+
+    appendUInt32((unsigned int)statistics.entries.size());
+
+    for (unordered_map<string, LemmaStatisticsEntry>::const_iterator it = statistics.entries.begin(); it != statistics.entries.end(); it++) {
+        const LemmaStatisticsEntry& entry = it->second;
+
+        appendString(entry.strongsKey);
+        appendUInt32(entry.occurrences);
+        appendUInt32((unsigned int)entry.bookOccurrences.size());
+
+        for (unsigned int i = 0; i < entry.bookOccurrences.size(); i++) {
+            appendUInt32(bookIndices[entry.bookOccurrences[i].first]);
+            appendUInt32(entry.bookOccurrences[i].second);
+        }
+
+        appendUInt32((unsigned int)entry.surfaceForms.size());
+
+        for (unsigned int i = 0; i < entry.surfaceForms.size(); i++) {
+            appendString(entry.surfaceForms[i].first);
+            appendUInt32(entry.surfaceForms[i].second);
+        }
+    }
+
+    return MappedFile::writeFile(filePath, data);
+}
@@ -0,0 +1,99 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef _LEMMA_STATISTICS
+#define _LEMMA_STATISTICS
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace sword {
+    class SWModule;
+};
+
+class ModuleStore;
+
+// The occurrences of one Strong's number in a module
+class LemmaStatisticsEntry
+{
+public:
+    LemmaStatisticsEntry() {}
+    virtual ~LemmaStatisticsEntry() {}
+
+    std::string strongsKey;
+    unsigned int occurrences = 0;
+
+    // Occurrences per book (OSIS book names) in the order of the books in the module
+    std::vector<std::pair<std::string, unsigned int>> bookOccurrences;
+
+    // The words that are tagged with the Strong's number, ordered by decreasing number of occurrences
+    std::vector<std::pair<std::string, unsigned int>> surfaceForms;
+};
+
+/**
+ * Per-module statistics of the Strong's numbers used in the <w lemma="strong:..."> elements of a module.
+ *
+ * The statistics of a module are built in one pass over all verses on the first query and are stored as a file in the
+ * user's SWORD directory, so that they are only built once per module version. Queries are answered from a hash map.
+ * While the statistics of a module are built, only the queries for that module wait.
+ */
+class LemmaStatistics
+{
+public:
+    LemmaStatistics(ModuleStore& moduleStore) : _moduleStore(moduleStore) {}
+    virtual ~LemmaStatistics() {}
+
+    // Returns false if the module does not exist. Lemmas that do not occur in the module have zero occurrences.
+    // Builds the statistics of the module first if necessary, so this may take a few seconds and should not be called on the main thread.
+    bool getLemmaStatistics(std::string moduleName, std::string strongsKey, LemmaStatisticsEntry& entry);
+
+private:
+    class ModuleLemmaStatistics {
+    public:
+        std::string moduleVersion;
+        std::vector<std::string> books;
+        std::unordered_map<std::string, LemmaStatisticsEntry> entries;
+    };
+
+    class ModuleStatisticsSlot {
+    public:
+        std::mutex buildMutex;
+        std::shared_ptr<ModuleLemmaStatistics> statistics;
+    };
+
+    std::shared_ptr<ModuleLemmaStatistics> getModuleLemmaStatistics(sword::SWModule* module);
+    std::shared_ptr<ModuleLemmaStatistics> buildModuleLemmaStatistics(sword::SWModule* module, std::string moduleVersion);
+    void addLemmasFromText(const std::string& text,
+                           unsigned int bookIndex,
+                           std::unordered_map<std::string, std::map<unsigned int, unsigned int>>& bookOccurrences,
+                           std::unordered_map<std::string, std::map<std::string, unsigned int>>& surfaceForms);
+
+    std::string getStatisticsFilePath(std::string moduleName);
+    bool readModuleLemmaStatistics(std::string filePath, ModuleLemmaStatistics& statistics);
+    bool writeModuleLemmaStatistics(std::string filePath, const ModuleLemmaStatistics& statistics);
+
+    ModuleStore& _moduleStore;
+    std::map<std::string, std::shared_ptr<ModuleStatisticsSlot>> _moduleStatistics;
+    std::mutex _moduleStatisticsMutex;
+};
+
+#endif // _LEMMA_STATISTICS
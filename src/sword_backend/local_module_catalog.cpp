@@ -0,0 +1,84 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+// Own includes
+#include "local_module_catalog.hpp"
+
+using namespace std;
+
+LocalModuleCatalog::LocalModuleCatalog(const vector<Entry>& entries)
+{
+    for (unsigned int i = 0; i < entries.size(); i++) {
+        const Entry& currentEntry = entries[i];
+
+        this->addToGroup("ANY", currentEntry.language, currentEntry.name);
+        this->addToGroup(currentEntry.type, currentEntry.language, currentEntry.name);
+    }
+
+    // The flat lists are concatenated from the language groups once, so that the queries only return a reference
+    for (unordered_map<string, ModuleGroup>::iterator it = this->_groups.begin(); it != this->_groups.end(); it++) {
+        ModuleGroup& group = it->second;
+
+        for (unsigned int i = 0; i < group.moduleNamesByLanguage.size(); i++) {
+            group.moduleNames.insert(group.moduleNames.end(), group.moduleNamesByLanguage[i].begin(), group.moduleNamesByLanguage[i].end());
+        }
+
+        group.moduleNamesByLanguage.clear();
+        group.languageIndices.clear();
+    }
+}
+
+void LocalModuleCatalog::addToGroup(const string& moduleType, const string& language, const string& moduleName)
+{
+    ModuleGroup& group = this->_groups[moduleType];
+    unordered_map<string, unsigned int>::iterator languageIndex = group.languageIndices.find(language);
+    unsigned int index = 0;
+
+    if (languageIndex == group.languageIndices.end()) {
+        index = (unsigned int)group.languages.size();
+        group.languageIndices[language] = index;
+        group.languages.push_back(language);
+        group.moduleNamesByLanguage.push_back(vector<string>());
+    } else {
+        index = languageIndex->second;
+    }
+
+    group.moduleNamesByLanguage[index].push_back(moduleName);
+}
+
+const vector<string>& LocalModuleCatalog::getModuleNames(const string& moduleType) const
+{
+    unordered_map<string, ModuleGroup>::const_iterator it = this->_groups.find(moduleType);
+
+    if (it == this->_groups.end()) {
+        return this->_emptyModuleNames;
+    }
+
+    return it->second.moduleNames;
+}
+
+const vector<string>& LocalModuleCatalog::getLanguages(const string& moduleType) const
+{
+    unordered_map<string, ModuleGroup>::const_iterator it = this->_groups.find(moduleType);
+
+    if (it == this->_groups.end()) {
+        return this->_emptyLanguages;
+    }
+
+    return it->second.languages;
+}
@@ -0,0 +1,67 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef _LOCAL_MODULE_CATALOG
+#define _LOCAL_MODULE_CATALOG
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/**
+ * An immutable snapshot of the names of the installed modules, grouped by module type and language.
+ * The name lists are precomputed in the order returned by ModuleStore::getAllLocalModules: grouped by language
+ * (in the order in which the languages first appear in the sorted module list) and sorted by name within a language.
+ *
+ * The catalog is built from the module configurations, so no module driver needs to be created for it.
+ * It must be discarded whenever modules are loaded, reloaded or removed.
+ */
+class LocalModuleCatalog {
+public:
+    class Entry {
+    public:
+        std::string name;
+        std::string type;
+        std::string language;
+    };
+
+    // The entries must be sorted by module name, like SWMgr::Modules
+    LocalModuleCatalog(const std::vector<Entry>& entries);
+    virtual ~LocalModuleCatalog() {}
+
+    // moduleType is a module type string as returned by RepositoryInterface::getModuleTypeString, including "ANY"
+    const std::vector<std::string>& getModuleNames(const std::string& moduleType) const;
+    const std::vector<std::string>& getLanguages(const std::string& moduleType) const;
+
+private:
+    class ModuleGroup {
+    public:
+        std::vector<std::string> languages;
+        std::vector<std::vector<std::string>> moduleNamesByLanguage;
+        std::unordered_map<std::string, unsigned int> languageIndices;
+        std::vector<std::string> moduleNames;
+    };
+
+    void addToGroup(const std::string& moduleType, const std::string& language, const std::string& moduleName);
+
+    std::unordered_map<std::string, ModuleGroup> _groups;
+    std::vector<std::string> _emptyModuleNames;
+    std::vector<std::string> _emptyLanguages;
+};
+
+#endif // _LOCAL_MODULE_CATALOG
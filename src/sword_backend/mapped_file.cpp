@@ -0,0 +1,181 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__ANDROID__)
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#elif _WIN32
+
+#include <windows.h>
+
+#endif
+
+// Std includes
+#include <iostream>
+#include <sstream>
+#include <cstdio>
+#include <atomic>
+#include <thread>
+#include <functional>
+
+// Sword includes
+#include <filemgr.h>
+
+// Own includes
+#include "mapped_file.hpp"
+#include "file_system_helper.hpp"
+
+using namespace std;
+using namespace sword;
+
+MappedFile::~MappedFile()
+{
+    this->close();
+}
+
+bool MappedFile::open(string filePath, unsigned long long minSize)
+{
+    this->close();
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__ANDROID__)
+    int fd = ::open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0 && (unsigned long long)fileStat.st_size >= minSize) {
+        void* data = mmap(0, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (data != MAP_FAILED) {
+            this->_data = (const char*)data;
+            this->_size = (unsigned long long)fileStat.st_size;
+        }
+    }
+
+    // The mapping stays valid after closing the file
+    ::close(fd);
+#elif _WIN32
+    FileSystemHelper fileSystemHelper;
+    wstring wFilePath = fileSystemHelper.convertUtf8StringToUtf16(filePath);
+
+    HANDLE fileHandle = CreateFileW(wFilePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+                                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0 || (unsigned long long)fileSize.QuadPart < minSize) {
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    HANDLE mappingHandle = CreateFileMappingW(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mappingHandle == NULL) {
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    this->_data = (const char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if (this->_data == 0) {
+        CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    this->_size = (unsigned long long)fileSize.QuadPart;
+    this->_fileHandle = fileHandle;
+    this->_mappingHandle = mappingHandle;
+#endif
+
+    return this->isOpen();
+}
+
+void MappedFile::close()
+{
+    if (this->_data == 0) {
+        return;
+    }
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__ANDROID__)
+    munmap((void*)this->_data, (size_t)this->_size);
+#elif _WIN32
+    UnmapViewOfFile(this->_data);
+    CloseHandle((HANDLE)this->_mappingHandle);
+    CloseHandle((HANDLE)this->_fileHandle);
+    this->_mappingHandle = 0;
+    this->_fileHandle = 0;
+#endif
+
+    this->_data = 0;
+    this->_size = 0;
+}
+
+bool MappedFile::writeFile(string filePath, const vector<char>& data)
+{
+    // Each write uses its own temporary file, so that concurrent writes of the same file (e.g. by another process
+    // using the same SWORD directory) cannot interleave. The last completed write replaces the file.
+    static atomic<unsigned int> tempFileCounter(0);
+    stringstream tempFilePathStream;
+
+#if defined(_WIN32)
+    tempFilePathStream << filePath << "." << GetCurrentProcessId();
+#else
+    tempFilePathStream << filePath << "." << getpid();
+#endif
+
+    tempFilePathStream << "." << hash<thread::id>()(this_thread::get_id()) << "." << tempFileCounter++ << ".tmp";
+    string tempFilePath = tempFilePathStream.str();
+
+    // The file is not accessed by SWORD, so it is written without the FileMgr and the SwordFileLock
+    FileSystemHelper fileSystemHelper;
+    int tempFile = fileSystemHelper.openFile(tempFilePath, true);
+
+    if (tempFile < 0) {
+        cerr << "MappedFile: Could not write " << tempFilePath << endl;
+        return false;
+    }
+
+    bool written = (data.size() == 0 || fileSystemHelper.writeFile(tempFile, &data[0], (long)data.size()));
+    fileSystemHelper.closeFile(tempFile);
+
+    if (!written) {
+        cerr << "MappedFile: Could not write " << tempFilePath << endl;
+        FileMgr::removeFile(tempFilePath.c_str());
+        return false;
+    }
+
+#if defined(_WIN32)
+    // rename does not replace existing files on Windows
+    FileMgr::removeFile(filePath.c_str());
+#endif
+
+    if (rename(tempFilePath.c_str(), filePath.c_str()) != 0) {
+        cerr << "MappedFile: Could not move " << tempFilePath << " to " << filePath << endl;
+        FileMgr::removeFile(tempFilePath.c_str());
+        return false;
+    }
+
+    return true;
+}
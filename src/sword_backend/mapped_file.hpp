@@ -0,0 +1,58 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef _MAPPED_FILE
+#define _MAPPED_FILE
+
+#include <string>
+#include <vector>
+
+/**
+ * A read-only memory mapping of a whole file (mmap on POSIX systems, MapViewOfFile on Windows).
+ */
+class MappedFile {
+public:
+    MappedFile() {}
+    virtual ~MappedFile();
+
+    // Returns false if the file does not exist, is smaller than minSize or cannot be mapped
+    bool open(std::string filePath, unsigned long long minSize=0);
+    void close();
+
+    bool isOpen() const { return (this->_data != 0); }
+    const char* getData() const { return this->_data; }
+    unsigned long long getSize() const { return this->_size; }
+
+    // Writes the data to a temporary file first and then moves it to filePath, so that no other process
+    // ever maps a partially written file. A mapping of filePath must be closed before calling this.
+    static bool writeFile(std::string filePath, const std::vector<char>& data);
+
+private:
+    // Mappings are not copyable
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const char* _data = 0;
+    unsigned long long _size = 0;
+#if defined(_WIN32)
+    void* _fileHandle = 0;
+    void* _mappingHandle = 0;
+#endif
+};
+
+#endif // _MAPPED_FILE
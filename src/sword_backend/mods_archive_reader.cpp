@@ -0,0 +1,241 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+
+// Std includes
+#include <iostream>
+#include <cstring>
+
+// zlib includes
+#include <zlib.h>
+
+// Sword includes
+#include <swconfig.h>
+
+// Own includes
+#include "mods_archive_reader.hpp"
+#include "string_helper.hpp"
+
+using namespace std;
+using namespace sword;
+
+#define TAR_BLOCK_SIZE 512
+
+int ModsArchiveReader::readModuleConfigs(string archivePath, SWConfig& config)
+{
+    int confCount = 0;
+
+    bool successful = this->readArchive(archivePath, [this, &config, &confCount](const string& fileName, const string& content) {
+        if (this->isModuleConfigFile(fileName)) {
+            this->parseConf(content, config);
+            confCount++;
+        }
+    });
+
+    return successful ? confCount : -1;
+}
+
+bool ModsArchiveReader::readArchive(string archivePath, std::function<void(const std::string& fileName, const std::string& content)> fileCallback)
+{
+    // gzread decompresses on the fly, so the tar blocks can be consumed directly from the compressed stream
+    gzFile archive = gzopen(archivePath.c_str(), "rb");
+    if (archive == 0) {
+        cerr << "readArchive: Could not open " << archivePath << endl;
+        return false;
+    }
+
+    char header[TAR_BLOCK_SIZE];
+    string longName;
+    string content;
+    bool successful = true;
+
+    for (;;) {
+        int bytesRead = gzread(archive, header, TAR_BLOCK_SIZE);
+
+        // An archive without end-of-archive blocks is still accepted, as long as it ends at an entry boundary
+        if (bytesRead == 0) {
+            break;
+        }
+
+        if (bytesRead != TAR_BLOCK_SIZE) {
+            successful = false;
+            break;
+        }
+
+        // End of archive
+        if (header[0] == '\0') {
+            break;
+        }
+
+        string fileName = longName;
+        longName.clear();
+
+        if (fileName.empty()) {
+            fileName = this->getHeaderField(header, 0, 100);
+
+            // ustar archives store long paths in a separate prefix field
+            if (memcmp(header + 257, "ustar", 5) == 0) {
+                string prefix = this->getHeaderField(header, 345, 155);
+                if (!prefix.empty()) {
+                    fileName = prefix + "/" + fileName;
+                }
+            }
+        }
+
+        unsigned long long entrySize = this->getHeaderNumber(header, 124, 12);
+        unsigned long long paddedSize = (entrySize + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE * TAR_BLOCK_SIZE;
+        char entryType = header[156];
+
+        bool isRegularFile = (entryType == '0' || entryType == '\0');
+        bool isLongName = (entryType == 'L');
+
+        if (!isRegularFile && !isLongName) {
+            if (paddedSize > 0 && gzseek(archive, (z_off_t)paddedSize, SEEK_CUR) < 0) {
+                successful = false;
+                break;
+            }
+
+            continue;
+        }
+
+        content.resize((size_t)paddedSize);
+        if (paddedSize > 0 && gzread(archive, &content[0], (unsigned int)paddedSize) != (int)paddedSize) {
+            successful = false;
+            break;
+        }
+
+        content.resize((size_t)entrySize);
+
+        if (isLongName) {
+            // GNU tar stores names longer than 100 characters in an extra entry preceding the actual file
+            longName = string(content.c_str());
+        } else {
+            fileCallback(fileName, content);
+        }
+    }
+
+    gzclose(archive);
+
+    if (!successful) {
+        cerr << "readArchive: " << archivePath << " is truncated or corrupt" << endl;
+    }
+
+    return successful;
+}
+
+void ModsArchiveReader::parseConf(const string& confContent, SWConfig& config)
+{
+    ConfigEntMap* currentSection = 0;
+    size_t position = 0;
+
+    while (position < confContent.size()) {
+        string line = this->getNextLine(confContent, position);
+
+        // A trailing backslash continues an entry on the next line
+        while (StringHelper::hasEnding(line, "\\") && position < confContent.size()) {
+            line.erase(line.size() - 1);
+            line += "\n" + this->getNextLine(confContent, position);
+        }
+
+        StringHelper::trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        if (line[0] == '[') {
+            size_t sectionEnd = line.find(']');
+            if (sectionEnd != string::npos) {
+                string sectionName = line.substr(1, sectionEnd - 1);
+                currentSection = &(config.getSections()[sectionName.c_str()]);
+            }
+
+            continue;
+        }
+
+        size_t separator = line.find('=');
+        if (currentSection == 0 || separator == string::npos) {
+            continue;
+        }
+
+        string key = line.substr(0, separator);
+        string value = line.substr(separator + 1);
+        StringHelper::trim(key);
+        StringHelper::trim(value);
+
+        // Repeated keys (e.g. GlobalOptionFilter) are kept as separate entries
+        currentSection->insert(ConfigEntMap::value_type(key.c_str(), value.c_str()));
+    }
+}
+
+string ModsArchiveReader::getNextLine(const string& content, size_t& position)
+{
+    size_t lineEnd = content.find('\n', position);
+    if (lineEnd == string::npos) {
+        lineEnd = content.size();
+    }
+
+    string line = content.substr(position, lineEnd - position);
+    position = lineEnd + 1;
+
+    if (!line.empty() && line[line.size() - 1] == '\r') {
+        line.erase(line.size() - 1);
+    }
+
+    return line;
+}
+
+bool ModsArchiveReader::isModuleConfigFile(const string& fileName)
+{
+    string normalizedName = fileName;
+
+    if (StringHelper::hasBeginning(normalizedName, "./")) {
+        normalizedName = normalizedName.substr(2);
+    }
+
+    return (StringHelper::hasBeginning(normalizedName, "mods.d/") && StringHelper::hasEnding(normalizedName, ".conf"));
+}
+
+string ModsArchiveReader::getHeaderField(const char* header, unsigned int offset, unsigned int length)
+{
+    const char* field = header + offset;
+    unsigned int fieldLength = 0;
+
+    while (fieldLength < length && field[fieldLength] != '\0') {
+        fieldLength++;
+    }
+
+    return string(field, fieldLength);
+}
+
+unsigned long long ModsArchiveReader::getHeaderNumber(const char* header, unsigned int offset, unsigned int length)
+{
+    // Numbers are stored as octal strings, padded with spaces or NULs
+    unsigned long long number = 0;
+
+    for (unsigned int i = 0; i < length; i++) {
+        char currentChar = header[offset + i];
+
+        if (currentChar >= '0' && currentChar <= '7') {
+            number = number * 8 + (unsigned long long)(currentChar - '0');
+        } else if (currentChar != ' ' || number != 0) {
+            break;
+        }
+    }
+
+    return number;
+}
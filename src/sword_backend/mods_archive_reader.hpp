@@ -0,0 +1,59 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+
+#ifndef _MODS_ARCHIVE_READER
+#define _MODS_ARCHIVE_READER
+
+#include <string>
+#include <functional>
+
+namespace sword {
+    class SWConfig;
+};
+
+/**
+ * The ModsArchiveReader reads the module index of a remote source (mods.d.tar.gz) directly into memory.
+ *
+ * The archive is decompressed and split into its tar entries in a single streaming pass, so that the
+ * module configurations never have to be extracted to individual files.
+ */
+class ModsArchiveReader {
+public:
+    ModsArchiveReader(){}
+    virtual ~ModsArchiveReader(){}
+
+    // Adds the sections of all module configuration files (mods.d/*.conf) of the archive to the given config.
+    // Returns the number of configuration files that have been read or -1 if the archive could not be read.
+    int readModuleConfigs(std::string archivePath, sword::SWConfig& config);
+
+    // Invokes the callback with name and content of every regular file in the archive.
+    // Returns false if the archive could not be opened or is truncated.
+    bool readArchive(std::string archivePath, std::function<void(const std::string& fileName, const std::string& content)> fileCallback);
+
+    // Parses the content of a SWORD configuration file and adds its sections to the given config
+    void parseConf(const std::string& confContent, sword::SWConfig& config);
+
+private:
+    std::string getNextLine(const std::string& content, size_t& position);
+    bool isModuleConfigFile(const std::string& fileName);
+    std::string getHeaderField(const char* header, unsigned int offset, unsigned int length);
+    unsigned long long getHeaderNumber(const char* header, unsigned int offset, unsigned int length);
+};
+
+#endif // _MODS_ARCHIVE_READER
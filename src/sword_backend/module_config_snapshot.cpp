@@ -0,0 +1,505 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__ANDROID__)
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#elif _WIN32
+
+#include <windows.h>
+
+#endif
+
+// Std includes
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+#include <set>
+
+// Sword includes
+#include <swconfig.h>
+#include <filemgr.h>
+
+// Own includes
+#include "module_config_snapshot.hpp"
+#include "file_system_helper.hpp"
+#include "string_helper.hpp"
+
+using namespace std;
+using namespace sword;
+
+// Layout of the snapshot file (integers in native byte order):
+//
+// Header:       "NSCS", uint32 format version, uint32 byte order marker, uint32 string count, uint32 file count,
+//               uint64 offset of the string table
+// File records: uint32 path, uint64 modification time, uint64 size, uint64 content hash, uint32 section count and for every section
+//               uint32 name, uint32 entry count and the entries as pairs of uint32 key and uint32 value
+// String table: uint32 offset and uint32 length of every string, followed by the string data
+//
+// All strings are stored as indices into the string table.
+
+#define SNAPSHOT_MAGIC "NSCS"
+#define SNAPSHOT_VERSION 2
+#define SNAPSHOT_HEADER_SIZE 28
+
+// Written in native byte order, so that a snapshot copied from a machine with another byte order is rejected
+#define SNAPSHOT_BYTE_ORDER_MARKER 0x01020304
+
+ModuleConfigSnapshot::ModuleConfigSnapshot(string snapshotFilePath)
+    : _snapshotFilePath(snapshotFilePath)
+{
+    this->openSnapshot();
+}
+
+ModuleConfigSnapshot::~ModuleConfigSnapshot()
+{
+    this->closeSnapshot();
+}
+
+unsigned int ModuleConfigSnapshot::loadConfigDir(string dirPath, SectionMap& sections)
+{
+    lock_guard<mutex> lock(this->_snapshotMutex);
+
+    string basePath = dirPath;
+    if (basePath.size() == 0 || (basePath[basePath.size() - 1] != '/' && basePath[basePath.size() - 1] != '\\')) {
+        basePath += "/";
+    }
+
+    // Sorted, so that sections defined in several files are always merged in the same order
+    FileSystemHelper fileSystemHelper;
+    vector<string> fileNames = fileSystemHelper.getFilesInDir(dirPath);
+    std::sort(fileNames.begin(), fileNames.end());
+
+    set<string> presentPaths;
+    unsigned int confCount = 0;
+    bool snapshotChanged = false;
+
+    for (unsigned int i = 0; i < fileNames.size(); i++) {
+        if (!StringHelper::hasEnding(fileNames[i], ".conf")) {
+            continue;
+        }
+
+        string filePath = basePath + fileNames[i];
+        ConfigFileStamp stamp;
+
+        if (!ModuleConfigSnapshot::getFileStamp(filePath, stamp)) {
+            continue;
+        }
+
+        presentPaths.insert(filePath);
+        confCount++;
+
+        map<string, FileRecord>::iterator record = this->_fileRecords.find(filePath);
+
+        if (record != this->_fileRecords.end() && record->second.stamp == stamp) {
+            if (record->second.parsed) {
+                ModuleConfigSnapshot::appendSections(record->second.sections, sections);
+                continue;
+            }
+
+            SectionMap snapshotSections;
+            if (this->readSections(record->second.sectionsOffset, snapshotSections)) {
+                ModuleConfigSnapshot::appendSections(snapshotSections, sections);
+                continue;
+            }
+        }
+
+        // New or changed configuration file
+        SWConfig config(filePath.c_str());
+        FileRecord& newRecord = this->_fileRecords[filePath];
+        newRecord.stamp = stamp;
+        newRecord.parsed = true;
+        newRecord.sections = config.getSections();
+
+        ModuleConfigSnapshot::appendSections(newRecord.sections, sections);
+        snapshotChanged = true;
+    }
+
+    // Forget the configuration files that have been removed from this directory
+    for (map<string, FileRecord>::iterator it = this->_fileRecords.begin(); it != this->_fileRecords.end();) {
+        const string& recordPath = it->first;
+        bool isInDir = (recordPath.compare(0, basePath.size(), basePath) == 0 &&
+                        recordPath.find_first_of("/\\", basePath.size()) == string::npos);
+
+        if (isInDir && presentPaths.find(recordPath) == presentPaths.end()) {
+            this->_fileRecords.erase(it++);
+            snapshotChanged = true;
+        } else {
+            it++;
+        }
+    }
+
+    if (snapshotChanged) {
+        this->writeSnapshot();
+    }
+
+    return confCount;
+}
+
+void ModuleConfigSnapshot::appendSections(const SectionMap& source, SectionMap& target)
+{
+    // Same semantics as SWConfig::operator+=
+    for (SectionMap::const_iterator section = source.begin(); section != source.end(); section++) {
+        ConfigEntMap& targetSection = target[section->first];
+
+        for (ConfigEntMap::const_iterator entry = section->second.begin(); entry != section->second.end(); entry++) {
+            targetSection.insert(ConfigEntMap::value_type(entry->first, entry->second));
+        }
+    }
+}
+
+bool ModuleConfigSnapshot::getFileStamp(string filePath, ConfigFileStamp& stamp)
+{
+#if defined(__linux__) || defined(__APPLE__) || defined(__ANDROID__)
+    struct stat fileStat;
+
+    if (stat(filePath.c_str(), &fileStat) != 0) {
+        return false;
+    }
+
+    #if defined(__APPLE__)
+        stamp.modificationTime = (unsigned long long)fileStat.st_mtimespec.tv_sec * 1000000000ULL + fileStat.st_mtimespec.tv_nsec;
+    #else
+        stamp.modificationTime = (unsigned long long)fileStat.st_mtim.tv_sec * 1000000000ULL + fileStat.st_mtim.tv_nsec;
+    #endif
+
+    stamp.size = (unsigned long long)fileStat.st_size;
+#elif _WIN32
+    FileSystemHelper fileSystemHelper;
+    wstring wFilePath = fileSystemHelper.convertUtf8StringToUtf16(filePath);
+    struct _stat64 fileStat;
+
+    WIN32_FILE_ATTRIBUTE_DATA fileAttributes;
+
+    if (!GetFileAttributesExW(wFilePath.c_str(), GetFileExInfoStandard, &fileAttributes)) {
+        return false;
+    }
+
+    // _wstat64 only has a resolution of one second, the FILETIME is given in intervals of 100 nanoseconds
+    stamp.modificationTime = (((unsigned long long)fileAttributes.ftLastWriteTime.dwHighDateTime << 32) |
+                              fileAttributes.ftLastWriteTime.dwLowDateTime) * 100ULL;
+    stamp.size = ((unsigned long long)fileAttributes.nFileSizeHigh << 32) | fileAttributes.nFileSizeLow;
+#endif
+
+    // Configuration files are small, so hashing them is cheap compared to parsing them
+    if (stamp.size == 0) {
+        stamp.contentHash = ModuleConfigSnapshot::getContentHash(0, 0);
+    } else {
+        MappedFile confFile;
+
+        if (!confFile.open(filePath)) {
+            return false;
+        }
+
+        stamp.contentHash = ModuleConfigSnapshot::getContentHash(confFile.getData(), confFile.getSize());
+    }
+
+    return true;
+}
+
+unsigned long long ModuleConfigSnapshot::getContentHash(const char* data, unsigned long long size)
+{
+    // 64 bit FNV-1a
+    unsigned long long hash = 14695981039346656037ULL;
+
+    for (unsigned long long i = 0; i < size; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+void ModuleConfigSnapshot::openSnapshot()
+{
+    if (!this->_mappedFile.open(this->_snapshotFilePath, SNAPSHOT_HEADER_SIZE)) {
+        return;
+    }
+
+    this->_data = this->_mappedFile.getData();
+    this->_dataSize = this->_mappedFile.getSize();
+
+    if (!this->readFileRecords()) {
+        // An invalid snapshot is ignored and replaced with the next load
+        cerr << "ModuleConfigSnapshot: Ignoring invalid snapshot " << this->_snapshotFilePath << endl;
+        this->_fileRecords.clear();
+        this->closeSnapshot();
+    }
+}
+
+void ModuleConfigSnapshot::closeSnapshot()
+{
+    if (this->_data == 0) {
+        return;
+    }
+
+    // Configurations that are still read from the snapshot need to be copied before the mapping is released
+    for (map<string, FileRecord>::iterator it = this->_fileRecords.begin(); it != this->_fileRecords.end(); it++) {
+        if (!it->second.parsed) {
+            it->second.parsed = this->readSections(it->second.sectionsOffset, it->second.sections);
+        }
+    }
+
+    this->_mappedFile.close();
+    this->_data = 0;
+    this->_dataSize = 0;
+}
+
+bool ModuleConfigSnapshot::readFileRecords()
+{
+    if (this->_dataSize < SNAPSHOT_HEADER_SIZE || memcmp(this->_data, SNAPSHOT_MAGIC, 4) != 0) {
+        return false;
+    }
+
+    unsigned long long offset = 4;
+    unsigned int version = 0;
+    unsigned int byteOrderMarker = 0;
+    unsigned int fileCount = 0;
+
+    if (!this->readUInt32(offset, version) || version != SNAPSHOT_VERSION ||
+        !this->readUInt32(offset, byteOrderMarker) || byteOrderMarker != SNAPSHOT_BYTE_ORDER_MARKER ||
+        !this->readUInt32(offset, this->_stringCount) ||
+        !this->readUInt32(offset, fileCount) ||
+        !this->readUInt64(offset, this->_stringTableOffset)) {
+        return false;
+    }
+
+    if (this->_stringTableOffset > this->_dataSize ||
+        (unsigned long long)this->_stringCount * 8 > this->_dataSize - this->_stringTableOffset) {
+        return false;
+    }
+
+    for (unsigned int i = 0; i < fileCount; i++) {
+        string filePath;
+        FileRecord record;
+        unsigned int sectionCount = 0;
+
+        if (!this->readString(offset, filePath) ||
+            !this->readUInt64(offset, record.stamp.modificationTime) ||
+            !this->readUInt64(offset, record.stamp.size) ||
+            !this->readUInt64(offset, record.stamp.contentHash)) {
+            return false;
+        }
+
+        record.sectionsOffset = offset;
+
+        // Skip the sections, they are only read when the file is loaded
+        if (!this->readUInt32(offset, sectionCount)) {
+            return false;
+        }
+
+        for (unsigned int j = 0; j < sectionCount; j++) {
+            unsigned int name = 0;
+            unsigned int entryCount = 0;
+
+            if (!this->readUInt32(offset, name) || !this->readUInt32(offset, entryCount) ||
+                (unsigned long long)entryCount * 8 > this->_stringTableOffset - offset) {
+                return false;
+            }
+
+            offset += (unsigned long long)entryCount * 8;
+        }
+
+        this->_fileRecords[filePath] = record;
+    }
+
+    return true;
+}
+
+bool ModuleConfigSnapshot::readSections(unsigned long long offset, SectionMap& sections)
+{
+    if (this->_data == 0) {
+        return false;
+    }
+
+    unsigned int sectionCount = 0;
+    if (!this->readUInt32(offset, sectionCount)) {
+        return false;
+    }
+
+    for (unsigned int i = 0; i < sectionCount; i++) {
+        string sectionName;
+        unsigned int entryCount = 0;
+
+        if (!this->readString(offset, sectionName) || !this->readUInt32(offset, entryCount)) {
+            return false;
+        }
+
+        ConfigEntMap& section = sections[sectionName.c_str()];
+
+        for (unsigned int j = 0; j < entryCount; j++) {
+            string key;
+            string value;
+
+            if (!this->readString(offset, key) || !this->readString(offset, value)) {
+                return false;
+            }
+
+            section.insert(ConfigEntMap::value_type(key.c_str(), value.c_str()));
+        }
+    }
+
+    return true;
+}
+
+bool ModuleConfigSnapshot::readUInt32(unsigned long long& offset, unsigned int& value)
+{
+    if (offset + 4 > this->_dataSize) {
+        return false;
+    }
+
+    memcpy(&value, this->_data + offset, 4);
+    offset += 4;
+    return true;
+}
+
+bool ModuleConfigSnapshot::readUInt64(unsigned long long& offset, unsigned long long& value)
+{
+    if (offset + 8 > this->_dataSize) {
+        return false;
+    }
+
+    memcpy(&value, this->_data + offset, 8);
+    offset += 8;
+    return true;
+}
+
+bool ModuleConfigSnapshot::readString(unsigned long long& offset, string& value)
+{
+    unsigned int stringIndex = 0;
+    if (!this->readUInt32(offset, stringIndex) || stringIndex >= this->_stringCount) {
+        return false;
+    }
+
+    unsigned long long tableOffset = this->_stringTableOffset + (unsigned long long)stringIndex * 8;
+    unsigned long long stringDataOffset = this->_stringTableOffset + (unsigned long long)this->_stringCount * 8;
+    unsigned int stringOffset = 0;
+    unsigned int stringLength = 0;
+
+    if (!this->readUInt32(tableOffset, stringOffset) || !this->readUInt32(tableOffset, stringLength) ||
+        stringDataOffset + stringOffset + stringLength > this->_dataSize) {
+        return false;
+    }
+
+    value.assign(this->_data + stringDataOffset + stringOffset, stringLength);
+    return true;
+}
+
+bool ModuleConfigSnapshot::writeSnapshot()
+{
+    vector<char> records;
+    vector<string> strings;
+    unordered_map<string, unsigned int> stringIndices;
+
+    std::function<void(const void*, size_t)> append = [&records](const void* data, size_t length) {
+        records.insert(records.end(), (const char*)data, (const char*)data + length);
+    };
+
+    std::function<void(unsigned int)> appendUInt32 = [&append](unsigned int value) {
+        append(&value, 4);
+    };
+
+    std::function<void(const string&)> appendString = [&](const string& value) {
+        unordered_map<string, unsigned int>::iterator it = stringIndices.find(value);
+        unsigned int stringIndex = 0;
+
+        if (it != stringIndices.end()) {
+            stringIndex = it->second;
+        } else {
+            stringIndex = (unsigned int)strings.size();
+            stringIndices[value] = stringIndex;
+            strings.push_back(value);
+        }
+
+        appendUInt32(stringIndex);
+    };
+
+    unsigned int fileCount = 0;
+
+    for (map<string, FileRecord>::iterator it = this->_fileRecords.begin(); it != this->_fileRecords.end(); it++) {
+        SectionMap snapshotSections;
+        const SectionMap* sections = &(it->second.sections);
+
+        if (!it->second.parsed) {
+            if (!this->readSections(it->second.sectionsOffset, snapshotSections)) {
+                continue;
+            }
+
+            sections = &snapshotSections;
+        }
+
+        appendString(it->first);
+        append(&(it->second.stamp.modificationTime), 8);
+        append(&(it->second.stamp.size), 8);
+        append(&(it->second.stamp.contentHash), 8);
+        appendUInt32((unsigned int)sections->size());
+
+        for (SectionMap::const_iterator section = sections->begin(); section != sections->end(); section++) {
+            appendString(string(section->first.c_str()));
+            appendUInt32((unsigned int)section->second.size());
+
+            for (ConfigEntMap::const_iterator entry = section->second.begin(); entry != section->second.end(); entry++) {
+                appendString(string(entry->first.c_str()));
+                appendString(string(entry->second.c_str()));
+            }
+        }
+
+        fileCount++;
+    }
+
+    vector<char> header;
+    unsigned int version = SNAPSHOT_VERSION;
+    unsigned int byteOrderMarker = SNAPSHOT_BYTE_ORDER_MARKER;
+    unsigned int stringCount = (unsigned int)strings.size();
+    unsigned long long stringTableOffset = SNAPSHOT_HEADER_SIZE + records.size();
+
+    header.insert(header.end(), SNAPSHOT_MAGIC, SNAPSHOT_MAGIC + 4);
+    header.insert(header.end(), (const char*)&version, (const char*)&version + 4);
+    header.insert(header.end(), (const char*)&byteOrderMarker, (const char*)&byteOrderMarker + 4);
+    header.insert(header.end(), (const char*)&stringCount, (const char*)&stringCount + 4);
+    header.insert(header.end(), (const char*)&fileCount, (const char*)&fileCount + 4);
+    header.insert(header.end(), (const char*)&stringTableOffset, (const char*)&stringTableOffset + 8);
+
+    vector<char> stringTable;
+    vector<char> stringData;
+
+    for (unsigned int i = 0; i < strings.size(); i++) {
+        unsigned int stringOffset = (unsigned int)stringData.size();
+        unsigned int stringLength = (unsigned int)strings[i].size();
+
+        stringTable.insert(stringTable.end(), (const char*)&stringOffset, (const char*)&stringOffset + 4);
+        stringTable.insert(stringTable.end(), (const char*)&stringLength, (const char*)&stringLength + 4);
+        stringData.insert(stringData.end(), strings[i].begin(), strings[i].end());
+    }
+
+    vector<char> snapshot;
+    snapshot.reserve(header.size() + records.size() + stringTable.size() + stringData.size());
+    snapshot.insert(snapshot.end(), header.begin(), header.end());
+    snapshot.insert(snapshot.end(), records.begin(), records.end());
+    snapshot.insert(snapshot.end(), stringTable.begin(), stringTable.end());
+    snapshot.insert(snapshot.end(), stringData.begin(), stringData.end());
+
+    // The current mapping refers to the file that is replaced
+    this->closeSnapshot();
+
+    return MappedFile::writeFile(this->_snapshotFilePath, snapshot);
+}
@@ -0,0 +1,103 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef _MODULE_CONFIG_SNAPSHOT
+#define _MODULE_CONFIG_SNAPSHOT
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+
+#include <swconfig.h>
+
+#include "mapped_file.hpp"
+
+// The modification time, size and content hash of a configuration file at the time it was parsed
+class ConfigFileStamp {
+public:
+    unsigned long long modificationTime = 0;
+    unsigned long long size = 0;
+    unsigned long long contentHash = 0;
+
+    bool operator==(const ConfigFileStamp& other) const {
+        return (this->modificationTime == other.modificationTime && this->size == other.size &&
+                this->contentHash == other.contentHash);
+    }
+};
+
+/**
+ * A binary snapshot of the parsed module configurations (the .conf files in mods.d) of all module directories.
+ *
+ * The snapshot file is mapped into memory with a single mmap when it is opened. Keys and values are interned in a
+ * string table, so every distinct string is stored only once. A configuration file is only parsed again if its
+ * modification time, size or content hash differ from the stamp stored in the snapshot. The content hash catches
+ * changes that keep the size within the resolution of the file system's timestamps. The snapshot file is rewritten after
+ * a directory has been loaded with changed, new or removed configuration files.
+ *
+ * One snapshot is shared by all SWMgr instances of the process, so all methods are thread safe.
+ */
+class ModuleConfigSnapshot {
+public:
+    ModuleConfigSnapshot(std::string snapshotFilePath);
+    virtual ~ModuleConfigSnapshot();
+
+    // Adds the sections of all configuration files in dirPath to the given sections, like SWMgr::loadConfigDir.
+    // Returns the number of configuration files.
+    unsigned int loadConfigDir(std::string dirPath, sword::SectionMap& sections);
+
+private:
+    class FileRecord {
+    public:
+        ConfigFileStamp stamp;
+
+        // Offset of the sections in the mapped snapshot. Only used if parsed is false.
+        unsigned long long sectionsOffset = 0;
+
+        // Configurations parsed in this process
+        bool parsed = false;
+        sword::SectionMap sections;
+    };
+
+    void openSnapshot();
+    void closeSnapshot();
+    bool readFileRecords();
+    bool readSections(unsigned long long offset, sword::SectionMap& sections);
+    bool readUInt32(unsigned long long& offset, unsigned int& value);
+    bool readUInt64(unsigned long long& offset, unsigned long long& value);
+    bool readString(unsigned long long& offset, std::string& value);
+    bool writeSnapshot();
+
+    static bool getFileStamp(std::string filePath, ConfigFileStamp& stamp);
+    static unsigned long long getContentHash(const char* data, unsigned long long size);
+    static void appendSections(const sword::SectionMap& source, sword::SectionMap& target);
+
+    std::string _snapshotFilePath;
+    std::map<std::string, FileRecord> _fileRecords;
+    std::mutex _snapshotMutex;
+
+    // The mapped snapshot file
+    MappedFile _mappedFile;
+    const char* _data = 0;
+    unsigned long long _dataSize = 0;
+    unsigned int _stringCount = 0;
+    unsigned long long _stringTableOffset = 0;
+};
+
+#endif // _MODULE_CONFIG_SNAPSHOT
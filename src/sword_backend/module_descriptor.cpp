@@ -0,0 +1,127 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+// Std includes
+#include <iostream>
+
+// Sword includes
+#include <swmodule.h>
+
+// Own includes
+#include "module_descriptor.hpp"
+#include "module_helper.hpp"
+#include "module_store.hpp"
+
+using namespace std;
+using namespace sword;
+
+// Enough for the modules of all CrossWire repositories and the installed modules
+#define MODULE_DESCRIPTOR_CACHE_MAX_ENTRIES 8192
+
+shared_ptr<const ModuleDescriptor> ModuleDescriptorCache::getDescriptor(SWModule* module)
+{
+    if (module == 0) {
+        cerr << "getDescriptor: module is zero pointer!" << endl;
+        return shared_ptr<const ModuleDescriptor>();
+    }
+
+    // Repository modules and installed modules with the same name are located in different directories
+    string cacheKey = string(module->getName()) + '\n' + this->getConfigEntry(module, "AbsoluteDataPath");
+    const ConfigEntMap& config = module->getConfig();
+
+    lock_guard<mutex> lock(this->_entriesMutex);
+    unordered_map<string, CacheEntry>::iterator it = this->_entries.find(cacheKey);
+
+    if (it != this->_entries.end()) {
+        // Move the entry to the end of the order, so that the least recently used entries are dropped first
+        this->_entryOrder.splice(this->_entryOrder.end(), this->_entryOrder, it->second.orderPosition);
+
+        // Any config entry (e.g. Description, About or InstallSourceCaption) may have changed since the descriptor has been created
+        if (it->second.config == config) {
+            return it->second.descriptor;
+        }
+
+        it->second.config = config;
+        it->second.descriptor = this->createDescriptor(module);
+        return it->second.descriptor;
+    }
+
+    while (this->_entries.size() >= MODULE_DESCRIPTOR_CACHE_MAX_ENTRIES) {
+        this->_entries.erase(this->_entryOrder.front());
+        this->_entryOrder.pop_front();
+    }
+
+    CacheEntry& entry = this->_entries[cacheKey];
+    entry.config = config;
+    entry.descriptor = this->createDescriptor(module);
+    entry.orderPosition = this->_entryOrder.insert(this->_entryOrder.end(), cacheKey);
+
+    return entry.descriptor;
+}
+
+shared_ptr<const ModuleDescriptor> ModuleDescriptorCache::createDescriptor(SWModule* module)
+{
+    shared_ptr<ModuleDescriptor> descriptor = make_shared<ModuleDescriptor>();
+
+    descriptor->name = module->getName();
+    descriptor->type = module->getType();
+    descriptor->category = this->getConfigEntry(module, "Category");
+    descriptor->description = module->getDescription();
+    descriptor->language = module->getLanguage();
+    descriptor->location = this->_moduleStore.getModuleDataPath(module);
+
+    descriptor->abbreviation = this->getConfigEntry(module, "Abbreviation");
+    descriptor->about = this->getConfigEntry(module, "About");
+    descriptor->distributionLicense = this->getConfigEntry(module, "DistributionLicense");
+    descriptor->shortCopyright = this->getConfigEntry(module, "ShortCopyright");
+    descriptor->version = this->getConfigEntry(module, "Version");
+    descriptor->lastUpdate = this->getConfigEntry(module, "SwordVersionDate");
+    descriptor->isRightToLeft = (this->getConfigEntry(module, "Direction") == "RtoL");
+    descriptor->repository = this->getConfigEntry(module, "InstallSourceCaption");
+
+    string configInstallSize = this->getConfigEntry(module, "InstallSize");
+    if (configInstallSize.length() > 0 &&
+        configInstallSize.find_first_not_of("0123456789") == string::npos) {
+        descriptor->size = stoi(configInstallSize);
+    }
+
+    descriptor->locked = (module->getConfigEntry("CipherKey") != 0);
+    if (descriptor->locked) {
+        descriptor->unlockInfo = this->getConfigEntry(module, "UnlockInfo");
+    }
+
+    descriptor->inUserDir = this->_moduleStore.isModuleInUserDir(module);
+    descriptor->hasStrongs = this->_moduleHelper.moduleHasGlobalOption(module, "Strongs");
+    descriptor->hasFootnotes = this->_moduleHelper.moduleHasGlobalOption(module, "Footnotes");
+    descriptor->hasHeadings = this->_moduleHelper.moduleHasGlobalOption(module, "Headings");
+    descriptor->hasRedLetterWords = this->_moduleHelper.moduleHasGlobalOption(module, "RedLetter");
+    descriptor->hasCrossReferences = this->_moduleHelper.moduleHasGlobalOption(module, "Scripref");
+
+    descriptor->hasGreekStrongsKeys = this->_moduleHelper.moduleHasFeature(module, "GreekDef");
+    descriptor->hasHebrewStrongsKeys = this->_moduleHelper.moduleHasFeature(module, "HebrewDef");
+
+    descriptor->history = this->_moduleHelper.getModuleHistoryEntries(module);
+
+    return descriptor;
+}
+
+string ModuleDescriptorCache::getConfigEntry(SWModule* module, const char* key)
+{
+    const char* configEntry = module->getConfigEntry(key);
+    return (configEntry != 0) ? string(configEntry) : "";
+}
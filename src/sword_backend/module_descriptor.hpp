@@ -0,0 +1,106 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef _MODULE_DESCRIPTOR
+#define _MODULE_DESCRIPTOR
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <list>
+#include <unordered_map>
+
+#include <swconfig.h>
+
+namespace sword {
+    class SWModule;
+};
+
+class ModuleHelper;
+class ModuleStore;
+
+// The module properties that are exposed to JavaScript, extracted from the module configuration
+class ModuleDescriptor
+{
+public:
+    ModuleDescriptor() {}
+    virtual ~ModuleDescriptor() {}
+
+    std::string name;
+    std::string type;
+    std::string category;
+    std::string description;
+    std::string language;
+    std::string location;
+    std::string abbreviation;
+    std::string about;
+    std::string distributionLicense;
+    std::string shortCopyright;
+    std::string version;
+    std::string lastUpdate;
+    bool isRightToLeft = false;
+    std::string repository;
+    int size = -1;
+    bool locked = false;
+    std::string unlockInfo;
+    bool inUserDir = false;
+    bool hasStrongs = false;
+    bool hasFootnotes = false;
+    bool hasHeadings = false;
+    bool hasRedLetterWords = false;
+    bool hasCrossReferences = false;
+    bool hasGreekStrongsKeys = false;
+    bool hasHebrewStrongsKeys = false;
+    std::vector<std::string> history;
+};
+
+/**
+ * Caches one ModuleDescriptor per module location. A descriptor is recreated when the config section of the module
+ * has changed (e.g. after a repository refresh or an update of the module), which is a plain comparison of the config
+ * entries. The cache holds the descriptors of the most recently used modules and drops the oldest ones beyond that.
+ */
+class ModuleDescriptorCache
+{
+public:
+    ModuleDescriptorCache(ModuleHelper& moduleHelper, ModuleStore& moduleStore)
+        : _moduleHelper(moduleHelper), _moduleStore(moduleStore) {}
+
+    virtual ~ModuleDescriptorCache() {}
+
+    std::shared_ptr<const ModuleDescriptor> getDescriptor(sword::SWModule* module);
+
+private:
+    class CacheEntry {
+    public:
+        sword::ConfigEntMap config;
+        std::shared_ptr<const ModuleDescriptor> descriptor;
+        std::list<std::string>::iterator orderPosition;
+    };
+
+    std::shared_ptr<const ModuleDescriptor> createDescriptor(sword::SWModule* module);
+    std::string getConfigEntry(sword::SWModule* module, const char* key);
+
+    ModuleHelper& _moduleHelper;
+    ModuleStore& _moduleStore;
+    std::unordered_map<std::string, CacheEntry> _entries;
+    std::list<std::string> _entryOrder;
+    std::mutex _entriesMutex;
+};
+
+#endif // _MODULE_DESCRIPTOR
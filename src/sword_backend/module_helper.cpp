@@ -89,20 +89,26 @@ bool ModuleHelper::moduleHasBook(sword::SWModule* module, std::string bookCode)
 
 vector<string> ModuleHelper::getBookList(string moduleName)
 {
-    string currentBookName = "";
-    vector<string> bookList;
     SWModule* module = this->_moduleStore.getLocalModule(moduleName);
 
     if (module == 0) {
         cerr << "getLocalModule returned zero pointer for " << moduleName << endl;
-    } else {
-        VerseKey *vk = (VerseKey *)module->getKey();
+        return vector<string>();
+    }
 
-        for ((*vk) = TOP; !vk->popError(); vk->setBook(vk->getBook()+1)) {
-            if (module->hasEntry(vk)) {
-                currentBookName = vk->getOSISBookName();
-                bookList.push_back(currentBookName);
-            }
+    return this->getBookList(module);
+}
+
+vector<string> ModuleHelper::getBookList(SWModule* module)
+{
+    string currentBookName = "";
+    vector<string> bookList;
+    VerseKey *vk = (VerseKey *)module->getKey();
+
+    for ((*vk) = TOP; !vk->popError(); vk->setBook(vk->getBook()+1)) {
+        if (module->hasEntry(vk)) {
+            currentBookName = vk->getOSISBookName();
+            bookList.push_back(currentBookName);
         }
     }
 
@@ -112,42 +118,48 @@ vector<string> ModuleHelper::getBookList(string moduleName)
 int ModuleHelper::getBookChapterCount(std::string moduleName, std::string bookCode)
 {
     SWModule* module = this->_moduleStore.getLocalModule(moduleName);
-    int bookChapterCount = -1;
 
     if (module == 0) {
         cerr << "getLocalModule returned zero pointer for " << moduleName << endl;
-    } else {
-        stringstream key;
-        key << bookCode;
-        key << " 1:1";
+        return -1;
+    }
 
-        module->setKey(key.str().c_str());
-        VerseKey currentVerseKey(module->getKey());
+    return this->getBookChapterCount(module, bookCode);
+}
 
-        bookChapterCount = currentVerseKey.getChapterMax();
-    }
+int ModuleHelper::getBookChapterCount(SWModule* module, std::string bookCode)
+{
+    stringstream key;
+    key << bookCode;
+    key << " 1:1";
 
-    return bookChapterCount;
+    module->setKey(key.str().c_str());
+    VerseKey currentVerseKey(module->getKey());
+
+    return currentVerseKey.getChapterMax();
 }
 
 int ModuleHelper::getChapterVerseCount(std::string moduleName, std::string bookCode, int chapter)
 {
     SWModule* module = this->_moduleStore.getLocalModule(moduleName);
-    int chapterVerseCount = -1;
 
     if (module == 0) {
         cerr << "getLocalModule returned zero pointer for " << moduleName << endl;
-    } else {
-        stringstream key;
-        key << bookCode << " " << chapter << ":1";
+        return -1;
+    }
 
-        module->setKey(key.str().c_str());
-        VerseKey currentVerseKey(module->getKey());
+    return this->getChapterVerseCount(module, bookCode, chapter);
+}
 
-        chapterVerseCount = currentVerseKey.getVerseMax();
-    }
+int ModuleHelper::getChapterVerseCount(SWModule* module, std::string bookCode, int chapter)
+{
+    stringstream key;
+    key << bookCode << " " << chapter << ":1";
+
+    module->setKey(key.str().c_str());
+    VerseKey currentVerseKey(module->getKey());
 
-    return chapterVerseCount;
+    return currentVerseKey.getVerseMax();
 }
 
 map<string, int> ModuleHelper::getAbsoluteVerseNumberMap(SWModule* module, vector<string> bookList)
@@ -160,7 +172,7 @@ map<string, int> ModuleHelper::getAbsoluteVerseNumberMap(SWModule* module, vecto
     std::map<std::string, int> absoluteVerseNumbers;
 
     if (bookList.size() == 0) {
-        bookList = this->getBookList(string(module->getName()));
+        bookList = this->getBookList(module);
     }
 
     for (unsigned int i = 0; i < bookList.size(); i++) {
@@ -47,6 +47,9 @@ public:
     std::vector<std::string> getBookList(std::string moduleName);
     int getBookChapterCount(std::string moduleName, std::string bookCode);
     int getChapterVerseCount(std::string moduleName, std::string bookCode, int chapter);
+    std::vector<std::string> getBookList(sword::SWModule* module);
+    int getBookChapterCount(sword::SWModule* module, std::string bookCode);
+    int getChapterVerseCount(sword::SWModule* module, std::string bookCode, int chapter);
     std::map<std::string, int> getAbsoluteVerseNumberMap(sword::SWModule* module, std::vector<std::string> bookList={});
     bool isBrokenMarkupModule(std::string moduleName);
     bool isInconsistentClosingEndDivModule(std::string moduleName);
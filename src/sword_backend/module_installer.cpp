@@ -18,15 +18,22 @@
 
 // std includes
 #include <iostream>
+#include <future>
 
 // Sword includes
 #include <swmgr.h>
 #include <installmgr.h>
+#include <filemgr.h>
 
 // Own includes
 #include "repository_interface.hpp"
 #include "module_installer.hpp"
 #include "module_store.hpp"
+#include "sword_status_reporter.hpp"
+#include "percentage_calc.hpp"
+#include "thread_pool.hpp"
+#include "reloadable_sword_mgr.hpp"
+#include "sword_file_lock.hpp"
 
 using namespace std;
 using namespace sword;
@@ -35,21 +42,37 @@ ModuleInstaller::ModuleInstaller(RepositoryInterface& repoInterface, ModuleStore
     : _repoInterface(repoInterface), _moduleStore(moduleStore)
 {
     this->_fileSystemHelper.setCustomHomeDir(customHomeDir);
-    this->_mgrForInstall = new SWMgr(this->_fileSystemHelper.getUserSwordDir().c_str());
+
+    // The InstallMgr only needs the module configurations, so the module drivers of this manager are never created
+    SwordFileLock fileLock;
+    this->_mgrForInstall = new ReloadableSwordMgr(this->_fileSystemHelper.getUserSwordDir().c_str(), false);
+    this->_mgrForInstall->setConfigSnapshot(this->_moduleStore.getConfigSnapshot());
+    this->_mgrForInstall->setModuleCreationDeferred(true);
+    this->_mgrForInstall->load();
+    this->_streamingInstaller.setTimeoutMillis(this->_repoInterface.getTimeoutMillis());
 }
 
 ModuleInstaller::~ModuleInstaller()
 {
     if (this->_mgrForInstall != 0) {
+        SwordFileLock fileLock;
         delete this->_mgrForInstall;
     }
 }
 
 void ModuleInstaller::refreshMgr()
 {
+    SwordFileLock fileLock;
+    lock_guard<mutex> lock(this->_mgrForInstallMutex);
     this->_mgrForInstall->augmentModules(this->_fileSystemHelper.getUserSwordDir().c_str());
 }
 
+string ModuleInstaller::getModuleVersion(SWModule* module)
+{
+    const char* version = module->getConfigEntry("Version");
+    return (version != 0) ? string(version) : "";
+}
+
 void ModuleInstaller::resetAllMgrs()
 {
     this->_repoInterface.resetMgr();
@@ -57,44 +80,330 @@ void ModuleInstaller::resetAllMgrs()
     this->refreshMgr();
 }
 
-int ModuleInstaller::installModule(string repoName, string moduleName)
+void ModuleInstaller::reloadModule(string moduleName)
 {
-    InstallSource* remoteSource = this->_repoInterface.getRemoteSource(repoName);
+    this->_moduleStore.reloadModule(moduleName);
+
+    string userSwordDir = this->_fileSystemHelper.getUserSwordDir();
+    string confFilePath = ReloadableSwordMgr::findModuleConf(this->_fileSystemHelper.getModuleDir(), moduleName);
+
+    // The module store has already released the file lock, since it takes its manager lock first
+    SwordFileLock fileLock;
+    lock_guard<mutex> lock(this->_mgrForInstallMutex);
+
+    if (confFilePath == "" || this->_mgrForInstall->reloadModule(moduleName, confFilePath, userSwordDir) != 0) {
+        this->_mgrForInstall->evictModule(moduleName);
+    }
+}
+
+int ModuleInstaller::installModule(string repoName, string moduleName, SwordStatusReporter* statusReporter)
+{
+    if (statusReporter == 0) {
+        statusReporter = &(this->_repoInterface.getStatusReporter());
+    }
+
+    // The references keep the source and the repository module valid, even if the repositories are refreshed in the meantime
+    shared_ptr<InstallMgr> repoInstallMgr = this->_repoInterface.getInstallMgr();
+    shared_ptr<const RepositoryCatalog> catalog = this->_repoInterface.getCatalog();
+
+    InstallSource* remoteSource = this->_repoInterface.getRemoteSource(repoName, repoInstallMgr.get());
     if (remoteSource == 0) {
         cerr << "Couldn't find remote source " << repoName << endl;
         return -1;
     }
 
-    SWMgr *remoteMgr = remoteSource->getMgr();
-    ModMap::iterator it = remoteMgr->Modules.find(moduleName.c_str());
-
-    if (it == remoteMgr->Modules.end()) {
+    SWModule* repoModule = catalog->getModule(repoName, moduleName);
+    if (repoModule == 0) {
         cerr << "Did not find module " << moduleName << " in repository " << repoName << endl;
         return -1;
+    }
+
+    this->_installationCancelled = false;
+
+    // The module package is extracted while it is downloaded. If the repository does not publish packages
+    // or the package is not usable, the module is installed file by file via the InstallMgr.
+    int result = this->_streamingInstaller.installModule(remoteSource,
+                                                         moduleName,
+                                                         this->getModuleVersion(repoModule),
+                                                         this->_fileSystemHelper.getUserSwordDir(),
+                                                         statusReporter,
+                                                         this->_installationCancelled);
+
+    if (result == STREAMING_INSTALL_INTERRUPTED) {
+        // The download is resumed by the next installation of the module
+        result = -1;
+    } else if (result != 0 && result != -9) {
+        if (this->_repoInterface.prepareSourceForInstall(repoName) != 0) {
+            return -1;
+        }
+
+        // A separate InstallMgr is used, so that the progress is reported to the status reporter of this installation
+        InstallMgr* installMgr = this->_repoInterface.createInstallMgr(statusReporter);
+
+        this->_runningInstallMutex.lock();
+        this->_runningInstallMgrs.insert(installMgr);
+        this->_runningInstallMutex.unlock();
+
+        // Like in the lanes of installModules, the InstallMgr only uses the paths of an unloaded destination manager
+        SWMgr destMgr(this->_fileSystemHelper.getUserSwordDir().c_str(), false, 0, false, false);
+        InstallSourceMap::iterator source = installMgr->sources.find(repoName.c_str());
+        result = -1;
+
+        if (source != installMgr->sources.end() && !this->_installationCancelled) {
+            // The SWORD transport writes the module files through the FileMgr
+            SwordFileLock fileLock;
+            result = installMgr->installModule(&destMgr, 0, moduleName.c_str(), source->second);
+        }
+
+        this->_runningInstallMutex.lock();
+        this->_runningInstallMgrs.erase(installMgr);
+        this->_runningInstallMutex.unlock();
+
+        SwordFileLock fileLock;
+        delete installMgr;
+    }
+
+    // Only the installed module is loaded. A failed installation may have left parts of the module behind,
+    // so the module is also reloaded in that case.
+    this->reloadModule(moduleName);
+
+    if (result != 0) {
+        // cerr << "Error installing module: " << moduleName << " (write permissions?)" << endl;
+        return result;
     } else {
-        int result = this->_repoInterface.getInstallMgr()->installModule(this->_mgrForInstall, 0, moduleName.c_str(), remoteSource);
-        this->resetAllMgrs();
-
-        if (result != 0) {
-            // cerr << "Error installing module: " << moduleName << " (write permissions?)" << endl;
-            return result;
-        } else {
-            return 0;
+        return 0;
+    }
+}
+
+unsigned int ModuleInstaller::installModules(vector<ModuleInstallRequest>& requests,
+                                             std::function<void(unsigned int totalPercent, std::string message)>* progressCallback,
+                                             unsigned int maxParallelInstalls)
+{
+    this->_installationCancelled = false;
+
+    if (maxParallelInstalls == 0) {
+        maxParallelInstalls = 1;
+    }
+
+    // Unknown modules are rejected and the sources are prepared before any transfer is started
+    vector<unsigned int> pendingRequests;
+    vector<string> expectedVersions(requests.size());
+    string swordDir = this->_fileSystemHelper.getUserSwordDir();
+    shared_ptr<const RepositoryCatalog> catalog = this->_repoInterface.getCatalog();
+
+    for (unsigned int i = 0; i < requests.size(); i++) {
+        ModuleInstallRequest& request = requests[i];
+        request.result = -1;
+
+        SWModule* repoModule = catalog->getModule(request.repoName, request.moduleName);
+        if (repoModule == 0) {
+            cerr << "Did not find module " << request.moduleName << " in repository " << request.repoName << endl;
+            continue;
+        }
+
+        if (this->_repoInterface.prepareSourceForInstall(request.repoName) != 0) {
+            continue;
+        }
+
+        expectedVersions[i] = this->getModuleVersion(repoModule);
+        request.result = -9;
+        pendingRequests.push_back(i);
+    }
+
+    // Byte counts per request. The total is -1 as long as the transfer of a module has not started.
+    vector<long long> totalBytes(requests.size(), -1);
+    vector<long long> completedBytes(requests.size(), 0);
+    unsigned int nextPendingRequest = 0;
+    mutex progressMutex;
+
+    // Must be called with the progressMutex held
+    std::function<void(string)> reportProgress = [&](string message) {
+        if (progressCallback == 0) {
+            return;
+        }
+
+        long long knownTotalBytes = 0;
+        long long doneBytes = 0;
+        unsigned int knownCount = 0;
+
+        for (unsigned int i = 0; i < pendingRequests.size(); i++) {
+            unsigned int requestIndex = pendingRequests[i];
+            doneBytes += completedBytes[requestIndex];
+
+            if (totalBytes[requestIndex] >= 0) {
+                knownTotalBytes += totalBytes[requestIndex];
+                knownCount++;
+            }
+        }
+
+        // Modules that have not been started yet are estimated with the average size of the known ones
+        double estimatedTotalBytes = (double)knownTotalBytes;
+        if (knownCount > 0) {
+            estimatedTotalBytes += (double)knownTotalBytes / knownCount * (pendingRequests.size() - knownCount);
+        }
+
+        unsigned int totalPercent = 0;
+        if (estimatedTotalBytes > 0) {
+            totalPercent = (unsigned int)calculateIntPercentage<double>((double)doneBytes, estimatedTotalBytes);
+        }
+
+        (*progressCallback)(totalPercent, message);
+    };
+
+    // Each lane uses its own InstallMgr, because an InstallMgr only supports one transfer at a time
+    std::function<int()> laneTask = [&]() {
+        SwordStatusReporter laneStatusReporter;
+        InstallMgr* laneInstallMgr = this->_repoInterface.createInstallMgr(&laneStatusReporter);
+
+        // InstallMgr::installModule only uses the paths of the destination manager. Each lane gets its own manager
+        // that is not loaded, so that the lanes do not share the install manager. The modules are loaded at the end.
+        SWMgr laneDestMgr(swordDir.c_str(), false, 0, false, false);
+
+        this->_runningInstallMutex.lock();
+        this->_runningInstallMgrs.insert(laneInstallMgr);
+        this->_runningInstallMutex.unlock();
+
+        unsigned int currentRequest = 0;
+        long long currentCompletedBytes = 0;
+
+        std::function<void(long, long, const char*)> preStatusCallback = [&](long moduleTotalBytes, long moduleCompletedBytes, const char* message) {
+            lock_guard<mutex> lock(progressMutex);
+            totalBytes[currentRequest] = moduleTotalBytes;
+            completedBytes[currentRequest] = moduleCompletedBytes;
+            currentCompletedBytes = moduleCompletedBytes;
+            reportProgress(string(message));
+        };
+
+        std::function<void(unsigned long, unsigned long)> updateCallback = [&](unsigned long fileTotalBytes, unsigned long fileCompletedBytes) {
+            lock_guard<mutex> lock(progressMutex);
+            completedBytes[currentRequest] = currentCompletedBytes + (long long)fileCompletedBytes;
+            reportProgress("");
+        };
+
+        laneStatusReporter.setCallBacks(&preStatusCallback, &updateCallback);
+
+        for (;;) {
+            {
+                lock_guard<mutex> lock(progressMutex);
+                if (nextPendingRequest >= pendingRequests.size() || this->_installationCancelled) {
+                    break;
+                }
+
+                currentRequest = pendingRequests[nextPendingRequest++];
+                currentCompletedBytes = 0;
+            }
+
+            ModuleInstallRequest& request = requests[currentRequest];
+            InstallSourceMap::iterator source = laneInstallMgr->sources.find(request.repoName.c_str());
+            int result = -1;
+
+            if (source != laneInstallMgr->sources.end()) {
+                result = this->_streamingInstaller.installModule(source->second,
+                                                                 request.moduleName,
+                                                                 expectedVersions[currentRequest],
+                                                                 swordDir,
+                                                                 &laneStatusReporter,
+                                                                 this->_installationCancelled);
+
+                if (result == STREAMING_INSTALL_INTERRUPTED) {
+                    result = -1;
+                } else if (result != 0 && result != -9) {
+                    SwordFileLock fileLock;
+                    result = laneInstallMgr->installModule(&laneDestMgr, 0, request.moduleName.c_str(), source->second);
+                }
+            }
+
+            lock_guard<mutex> lock(progressMutex);
+            request.result = result;
+
+            // A finished module (also a failed one) counts as completed with the bytes transferred so far
+            if (totalBytes[currentRequest] < 0 || result != 0) {
+                totalBytes[currentRequest] = completedBytes[currentRequest];
+            } else {
+                completedBytes[currentRequest] = totalBytes[currentRequest];
+            }
+
+            reportProgress("");
+        }
+
+        laneStatusReporter.resetCallbacks();
+
+        this->_runningInstallMutex.lock();
+        this->_runningInstallMgrs.erase(laneInstallMgr);
+        this->_runningInstallMutex.unlock();
+
+        SwordFileLock fileLock;
+        delete laneInstallMgr;
+        return 0;
+    };
+
+    unsigned int laneCount = maxParallelInstalls;
+    if (laneCount > pendingRequests.size()) {
+        laneCount = pendingRequests.size();
+    }
+
+    vector<future<int>> laneFutures;
+    for (unsigned int i = 0; i < laneCount; i++) {
+        laneFutures.push_back(ThreadPool::getInstance().submit<int>(TaskPriority::network, laneTask));
+    }
+
+    for (unsigned int i = 0; i < laneFutures.size(); i++) {
+        ThreadPool::getInstance().waitFor(laneFutures[i]);
+    }
+
+    // The modules are loaded once the whole batch is finished, since the lanes share the managers
+    for (unsigned int i = 0; i < pendingRequests.size(); i++) {
+        this->reloadModule(requests[pendingRequests[i]].moduleName);
+    }
+
+    unsigned int failedCount = 0;
+    for (unsigned int i = 0; i < requests.size(); i++) {
+        if (requests[i].result != 0) {
+            failedCount++;
         }
     }
+
+    return failedCount;
 }
 
 void ModuleInstaller::cancelInstallation()
 {
     this->_repoInterface.getInstallMgr()->terminate();
+
+    this->_installationCancelled = true;
+    this->_runningInstallMutex.lock();
+    for (set<InstallMgr*>::iterator it = this->_runningInstallMgrs.begin(); it != this->_runningInstallMgrs.end(); ++it) {
+        (*it)->terminate();
+    }
+    this->_runningInstallMutex.unlock();
 }
 
 int ModuleInstaller::uninstallModule(string moduleName)
 {
-    int error = this->_repoInterface.getInstallMgr()->removeModule(this->_mgrForInstall, moduleName.c_str());
-    this->_mgrForInstall->deleteModule(moduleName.c_str());
+    int error = 0;
+
+    {
+        // The module store must not be called while holding the file lock, so it is only taken for this block
+        SwordFileLock fileLock;
+        lock_guard<mutex> lock(this->_mgrForInstallMutex);
+        error = this->_repoInterface.getInstallMgr()->removeModule(this->_mgrForInstall, moduleName.c_str());
+        this->_mgrForInstall->evictModule(moduleName);
+    }
+
     this->_moduleStore.deleteModule(moduleName);
 
+    // The Strong's table, the dictionary key index and the lemma statistics are derived from the module
+    string userSwordDir = this->_fileSystemHelper.getUserSwordDir();
+    const char* derivedFileExtensions[] = { ".table", ".keys", ".lemmas" };
+
+    for (unsigned int i = 0; i < sizeof(derivedFileExtensions) / sizeof(derivedFileExtensions[0]); i++) {
+        string derivedFilePath = userSwordDir + "/." + moduleName + derivedFileExtensions[i];
+
+        if (FileMgr::existsFile(derivedFilePath.c_str())) {
+            FileMgr::removeFile(derivedFilePath.c_str());
+        }
+    }
+
     if (error) {
         // cerr << "Error uninstalling module: " << moduleName << " (write permissions?)" << endl;
         return -1;
@@ -135,9 +444,11 @@ int ModuleInstaller::saveModuleUnlockKey(string moduleName, string key)
                 cipherKeyEntry->second = key.c_str();
                 //-- save config file
                 config->save();
-                // Reset the mgr to reload the modules
-                this->resetAllMgrs();
+                // Only the unlocked module is reloaded
+                this->reloadModule(moduleName);
                 // Without this step we cannot load a remote module afterwards ...
+                // The refresh runs on worker threads that need the file lock, which is held by this API call
+                SwordFileUnlock fileUnlock;
                 this->_repoInterface.refreshRemoteSources(true);
             } else {
                 // Section CipherKey not found!
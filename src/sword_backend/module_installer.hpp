@@ -20,16 +20,34 @@
 #define _MODULE_INSTALLER
 
 #include <string>
+#include <vector>
+#include <set>
+#include <mutex>
+#include <atomic>
+#include <functional>
 #include "file_system_helper.hpp"
 #include "string_helper.hpp"
+#include "streaming_module_installer.hpp"
 
 namespace sword {
     class SWModule;
     class SWMgr;
+    class InstallMgr;
 };
 
 class RepositoryInterface;
+class SwordStatusReporter;
 class ModuleStore;
+class ReloadableSwordMgr;
+
+class ModuleInstallRequest {
+public:
+    std::string repoName;
+    std::string moduleName;
+
+    // 0 on success, otherwise the SWORD error code (-9 if the installation was cancelled before it started)
+    int result = -1;
+};
 
 class ModuleInstaller
 {
@@ -37,7 +55,16 @@ public:
     ModuleInstaller(RepositoryInterface& repoInterface, ModuleStore& moduleStore, std::string customHomeDir="");
     virtual ~ModuleInstaller();
 
-    int installModule(std::string repoName, std::string moduleName);
+    // The progress of the installation is reported to the given status reporter. Without a status reporter,
+    // the shared status reporter of the RepositoryInterface is used.
+    int installModule(std::string repoName, std::string moduleName, SwordStatusReporter* statusReporter=0);
+
+    // Installs several modules with at most maxParallelInstalls concurrent downloads. The progress is aggregated over the bytes
+    // of all modules and the managers are only reset once at the end. Returns the number of failed installations.
+    unsigned int installModules(std::vector<ModuleInstallRequest>& requests,
+                                std::function<void(unsigned int totalPercent, std::string message)>* progressCallback=0,
+                                unsigned int maxParallelInstalls=3);
+
     void cancelInstallation();
     int uninstallModule(std::string moduleName);
 
@@ -46,15 +73,27 @@ public:
 
     void resetAllMgrs();
 
+    // Loads, reloads or evicts a single module in all local managers, depending on whether it is (still) installed
+    void reloadModule(std::string moduleName);
+
 private:
     void refreshMgr();
+    std::string getModuleVersion(sword::SWModule* module);
 
     RepositoryInterface& _repoInterface;
     ModuleStore& _moduleStore;
     FileSystemHelper _fileSystemHelper;
     StringHelper _stringHelper;
+    StreamingModuleInstaller _streamingInstaller;
+
+    // Only holds the module configurations for InstallMgr::removeModule. It is changed by the background operations and by API calls.
+    ReloadableSwordMgr* _mgrForInstall = 0;
+    std::mutex _mgrForInstallMutex;
 
-    sword::SWMgr* _mgrForInstall = 0;
+    // The InstallMgrs of the running installations, so that they can be terminated by cancelInstallation
+    std::set<sword::InstallMgr*> _runningInstallMgrs;
+    std::mutex _runningInstallMutex;
+    std::atomic<bool> _installationCancelled{false};
 };
 
 #endif // _MODULE_INSTALLER
\ No newline at end of file
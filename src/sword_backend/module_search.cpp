@@ -23,6 +23,8 @@
 #include <algorithm>
 #include <regex>
 #include <sstream>
+#include <memory>
+#include <thread>
 
 // sword includes
 #include <swmgr.h>
@@ -35,6 +37,7 @@
 #include "module_helper.hpp"
 #include "text_processor.hpp"
 #include "string_helper.hpp"
+#include "sword_file_lock.hpp"
 
 /* REGEX definitions from regex.h */
 /* POSIX `cflags' bits (i.e., information for `regcomp').  */
@@ -261,7 +264,12 @@ vector<Verse> ModuleSearch::createVersesFromReferences(SWModule* module, const v
                                                        bool moduleMarkupIsBroken)
 {
     vector<Verse> verses;
-    map<string, int> absoluteVerseNumbers = this->_moduleHelper.getAbsoluteVerseNumberMap(module);
+    map<string, int> absoluteVerseNumbers;
+
+    {
+        SwordFileLock fileLock;
+        absoluteVerseNumbers = this->_moduleHelper.getAbsoluteVerseNumberMap(module);
+    }
 
     for (const auto& reference : references) {
         module->setKey(reference.c_str());
@@ -281,6 +289,23 @@ vector<Verse> ModuleSearch::createVersesFromReferences(SWModule* module, const v
     return verses;
 }
 
+// userData is the progress callback of the ModuleSearch instance that started the search
+static void internalModuleSearchProgressCB(char percent, void* userData)
+{
+    std::function<void(char, void*)>* moduleSearchProgressCB = (std::function<void(char, void*)>*)userData;
+
+    // The search holds the SWORD file lock. Give the other readers a chance to take it on every progress step.
+    SwordFileUnlock fileUnlock;
+
+    if (moduleSearchProgressCB != 0) {
+        //cout << "internal cb: " << (int)percent << endl;
+
+        (*moduleSearchProgressCB)(percent, 0);
+    }
+
+    std::this_thread::yield();
+}
+
 vector<Verse> ModuleSearch::getModuleSearchResults(string moduleName,
                                                    string searchTerm,
                                                    SearchType searchType,
@@ -289,13 +314,14 @@ vector<Verse> ModuleSearch::getModuleSearchResults(string moduleName,
                                                    bool useExtendedVerseBoundaries,
                                                    bool filterOnWordBoundaries)
 {
-    this->_currentModuleName = moduleName;
-    SWModule* module = this->_moduleStore.getSearchSwMgr()->getModule(moduleName.c_str());
+    SwordMgrLease lease = this->_moduleStore.acquireMgr();
+    SWModule* module = this->beginSearch(lease, moduleName);
     ListKey listKey;
     SWKey* scope = 0;
     vector<Verse> searchResults;
 
     if (!validateSearchParameters(module, searchTerm)) {
+        this->endSearch(lease);
         return searchResults;
     }
 
@@ -318,7 +344,10 @@ vector<Verse> ModuleSearch::getModuleSearchResults(string moduleName,
     }
 
     // Perform search
-    listKey = module->search(searchTerm.c_str(), int(searchType), flags, scope, 0, internalModuleSearchProgressCB);
+    {
+        SwordFileLock fileLock;
+        listKey = module->search(searchTerm.c_str(), int(searchType), flags, scope, 0, internalModuleSearchProgressCB, this->_progressCallback);
+    }
 
     // Get search result references while considering the word boundary filter option
     vector<string> filteredReferences = getSearchResultReferences(module, listKey, searchTerm, searchType, 
@@ -329,32 +358,190 @@ vector<Verse> ModuleSearch::getModuleSearchResults(string moduleName,
     searchResults = createVersesFromReferences(module, filteredReferences, hasStrongs, 
                                                hasInconsistentClosingEndDivs, moduleMarkupIsBroken);
 
-    this->_currentModuleName = "";
+    this->endSearch(lease);
 
     return searchResults;
 }
 
-void ModuleSearch::terminate()
+EntrySearchResult ModuleSearch::createEntrySearchResult(SWModule* module, SWKey* key, bool isCommentary,
+                                                        bool hasStrongs, bool hasInconsistentClosingEndDivs,
+                                                        bool moduleMarkupIsBroken)
 {
-    if (this->_currentModuleName != "") {
-        SWModule* module = this->_moduleStore.getSearchSwMgr()->getModule(this->_currentModuleName.c_str());
-        module->terminateSearch = true;
-        this->_currentModuleName = "";
+    EntrySearchResult result;
+
+    {
+        SwordFileLock fileLock;
+        module->setKey(key);
+        result.key = module->getKey()->getShortText();
+        result.endKey = result.key;
+    }
+
+    // The content is filtered like the verses of a Bible search
+    result.content = this->_textProcessor.getCurrentVerseText(module,
+                                                              hasStrongs,
+                                                              hasInconsistentClosingEndDivs,
+                                                              moduleMarkupIsBroken);
+
+    VerseKey* moduleKey = dynamic_cast<VerseKey*>(module->getKey());
+
+    if (isCommentary && moduleKey != 0) {
+        // Commentary entries are often linked to a range of verses. The search only reports the first verse.
+        // The keys are copied from the module key, so that they use the versification of the module.
+        SwordFileLock fileLock;
+        VerseKey startKey(*moduleKey);
+        VerseKey endKey(*moduleKey);
+        VerseKey nextKey(*moduleKey);
+        nextKey.increment();
+
+        while (!nextKey.popError() && module->isLinked(&startKey, &nextKey)) {
+            endKey = nextKey;
+            nextKey.increment();
+        }
+
+        result.endKey = endKey.getShortText();
     }
+
+    return result;
 }
 
-static std::function<void(char, void*)>* _moduleSearchProgressCB = 0;
+EntrySearchPage ModuleSearch::getEntrySearchResults(string moduleName,
+                                                    string searchTerm,
+                                                    SearchType searchType,
+                                                    bool isCaseSensitive,
+                                                    unsigned int startIndex,
+                                                    unsigned int maxCount)
+{
+    SwordMgrLease lease = this->_moduleStore.acquireMgr();
+    SWModule* module = this->beginSearch(lease, moduleName);
+    EntrySearchPage searchPage;
+
+    if (!validateSearchParameters(module, searchTerm)) {
+        this->endSearch(lease);
+        return searchPage;
+    }
+
+    string moduleType = string(module->getType());
+    bool isCommentary = (moduleType == "Commentaries");
+
+    if (!isCommentary && moduleType != "Lexicons / Dictionaries") {
+        cerr << "ModuleSearch::getEntrySearchResults: " << moduleName << " is not a dictionary or commentary module!" << endl;
+        this->endSearch(lease);
+        return searchPage;
+    }
+
+    stringstream cacheKey;
+    cacheKey << moduleName << "\n" << searchTerm << "\n" << int(searchType) << "\n" << isCaseSensitive;
+    shared_ptr<ListKey> listKey = this->getCachedEntrySearch(cacheKey.str());
 
-void internalModuleSearchProgressCB(char percent, void* userData)
+    if (!listKey) {
+        // Entries have no verse boundaries, so only the case sensitivity applies
+        int flags = isCaseSensitive ? 0 : REG_ICASE;
+
+        // Perform search (the module uses its search index if there is one)
+        SwordFileLock fileLock;
+        listKey = make_shared<ListKey>(module->search(searchTerm.c_str(), int(searchType), flags, 0, 0, internalModuleSearchProgressCB, this->_progressCallback));
+
+        // The results of a terminated search are incomplete
+        if (!module->terminateSearch) {
+            this->cacheEntrySearch(cacheKey.str(), listKey);
+        }
+    }
+
+    searchPage.totalCount = (unsigned int)listKey->getCount();
+
+    bool hasStrongs = this->_moduleHelper.moduleHasGlobalOption(module, "Strongs");
+    bool moduleMarkupIsBroken = this->_moduleHelper.isBrokenMarkupModule(moduleName);
+    bool hasInconsistentClosingEndDivs = this->_moduleHelper.isInconsistentClosingEndDivModule(moduleName);
+
+    unsigned int endIndex = searchPage.totalCount;
+    if (maxCount > 0 && startIndex < searchPage.totalCount && maxCount < searchPage.totalCount - startIndex) {
+        endIndex = startIndex + maxCount;
+    }
+
+    // Only the entries of the requested page are read
+    for (unsigned int i = startIndex; i < endIndex; i++) {
+        SWKey* key = listKey->getElement(i);
+
+        if (key != 0) {
+            searchPage.results.push_back(this->createEntrySearchResult(module, key, isCommentary, hasStrongs,
+                                                                          hasInconsistentClosingEndDivs, moduleMarkupIsBroken));
+        }
+    }
+
+    this->endSearch(lease);
+
+    return searchPage;
+}
+
+shared_ptr<ListKey> ModuleSearch::getCachedEntrySearch(const string& cacheKey)
 {
-    if (_moduleSearchProgressCB != 0) {
-        //cout << "internal cb: " << (int)percent << endl;
+    shared_ptr<const InstalledVersionMap> installedVersions = this->_moduleStore.getInstalledVersions();
+    lock_guard<mutex> lock(this->_entrySearchCacheMutex);
+
+    // The snapshot of the installed versions is replaced whenever a module changes, so comparing the pointers is enough
+    if (installedVersions != this->_entrySearchCacheVersions) {
+        this->_entrySearchCache.clear();
+        this->_entrySearchCacheOrder.clear();
+        this->_entrySearchCacheVersions = installedVersions;
+    }
 
-        (*_moduleSearchProgressCB)(percent, userData);
+    map<string, shared_ptr<ListKey>>::iterator it = this->_entrySearchCache.find(cacheKey);
+    if (it == this->_entrySearchCache.end()) {
+        return shared_ptr<ListKey>();
     }
+
+    return it->second;
 }
 
-void setModuleSearchProgressCB(std::function<void(char, void*)>* moduleSearchProgressCB)
+void ModuleSearch::cacheEntrySearch(const string& cacheKey, shared_ptr<ListKey> results)
 {
-    _moduleSearchProgressCB = moduleSearchProgressCB;
-}
\ No newline at end of file
+    // Paging usually continues the latest searches, so only a few of them are kept
+    static const unsigned int MAX_CACHED_ENTRY_SEARCHES = 8;
+
+    lock_guard<mutex> lock(this->_entrySearchCacheMutex);
+
+    if (this->_entrySearchCache.find(cacheKey) == this->_entrySearchCache.end()) {
+        this->_entrySearchCacheOrder.push_back(cacheKey);
+    }
+
+    this->_entrySearchCache[cacheKey] = results;
+
+    while (this->_entrySearchCacheOrder.size() > MAX_CACHED_ENTRY_SEARCHES) {
+        this->_entrySearchCache.erase(this->_entrySearchCacheOrder.front());
+        this->_entrySearchCacheOrder.pop_front();
+    }
+}
+
+SWModule* ModuleSearch::beginSearch(SwordMgrLease& lease, string moduleName)
+{
+    // Headings are not interesting when searching
+    lease.getMgr()->setGlobalOption("Headings", "Off");
+    SWModule* module = lease.getModule(moduleName);
+
+    lock_guard<mutex> lock(this->_currentModuleMutex);
+    this->_currentModuleName = moduleName;
+    this->_currentModule = module;
+    return module;
+}
+
+void ModuleSearch::endSearch(SwordMgrLease& lease)
+{
+    {
+        lock_guard<mutex> lock(this->_currentModuleMutex);
+        this->_currentModuleName = "";
+        this->_currentModule = 0;
+    }
+
+    // The other users of the pool expect the default options
+    lease.getMgr()->setGlobalOption("Headings", "On");
+    lease.release();
+}
+
+void ModuleSearch::terminate()
+{
+    lock_guard<mutex> lock(this->_currentModuleMutex);
+
+    if (this->_currentModule != 0) {
+        this->_currentModule->terminateSearch = true;
+    }
+}
@@ -20,15 +20,17 @@
 #define _MODULE_SEARCH
 
 #include <functional>
+#include <list>
 #include <map>
+#include <memory>
+#include <mutex>
 
 #include "common_defs.hpp"
-
-void setModuleSearchProgressCB(std::function<void(char, void*)>* moduleSearchProgressCB);
-void internalModuleSearchProgressCB(char percent, void* userData);
+#include "module_store.hpp"
 
 namespace sword {
     class SWModule;
+    class SWKey;
     class ListKey;
 };
 
@@ -44,9 +46,9 @@ enum class SearchScope {
     NT = 2
 };
 
-class ModuleStore;
 class ModuleHelper;
 class TextProcessor;
+class SwordMgrLease;
 
 class ModuleSearch
 {
@@ -55,6 +57,9 @@ public:
         : _moduleStore(moduleStore), _moduleHelper(moduleHelper), _textProcessor(textProcessor), _currentModuleName("") {}
     virtual ~ModuleSearch() {}
 
+    // The progress callback is passed to SWORD as user data of the search, so that there is no global callback state.
+    void setProgressCallback(std::function<void(char, void*)>* progressCallback) { this->_progressCallback = progressCallback; }
+
     std::vector<Verse> getModuleSearchResults(std::string moduleName,
                                               std::string searchTerm,
                                               SearchType searchType=SearchType::multiWord,
@@ -63,6 +68,15 @@ public:
                                               bool useExtendedVerseBoundaries=false,
                                               bool filterOnWordBoundaries=false);
     
+    // Searches a dictionary or commentary module and returns the results from startIndex on.
+    // A maxCount of 0 returns all remaining results.
+    EntrySearchPage getEntrySearchResults(std::string moduleName,
+                                          std::string searchTerm,
+                                          SearchType searchType=SearchType::multiWord,
+                                          bool isCaseSensitive=false,
+                                          unsigned int startIndex=0,
+                                          unsigned int maxCount=0);
+
     void terminate();
 
 private:
@@ -79,12 +93,35 @@ private:
     std::vector<Verse> createVersesFromReferences(sword::SWModule* module, const std::vector<std::string>& references,
                                                   bool hasStrongs, bool hasInconsistentClosingEndDivs, 
                                                   bool moduleMarkupIsBroken);
+    EntrySearchResult createEntrySearchResult(sword::SWModule* module, sword::SWKey* key, bool isCommentary,
+                                              bool hasStrongs, bool hasInconsistentClosingEndDivs,
+                                              bool moduleMarkupIsBroken);
+
+    // A search reads from a SWMgr of the reader pool, so that it neither shares the module cursor with the API
+    // nor sees a module that is reloaded while the search is running
+    sword::SWModule* beginSearch(SwordMgrLease& lease, std::string moduleName);
+    void endSearch(SwordMgrLease& lease);
     bool phraseSequenceCheck(const std::vector<std::string>& words, const std::vector<std::string>& searchWords);
 
+    // The complete result list of an entry search is cached, so that the following pages are sliced from it
+    // instead of searching the module again. Returns an empty pointer if the search is not cached.
+    // The cached lists are shared between searches and only read via ListKey::getElement, which does not change them.
+    std::shared_ptr<sword::ListKey> getCachedEntrySearch(const std::string& cacheKey);
+    void cacheEntrySearch(const std::string& cacheKey, std::shared_ptr<sword::ListKey> results);
+
     ModuleStore& _moduleStore;
     ModuleHelper& _moduleHelper;
     TextProcessor& _textProcessor;
     std::string _currentModuleName;
+    sword::SWModule* _currentModule = 0;
+    std::mutex _currentModuleMutex;
+    std::function<void(char, void*)>* _progressCallback = 0;
+
+    // The cached entry searches are discarded whenever modules are installed, reloaded or removed
+    std::shared_ptr<const InstalledVersionMap> _entrySearchCacheVersions;
+    std::map<std::string, std::shared_ptr<sword::ListKey>> _entrySearchCache;
+    std::list<std::string> _entrySearchCacheOrder;
+    std::mutex _entrySearchCacheMutex;
 };
 
 #endif // _MODULE_SEARCH
\ No newline at end of file
@@ -17,6 +17,7 @@
    If not, see <http://www.gnu.org/licenses/>. */
 
 // Std includes
+#include <algorithm>
 #include <regex>
 #include <string>
 #include <sstream>
@@ -29,6 +30,7 @@
 // Own includes
 #include "module_store.hpp"
 #include "repository_interface.hpp"
+#include "sword_file_lock.hpp"
 
 using namespace std;
 using namespace sword;
@@ -39,28 +41,43 @@ ModuleStore::ModuleStore(string customHomeDir)
     this->_fileSystemHelper.createBasicDirectories();
     this->customHomeDir = customHomeDir;
 
-    this->_mgr = this->createSWMgr();
+    string snapshotPath = this->_fileSystemHelper.getUserSwordDir() + this->_fileSystemHelper.getPathSeparator() + ".mods.d.snapshot";
+    this->_configSnapshot = new ModuleConfigSnapshot(snapshotPath);
+
+    // Only the module configurations are read at startup. The module drivers are created on first access.
+    this->_mgr = this->createSWMgr(true);
     this->_mgr->setGlobalOption("Headings", "On");
 
-    // After creating the searchMgr we turn off features that we are not interested in when searching
-    this->_searchMgr = this->createSWMgr();
-    this->_searchMgr->setGlobalOption("Headings", "Off");
+    // The pooled reader instances are configured like _mgr and only created once they are needed.
+    // Like _mgr, they only create the drivers of the modules that are actually read.
+    this->_mgrPool = new SwordMgrPool([this]() {
+        ReloadableSwordMgr* mgr = this->createSWMgr(true);
+        mgr->setGlobalOption("Headings", "On");
+        return mgr;
+    });
+
+    this->updateInstalledVersions();
 }
 
 ModuleStore::~ModuleStore()
 {
+    if (this->_mgrPool != 0) {
+        delete this->_mgrPool;
+    }
+
     if (this->_mgr != 0) {
+        SwordFileLock fileLock;
         delete this->_mgr;
     }
 
-    if (this->_searchMgr != 0) {
-        delete this->_searchMgr;
+    if (this->_configSnapshot != 0) {
+        delete this->_configSnapshot;
     }
 }
 
-SWMgr* ModuleStore::createSWMgr()
+ReloadableSwordMgr* ModuleStore::createSWMgr(bool deferModuleCreation)
 {
-    SWMgr* swMgr = 0;
+    ReloadableSwordMgr* swMgr = 0;
     bool isAndroid = false;
     #if defined(__ANDROID__)
         isAndroid = true;
@@ -68,114 +85,236 @@ SWMgr* ModuleStore::createSWMgr()
 
     MarkupFilterMgr* markupFilterMgr = new MarkupFilterMgr(sword::FMT_OSIS, sword::ENC_UTF8);
 
+    // Loading the module configurations goes through the FileMgr
+    SwordFileLock fileLock;
+
+    // The managers are created without autoload and loaded afterwards, so that the creation of the module drivers can be deferred
     if (customHomeDir != "" || isAndroid) {
-        swMgr = new SWMgr(this->_fileSystemHelper.getUserSwordDir().c_str(),
-                          true, // autoload
-                          markupFilterMgr,
-                          false, // multiMod
-                          false); // augmentHome
-
-        if (isAndroid) {
-          // Also consider the originally used path for Android, which does not work anymore from Android 11, but is still relevant
-          // for existing translations on Android versions < 11.
-          swMgr->augmentModules("/sdcard/sword");
-
-          // Also consider /sdcard/Documents/sword, which is the path used by other programs
-          swMgr->augmentModules("/sdcard/Documents/sword");
-        }
+        swMgr = new ReloadableSwordMgr(this->_fileSystemHelper.getUserSwordDir().c_str(),
+                                       false, // autoload
+                                       markupFilterMgr,
+                                       false, // multiMod
+                                       false); // augmentHome
     } else {
         #ifdef _WIN32
-            swMgr = new SWMgr(this->_fileSystemHelper.getUserSwordDir().c_str(),
-                              true, // autoload
-                              markupFilterMgr,
-                              false, // multimod
-                              true); // augmentHome
-
-            // This has been disabled because it lead to a crash.
-            // We're keeping it here for now in case this becomes relevant again.
-            // this->_mgr->augmentModules(this->_fileSystemHelper.getSystemSwordDir().c_str());
-        #elif defined(__APPLE__)
-            swMgr = new SWMgr(markupFilterMgr);
+            swMgr = new ReloadableSwordMgr(this->_fileSystemHelper.getUserSwordDir().c_str(),
+                                           false, // autoload
+                                           markupFilterMgr,
+                                           false, // multimod
+                                           true); // augmentHome
+        #else
+            swMgr = new ReloadableSwordMgr((SWConfig*)0, // config
+                                           (SWConfig*)0, // sysConfig
+                                           false, // autoload
+                                           markupFilterMgr);
+        #endif
+    }
+
+    swMgr->setConfigSnapshot(this->_configSnapshot);
+    swMgr->setModuleCreationDeferred(deferModuleCreation);
+    swMgr->load();
 
+    if (isAndroid) {
+      // Also consider the originally used path for Android, which does not work anymore from Android 11, but is still relevant
+      // for existing translations on Android versions < 11.
+      swMgr->augmentModules("/sdcard/sword");
+
+      // Also consider /sdcard/Documents/sword, which is the path used by other programs
+      swMgr->augmentModules("/sdcard/Documents/sword");
+    }
+
+    #if defined(_WIN32)
+        // This has been disabled because it lead to a crash.
+        // We're keeping it here for now in case this becomes relevant again.
+        // this->_mgr->augmentModules(this->_fileSystemHelper.getSystemSwordDir().c_str());
+    #elif defined(__APPLE__)
+        if (customHomeDir == "") {
             stringstream appSupport;
             appSupport << string(getenv("HOME")) << "/Library/Application Support/Sword";            
             swMgr->augmentModules(appSupport.str().c_str());
-        #else // LINUX!
-            swMgr = new SWMgr(markupFilterMgr);
-        #endif
-    }
+        }
+    #endif
 
+    swMgr->setModuleCreationDeferred(false);
     return swMgr;
 }
 
+void ModuleStore::lockMgr()
+{
+    this->_mgrMutex.lock();
+}
+
+void ModuleStore::unlockMgr()
+{
+    this->_mgrMutex.unlock();
+}
+
 void ModuleStore::refreshMgr()
 {
+    lock_guard<recursive_mutex> mgrLock(this->_mgrMutex);
+    SwordFileLock fileLock;
+    this->invalidateLocalModuleCatalog();
+
+    // Modules that are not loaded yet stay deferred, the other ones are recreated on their next access
+    this->_mgr->setModuleCreationDeferred(true);
     this->_mgr->augmentModules(this->_fileSystemHelper.getUserSwordDir().c_str());
-    this->_searchMgr->augmentModules(this->_fileSystemHelper.getUserSwordDir().c_str());
+    this->_mgr->setModuleCreationDeferred(false);
+
+    this->_mgrPool->invalidate();
+    this->updateInstalledVersions();
 }
 
 void ModuleStore::deleteModule(string moduleName)
 {
-    this->_mgr->deleteModule(moduleName.c_str());
-    this->_searchMgr->deleteModule(moduleName.c_str());
+    lock_guard<recursive_mutex> mgrLock(this->_mgrMutex);
+    SwordFileLock fileLock;
+    this->invalidateLocalModuleCatalog();
+    this->_mgr->evictModule(moduleName);
+
+    this->_mgrPool->invalidate();
+
+    lock_guard<mutex> lock(this->_installedVersionsMutex);
+    shared_ptr<InstalledVersionMap> installedVersions = make_shared<InstalledVersionMap>(*(this->_installedVersions));
+    installedVersions->erase(moduleName);
+    this->_installedVersions = installedVersions;
 }
 
-SWModule* ModuleStore::getLocalModule(string moduleName)
+void ModuleStore::reloadModule(string moduleName)
+{
+    lock_guard<recursive_mutex> mgrLock(this->_mgrMutex);
+    SwordFileLock fileLock;
+    this->invalidateLocalModuleCatalog();
+
+    string userSwordDir = this->_fileSystemHelper.getUserSwordDir();
+    string confFilePath = ReloadableSwordMgr::findModuleConf(this->_fileSystemHelper.getModuleDir(), moduleName);
+
+    if (confFilePath == "" || this->_mgr->reloadModule(moduleName, confFilePath, userSwordDir) != 0) {
+        // Without a usable configuration the module is not installed (anymore)
+        this->_mgr->evictModule(moduleName);
+    }
+
+    this->_mgrPool->invalidate();
+
+    lock_guard<mutex> lock(this->_installedVersionsMutex);
+    shared_ptr<InstalledVersionMap> installedVersions = make_shared<InstalledVersionMap>(*(this->_installedVersions));
+    SWModule* module = this->_mgr->getOrCreateModule(moduleName);
+
+    if (module != 0) {
+        const char* version = module->getConfigEntry("Version");
+        (*installedVersions)[moduleName] = (version != 0) ? string(version) : "1.0";
+    } else {
+        installedVersions->erase(moduleName);
+    }
+
+    this->_installedVersions = installedVersions;
+}
+
+void ModuleStore::updateInstalledVersions()
 {
-    return this->_mgr->getModule(moduleName.c_str());
+    // The versions are taken from the configurations, so that no module driver needs to be created
+    vector<string> moduleNames = this->_mgr->getModuleNames();
+    shared_ptr<InstalledVersionMap> installedVersions = make_shared<InstalledVersionMap>();
+    installedVersions->reserve(moduleNames.size());
+
+    for (unsigned int i = 0; i < moduleNames.size(); i++) {
+        const ConfigEntMap* moduleConfig = this->_mgr->getModuleConfig(moduleNames[i]);
+        if (moduleConfig == 0) {
+            continue;
+        }
+
+        ConfigEntMap::const_iterator version = moduleConfig->find("Version");
+
+        // Modules without version are treated as version 1.0, like InstallMgr::getModuleStatus does
+        (*installedVersions)[moduleNames[i]] = (version != moduleConfig->end()) ? string(version->second.c_str()) : "1.0";
+    }
+
+    lock_guard<mutex> lock(this->_installedVersionsMutex);
+    this->_installedVersions = installedVersions;
 }
 
-vector<string> ModuleStore::getModuleLanguages(ModuleType moduleType)
+shared_ptr<const InstalledVersionMap> ModuleStore::getInstalledVersions()
 {
-    vector<string> languages;
-    string moduleTypeFilter = RepositoryInterface::getModuleTypeString(moduleType);
+    lock_guard<mutex> lock(this->_installedVersionsMutex);
+    return this->_installedVersions;
+}
 
-    for (ModMap::iterator modIterator = this->_mgr->Modules.begin();
-         modIterator != this->_mgr->Modules.end();
-         modIterator++) {
-        
-        SWModule* currentModule = (SWModule*)modIterator->second;
-        string moduleType = string(currentModule->getType());
-        string moduleLanguage = string(currentModule->getLanguage());
+SWModule* ModuleStore::getLocalModule(string moduleName)
+{
+    lock_guard<recursive_mutex> mgrLock(this->_mgrMutex);
+    SwordFileLock fileLock;
+    return this->_mgr->getOrCreateModule(moduleName);
+}
 
-        if (moduleTypeFilter == "ANY" || moduleType == moduleTypeFilter) {
+shared_ptr<const LocalModuleCatalog> ModuleStore::getLocalModuleCatalog()
+{
+    // The manager lock is always taken before the catalog lock
+    lock_guard<recursive_mutex> mgrLock(this->_mgrMutex);
+    lock_guard<mutex> lock(this->_localModuleCatalogMutex);
+
+    if (!this->_localModuleCatalog) {
+        // The catalog is built from the configurations, so that listing the modules does not create their drivers
+        vector<string> moduleNames = this->_mgr->getModuleNames();
+        sort(moduleNames.begin(), moduleNames.end());
+
+        vector<LocalModuleCatalog::Entry> entries;
+        entries.reserve(moduleNames.size());
+
+        for (unsigned int i = 0; i < moduleNames.size(); i++) {
+            const ConfigEntMap* moduleConfig = this->_mgr->getModuleConfig(moduleNames[i]);
+            if (moduleConfig == 0) {
+                continue;
+            }
 
-            if (std::find(languages.begin(),
-                          languages.end(),                       // Only accept add the language if we do not
-                          moduleLanguage) == languages.end()) {  // have it yet!
+            LocalModuleCatalog::Entry entry;
+            entry.name = moduleNames[i];
+            entry.type = ReloadableSwordMgr::getModuleType(*moduleConfig);
+            entry.language = ReloadableSwordMgr::getModuleLanguage(*moduleConfig);
 
-                languages.push_back(moduleLanguage);
+            // SWMgr does not create modules with unsupported drivers
+            if (entry.type != "") {
+                entries.push_back(entry);
             }
         }
+
+        this->_localModuleCatalog = make_shared<const LocalModuleCatalog>(entries);
     }
 
-    return languages;
+    return this->_localModuleCatalog;
+}
+
+void ModuleStore::invalidateLocalModuleCatalog()
+{
+    lock_guard<mutex> lock(this->_localModuleCatalogMutex);
+    this->_localModuleCatalog.reset();
+}
+
+vector<string> ModuleStore::getModuleLanguages(ModuleType moduleType)
+{
+    string moduleTypeFilter = RepositoryInterface::getModuleTypeString(moduleType);
+    return this->getLocalModuleCatalog()->getLanguages(moduleTypeFilter);
 }
 
 vector<SWModule*> ModuleStore::getAllLocalModules(ModuleType moduleType)
 {
-    vector<SWModule*> allLocalModules;
+    lock_guard<recursive_mutex> mgrLock(this->_mgrMutex);
+    SwordFileLock fileLock;
     string moduleTypeFilter = RepositoryInterface::getModuleTypeString(moduleType);
-    vector<string> languages = this->getModuleLanguages(moduleType);
+    shared_ptr<const LocalModuleCatalog> catalog = this->getLocalModuleCatalog();
+    const vector<string>& moduleNames = catalog->getModuleNames(moduleTypeFilter);
 
-    for (unsigned int i = 0; i < languages.size(); i++) {
-        string currentLanguage = languages[i];
+    // Only the drivers of the requested modules are created
+    vector<SWModule*> modules;
+    modules.reserve(moduleNames.size());
 
-        for (ModMap::iterator modIterator = this->_mgr->Modules.begin();
-            modIterator != this->_mgr->Modules.end();
-            modIterator++) {
-            
-            SWModule* currentModule = (SWModule*)modIterator->second;
-            string moduleType = string(currentModule->getType());
-            string moduleLanguage = string(currentModule->getLanguage());
+    for (unsigned int i = 0; i < moduleNames.size(); i++) {
+        SWModule* module = this->_mgr->getOrCreateModule(moduleNames[i]);
 
-            if ((moduleTypeFilter == "ANY" || moduleType == moduleTypeFilter) && (moduleLanguage == currentLanguage)) {
-                allLocalModules.push_back(currentModule);
-            }
+        if (module != 0) {
+            modules.push_back(module);
         }
     }
 
-    return allLocalModules;
+    return modules;
 }
 
 bool ModuleStore::isModuleInUserDir(sword::SWModule* module)
@@ -217,12 +356,22 @@ string ModuleStore::getModuleDataPath(sword::SWModule* module)
     return dataPath;
 }
 
+string ModuleStore::getUserSwordDir()
+{
+    return this->_fileSystemHelper.getUserSwordDir();
+}
+
+ModuleConfigSnapshot* ModuleStore::getConfigSnapshot()
+{
+    return this->_configSnapshot;
+}
+
 SWMgr* ModuleStore::getSwMgr()
 {
     return this->_mgr;
 }
 
-SWMgr* ModuleStore::getSearchSwMgr()
+SwordMgrLease ModuleStore::acquireMgr()
 {
-    return this->_searchMgr;
+    return this->_mgrPool->acquire();
 }
\ No newline at end of file
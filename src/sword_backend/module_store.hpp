@@ -20,40 +20,85 @@
 #define _MODULE_STORE
 
 #include <string>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #include "common_defs.hpp"
 #include "file_system_helper.hpp"
+#include "sword_mgr_pool.hpp"
+#include "reloadable_sword_mgr.hpp"
+#include "module_config_snapshot.hpp"
+#include "local_module_catalog.hpp"
 
 namespace sword {
     class SWModule;
     class SWMgr;
 };
 
+// Maps the names of the installed modules to their versions
+typedef std::unordered_map<std::string, std::string> InstalledVersionMap;
+
 class ModuleStore
 {
 public:
     ModuleStore(std::string customHomeDir="");
     virtual ~ModuleStore();
 
-    sword::SWMgr* createSWMgr();
+    // If deferModuleCreation is true, only the module configurations are loaded and the module drivers are created on first access
+    ReloadableSwordMgr* createSWMgr(bool deferModuleCreation=false);
     sword::SWModule* getLocalModule(std::string moduleName);
     std::vector<sword::SWModule*> getAllLocalModules(ModuleType moduleType=ModuleType::bible);
     
     bool isModuleInUserDir(std::string moduleName);
     bool isModuleInUserDir(sword::SWModule* module);
     std::string getModuleDataPath(sword::SWModule* module);
+    std::string getUserSwordDir();
+
+    // refreshMgr, deleteModule and reloadModule replace modules of the main SWMgr under the manager lock. Module pointers
+    // returned by getLocalModule and getAllLocalModules stay valid until the module is replaced, so callers that keep
+    // them must hold the manager lock via lockMgr(). The API lock of the backend takes it for every API call.
+    void lockMgr();
+    void unlockMgr();
 
     void refreshMgr();
     void deleteModule(std::string moduleName);
 
+    // Loads, reloads or evicts a single module based on its configuration in the user's SWORD directory,
+    // without rescanning the configurations of all other modules
+    void reloadModule(std::string moduleName);
+
     sword::SWMgr* getSwMgr();
-    sword::SWMgr* getSearchSwMgr();
+
+    // The snapshot of the parsed module configurations, which is shared by all managers
+    ModuleConfigSnapshot* getConfigSnapshot();
+
+    // Leases a SWMgr from the reader pool. Use this to read modules from worker threads (searches, statistics, index builds).
+    // The reads of leased modules must hold the SwordFileLock. Since the manager lock comes first in the lock order,
+    // no other method of the module store may be called while holding it.
+    SwordMgrLease acquireMgr();
+
+    // Returns the current snapshot of the installed module versions. A new snapshot is created whenever modules
+    // are installed or uninstalled, so the snapshot pointer can be used to detect changes.
+    std::shared_ptr<const InstalledVersionMap> getInstalledVersions();
     
 private:
     std::string customHomeDir;
     std::vector<std::string> getModuleLanguages(ModuleType moduleType=ModuleType::bible);
-    sword::SWMgr* _mgr = 0;
-    sword::SWMgr* _searchMgr = 0;
+    void updateInstalledVersions();
+
+    // The catalog is built on first use and discarded whenever the set of loaded modules changes
+    std::shared_ptr<const LocalModuleCatalog> getLocalModuleCatalog();
+    void invalidateLocalModuleCatalog();
+
+    ModuleConfigSnapshot* _configSnapshot = 0;
+    ReloadableSwordMgr* _mgr = 0;
+    SwordMgrPool* _mgrPool = 0;
+    std::recursive_mutex _mgrMutex;
+    std::shared_ptr<const InstalledVersionMap> _installedVersions;
+    std::mutex _installedVersionsMutex;
+    std::shared_ptr<const LocalModuleCatalog> _localModuleCatalog;
+    std::mutex _localModuleCatalogMutex;
     FileSystemHelper _fileSystemHelper;
 };
 
@@ -0,0 +1,327 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+// Std includes
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+// Sword includes
+#include <swconfig.h>
+#include <swmodule.h>
+#include <filemgr.h>
+#include <utilstr.h>
+
+// Own includes
+#include "reloadable_sword_mgr.hpp"
+#include "module_config_snapshot.hpp"
+#include "file_system_helper.hpp"
+#include "string_helper.hpp"
+#include "sword_file_lock.hpp"
+
+using namespace std;
+using namespace sword;
+
+ReloadableSwordMgr::~ReloadableSwordMgr()
+{
+    // The modules refer to the configurations, so they are deleted first
+    for (map<string, SWConfig*>::iterator it = this->_moduleConfigs.begin(); it != this->_moduleConfigs.end(); it++) {
+        this->deleteModule(it->first.c_str());
+        delete it->second;
+    }
+}
+
+void ReloadableSwordMgr::setModuleCreationDeferred(bool deferred)
+{
+    lock_guard<recursive_mutex> lock(this->_moduleMutex);
+    this->_moduleCreationDeferred = deferred;
+}
+
+void ReloadableSwordMgr::setConfigSnapshot(ModuleConfigSnapshot* configSnapshot)
+{
+    this->_configSnapshot = configSnapshot;
+}
+
+void ReloadableSwordMgr::loadConfigDir(const char* ipath)
+{
+    if (this->_configSnapshot == 0) {
+        SWMgr::loadConfigDir(ipath);
+        return;
+    }
+
+    // Like SWMgr::loadConfigDir, the configurations are added to an existing configuration
+    if (this->config == 0) {
+        this->config = this->myconfig = new SWConfig();
+    }
+
+    this->_configSnapshot->loadConfigDir(string(ipath), this->config->getSections());
+}
+
+SWModule* ReloadableSwordMgr::createModule(const char* name, const char* driver, ConfigEntMap& section)
+{
+    if (!this->_moduleCreationDeferred) {
+        return SWMgr::createModule(name, driver, section);
+    }
+
+    // Like a newly created module, the deferred configuration replaces an already loaded instance
+    string moduleName = string(name);
+    this->releaseModule(moduleName);
+
+    DeferredModule& deferredModule = this->_deferredModules[moduleName];
+    deferredModule.section = section;
+    deferredModule.prefixPath = (this->prefixPath != 0) ? string(this->prefixPath) : "";
+
+    // createAllModules skips sections without module
+    return 0;
+}
+
+SWModule* ReloadableSwordMgr::getOrCreateModule(string moduleName)
+{
+    lock_guard<recursive_mutex> lock(this->_moduleMutex);
+    SWModule* module = this->getModule(moduleName.c_str());
+
+    if (module == 0) {
+        map<string, DeferredModule>::iterator it = this->_deferredModules.find(moduleName);
+
+        if (it != this->_deferredModules.end()) {
+            SWConfig* moduleConfig = new SWConfig();
+            moduleConfig->getSections()[moduleName.c_str()] = it->second.section;
+            string prefixPath = it->second.prefixPath;
+            this->_deferredModules.erase(it);
+
+            if (this->createModuleFromConfig(moduleName, moduleConfig, prefixPath) == 0) {
+                module = this->getModule(moduleName.c_str());
+            }
+        }
+    }
+
+    return module;
+}
+
+vector<string> ReloadableSwordMgr::getModuleNames()
+{
+    lock_guard<recursive_mutex> lock(this->_moduleMutex);
+    vector<string> moduleNames;
+
+    for (ModMap::iterator it = this->Modules.begin(); it != this->Modules.end(); it++) {
+        moduleNames.push_back(string(it->first.c_str()));
+    }
+
+    for (map<string, DeferredModule>::iterator it = this->_deferredModules.begin(); it != this->_deferredModules.end(); it++) {
+        moduleNames.push_back(it->first);
+    }
+
+    return moduleNames;
+}
+
+const ConfigEntMap* ReloadableSwordMgr::getModuleConfig(string moduleName)
+{
+    lock_guard<recursive_mutex> lock(this->_moduleMutex);
+    SWModule* module = this->getModule(moduleName.c_str());
+
+    if (module != 0) {
+        return &(module->getConfig());
+    }
+
+    map<string, DeferredModule>::iterator it = this->_deferredModules.find(moduleName);
+    if (it != this->_deferredModules.end()) {
+        return &(it->second.section);
+    }
+
+    return 0;
+}
+
+int ReloadableSwordMgr::reloadModule(string moduleName, string confFilePath, string prefixPath)
+{
+    SWConfig* moduleConfig = new SWConfig(confFilePath.c_str());
+    SectionMap& sections = moduleConfig->getSections();
+
+    if (sections.find(moduleName.c_str()) == sections.end()) {
+        cerr << "reloadModule: " << confFilePath << " does not contain the module " << moduleName << endl;
+        delete moduleConfig;
+        return -1;
+    }
+
+    // Other modules defined in the same file are not touched
+    for (SectionMap::iterator it = sections.begin(); it != sections.end();) {
+        if (string(it->first.c_str()) != moduleName) {
+            sections.erase(it++);
+        } else {
+            it++;
+        }
+    }
+
+    lock_guard<recursive_mutex> lock(this->_moduleMutex);
+    this->evictModule(moduleName);
+    return this->createModuleFromConfig(moduleName, moduleConfig, prefixPath);
+}
+
+int ReloadableSwordMgr::createModuleFromConfig(string moduleName, SWConfig* moduleConfig, string prefixPath)
+{
+    ConfigEntMap& section = moduleConfig->getSections().begin()->second;
+    ConfigEntMap::iterator driverEntry = section.find("ModDrv");
+    SWModule* module = 0;
+
+    if (prefixPath.size() > 0 && prefixPath[prefixPath.size() - 1] != '/' && prefixPath[prefixPath.size() - 1] != '\\') {
+        prefixPath += "/";
+    }
+
+    if (driverEntry != section.end()) {
+        // SWMgr::createModule resolves the DataPath of the module against prefixPath, so the prefix path of the
+        // module's directory is set for the creation. The base implementation is called to bypass the deferral.
+        char* mainPrefixPath = 0;
+        stdstr(&mainPrefixPath, this->prefixPath);
+        stdstr(&(this->prefixPath), prefixPath.c_str());
+
+        module = SWMgr::createModule(moduleName.c_str(), driverEntry->second.c_str(), section);
+
+        stdstr(&(this->prefixPath), mainPrefixPath);
+        delete [] mainPrefixPath;
+    }
+
+    if (module == 0) {
+        cerr << "reloadModule: Could not create the module " << moduleName << endl;
+        delete moduleConfig;
+        return -1;
+    }
+
+    // The filters are added through the same hooks and in the same order as in SWMgr::createAllModules
+    this->addGlobalOptions(module, section, section.lower_bound("GlobalOptionFilter"), section.upper_bound("GlobalOptionFilter"));
+    this->addLocalOptions(module, section, section.lower_bound("LocalOptionFilter"), section.upper_bound("LocalOptionFilter"));
+    this->addStripFilters(module, section);
+    this->addLocalStripFilters(module, section, section.lower_bound("LocalStripFilter"), section.upper_bound("LocalStripFilter"));
+    this->addRawFilters(module, section);
+    this->addRenderFilters(module, section);
+    this->addEncodingFilters(module, section);
+
+    this->Modules[module->getName()] = module;
+
+    if (this->config != 0) {
+        this->config->getSections()[moduleName.c_str()] = section;
+    }
+
+    this->_moduleConfigs[moduleName] = moduleConfig;
+    return 0;
+}
+
+void ReloadableSwordMgr::evictModule(string moduleName)
+{
+    lock_guard<recursive_mutex> lock(this->_moduleMutex);
+    this->releaseModule(moduleName);
+
+    if (this->config != 0) {
+        this->config->getSections().erase(moduleName.c_str());
+    }
+}
+
+void ReloadableSwordMgr::releaseModule(string moduleName)
+{
+    // Must not touch this->config, since this is also called while createAllModules iterates over it
+    this->deleteModule(moduleName.c_str());
+    this->_deferredModules.erase(moduleName);
+
+    map<string, SWConfig*>::iterator it = this->_moduleConfigs.find(moduleName);
+    if (it != this->_moduleConfigs.end()) {
+        delete it->second;
+        this->_moduleConfigs.erase(it);
+    }
+}
+
+string ReloadableSwordMgr::findModuleConf(string modsDir, string moduleName)
+{
+    FileSystemHelper fileSystemHelper;
+    string separator = fileSystemHelper.getPathSeparator();
+
+    // Configuration files are usually named after the lowercase module name, so that file is checked first
+    string lowerCaseName = moduleName;
+    std::transform(lowerCaseName.begin(), lowerCaseName.end(), lowerCaseName.begin(), ::tolower);
+
+    vector<string> candidates;
+    candidates.push_back(lowerCaseName + ".conf");
+
+    vector<string> confFiles = fileSystemHelper.getFilesInDir(modsDir);
+    for (unsigned int i = 0; i < confFiles.size(); i++) {
+        if (StringHelper::hasEnding(confFiles[i], ".conf") && confFiles[i] != candidates[0]) {
+            candidates.push_back(confFiles[i]);
+        }
+    }
+
+    for (unsigned int i = 0; i < candidates.size(); i++) {
+        string confFilePath = modsDir + separator + candidates[i];
+
+        if (!FileMgr::existsFile(confFilePath.c_str())) {
+            continue;
+        }
+
+        SwordFileLock fileLock;
+        SWConfig config(confFilePath.c_str());
+        if (config.getSections().find(moduleName.c_str()) != config.getSections().end()) {
+            return confFilePath;
+        }
+    }
+
+    return "";
+}
+
+string ReloadableSwordMgr::getModuleType(const ConfigEntMap& section)
+{
+    ConfigEntMap::const_iterator entry = section.find("Type");
+
+    // Like in SWMgr::createModule, an explicitly configured type takes precedence over the driver
+    if (entry != section.end()) {
+        return string(entry->second.c_str());
+    }
+
+    // Image and map collections are distinguished by their category
+    entry = section.find("Category");
+    if (entry != section.end()) {
+        if (!stricmp(entry->second.c_str(), "Images")) {
+            return "Images";
+        } else if (!stricmp(entry->second.c_str(), "Maps")) {
+            return "Maps";
+        }
+    }
+
+    entry = section.find("ModDrv");
+    if (entry == section.end()) {
+        return "";
+    }
+
+    const char* driver = entry->second.c_str();
+
+    if (!stricmp(driver, "RawText") || !stricmp(driver, "RawText4") || !stricmp(driver, "zText") || !stricmp(driver, "zText4")) {
+        return SWMgr::MODTYPE_BIBLES;
+    } else if (!stricmp(driver, "RawCom") || !stricmp(driver, "RawCom4") || !stricmp(driver, "zCom") || !stricmp(driver, "zCom4") ||
+               !stricmp(driver, "HREFCom") || !stricmp(driver, "RawFiles")) {
+        return SWMgr::MODTYPE_COMMENTARIES;
+    } else if (!stricmp(driver, "RawLD") || !stricmp(driver, "RawLD4") || !stricmp(driver, "zLD")) {
+        return SWMgr::MODTYPE_LEXDICTS;
+    } else if (!stricmp(driver, "RawGenBook")) {
+        return SWMgr::MODTYPE_GENBOOKS;
+    }
+
+    return "";
+}
+
+string ReloadableSwordMgr::getModuleLanguage(const ConfigEntMap& section)
+{
+    ConfigEntMap::const_iterator entry = section.find("Lang");
+
+    // SWMgr::createModule defaults to English
+    return (entry != section.end()) ? string(entry->second.c_str()) : "en";
+}
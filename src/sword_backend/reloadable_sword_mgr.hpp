@@ -0,0 +1,105 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef _RELOADABLE_SWORD_MGR
+#define _RELOADABLE_SWORD_MGR
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+
+#include <swmgr.h>
+
+namespace sword {
+    class SWConfig;
+    class SWModule;
+};
+
+class ModuleConfigSnapshot;
+
+/**
+ * A SWMgr that can load, reload or evict a single module without rescanning all module configurations.
+ * Modules loaded this way keep a pointer to their configuration section, so the configuration of every
+ * individually loaded module is owned by the manager until the module is reloaded or evicted.
+ *
+ * The creation of the module drivers can be deferred while the configurations are loaded. Deferred modules
+ * are only known by their configuration and their drivers are created on first access via getOrCreateModule.
+ * Note that SWMgr::getModule and SWMgr::Modules do not know about deferred modules.
+ *
+ * If a ModuleConfigSnapshot is set, the module configuration directories are loaded through the snapshot.
+ */
+class ReloadableSwordMgr : public sword::SWMgr
+{
+public:
+    using sword::SWMgr::SWMgr;
+    virtual ~ReloadableSwordMgr();
+
+    // While enabled, load() and augmentModules() only record the module configurations. To defer the initial load,
+    // the manager must be constructed without autoload and load() must be called after enabling this.
+    void setModuleCreationDeferred(bool deferred);
+
+    // Must be called before load(). The snapshot must outlive the manager.
+    void setConfigSnapshot(ModuleConfigSnapshot* configSnapshot);
+
+    // Returns the module and creates its driver if it has been deferred. Returns 0 for unknown modules.
+    sword::SWModule* getOrCreateModule(std::string moduleName);
+
+    // Returns the names of all modules including the deferred ones
+    std::vector<std::string> getModuleNames();
+
+    // Returns the configuration of a module, also if its driver has not been created yet. Returns 0 for unknown modules.
+    const sword::ConfigEntMap* getModuleConfig(std::string moduleName);
+
+    // Creates the module from the section moduleName of the given configuration file. The module's DataPath is
+    // resolved against prefixPath. An already loaded instance of the module is replaced. Returns 0 on success.
+    int reloadModule(std::string moduleName, std::string confFilePath, std::string prefixPath);
+
+    // Removes the module from the manager and from its configuration
+    void evictModule(std::string moduleName);
+
+    // Returns the path of the configuration file in modsDir that defines the given module or "" if there is none
+    static std::string findModuleConf(std::string modsDir, std::string moduleName);
+
+    // Return the type and language that SWMgr assigns to a module created from the given configuration section,
+    // so that modules can be classified without creating their drivers. The type is "" for unsupported drivers.
+    static std::string getModuleType(const sword::ConfigEntMap& section);
+    static std::string getModuleLanguage(const sword::ConfigEntMap& section);
+
+protected:
+    virtual sword::SWModule* createModule(const char* name, const char* driver, sword::ConfigEntMap& section);
+    virtual void loadConfigDir(const char* ipath);
+
+private:
+    class DeferredModule {
+    public:
+        sword::ConfigEntMap section;
+        std::string prefixPath;
+    };
+
+    int createModuleFromConfig(std::string moduleName, sword::SWConfig* moduleConfig, std::string prefixPath);
+    void releaseModule(std::string moduleName);
+
+    ModuleConfigSnapshot* _configSnapshot = 0;
+    bool _moduleCreationDeferred = false;
+    std::map<std::string, DeferredModule> _deferredModules;
+    std::map<std::string, sword::SWConfig*> _moduleConfigs;
+    std::recursive_mutex _moduleMutex;
+};
+
+#endif // _RELOADABLE_SWORD_MGR
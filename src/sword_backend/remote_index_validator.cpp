@@ -0,0 +1,348 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+
+// Std includes
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <cctype>
+#include <mutex>
+
+#if defined(__APPLE__)
+#include <TargetConditionals.h>
+#endif
+
+#if !defined(__ANDROID__) && !TARGET_OS_IOS
+#define REMOTE_INDEX_PROBE_SUPPORTED 1
+#include <curl/curl.h>
+#endif
+
+// Sword includes
+#include <installmgr.h>
+#include <swconfig.h>
+#include <filemgr.h>
+
+// Own includes
+#include "remote_index_validator.hpp"
+#include "repository_refresh_scheduler.hpp"
+#include "sword_file_lock.hpp"
+
+using namespace std;
+using namespace sword;
+
+#define VALIDATOR_SECTION "Validators"
+
+#ifdef REMOTE_INDEX_PROBE_SUPPORTED
+static once_flag curlInitFlag;
+
+static size_t probeHeaderCallback(char* buffer, size_t size, size_t itemCount, void* userData)
+{
+    size_t length = size * itemCount;
+    RemoteIndexValidators* validators = (RemoteIndexValidators*)userData;
+    string headerLine(buffer, length);
+    string headerPrefix = "etag:";
+
+    if (headerLine.size() > headerPrefix.size()) {
+        bool isEtag = true;
+
+        for (unsigned int i = 0; i < headerPrefix.size(); i++) {
+            if (tolower((unsigned char)headerLine[i]) != headerPrefix[i]) {
+                isEtag = false;
+                break;
+            }
+        }
+
+        if (isEtag) {
+            string etag = headerLine.substr(headerPrefix.size());
+            size_t start = etag.find_first_not_of(" \t");
+            size_t end = etag.find_last_not_of(" \t\r\n");
+
+            if (start != string::npos && end != string::npos) {
+                validators->etag = etag.substr(start, end - start + 1);
+            }
+        }
+    }
+
+    return length;
+}
+
+static size_t downloadWriteCallback(char* buffer, size_t size, size_t itemCount, void* userData)
+{
+    ofstream* destFile = (ofstream*)userData;
+    destFile->write(buffer, size * itemCount);
+    return destFile->good() ? (size * itemCount) : 0;
+}
+#endif
+
+RemoteIndexValidator::RemoteIndexValidator(long timeoutMillis) : _timeoutMillis(timeoutMillis)
+{
+}
+
+bool RemoteIndexValidator::isLocalIndexCurrent(InstallSource* source, RemoteIndexValidators& currentValidators, long maxDurationMillis)
+{
+    if (source == 0) {
+        return false;
+    }
+
+    if (!this->probeRemoteValidators(source, currentValidators, maxDurationMillis)) {
+        return false;
+    }
+
+    string localShadow = string(source->localShadow.c_str());
+    if (!FileMgr::existsFile(localShadow.c_str(), "mods.d.tar.gz")) {
+        return false;
+    }
+
+    RemoteIndexValidators storedValidators = this->loadValidators(source);
+    return this->validatorsMatch(storedValidators, currentValidators);
+}
+
+void RemoteIndexValidator::storeValidators(InstallSource* source, const RemoteIndexValidators& validators)
+{
+    // SWConfig reads and writes through the FileMgr
+    SwordFileLock fileLock;
+    SWConfig validatorConfig(this->getValidatorFilePath(source).c_str());
+
+    validatorConfig.setValue(VALIDATOR_SECTION, "ETag", validators.etag.c_str());
+    validatorConfig.setValue(VALIDATOR_SECTION, "LastModified", to_string(validators.lastModified).c_str());
+    validatorConfig.setValue(VALIDATOR_SECTION, "Size", to_string(validators.size).c_str());
+    validatorConfig.save();
+}
+
+void RemoteIndexValidator::clearValidators(InstallSource* source)
+{
+    FileMgr::removeFile(this->getValidatorFilePath(source).c_str());
+}
+
+int RemoteIndexValidator::downloadIndex(InstallSource* source, string destPath, long maxDurationMillis)
+{
+#ifdef REMOTE_INDEX_PROBE_SUPPORTED
+    call_once(curlInitFlag, []() { curl_global_init(CURL_GLOBAL_DEFAULT); });
+
+    CURL* curl = curl_easy_init();
+    if (curl == 0) {
+        return -1;
+    }
+
+    ofstream destFile(destPath.c_str(), ios::binary | ios::trunc);
+    if (!destFile.is_open()) {
+        cerr << "Could not open " << destPath << " for writing" << endl << flush;
+        curl_easy_cleanup(curl);
+        return -1;
+    }
+
+    string url = this->getIndexUrl(source);
+    string userName = string(source->u.c_str());
+    string password = string(source->p.c_str());
+    long transferTimeout = this->getTransferTimeout(maxDurationMillis);
+    long lowSpeedTime = transferTimeout / 1000;
+    if (lowSpeedTime < 1) {
+        lowSpeedTime = 1;
+    }
+
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, transferTimeout);
+    // The whole transfer has to finish within the budget, independent of whether the server still sends data
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, maxDurationMillis);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, lowSpeedTime);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, downloadWriteCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &destFile);
+
+    if (!userName.empty()) {
+        curl_easy_setopt(curl, CURLOPT_USERNAME, userName.c_str());
+        curl_easy_setopt(curl, CURLOPT_PASSWORD, password.c_str());
+    }
+
+    CURLcode result = curl_easy_perform(curl);
+    long responseCode = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responseCode);
+    curl_easy_cleanup(curl);
+    destFile.close();
+
+    if (result != CURLE_OK) {
+        cerr << "Could not download " << url << ": " << curl_easy_strerror(result) << endl << flush;
+
+        // Retrying does not help if the server does not know the index
+        bool indexMissing = (result == CURLE_REMOTE_FILE_NOT_FOUND ||
+                             (result == CURLE_HTTP_RETURNED_ERROR && (responseCode == 404 || responseCode == 410)));
+
+        return indexMissing ? REFRESH_PERMANENT_FAILURE : -1;
+    }
+
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+bool RemoteIndexValidator::isDownloadSupported()
+{
+#ifdef REMOTE_INDEX_PROBE_SUPPORTED
+    return true;
+#else
+    return false;
+#endif
+}
+
+long RemoteIndexValidator::getTransferTimeout(long maxDurationMillis)
+{
+    // A single request may take as long as the network timeout, but not longer than the remaining budget
+    if (maxDurationMillis > 0 && maxDurationMillis < this->_timeoutMillis) {
+        return maxDurationMillis;
+    }
+
+    return this->_timeoutMillis;
+}
+
+bool RemoteIndexValidator::probeRemoteValidators(InstallSource* source, RemoteIndexValidators& validators, long maxDurationMillis)
+{
+#ifdef REMOTE_INDEX_PROBE_SUPPORTED
+    call_once(curlInitFlag, []() { curl_global_init(CURL_GLOBAL_DEFAULT); });
+
+    CURL* curl = curl_easy_init();
+    if (curl == 0) {
+        return false;
+    }
+
+    string url = this->getIndexUrl(source);
+    string userName = string(source->u.c_str());
+    string password = string(source->p.c_str());
+
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+    curl_easy_setopt(curl, CURLOPT_FILETIME, 1L);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, this->getTransferTimeout(maxDurationMillis));
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, probeHeaderCallback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &validators);
+
+    if (!userName.empty()) {
+        curl_easy_setopt(curl, CURLOPT_USERNAME, userName.c_str());
+        curl_easy_setopt(curl, CURLOPT_PASSWORD, password.c_str());
+    }
+
+    CURLcode result = curl_easy_perform(curl);
+
+    if (result == CURLE_OK) {
+#if LIBCURL_VERSION_NUM >= 0x073b00
+        curl_off_t fileTime = -1;
+        curl_easy_getinfo(curl, CURLINFO_FILETIME_T, &fileTime);
+#else
+        long fileTime = -1;
+        curl_easy_getinfo(curl, CURLINFO_FILETIME, &fileTime);
+#endif
+
+#if LIBCURL_VERSION_NUM >= 0x073700
+        curl_off_t contentLength = -1;
+        curl_easy_getinfo(curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &contentLength);
+#else
+        double contentLength = -1;
+        curl_easy_getinfo(curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD, &contentLength);
+#endif
+
+        validators.lastModified = (long long)fileTime;
+        validators.size = (long long)contentLength;
+    } else {
+        cerr << "Could not probe " << url << ": " << curl_easy_strerror(result) << endl << flush;
+    }
+
+    curl_easy_cleanup(curl);
+    return (result == CURLE_OK && !validators.isEmpty());
+#else
+    return false;
+#endif
+}
+
+RemoteIndexValidators RemoteIndexValidator::loadValidators(InstallSource* source)
+{
+    RemoteIndexValidators validators;
+    string validatorFilePath = this->getValidatorFilePath(source);
+
+    if (!FileMgr::existsFile(validatorFilePath.c_str())) {
+        return validators;
+    }
+
+    SwordFileLock fileLock;
+    SWConfig validatorConfig(validatorFilePath.c_str());
+    string lastModified = string(validatorConfig.getValue(VALIDATOR_SECTION, "LastModified").c_str());
+    string size = string(validatorConfig.getValue(VALIDATOR_SECTION, "Size").c_str());
+
+    validators.etag = string(validatorConfig.getValue(VALIDATOR_SECTION, "ETag").c_str());
+
+    if (!lastModified.empty()) {
+        validators.lastModified = strtoll(lastModified.c_str(), 0, 10);
+    }
+
+    if (!size.empty()) {
+        validators.size = strtoll(size.c_str(), 0, 10);
+    }
+
+    return validators;
+}
+
+bool RemoteIndexValidator::validatorsMatch(const RemoteIndexValidators& storedValidators, const RemoteIndexValidators& remoteValidators)
+{
+    if (!storedValidators.etag.empty() && !remoteValidators.etag.empty()) {
+        return (storedValidators.etag == remoteValidators.etag);
+    }
+
+    // Without ETag the modification time alone is too coarse (one second resolution), so the size has to match as well
+    return (storedValidators.lastModified >= 0 &&
+            storedValidators.size >= 0 &&
+            storedValidators.lastModified == remoteValidators.lastModified &&
+            storedValidators.size == remoteValidators.size);
+}
+
+string RemoteIndexValidator::getIndexUrl(InstallSource* source)
+{
+    // Mirrors the URL construction of InstallMgr::remoteCopy
+    string type = string(source->type.c_str());
+    string url;
+
+    if (type == "HTTP") {
+        url = "http://";
+    } else if (type == "HTTPS") {
+        url = "https://";
+    } else if (type == "SFTP") {
+        url = "sftp://";
+    } else {
+        url = "ftp://";
+    }
+
+    url += string(source->source.c_str());
+    url += string(source->directory.c_str());
+
+    while (!url.empty() && (url[url.size() - 1] == '/' || url[url.size() - 1] == '\\')) {
+        url.erase(url.size() - 1);
+    }
+
+    url += "/mods.d.tar.gz";
+    return url;
+}
+
+string RemoteIndexValidator::getValidatorFilePath(InstallSource* source)
+{
+    return string(source->localShadow.c_str()) + "/validators.conf";
+}
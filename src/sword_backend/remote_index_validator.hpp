@@ -0,0 +1,88 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+
+#ifndef _REMOTE_INDEX_VALIDATOR
+#define _REMOTE_INDEX_VALIDATOR
+
+#include <string>
+
+namespace sword {
+    class InstallSource;
+};
+
+// The validators describing a version of the module index (mods.d.tar.gz) of a remote source
+class RemoteIndexValidators {
+public:
+    std::string etag;
+    long long lastModified = -1;
+    long long size = -1;
+
+    bool isEmpty() const {
+        return (this->etag.empty() && this->lastModified < 0 && this->size < 0);
+    }
+};
+
+/**
+ * The RemoteIndexValidator decides whether the module index of a remote source needs to be downloaded again.
+ *
+ * The validators of the last downloaded index are persisted in the local shadow directory of the source.
+ * Before a refresh, the current validators are requested from the server (HTTP HEAD / FTP MDTM + SIZE) without
+ * transferring the index itself. The index is considered unchanged if the ETags match or, for servers without ETag,
+ * if both the modification time and the size match.
+ *
+ * The index itself is also downloaded here, so that its transfer can be limited to the remaining time budget of the refresh.
+ *
+ * Platforms on which SWORD is built without libcurl (Android, iOS) do not support probing, so every refresh
+ * downloads the index there via the InstallMgr.
+ */
+class RemoteIndexValidator {
+public:
+    RemoteIndexValidator(long timeoutMillis=20000);
+    virtual ~RemoteIndexValidator(){}
+
+    // Returns true if the local copy of the index is known to be identical to the remote one.
+    // The remote validators are returned in currentValidators, so that they can be stored after a download.
+    // A maxDurationMillis of 0 only limits the request by the network timeout.
+    bool isLocalIndexCurrent(sword::InstallSource* source, RemoteIndexValidators& currentValidators, long maxDurationMillis=0);
+
+    // Downloads the index of the source to destPath and returns 0 on success. The transfer is aborted once
+    // maxDurationMillis have passed (0: no limit) or if it stalls for longer than the network timeout.
+    // Returns REFRESH_PERMANENT_FAILURE if the server reports that the index does not exist.
+    int downloadIndex(sword::InstallSource* source, std::string destPath, long maxDurationMillis=0);
+
+    // Returns false on platforms without libcurl, where downloadIndex is not available
+    static bool isDownloadSupported();
+
+    void storeValidators(sword::InstallSource* source, const RemoteIndexValidators& validators);
+    void clearValidators(sword::InstallSource* source);
+
+    void setTimeoutMillis(long timeoutMillis) { this->_timeoutMillis = timeoutMillis; }
+
+private:
+    bool probeRemoteValidators(sword::InstallSource* source, RemoteIndexValidators& validators, long maxDurationMillis);
+    long getTransferTimeout(long maxDurationMillis);
+    RemoteIndexValidators loadValidators(sword::InstallSource* source);
+    bool validatorsMatch(const RemoteIndexValidators& storedValidators, const RemoteIndexValidators& remoteValidators);
+    std::string getIndexUrl(sword::InstallSource* source);
+    std::string getValidatorFilePath(sword::InstallSource* source);
+
+    long _timeoutMillis;
+};
+
+#endif // _REMOTE_INDEX_VALIDATOR
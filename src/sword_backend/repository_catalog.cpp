@@ -0,0 +1,272 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+// Sword includes
+#include <swmgr.h>
+#include <swmodule.h>
+#include <swversion.h>
+
+// Own includes
+#include "repository_catalog.hpp"
+#include "module_helper.hpp"
+
+using namespace std;
+using namespace sword;
+
+RepositoryCatalog::RepositoryCatalog(std::function<shared_ptr<SWMgr>(const string& repoName)> getSourceMgr,
+                                     const vector<string>& repoNames,
+                                     ModuleHelper& moduleHelper,
+                                     const RepositoryCatalog* baseCatalog,
+                                     const unordered_set<string>& staleRepos)
+{
+    // Used for deduplicating the language lists while building the catalog
+    unordered_set<string> knownLanguages;
+
+    for (unsigned int i = 0; i < repoNames.size(); i++) {
+        const string& repoName = repoNames[i];
+
+        // Every known repository gets an (initially empty) entry, so that hasRepo() works for empty repositories
+        this->_entriesByRepoAndType[this->getKey(repoName, "ANY")];
+        this->_languagesByRepoAndType[this->getKey(repoName, "ANY")];
+
+        // Take over the entries of unchanged repositories without touching their modules again
+        if (baseCatalog != 0 && staleRepos.find(repoName) == staleRepos.end() && baseCatalog->hasRepo(repoName)) {
+            const vector<unsigned int>* baseEntries = baseCatalog->findIndexEntries(baseCatalog->_entriesByRepoAndType,
+                                                                                    this->getKey(repoName, "ANY"));
+
+            for (unsigned int j = 0; j < baseEntries->size(); j++) {
+                this->addEntry(baseCatalog->_entries[(*baseEntries)[j]], knownLanguages);
+            }
+
+            unordered_map<string, shared_ptr<SWMgr>>::const_iterator baseMgr = baseCatalog->_sourceMgrs.find(repoName);
+            if (baseMgr != baseCatalog->_sourceMgrs.end()) {
+                this->_sourceMgrs[repoName] = baseMgr->second;
+            }
+
+            continue;
+        }
+
+        shared_ptr<SWMgr> mgr = getSourceMgr(repoName);
+        if (!mgr) {
+            continue;
+        }
+
+        this->_sourceMgrs[repoName] = mgr;
+
+        // ModMap is sorted by module name, so all indices are sorted by module name as well
+        for (ModMap::const_iterator it = mgr->Modules.begin(); it != mgr->Modules.end(); it++) {
+            SWModule* currentModule = it->second;
+
+            if (currentModule == 0 || currentModule->getName() == 0) {
+                continue;
+            }
+
+            RepositoryCatalogEntry entry;
+            entry.module = currentModule;
+            entry.repoName = repoName;
+            entry.moduleName = string(currentModule->getName());
+            entry.moduleType = string(currentModule->getType());
+            entry.language = string(currentModule->getLanguage());
+            entry.features = 0;
+
+            const char* version = currentModule->getConfigEntry("Version");
+            entry.version = (version != 0) ? string(version) : "1.0";
+            entry.locked = (currentModule->getConfigEntry("CipherKey") != 0);
+
+            if (moduleHelper.moduleHasGlobalOption(currentModule, "Headings")) {
+                entry.features |= CATALOG_FEATURE_HEADINGS;
+            }
+
+            if (moduleHelper.moduleHasGlobalOption(currentModule, "Strongs")) {
+                entry.features |= CATALOG_FEATURE_STRONGS;
+            }
+
+            if (moduleHelper.moduleHasFeature(currentModule, "HebrewDef")) {
+                entry.features |= CATALOG_FEATURE_HEBREW_STRONGS_KEYS;
+            }
+
+            if (moduleHelper.moduleHasFeature(currentModule, "GreekDef")) {
+                entry.features |= CATALOG_FEATURE_GREEK_STRONGS_KEYS;
+            }
+
+            this->addEntry(entry, knownLanguages);
+        }
+    }
+}
+
+bool RepositoryCatalog::hasRepo(const string& repoName) const
+{
+    return (this->_entriesByRepoAndType.find(this->getKey(repoName, "ANY")) != this->_entriesByRepoAndType.end());
+}
+
+vector<SWModule*> RepositoryCatalog::getModules(const string& repoName, const string& moduleType) const
+{
+    return this->getModulesFromIndexEntries(this->findIndexEntries(this->_entriesByRepoAndType, this->getKey(repoName, moduleType)));
+}
+
+vector<SWModule*> RepositoryCatalog::getModulesByLang(const string& repoName,
+                                                      const string& moduleType,
+                                                      const string& language,
+                                                      unsigned int requiredFeatures) const
+{
+    return this->getModulesFromIndexEntries(this->findIndexEntries(this->_entriesByRepoTypeAndLang, this->getKey(repoName, moduleType, language)),
+                                            requiredFeatures);
+}
+
+unsigned int RepositoryCatalog::getModuleCount(const string& repoName, const string& moduleType) const
+{
+    const vector<unsigned int>* indexEntries = this->findIndexEntries(this->_entriesByRepoAndType, this->getKey(repoName, moduleType));
+    return (indexEntries == 0) ? 0 : (unsigned int)indexEntries->size();
+}
+
+vector<string> RepositoryCatalog::getLanguages(const string& repoName, const string& moduleType) const
+{
+    unordered_map<string, vector<string>>::const_iterator it = this->_languagesByRepoAndType.find(this->getKey(repoName, moduleType));
+
+    if (it == this->_languagesByRepoAndType.end()) {
+        return vector<string>();
+    }
+
+    return it->second;
+}
+
+SWModule* RepositoryCatalog::getModule(const string& repoName, const string& moduleName) const
+{
+    unordered_map<string, unsigned int>::const_iterator it = this->_entryByRepoAndName.find(this->getKey(repoName, moduleName));
+
+    if (it == this->_entryByRepoAndName.end()) {
+        return 0;
+    }
+
+    return this->_entries[it->second].module;
+}
+
+string RepositoryCatalog::getModuleRepo(const string& moduleName) const
+{
+    unordered_map<string, string>::const_iterator it = this->_repoByModuleName.find(moduleName);
+
+    if (it == this->_repoByModuleName.end()) {
+        return "";
+    }
+
+    return it->second;
+}
+
+vector<SWModule*> RepositoryCatalog::getUpdatedModules(const string& repoName,
+                                                       const unordered_map<string, string>& installedVersions) const
+{
+    vector<SWModule*> modules;
+    const vector<unsigned int>* indexEntries = this->findIndexEntries(this->_entriesByRepoAndType, this->getKey(repoName, "ANY"));
+
+    if (indexEntries == 0) {
+        return modules;
+    }
+
+    for (unsigned int i = 0; i < indexEntries->size(); i++) {
+        const RepositoryCatalogEntry& entry = this->_entries[(*indexEntries)[i]];
+
+        if (entry.locked) {
+            continue;
+        }
+
+        unordered_map<string, string>::const_iterator it = installedVersions.find(entry.moduleName);
+
+        if (it != installedVersions.end() && SWVersion(entry.version.c_str()) > SWVersion(it->second.c_str())) {
+            modules.push_back(entry.module);
+        }
+    }
+
+    return modules;
+}
+
+void RepositoryCatalog::addEntry(const RepositoryCatalogEntry& entry, unordered_set<string>& knownLanguages)
+{
+    const string& repoName = entry.repoName;
+    unsigned int entryIndex = (unsigned int)this->_entries.size();
+    this->_entries.push_back(entry);
+
+    this->addToIndex(this->_entriesByRepoAndType, this->getKey(repoName, "ANY"), entryIndex);
+    this->addToIndex(this->_entriesByRepoAndType, this->getKey(repoName, entry.moduleType), entryIndex);
+    this->addToIndex(this->_entriesByRepoTypeAndLang, this->getKey(repoName, "ANY", entry.language), entryIndex);
+    this->addToIndex(this->_entriesByRepoTypeAndLang, this->getKey(repoName, entry.moduleType, entry.language), entryIndex);
+
+    this->addLanguage(this->getKey(repoName, "ANY"), entry.language, knownLanguages);
+    this->addLanguage(this->getKey(repoName, entry.moduleType), entry.language, knownLanguages);
+
+    this->_entryByRepoAndName[this->getKey(repoName, entry.moduleName)] = entryIndex;
+
+    if (this->_repoByModuleName.find(entry.moduleName) == this->_repoByModuleName.end()) {
+        this->_repoByModuleName[entry.moduleName] = repoName;
+    }
+}
+
+void RepositoryCatalog::addToIndex(unordered_map<string, vector<unsigned int>>& index, const string& key, unsigned int entryIndex)
+{
+    index[key].push_back(entryIndex);
+}
+
+void RepositoryCatalog::addLanguage(const string& key, const string& language, unordered_set<string>& knownLanguages)
+{
+    // The language lists keep the order in which the languages first appear
+    if (knownLanguages.insert(this->getKey(key, language)).second) {
+        this->_languagesByRepoAndType[key].push_back(language);
+    }
+}
+
+const vector<unsigned int>* RepositoryCatalog::findIndexEntries(const unordered_map<string, vector<unsigned int>>& index, const string& key) const
+{
+    unordered_map<string, vector<unsigned int>>::const_iterator it = index.find(key);
+
+    if (it == index.end()) {
+        return 0;
+    }
+
+    return &(it->second);
+}
+
+vector<SWModule*> RepositoryCatalog::getModulesFromIndexEntries(const vector<unsigned int>* indexEntries, unsigned int requiredFeatures) const
+{
+    vector<SWModule*> modules;
+
+    if (indexEntries == 0) {
+        return modules;
+    }
+
+    modules.reserve(indexEntries->size());
+
+    for (unsigned int i = 0; i < indexEntries->size(); i++) {
+        const RepositoryCatalogEntry& entry = this->_entries[(*indexEntries)[i]];
+
+        if ((entry.features & requiredFeatures) == requiredFeatures) {
+            modules.push_back(entry.module);
+        }
+    }
+
+    return modules;
+}
+
+string RepositoryCatalog::getKey(const string& first, const string& second) const
+{
+    // Module names, types, languages and repository names never contain line breaks
+    return first + '\n' + second;
+}
+
+string RepositoryCatalog::getKey(const string& first, const string& second, const string& third) const
+{
+    return first + '\n' + second + '\n' + third;
+}
@@ -0,0 +1,117 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef _REPOSITORY_CATALOG
+#define _REPOSITORY_CATALOG
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
+#include <memory>
+
+#include "common_defs.hpp"
+
+namespace sword {
+    class SWModule;
+    class SWMgr;
+};
+
+class ModuleHelper;
+
+enum CatalogFeature {
+    CATALOG_FEATURE_HEADINGS = 1,
+    CATALOG_FEATURE_STRONGS = 2,
+    CATALOG_FEATURE_HEBREW_STRONGS_KEYS = 4,
+    CATALOG_FEATURE_GREEK_STRONGS_KEYS = 8
+};
+
+class RepositoryCatalogEntry {
+public:
+    sword::SWModule* module;
+    std::string repoName;
+    std::string moduleName;
+    std::string moduleType;
+    std::string language;
+    std::string version;
+    bool locked;
+    unsigned int features;
+};
+
+/**
+ * An immutable snapshot of the modules of all remote repositories with hash indices for the queries of RepositoryInterface.
+ * The module pointers refer to the SWMgr instances of the remote sources the catalog has been built from. The catalog holds
+ * a reference to each of these SWMgr instances, so the modules stay valid as long as the catalog is used, even if a remote
+ * source is refreshed in the meantime. A catalog is still replaced after a refresh, since its content is outdated.
+ *
+ * A catalog can be built incrementally from a previous catalog. In that case only the repositories listed in
+ * staleRepos are read from the InstallMgr again, while the entries of all other repositories are taken over.
+ */
+class RepositoryCatalog {
+public:
+    RepositoryCatalog(std::function<std::shared_ptr<sword::SWMgr>(const std::string& repoName)> getSourceMgr,
+                      const std::vector<std::string>& repoNames,
+                      ModuleHelper& moduleHelper,
+                      const RepositoryCatalog* baseCatalog=0,
+                      const std::unordered_set<std::string>& staleRepos=std::unordered_set<std::string>());
+    virtual ~RepositoryCatalog() {}
+
+    bool hasRepo(const std::string& repoName) const;
+
+    // moduleType is a module type string as returned by RepositoryInterface::getModuleTypeString, including "ANY"
+    std::vector<sword::SWModule*> getModules(const std::string& repoName, const std::string& moduleType) const;
+    std::vector<sword::SWModule*> getModulesByLang(const std::string& repoName,
+                                                   const std::string& moduleType,
+                                                   const std::string& language,
+                                                   unsigned int requiredFeatures=0) const;
+
+    unsigned int getModuleCount(const std::string& repoName, const std::string& moduleType) const;
+    std::vector<std::string> getLanguages(const std::string& repoName, const std::string& moduleType) const;
+    sword::SWModule* getModule(const std::string& repoName, const std::string& moduleName) const;
+
+    // Returns the first repository (in the order of the repository names) containing the given module or "" if there is none
+    std::string getModuleRepo(const std::string& moduleName) const;
+
+    // Returns the modules of the given repository that are newer than the installed version. Locked modules are
+    // not reported, which matches the MODSTAT_UPDATED status of InstallMgr::getModuleStatus.
+    std::vector<sword::SWModule*> getUpdatedModules(const std::string& repoName,
+                                                    const std::unordered_map<std::string, std::string>& installedVersions) const;
+
+private:
+    void addEntry(const RepositoryCatalogEntry& entry, std::unordered_set<std::string>& knownLanguages);
+    void addToIndex(std::unordered_map<std::string, std::vector<unsigned int>>& index, const std::string& key, unsigned int entryIndex);
+    void addLanguage(const std::string& key, const std::string& language, std::unordered_set<std::string>& knownLanguages);
+    const std::vector<unsigned int>* findIndexEntries(const std::unordered_map<std::string, std::vector<unsigned int>>& index,
+                                                      const std::string& key) const;
+    std::vector<sword::SWModule*> getModulesFromIndexEntries(const std::vector<unsigned int>* indexEntries, unsigned int requiredFeatures=0) const;
+    std::string getKey(const std::string& first, const std::string& second) const;
+    std::string getKey(const std::string& first, const std::string& second, const std::string& third) const;
+
+    // Keeps the SWMgr instances alive that own the modules of the entries
+    std::unordered_map<std::string, std::shared_ptr<sword::SWMgr>> _sourceMgrs;
+
+    std::vector<RepositoryCatalogEntry> _entries;
+    std::unordered_map<std::string, std::vector<unsigned int>> _entriesByRepoAndType;
+    std::unordered_map<std::string, std::vector<unsigned int>> _entriesByRepoTypeAndLang;
+    std::unordered_map<std::string, unsigned int> _entryByRepoAndName;
+    std::unordered_map<std::string, std::string> _repoByModuleName;
+    std::unordered_map<std::string, std::vector<std::string>> _languagesByRepoAndType;
+};
+
+#endif // _REPOSITORY_CATALOG
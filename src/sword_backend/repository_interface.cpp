@@ -20,21 +20,13 @@
 #include <iostream>
 #include <sstream>
 #include <map>
-
-#ifdef __ANDROID__
-#include <sys/cdefs.h>
-#include <stdio.h>
-#include <stdlib.h>
-#else
-#include <fstream>
-#endif
+#include <chrono>
+#include <algorithm>
 
 #if defined(__APPLE__)
 #include <TargetConditionals.h>
 #endif
 
-#include <regex>
-
 // Own includes
 #include "repository_interface.hpp"
 #include "sword_status_reporter.hpp"
@@ -42,18 +34,31 @@
 #include "string_helper.hpp"
 #include "module_helper.hpp"
 #include "mutex.hpp"
+#include "repository_refresh_scheduler.hpp"
+#include "mods_archive_reader.hpp"
+#include "sword_file_lock.hpp"
 
 // Sword includes
 #include <installmgr.h>
 #include <swmodule.h>
 #include <swmgr.h>
 #include <remotetrans.h>
+#include <swconfig.h>
+#include <filemgr.h>
+#include <utilstr.h>
 
 using namespace std;
 using namespace sword;
 
 static Mutex remoteSourceUpdateMutex;
 
+// Deleting an InstallMgr also deletes the SWMgr instances of its sources, which close their files through the FileMgr
+static void deleteInstallMgr(InstallMgr* installMgr)
+{
+    SwordFileLock fileLock;
+    delete installMgr;
+}
+
 RepositoryInterface::RepositoryInterface(SwordStatusReporter& statusReporter,
                                          ModuleHelper& moduleHelper,
                                          ModuleStore& moduleStore,
@@ -68,42 +73,93 @@ RepositoryInterface::RepositoryInterface(SwordStatusReporter& statusReporter,
         this->_timeoutMillis = timeoutMillis;
     }
     this->_fileSystemHelper.setCustomHomeDir(customHomeDir);
+    this->_indexValidator.setTimeoutMillis(this->_timeoutMillis);
     this->resetMgr();
     remoteSourceUpdateMutex.init();
 }
 
+RepositoryInterface::~RepositoryInterface()
+{
+    this->invalidateCatalog();
+    this->flushAllSourceMgrs();
+}
+
 void RepositoryInterface::resetMgr()
 {
-    if (this->_installMgr != 0) {
-        delete this->_installMgr;
+    // cout << "Initializing InstallMgr at " << this->_fileSystemHelper.getInstallMgrDir() << endl;
+
+    this->replaceInstallMgr(shared_ptr<InstallMgr>(this->createInstallMgr(&this->_statusReporter), deleteInstallMgr));
+}
+
+void RepositoryInterface::replaceInstallMgr(shared_ptr<InstallMgr> installMgr)
+{
+    // Operations that still use the previous InstallMgr keep it alive with their own reference
+    shared_ptr<InstallMgr> previousInstallMgr;
+
+    {
+        lock_guard<mutex> lock(this->_installMgrMutex);
+        previousInstallMgr = this->_installMgr;
+        this->_installMgr = installMgr;
     }
 
-    // cout << "Initializing InstallMgr at " << this->_fileSystemHelper.getInstallMgrDir() << endl;
+    // The catalog refers to the sources of the previous InstallMgr
+    this->invalidateCatalog();
+}
 
-    this->_installMgr = new InstallMgr(this->_fileSystemHelper.getInstallMgrDir().c_str(), &this->_statusReporter);
-    this->_installMgr->setUserDisclaimerConfirmed(true);
+InstallMgr* RepositoryInterface::createInstallMgr(StatusReporter* statusReporter)
+{
+    // The InstallMgr reads its configuration through the FileMgr
+    SwordFileLock fileLock;
+    InstallMgr* installMgr = new InstallMgr(this->_fileSystemHelper.getInstallMgrDir().c_str(), statusReporter);
+    installMgr->setUserDisclaimerConfirmed(true);
+    installMgr->setTimeoutMillis(this->_timeoutMillis);
+    this->applySourceOverrides(installMgr);
+    return installMgr;
+}
 
-    this->_installMgr->setTimeoutMillis(this->_timeoutMillis);
+void RepositoryInterface::applySourceOverrides(InstallMgr* installMgr)
+{
+    // Force eBible.org to use HTTPS instead of FTP
+    InstallSourceMap::iterator eBibleSource = installMgr->sources.find("eBible.org");
+    if (eBibleSource != installMgr->sources.end() && eBibleSource->second != 0) {
+        eBibleSource->second->type = "HTTPS";
+        eBibleSource->second->source = "ebible.org";
+    }
 }
 
 int RepositoryInterface::refreshRepositoryConfig()
 {
     //cout << "Refreshing repository configuration ... ";
 
-    int ret = this->_installMgr->refreshRemoteSourceConfiguration();
-    if (ret != 0) {
-        cout << endl << "refreshRemoteSourceConfiguration returned " << ret << endl;
-        return ret;
-    }
+    // The configuration is refreshed on a new InstallMgr, which replaces the current one once it is complete.
+    // In the meantime, the current one can still be used by other callers.
+    shared_ptr<InstallMgr> installMgr(this->createInstallMgr(&this->_statusReporter), deleteInstallMgr);
+
+    {
+        // The SWORD transport writes the downloaded repository list through the FileMgr
+        SwordFileLock fileLock;
 
-    this->_installMgr->saveInstallConf();
+        int ret = installMgr->refreshRemoteSourceConfiguration();
+        if (ret != 0) {
+            cout << endl << "refreshRemoteSourceConfiguration returned " << ret << endl;
+            return ret;
+        }
+
+        installMgr->saveInstallConf();
+
+        // The sources have been read again from the updated configuration
+        this->applySourceOverrides(installMgr.get());
+    }
+    this->replaceInstallMgr(installMgr);
     //cout << "done." << endl;
     return 0;
 }
 
-int RepositoryInterface::refreshRemoteSources(bool force, map<string, bool>* repoUpdateStatus, std::function<void(unsigned int progress)>* progressCallback)
+int RepositoryInterface::refreshRemoteSources(bool force,
+                                              map<string, bool>* repoUpdateStatus,
+                                              std::function<void(unsigned int progress)>* progressCallback,
+                                              std::function<void(std::string repoName, bool successful, unsigned int progress)>* sourceCallback)
 {
-    vector<future<int>> refreshFutures;
     this->_remoteSourceUpdateCount = 0;
     bool refreshSuccessful = true;
 
@@ -113,33 +169,41 @@ int RepositoryInterface::refreshRemoteSources(bool force, map<string, bool>* rep
             return -1;
         }
 
-        // Force eBible.org to use HTTPS instead of FTP
-        InstallSource* eBibleSource = this->getRemoteSource("eBible.org");
-        if (eBibleSource != 0) {
-            eBibleSource->type = "HTTPS";
-            eBibleSource->source = "ebible.org";
-        }
-
         vector<string> sourceNames = this->getRepoNames();
         this->_remoteSourceCount = sourceNames.size();
 
-        // Create worker threads
-        for (unsigned int i = 0; i < sourceNames.size(); i++) {
-            refreshFutures.push_back(this->getRemoteSourceRefreshFuture(sourceNames[i], progressCallback));
+        RepositoryRefreshOptions refreshOptions = this->getRefreshOptions();
+        if (refreshOptions.sourceDeadlineMillis <= 0) {
+            refreshOptions.sourceDeadlineMillis = 3 * this->_timeoutMillis;
         }
 
-        // Wait for threads to finish
-        for (unsigned int i = 0; i < refreshFutures.size(); i++) {
-            ret = refreshFutures[i].get();
+        std::function<int(string, long)> refreshFunction = std::bind(&RepositoryInterface::refreshRemoteSource, this,
+                                                                     std::placeholders::_1, std::placeholders::_2);
+        RepositoryRefreshScheduler refreshScheduler(refreshOptions, refreshFunction);
 
-            if (ret != 0) {
-              refreshSuccessful = false;
-            }
+        // The scheduler serializes the completion callbacks, so the status and progress can be updated without further locking
+        unsigned int failedSourceCount = refreshScheduler.run(sourceNames, [this, repoUpdateStatus, progressCallback, sourceCallback](string sourceName, int result) {
+            this->_remoteSourceUpdateCount++;
+            unsigned int totalPercent = (unsigned int)calculateIntPercentage<double>(this->_remoteSourceUpdateCount,
+                                                                             this->_remoteSourceCount);
 
             if (repoUpdateStatus != 0) {
-              (*repoUpdateStatus)[sourceNames[i]] = (ret == 0);
+                (*repoUpdateStatus)[sourceName] = (result == 0);
             }
-        }
+
+            if (sourceCallback != 0) {
+                (*sourceCallback)(sourceName, (result == 0), totalPercent);
+            }
+
+            if (progressCallback != 0) {
+                (*progressCallback)(totalPercent);
+            }
+        });
+
+        refreshSuccessful = (failedSourceCount == 0);
+
+        // Build the new catalog snapshot right away, so that the first query after the refresh does not have to wait for it
+        this->getCatalog();
     }
 
     if (refreshSuccessful) {
@@ -149,21 +213,114 @@ int RepositoryInterface::refreshRemoteSources(bool force, map<string, bool>* rep
     }
 }
 
-int RepositoryInterface::refreshIndividualRemoteSource(string remoteSourceName, std::function<void(unsigned int progress)>* progressCallback)
+int RepositoryInterface::refreshRemoteSource(string remoteSourceName, long maxDurationMillis)
 {
     //cout << "Refreshing source " << remoteSourceName << endl << flush;
-    InstallSource* source = this->getRemoteSource(remoteSourceName);
+    shared_ptr<InstallMgr> installMgr = this->getInstallMgr();
+    InstallSource* source = this->getRemoteSource(remoteSourceName, installMgr.get());
+    chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
     int result = -1;
 
+    // The SWORD transports cannot be aborted, so they are not started anymore once the budget is used up
+    auto getElapsedMillis = [startTime]() {
+        return (long)chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count();
+    };
+
+    auto isDeadlineExceeded = [maxDurationMillis, &getElapsedMillis]() {
+        return (maxDurationMillis > 0 && getElapsedMillis() >= maxDurationMillis);
+    };
+
     if (source == nullptr) {
         cerr << "refreshIndividualRemoteSource: Remote source '" << remoteSourceName << "' does not exist - skipping!" << endl << flush;
+        result = REFRESH_PERMANENT_FAILURE;
     } else {
-        result = this->_installMgr->refreshRemoteSource(source);
+        RemoteIndexValidators currentValidators;
+
+        // Skip the download if the module index of the source has not changed since the last refresh
+        if (this->_indexValidator.isLocalIndexCurrent(source, currentValidators, maxDurationMillis)) {
+            //cout << "Source " << remoteSourceName << " is up to date" << endl << flush;
+            return 0;
+        }
+
+        // The old validators must not survive a failed download, since the local index is replaced by the refresh
+        this->_indexValidator.clearValidators(source);
+
+        // Only the archive is downloaded. It is read into memory by getSourceMgr, so that the module configurations
+        // do not have to be extracted. They are only extracted on demand before a module is installed from the source.
+        string archivePath = this->getSourceArchivePath(source);
+        FileMgr::createParent(archivePath.c_str());
+        bool indexMissing = false;
+
+        if (RemoteIndexValidator::isDownloadSupported()) {
+            // The probe has already used a part of the budget
+            long remainingMillis = 0;
+
+            if (maxDurationMillis > 0) {
+                remainingMillis = max(maxDurationMillis - getElapsedMillis(), 1L);
+            }
+
+            result = this->_indexValidator.downloadIndex(source, archivePath, remainingMillis);
+            indexMissing = (result == REFRESH_PERMANENT_FAILURE);
+        } else if (!isDeadlineExceeded()) {
+            // The SWORD transport writes the download through the FileMgr
+            SwordFileLock fileLock;
+            result = installMgr->remoteCopy(source, "mods.d.tar.gz", archivePath.c_str(), false);
+        }
+
+        if (result == 0) {
+            string extractedIndexDir = string(source->localShadow.c_str()) + "/mods.d";
+            FileMgr::removeDir(extractedIndexDir.c_str());
+        } else {
+            FileMgr::removeFile(archivePath.c_str());
+
+            if (isDeadlineExceeded()) {
+                cerr << "Deadline of source " << remoteSourceName << " exceeded - skipping the transfer of the individual files" << endl << flush;
+                result = -1;
+            } else {
+                // Sources without archive are copied file by file by the InstallMgr
+                SwordFileLock fileLock;
+                result = installMgr->refreshRemoteSource(source);
+
+                // The server does not know the archive and the files cannot be copied either
+                if (result != 0 && indexMissing) {
+                    result = REFRESH_PERMANENT_FAILURE;
+                }
+            }
+        }
+
+        {
+            // The SWMgr of the source is based on the previous index. The catalog is invalidated first, so that no new
+            // snapshot refers to the outdated SWMgr. Snapshots that are still in use keep their own reference to it.
+            SwordFileLock fileLock;
+            this->invalidateCatalogRepo(remoteSourceName);
+            source->flush();
+            this->flushSourceMgr(remoteSourceName);
+        }
+
         if (result != 0) {
             cerr << "Failed to refresh source " << remoteSourceName << endl << flush;
+        } else if (!currentValidators.isEmpty()) {
+            this->_indexValidator.storeValidators(source, currentValidators);
         }
     }
 
+    return result;
+}
+
+int RepositoryInterface::refreshIndividualRemoteSource(string remoteSourceName, std::function<void(unsigned int progress)>* progressCallback)
+{
+    RepositoryRefreshOptions refreshOptions = this->getRefreshOptions();
+    if (refreshOptions.sourceDeadlineMillis <= 0) {
+        refreshOptions.sourceDeadlineMillis = 3 * this->_timeoutMillis;
+    }
+
+    // A single source is retried and limited by its deadline like the sources of a full refresh
+    std::function<int(string, long)> refreshFunction = std::bind(&RepositoryInterface::refreshRemoteSource, this,
+                                                                 std::placeholders::_1, std::placeholders::_2);
+    RepositoryRefreshScheduler refreshScheduler(refreshOptions, refreshFunction);
+    vector<string> sourceNames(1, remoteSourceName);
+    int result = (refreshScheduler.run(sourceNames, nullptr) == 0) ? 0 : -1;
+
     remoteSourceUpdateMutex.lock();
     this->_remoteSourceUpdateCount++;
     unsigned int totalPercent = (unsigned int)calculateIntPercentage<double>(this->_remoteSourceUpdateCount,
@@ -177,15 +334,134 @@ int RepositoryInterface::refreshIndividualRemoteSource(string remoteSourceName,
     return result;
 }
 
-std::future<int> RepositoryInterface::getRemoteSourceRefreshFuture(string remoteSourceName, std::function<void(unsigned int progress)>* progressCallback)
+void RepositoryInterface::setRefreshOptions(const RepositoryRefreshOptions& refreshOptions)
+{
+    remoteSourceUpdateMutex.lock();
+    this->_refreshOptions = refreshOptions;
+    remoteSourceUpdateMutex.unlock();
+}
+
+RepositoryRefreshOptions RepositoryInterface::getRefreshOptions()
+{
+    remoteSourceUpdateMutex.lock();
+    RepositoryRefreshOptions refreshOptions = this->_refreshOptions;
+    remoteSourceUpdateMutex.unlock();
+    return refreshOptions;
+}
+
+shared_ptr<SWMgr> RepositoryInterface::getSourceMgr(string remoteSourceName)
+{
+    shared_ptr<InstallMgr> installMgr = this->getInstallMgr();
+    InstallSource* source = this->getRemoteSource(remoteSourceName, installMgr.get());
+    if (source == 0) {
+        return shared_ptr<SWMgr>();
+    }
+
+    // Creating the SWMgr reads the module configurations through the FileMgr
+    SwordFileLock fileLock;
+    lock_guard<mutex> lock(this->_sourceMgrMutex);
+
+    map<string, shared_ptr<SWMgr>>::iterator it = this->_sourceMgrs.find(remoteSourceName);
+    if (it != this->_sourceMgrs.end()) {
+        return it->second;
+    }
+
+    shared_ptr<SWMgr> sourceMgr;
+    string archivePath = this->getSourceArchivePath(source);
+    SWConfig* sourceConfig = 0;
+
+    if (FileMgr::existsFile(archivePath.c_str())) {
+        sourceConfig = new SWConfig();
+        ModsArchiveReader archiveReader;
+
+        if (archiveReader.readModuleConfigs(archivePath, *sourceConfig) < 0) {
+            cerr << "getSourceMgr: Could not read the module index of " << remoteSourceName << " - using the extracted index" << endl;
+            delete sourceConfig;
+            sourceConfig = 0;
+        }
+    }
+
+    if (sourceConfig != 0) {
+        // The path handed to the SWMgr never contains a mods.d directory, so that the SWMgr neither searches for nor reloads
+        // a configuration on disk and only uses the given one. Like InstallSource::getMgr, the user's modules are not added.
+        string sourcePath = string(source->localShadow.c_str()) + "/";
+        SWMgr* archiveMgr = new SWMgr(archivePath.c_str(), false, 0, false, false);
+        stdstr(&(archiveMgr->prefixPath), sourcePath.c_str());
+        archiveMgr->config = sourceConfig;
+        archiveMgr->load();
+
+        // The configuration is not owned by the SWMgr
+        sourceMgr = shared_ptr<SWMgr>(archiveMgr, [sourceConfig](SWMgr* mgr) {
+            SwordFileLock fileLock;
+            delete mgr;
+            delete sourceConfig;
+        });
+    } else {
+        // Same as InstallSource::getMgr, but owned by us, so that it can outlive a flush of the InstallSource
+        sourceMgr = shared_ptr<SWMgr>(new SWMgr(source->localShadow.c_str(), true, 0, false, false), [](SWMgr* mgr) {
+            SwordFileLock fileLock;
+            delete mgr;
+        });
+    }
+
+    this->_sourceMgrs[remoteSourceName] = sourceMgr;
+    return sourceMgr;
+}
+
+int RepositoryInterface::prepareSourceForInstall(string remoteSourceName)
+{
+    shared_ptr<InstallMgr> installMgr = this->getInstallMgr();
+    InstallSource* source = this->getRemoteSource(remoteSourceName, installMgr.get());
+    if (source == 0) {
+        return -1;
+    }
+
+    SwordFileLock fileLock;
+    lock_guard<mutex> lock(this->_sourceMgrMutex);
+
+    string localShadow = string(source->localShadow.c_str());
+    string archivePath = this->getSourceArchivePath(source);
+
+    // InstallMgr::installModule reads the module configuration from the extracted index
+    if (FileMgr::existsDir(localShadow.c_str(), "mods.d") || !FileMgr::existsFile(archivePath.c_str())) {
+        return 0;
+    }
+
+    if (!this->_fileSystemHelper.unTarGZ(archivePath, localShadow)) {
+        cerr << "prepareSourceForInstall: Could not extract the module index of " << remoteSourceName << endl;
+        return -1;
+    }
+
+    source->flush();
+    return 0;
+}
+
+void RepositoryInterface::flushSourceMgr(string remoteSourceName)
+{
+    // The source managers take the file lock when they are deleted, so it has to be taken before the mutex
+    SwordFileLock fileLock;
+    lock_guard<mutex> lock(this->_sourceMgrMutex);
+
+    // The SWMgr is deleted once the last catalog snapshot referring to it is gone
+    this->_sourceMgrs.erase(remoteSourceName);
+}
+
+void RepositoryInterface::flushAllSourceMgrs()
+{
+    SwordFileLock fileLock;
+    lock_guard<mutex> lock(this->_sourceMgrMutex);
+    this->_sourceMgrs.clear();
+}
+
+string RepositoryInterface::getSourceArchivePath(InstallSource* source)
 {
-    return std::async(&RepositoryInterface::refreshIndividualRemoteSource, this, remoteSourceName, progressCallback);
+    return string(source->localShadow.c_str()) + "/mods.d.tar.gz";
 }
 
-InstallSource* RepositoryInterface::getRemoteSource(string remoteSourceName)
+InstallSource* RepositoryInterface::getRemoteSource(string remoteSourceName, InstallMgr* installMgr)
 {
-    InstallSourceMap::iterator source = this->_installMgr->sources.find(remoteSourceName.c_str());
-    if (source == this->_installMgr->sources.end()) {
+    InstallSourceMap::iterator source = installMgr->sources.find(remoteSourceName.c_str());
+    if (source == installMgr->sources.end()) {
         cerr << "getRemoteSource: Could not find remote source '" << remoteSourceName << "'" << endl;
     } else {
         return source->second;
@@ -197,10 +473,11 @@ InstallSource* RepositoryInterface::getRemoteSource(string remoteSourceName)
 int RepositoryInterface::getRepoCount()
 {
     int repoCount = 0;
+    shared_ptr<InstallMgr> installMgr = this->getInstallMgr();
 
-    if (this->_installMgr != 0) {
-        for (InstallSourceMap::iterator it = this->_installMgr->sources.begin();
-             it != this->_installMgr->sources.end();
+    if (installMgr) {
+        for (InstallSourceMap::iterator it = installMgr->sources.begin();
+             it != installMgr->sources.end();
              ++it) {
 
             repoCount++;
@@ -216,10 +493,11 @@ vector<string> RepositoryInterface::getRepoNames()
         this->resetMgr();
     }
 
+    shared_ptr<InstallMgr> installMgr = this->getInstallMgr();
     vector<string> sourceNames;
 
-    for (InstallSourceMap::iterator it = this->_installMgr->sources.begin();
-         it != this->_installMgr->sources.end();
+    for (InstallSourceMap::iterator it = installMgr->sources.begin();
+         it != installMgr->sources.end();
          ++it) {
 
         string source = string(it->second->caption);
@@ -252,36 +530,31 @@ vector<string> RepositoryInterface::getRepoNames()
 
 vector<SWModule*> RepositoryInterface::getAllRepoModules(string repoName, ModuleType moduleType)
 {
-    vector<SWModule*> modules;
-    InstallSource* remoteSource = this->getRemoteSource(repoName);
-    string moduleTypeString = RepositoryInterface::getModuleTypeString(moduleType);
-
-    if (remoteSource != 0) {
-        SWMgr* mgr = remoteSource->getMgr();
+    shared_ptr<const RepositoryCatalog> catalog = this->getCatalog();
 
-        for (ModMap::const_iterator it = mgr->Modules.begin(); it != mgr->Modules.end(); it++) {
-            SWModule* currentModule = it->second;
-            string currentModuleType = currentModule->getType();
-
-            if (moduleTypeString == "ANY" || currentModuleType == moduleTypeString) {
-                modules.push_back(currentModule);
-            }
-        }
-    } else {
+    if (!catalog->hasRepo(repoName)) {
       cerr << "getAllRepoModules: Could not find remote source for repository '" << repoName << "'" << endl;
+      return vector<SWModule*>();
     }
 
-    return modules;
+    return catalog->getModules(repoName, RepositoryInterface::getModuleTypeString(moduleType));
 }
 
 SWModule* RepositoryInterface::getRepoModule(string moduleName, string repoName)
 {    
+    shared_ptr<const RepositoryCatalog> catalog = this->getCatalog();
+
     if (repoName == "all") {
-        repoName = this->getModuleRepo(moduleName);
+        repoName = catalog->getModuleRepo(moduleName);
     }
-    
-    vector<SWModule*> modules = this->getAllRepoModules(repoName, ModuleType::any);
-    return this->getModuleFromList(modules, moduleName);
+
+    SWModule* module = catalog->getModule(repoName, moduleName);
+
+    if (module == 0) {
+        cerr << "getRepoModule: Did not find module " << moduleName << " in repository '" << repoName << "'!" << endl;
+    }
+
+    return module;
 }
 
 vector<SWModule*> RepositoryInterface::getRepoModulesByLang(string repoName,
@@ -292,55 +565,68 @@ vector<SWModule*> RepositoryInterface::getRepoModulesByLang(string repoName,
                                                             bool hebrewStrongsKeys,
                                                             bool greekStrongsKeys)
 {
-    vector<SWModule*> allModules = this->getAllRepoModules(repoName, moduleType);
-    vector<SWModule*> selectedLanguageModules;
-
-    string moduleTypeFilter = RepositoryInterface::getModuleTypeString(moduleType);
-
-    for (unsigned int i = 0; i < allModules.size(); i++) {
-      SWModule* currentModule = allModules[i];
+    shared_ptr<const RepositoryCatalog> catalog = this->getCatalog();
+    unsigned int requiredFeatures = this->getRequiredCatalogFeatures(headersFilter, strongsFilter, hebrewStrongsKeys, greekStrongsKeys);
 
-      if ((moduleTypeFilter == "ANY" || currentModule->getType() == moduleTypeFilter) &&
-          (currentModule->getLanguage() == languageCode)) {
+    if (!catalog->hasRepo(repoName)) {
+      cerr << "getRepoModulesByLang: Could not find remote source for repository '" << repoName << "'" << endl;
+      return vector<SWModule*>();
+    }
 
-        bool hasHeadings = this->_moduleHelper.moduleHasGlobalOption(currentModule, "Headings");
-        bool hasStrongs = this->_moduleHelper.moduleHasGlobalOption(currentModule, "Strongs");
+    return catalog->getModulesByLang(repoName, RepositoryInterface::getModuleTypeString(moduleType), languageCode, requiredFeatures);
+}
 
-        bool hasHebrewStrongsKeys = this->_moduleHelper.moduleHasFeature(currentModule, "HebrewDef");
-        bool hasGreekStrongsKeys = this->_moduleHelper.moduleHasFeature(currentModule, "GreekDef");
-        
-        if (headersFilter && !hasHeadings) {
-            continue;
-        }
+unsigned int RepositoryInterface::getRequiredCatalogFeatures(bool headersFilter, bool strongsFilter, bool hebrewStrongsKeys, bool greekStrongsKeys)
+{
+    unsigned int requiredFeatures = 0;
 
-        if (strongsFilter && !hasStrongs) {
-            continue;
-        }
+    if (headersFilter) {
+        requiredFeatures |= CATALOG_FEATURE_HEADINGS;
+    }
 
-        if (hebrewStrongsKeys && !hasHebrewStrongsKeys) {
-            continue;
-        }
+    if (strongsFilter) {
+        requiredFeatures |= CATALOG_FEATURE_STRONGS;
+    }
 
-        if (greekStrongsKeys && !hasGreekStrongsKeys) {
-            continue;
-        }
+    if (hebrewStrongsKeys) {
+        requiredFeatures |= CATALOG_FEATURE_HEBREW_STRONGS_KEYS;
+    }
 
-        selectedLanguageModules.push_back(currentModule);
-      }
+    if (greekStrongsKeys) {
+        requiredFeatures |= CATALOG_FEATURE_GREEK_STRONGS_KEYS;
     }
 
-    return selectedLanguageModules;
+    return requiredFeatures;
 }
 
 vector<SWModule*> RepositoryInterface::getUpdatedRepoModules(string repoName, bool includeBeta)
 {
+    shared_ptr<const RepositoryCatalog> catalog = this->getCatalog();
+    shared_ptr<const InstalledVersionMap> installedVersions = this->_moduleStore.getInstalledVersions();
+    string cacheKey = repoName + (includeBeta ? "\nbeta" : "");
+
+    // Replacing the cached catalog may release the last reference to its source managers
+    SwordFileLock fileLock;
+    lock_guard<mutex> lock(this->_updatedModulesMutex);
+
+    // Both snapshots are replaced whenever they change, so comparing the pointers is enough to detect outdated results.
+    // The catalog is kept together with the cached results, since it keeps the returned modules alive.
+    if (catalog != this->_updatedModulesCatalog || installedVersions != this->_updatedModulesVersions) {
+        this->_updatedModulesCache.clear();
+        this->_updatedModulesCatalog = catalog;
+        this->_updatedModulesVersions = installedVersions;
+    }
+
+    map<string, vector<SWModule*>>::const_iterator cachedResult = this->_updatedModulesCache.find(cacheKey);
+    if (cachedResult != this->_updatedModulesCache.end()) {
+        return cachedResult->second;
+    }
+
     vector<string> repoNames = this->getRepoNames();
     vector<SWModule*> updatedModules;
-    SWMgr* localMgr = this->_moduleStore.getSwMgr();
 
     for (size_t i = 0; i < repoNames.size(); i++) {
         string currentRepo = repoNames[i];
-        InstallSource* currentRemoteSource = this->getRemoteSource(currentRepo);
 
         if (currentRepo == "CrossWire Beta" && !includeBeta) {
             // Exclude modules from the beta repository unless explicitly requested.
@@ -353,27 +639,17 @@ vector<SWModule*> RepositoryInterface::getUpdatedRepoModules(string repoName, bo
             }
         }
 
-        if (currentRemoteSource != 0) {
-            SWMgr* remoteMgr = currentRemoteSource->getMgr();
-            map<SWModule*, int> moduleStatusMap = this->_installMgr->getModuleStatus(*localMgr, *remoteMgr, false);
-
-            for (auto const& moduleStatus : moduleStatusMap) {
-                const unsigned int updateStatus = moduleStatus.second;
-
-                if (updateStatus == static_cast<unsigned int>(InstallMgr::MODSTAT_UPDATED)) {
-                    updatedModules.push_back(moduleStatus.first);
-                }
-            }
-        }
+        vector<SWModule*> repoUpdates = catalog->getUpdatedModules(currentRepo, *installedVersions);
+        updatedModules.insert(updatedModules.end(), repoUpdates.begin(), repoUpdates.end());
     }
 
+    this->_updatedModulesCache[cacheKey] = updatedModules;
     return updatedModules;
 }
 
 unsigned int RepositoryInterface::getRepoModuleCount(string repoName, ModuleType moduleType)
 {
-    vector<SWModule*> allModules = this->getAllRepoModules(repoName, moduleType);
-    return (unsigned int)allModules.size();
+    return this->getCatalog()->getModuleCount(repoName, RepositoryInterface::getModuleTypeString(moduleType));
 }
 
 unsigned int RepositoryInterface::getRepoLanguageModuleCount(string repoName, string languageCode, ModuleType moduleType)
@@ -384,243 +660,109 @@ unsigned int RepositoryInterface::getRepoLanguageModuleCount(string repoName, st
 
 vector<string> RepositoryInterface::getRepoLanguages(string repoName, ModuleType moduleType)
 {
-    vector<SWModule*> modules;
-    vector<string> languages;
-
-    modules = this->getAllRepoModules(repoName, moduleType);
-
-    for (unsigned int i = 0; i < modules.size(); i++) {
-        SWModule* currentModule = modules[i];
-        string currentLanguage = string(currentModule->getLanguage());
-        
-        if (find(languages.begin(), languages.end(), currentLanguage) == languages.end()) {
-            // Only add the language if it is not already in the list
-            languages.push_back(currentLanguage);
-        }
-    }
-
-    return languages;
+    return this->getCatalog()->getLanguages(repoName, RepositoryInterface::getModuleTypeString(moduleType));
 }
 
-SWModule* RepositoryInterface::getModuleFromList(vector<SWModule*>& moduleList, string moduleName)
-{
-    for (unsigned int i = 0; i < moduleList.size(); i++) {
-      SWModule* currentModule = moduleList[i];
-      if (currentModule != 0 && currentModule->getName() != 0) {
-          string currentModuleName = string(currentModule->getName());
-          if (currentModuleName == moduleName) {
-              return currentModule;
-          }
-      } else {
-          cerr << "Could not access module at index " << i << endl;
-      }
-    }
-
-    cerr << "getModuleFromList: Did not find module " << moduleName << " in modulelist!" << endl;
-
-    return 0;
-}
-
-string RepositoryInterface::getModuleIdFromLine(string line)
+string RepositoryInterface::getModuleRepo(string moduleName)
 {
-    static regex parentheses = regex("[\\[\\]]");
-    static regex lineBreaks = regex("[\\r\\n]");
-
-    StringHelper::trim(line);
+    string repo = this->getCatalog()->getModuleRepo(moduleName);
 
-    string moduleId = "";
-    char firstChar = line[0];
-    char lastChar = line[line.size() - 1];
-
-    if (firstChar == '[' && lastChar == ']') {
-        // Remove parentheses and line breaks from the first line
-        // What's left is the module id
-        moduleId = regex_replace(line, parentheses, "");
-        moduleId = regex_replace(moduleId, lineBreaks, "");
+    if (repo == "") {
+        cerr << "getModuleRepo: Could not find repository for module '" << moduleName << "'" << endl;
     }
 
-    return moduleId;
+    return repo;
 }
 
-#ifdef __ANDROID__
-string RepositoryInterface::getModuleIdFromFile(string moduleFileName)
+bool RepositoryInterface::isModuleAvailableInRepo(string moduleName, string repoName)
 {
-    string moduleId = "";
-    FILE * fp;
-    char * line = NULL;
-    size_t len = 0;
-    ssize_t read_count;
-
-    fp = fopen(moduleFileName.c_str(), "r");
-
-    if (fp != NULL) {
-        while ((read_count = getline(&line, &len, fp)) != -1) {
-          if (read_count >= 1) {
-              string std_line = string(line);
-              StringHelper::trim(std_line);
-              char firstChar = std_line[0];
-
-              if (firstChar == '[') {
-                moduleId = this->getModuleIdFromLine(std_line);
-                break;
-              }
-          }
-        }
-
-        fclose(fp);
-        if (line) {
-            free(line);
-        }
+    shared_ptr<const RepositoryCatalog> catalog = this->getCatalog();
+    
+    if (repoName == "all") {
+        return (catalog->getModuleRepo(moduleName) != "");
     } else {
-      cerr << "getModuleIdFromFile: Could not open file " << moduleFileName << " / errno: " << errno << endl;
+        return (catalog->getModule(repoName, moduleName) != 0);
     }
-
-    return moduleId;
 }
-#else
-string RepositoryInterface::getModuleIdFromFile(string moduleFileName)
-{
-    string moduleId = "";
-
-    #if _WIN32
-      wstring utf16ModuleFileName = this->_fileSystemHelper.convertUtf8StringToUtf16(moduleFileName);
-      ifstream moduleFile(utf16ModuleFileName);
-    #else
-      ifstream moduleFile(moduleFileName);
-    #endif
-
-    if (moduleFile.is_open()) {
-        string line;
 
-        while (!moduleFile.eof() && !moduleFile.fail()) {
-          std::getline(moduleFile, line);
-
-          if (line.size() >= 1) {
-            StringHelper::trim(line);
-            char firstChar = line[0];
-
-            if (firstChar == '[') {
-              moduleId = this->getModuleIdFromLine(line);
-              break;
-            }
-          }
-        }
-    }
-
-    moduleFile.close();
-    return moduleId;
+shared_ptr<InstallMgr> RepositoryInterface::getInstallMgr()
+{
+    lock_guard<mutex> lock(this->_installMgrMutex);
+    return this->_installMgr;
 }
-#endif
 
-vector<string> RepositoryInterface::getRepoModuleIds(string repoName)
+shared_ptr<const RepositoryCatalog> RepositoryInterface::getCatalog()
 {
-    vector<string> moduleIds;
-    InstallSource* remoteSource = this->getRemoteSource(repoName);
-    FileSystemHelper fs;
-    stringstream repoModuleDir;
-
-    if (remoteSource != 0) {
-        //cout << remoteSource->localShadow << endl;
-        repoModuleDir << remoteSource->localShadow << fs.getPathSeparator() << "mods.d";
-
-        //cout << "getRepoModuleIds: Looking for files in directory " << repoModuleDir.str() << endl;
-        vector<string> filesInRepoDir = fs.getFilesInDir(repoModuleDir.str());
-
-        if (filesInRepoDir.size() == 0) {
-            cerr << "getRepoModuleIds: Got 0 files in directory " << repoModuleDir.str() << endl;
-
-            return moduleIds;
-        }
-
-        for (unsigned int i = 0; i < filesInRepoDir.size(); i++) {
-            // Skip files that do not end with .conf
-            if (!StringHelper::hasEnding(filesInRepoDir[i], ".conf")) {
-                continue;
-            }
-
-            stringstream moduleFileName;
-            moduleFileName << repoModuleDir.str() << fs.getPathSeparator() << filesInRepoDir[i];
-            string currentModuleId = this->getModuleIdFromFile(moduleFileName.str());
-
-            if (currentModuleId != "") {
-                moduleIds.push_back(currentModuleId);
-            } /* else {
-                cerr << "getRepoModuleIds: Could not read module id from file " << moduleFileName.str() << endl;
-            } */
+    shared_ptr<const RepositoryCatalog> catalog = atomic_load(&this->_catalog);
+
+    if (!catalog) {
+        // Building the catalog creates the source managers and releases the base catalog
+        SwordFileLock fileLock;
+        lock_guard<mutex> lock(this->_catalogMutex);
+        catalog = atomic_load(&this->_catalog);
+
+        if (!catalog) {
+            vector<string> repoNames = this->getRepoNames();
+            std::function<shared_ptr<SWMgr>(const string&)> getSourceMgr = [this](const string& repoName) {
+                return this->getSourceMgr(repoName);
+            };
+
+            catalog = make_shared<const RepositoryCatalog>(getSourceMgr,
+                                                           repoNames,
+                                                           this->_moduleHelper,
+                                                           this->_baseCatalog.get(),
+                                                           this->_staleCatalogRepos);
+            atomic_store(&this->_catalog, catalog);
+
+            this->_baseCatalog.reset();
+            this->_staleCatalogRepos.clear();
         }
-    } else {
-      cerr << "getRepoModuleIds: Could not find remote source for repository '" << repoName << "'" << endl;
     }
 
-    return moduleIds; 
+    return catalog;
 }
 
-vector<string> RepositoryInterface::getAllRepoModuleIds()
+void RepositoryInterface::invalidateCatalog()
 {
-    vector<string> repoNames = this->getRepoNames();
-    vector<string> allModuleIds;
-
-    for (unsigned int i = 0; i < repoNames.size(); i++) {
-        string currentRepo = repoNames[i];
-
-        vector<string> currentRepoModuleIds = this->getRepoModuleIds(currentRepo);
-        for (unsigned int j = 0; j < currentRepoModuleIds.size(); j++) {
-            allModuleIds.push_back(currentRepoModuleIds[j]);
-        }
+    // Releasing the catalog may delete the source managers, which needs the file lock before any other mutex
+    SwordFileLock fileLock;
+
+    {
+        lock_guard<mutex> lock(this->_catalogMutex);
+        atomic_store(&this->_catalog, shared_ptr<const RepositoryCatalog>());
+        this->_baseCatalog.reset();
+        this->_staleCatalogRepos.clear();
     }
 
-    return allModuleIds;
+    this->clearUpdatedModulesCache();
 }
 
-string RepositoryInterface::getModuleRepo(string moduleName)
+void RepositoryInterface::invalidateCatalogRepo(string repoName)
 {
-    vector<string> repositories = this->getRepoNames();
+    SwordFileLock fileLock;
 
-    if (repositories.size() == 0) {
-      cerr << "getModuleRepo: Got 0 repository names!" << endl;
-      return "";
-    }
+    {
+        lock_guard<mutex> lock(this->_catalogMutex);
+        shared_ptr<const RepositoryCatalog> catalog = atomic_load(&this->_catalog);
 
-    for (unsigned int i = 0; i < repositories.size(); i++) {
-        string repo = repositories[i];
-        vector<string> repoModuleIds = this->getRepoModuleIds(repo);
-
-        if (repoModuleIds.size() == 0) {
-          cerr << "getRepoModule: Got 0 repo module ids for repo " << repo << endl;
+        // The current snapshot becomes the base of the next one, unless there is already a base from an earlier invalidation
+        if (catalog) {
+            this->_baseCatalog = catalog;
+            atomic_store(&this->_catalog, shared_ptr<const RepositoryCatalog>());
         }
 
-        for (unsigned int j = 0; j < repoModuleIds.size(); j++) {
-            string currentId = repoModuleIds[j];
-            if (currentId == moduleName) {
-                return repo;
-            }
-        }
+        this->_staleCatalogRepos.insert(repoName);
     }
 
-    cerr << "getModuleRepo: Could not find repository for module '" << moduleName << "'" << endl;
-    return "";
+    this->clearUpdatedModulesCache();
 }
 
-bool RepositoryInterface::isModuleAvailableInRepo(string moduleName, string repoName)
+void RepositoryInterface::clearUpdatedModulesCache()
 {
-    vector<string> moduleIds;
-    
-    if (repoName == "all") {
-        moduleIds = this->getAllRepoModuleIds();
-    } else {
-        moduleIds = this->getRepoModuleIds(repoName);
-    }
-
-    for (unsigned int i = 0; i < moduleIds.size(); i++) {
-        if (moduleIds[i] == moduleName) {
-            return true;
-        }
-    }
-
-    return false;
-}
-
-sword::InstallMgr* RepositoryInterface::getInstallMgr()
-{
-    return this->_installMgr;
+    // The cached modules are owned by the source managers of the cached catalog. They are released together.
+    SwordFileLock fileLock;
+    lock_guard<mutex> lock(this->_updatedModulesMutex);
+    this->_updatedModulesCache.clear();
+    this->_updatedModulesCatalog.reset();
+    this->_updatedModulesVersions.reset();
 }
@@ -23,17 +23,24 @@
 #include <string>
 #include <map>
 #include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
 
 #include "common_defs.hpp"
 #include "file_system_helper.hpp"
 #include "module_helper.hpp"
 #include "sword_status_reporter.hpp"
+#include "repository_catalog.hpp"
+#include "repository_refresh_scheduler.hpp"
+#include "remote_index_validator.hpp"
 #include "installmgr.h"
 
 namespace sword {
     class InstallSource;
     class SWModule;
     class SWMGr;
+    class SWConfig;
 };
 
 class ModuleHelper;
@@ -46,14 +53,21 @@ public:
                         std::string customHomeDir="",
                         long timeoutMillis=20000);
 
-    virtual ~RepositoryInterface(){}
+    virtual ~RepositoryInterface();
 
     void resetMgr();
 
     int refreshRepositoryConfig();
-    int refreshRemoteSources(bool force=false, std::map<std::string, bool>* repoUpdateStatus=0, std::function<void(unsigned int progress)>* progressCallback=0);
+    // The sourceCallback is invoked as soon as an individual source is finished, in the order in which the sources complete.
+    int refreshRemoteSources(bool force=false,
+                             std::map<std::string, bool>* repoUpdateStatus=0,
+                             std::function<void(unsigned int progress)>* progressCallback=0,
+                             std::function<void(std::string repoName, bool successful, unsigned int progress)>* sourceCallback=0);
     int refreshIndividualRemoteSource(std::string remoteSourceName, std::function<void(unsigned int progress)>* progressCallback=0);
 
+    void setRefreshOptions(const RepositoryRefreshOptions& refreshOptions);
+    RepositoryRefreshOptions getRefreshOptions();
+
     std::vector<std::string> getRepoNames();
     sword::SWModule* getRepoModule(std::string moduleName, std::string repoName="all");
     std::vector<sword::SWModule*> getAllRepoModules(std::string repoName, ModuleType moduleType=ModuleType::bible);
@@ -64,20 +78,46 @@ public:
                                                        bool strongsFilter=false,
                                                        bool hebrewStrongsKeys=false,
                                                        bool greekStrongsKeys=false);
+    // The result is cached until the catalog or the installed modules change
     std::vector<sword::SWModule*> getUpdatedRepoModules(std::string repoName="all", bool includeBeta=false);
     unsigned int getRepoModuleCount(std::string repoName, ModuleType moduleType=ModuleType::bible);
     std::vector<std::string> getRepoLanguages(std::string repoName, ModuleType moduleType=ModuleType::bible);
     unsigned int getRepoLanguageModuleCount(std::string repoName, std::string languageCode, ModuleType moduleType=ModuleType::bible);
     bool isModuleAvailableInRepo(std::string moduleName, std::string repoName="all");
     std::string getModuleRepo(std::string moduleName);
-    sword::InstallSource* getRemoteSource(std::string remoteSourceName);
 
-    sword::InstallMgr* getInstallMgr();
+    // Returns the source of the given InstallMgr, which must be kept alive as long as the source is used
+    sword::InstallSource* getRemoteSource(std::string remoteSourceName, sword::InstallMgr* installMgr);
+
+    // Returns the SWMgr with the modules of the given remote source. It is built from the module index archive in memory,
+    // if the source provides one. A refresh of the source replaces the SWMgr, but the returned reference keeps the previous one alive.
+    std::shared_ptr<sword::SWMgr> getSourceMgr(std::string remoteSourceName);
+
+    // Extracts the module index of the given source to disk, which is required by InstallMgr::installModule
+    int prepareSourceForInstall(std::string remoteSourceName);
+
+    // The InstallMgr is replaced when the repository configuration is refreshed or reset. The returned reference keeps
+    // the instance and its sources alive, also while a background operation replaces it.
+    std::shared_ptr<sword::InstallMgr> getInstallMgr();
+
+    // Creates an additional InstallMgr on the same configuration, e.g. for transfers that run in parallel to the main InstallMgr
+    sword::InstallMgr* createInstallMgr(sword::StatusReporter* statusReporter);
+
+    // Returns the current catalog snapshot. The snapshot is built on demand after it has been invalidated by a refresh.
+    std::shared_ptr<const RepositoryCatalog> getCatalog();
+    void invalidateCatalog();
+
+    // Invalidates the catalog entries of a single repository. The entries of the other repositories are reused by the next snapshot.
+    void invalidateCatalogRepo(std::string repoName);
     
     SwordStatusReporter& getStatusReporter() {
         return this->_statusReporter;
     }
 
+    long getTimeoutMillis() {
+        return this->_timeoutMillis;
+    }
+
     static std::string getModuleTypeString(ModuleType moduleType)
     {
         std::string moduleTypeFilter = "";
@@ -106,18 +146,34 @@ public:
     }
 
 private:
-    std::future<int> getRemoteSourceRefreshFuture(std::string remoteSourceName, std::function<void(unsigned int progress)>* progressCallback=0);
+    // The transfers of the refresh are aborted once maxDurationMillis have passed (0: only the network timeout applies)
+    int refreshRemoteSource(std::string remoteSourceName, long maxDurationMillis=0);
 
     int getRepoCount();
-    std::vector<std::string> getRepoModuleIds(std::string repoName);
-    std::vector<std::string> getAllRepoModuleIds();
-    std::string getModuleIdFromLine(std::string line);
-    std::string getModuleIdFromFile(std::string moduleFileName);
-    sword::SWModule* getModuleFromList(std::vector<sword::SWModule*>& moduleList, std::string moduleName);
+    void replaceInstallMgr(std::shared_ptr<sword::InstallMgr> installMgr);
+    void applySourceOverrides(sword::InstallMgr* installMgr);
+    void flushSourceMgr(std::string remoteSourceName);
+    void flushAllSourceMgrs();
+    void clearUpdatedModulesCache();
+    std::string getSourceArchivePath(sword::InstallSource* source);
+    unsigned int getRequiredCatalogFeatures(bool headersFilter, bool strongsFilter, bool hebrewStrongsKeys, bool greekStrongsKeys);
 
     unsigned int _remoteSourceCount = 0;
     unsigned int _remoteSourceUpdateCount = 0;
-    sword::InstallMgr* _installMgr = 0;
+    std::shared_ptr<sword::InstallMgr> _installMgr;
+    std::mutex _installMgrMutex;
+    std::shared_ptr<const RepositoryCatalog> _catalog;
+    std::shared_ptr<const RepositoryCatalog> _baseCatalog;
+    std::unordered_set<std::string> _staleCatalogRepos;
+    std::mutex _catalogMutex;
+    std::shared_ptr<const RepositoryCatalog> _updatedModulesCatalog;
+    std::shared_ptr<const InstalledVersionMap> _updatedModulesVersions;
+    std::map<std::string, std::vector<sword::SWModule*>> _updatedModulesCache;
+    std::mutex _updatedModulesMutex;
+    RemoteIndexValidator _indexValidator;
+    std::map<std::string, std::shared_ptr<sword::SWMgr>> _sourceMgrs;
+    std::mutex _sourceMgrMutex;
+    RepositoryRefreshOptions _refreshOptions;
     SwordStatusReporter& _statusReporter;
     FileSystemHelper _fileSystemHelper;
     ModuleHelper& _moduleHelper;
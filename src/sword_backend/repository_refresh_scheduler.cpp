@@ -0,0 +1,146 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+
+// Std includes
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <future>
+
+// Own includes
+#include "repository_refresh_scheduler.hpp"
+#include "thread_pool.hpp"
+
+using namespace std;
+
+RepositoryRefreshScheduler::RepositoryRefreshScheduler(const RepositoryRefreshOptions& options,
+                                                       std::function<int(std::string sourceName, long remainingMillis)> refreshFunction)
+    : _options(options), _refreshFunction(refreshFunction)
+{
+    if (this->_options.maxConcurrency == 0) {
+        this->_options.maxConcurrency = 1;
+    }
+}
+
+unsigned int RepositoryRefreshScheduler::run(const vector<string>& sourceNames,
+                                             std::function<void(std::string sourceName, int result)> completionCallback)
+{
+    this->_nextSourceIndex = 0;
+    this->_failedSourceCount = 0;
+
+    unsigned int laneCount = this->_options.maxConcurrency;
+    if (laneCount > sourceNames.size()) {
+        laneCount = sourceNames.size();
+    }
+
+    // Each lane picks the next pending source once it is done with the previous one. A slow source therefore
+    // only occupies its own lane, while the remaining sources are distributed over the other lanes.
+    vector<future<int>> laneFutures;
+    for (unsigned int i = 0; i < laneCount; i++) {
+        std::function<int()> laneTask = [this, &sourceNames, &completionCallback]() {
+            this->processSources(sourceNames, completionCallback);
+            return 0;
+        };
+
+        laneFutures.push_back(ThreadPool::getInstance().submit<int>(TaskPriority::network, laneTask));
+    }
+
+    for (unsigned int i = 0; i < laneFutures.size(); i++) {
+        ThreadPool::getInstance().waitFor(laneFutures[i]);
+    }
+
+    return this->_failedSourceCount;
+}
+
+void RepositoryRefreshScheduler::processSources(const vector<string>& sourceNames,
+                                                std::function<void(std::string sourceName, int result)>& completionCallback)
+{
+    for (;;) {
+        unsigned int sourceIndex = 0;
+
+        {
+            lock_guard<mutex> lock(this->_schedulerMutex);
+            if (this->_nextSourceIndex >= sourceNames.size()) {
+                return;
+            }
+
+            sourceIndex = this->_nextSourceIndex++;
+        }
+
+        int result = this->refreshSourceWithRetries(sourceNames[sourceIndex]);
+
+        lock_guard<mutex> lock(this->_schedulerMutex);
+        if (result != 0) {
+            this->_failedSourceCount++;
+        }
+
+        if (completionCallback) {
+            completionCallback(sourceNames[sourceIndex], result);
+        }
+    }
+}
+
+int RepositoryRefreshScheduler::refreshSourceWithRetries(string sourceName)
+{
+    chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+    long backoffMillis = this->_options.initialBackoffMillis;
+    int result = -1;
+
+    for (unsigned int attempt = 0; attempt <= this->_options.maxRetries; attempt++) {
+        // A deadline of 0 means that the refresh of a source is not limited in time
+        long remainingMillis = 0;
+
+        if (this->_options.sourceDeadlineMillis > 0) {
+            long elapsedMillis = (long)chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count();
+            remainingMillis = this->_options.sourceDeadlineMillis - elapsedMillis;
+
+            if (remainingMillis < 1) {
+                remainingMillis = 1;
+            }
+        }
+
+        result = this->_refreshFunction(sourceName, remainingMillis);
+
+        if (result == 0 || attempt == this->_options.maxRetries) {
+            break;
+        }
+
+        if (result == REFRESH_PERMANENT_FAILURE) {
+            cerr << "Refreshing source " << sourceName << " failed permanently - not retrying!" << endl << flush;
+            break;
+        }
+
+        if (this->_options.sourceDeadlineMillis > 0) {
+            long elapsedMillis = (long)chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count();
+
+            if (elapsedMillis + backoffMillis >= this->_options.sourceDeadlineMillis) {
+                cerr << "Deadline of source " << sourceName << " exceeded after " << (attempt + 1) << " attempt(s) - giving up!" << endl << flush;
+                break;
+            }
+        }
+
+        cerr << "Refreshing source " << sourceName << " failed (attempt " << (attempt + 1) << "), retrying in "
+             << backoffMillis << "ms" << endl << flush;
+
+        this_thread::sleep_for(chrono::milliseconds(backoffMillis));
+        backoffMillis *= 2;
+    }
+
+    return result;
+}
@@ -0,0 +1,84 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+
+#ifndef _REPOSITORY_REFRESH_SCHEDULER
+#define _REPOSITORY_REFRESH_SCHEDULER
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <mutex>
+
+// Result of a refresh function if the source cannot be refreshed at all (e.g. the source does not exist or the server
+// does not know its index). The scheduler does not retry such sources.
+#define REFRESH_PERMANENT_FAILURE -2
+
+class RepositoryRefreshOptions {
+public:
+    // Maximum number of sources that are refreshed at the same time
+    unsigned int maxConcurrency = 4;
+
+    // Number of additional attempts after a failed refresh of a source
+    unsigned int maxRetries = 2;
+
+    // Delay before the first retry, doubled for every further retry
+    long initialBackoffMillis = 500;
+
+    // Time budget of a source including all retries. No further attempt is started once it is used up.
+    // A value of 0 uses three times the transfer timeout of the InstallMgr.
+    long sourceDeadlineMillis = 0;
+};
+
+/**
+ * The RepositoryRefreshScheduler refreshes a list of remote sources with a bounded number of parallel transfers.
+ *
+ * The actual refresh of a source is done by the given refresh function, which returns 0 on success. This keeps the
+ * scheduler independent of the InstallMgr, so that it can also be driven by a local stand-in with injected latency.
+ * The refresh function receives the remaining time budget of the source (0 if the source has no deadline) and must
+ * abort its transfers once the budget is used up, so that a single hanging transfer cannot exceed the deadline.
+ * Failed sources are retried with exponential backoff until the retries or the deadline of the source are used up,
+ * unless the refresh function reports a permanent failure (REFRESH_PERMANENT_FAILURE).
+ * The completion callback is invoked as soon as a source is finished, so results arrive in completion order.
+ * Calls of the completion callback are serialized.
+ */
+class RepositoryRefreshScheduler {
+public:
+    RepositoryRefreshScheduler(const RepositoryRefreshOptions& options,
+                               std::function<int(std::string sourceName, long remainingMillis)> refreshFunction);
+
+    virtual ~RepositoryRefreshScheduler(){}
+
+    // Returns the number of sources that could not be refreshed
+    unsigned int run(const std::vector<std::string>& sourceNames,
+                     std::function<void(std::string sourceName, int result)> completionCallback);
+
+private:
+    void processSources(const std::vector<std::string>& sourceNames,
+                        std::function<void(std::string sourceName, int result)>& completionCallback);
+
+    int refreshSourceWithRetries(std::string sourceName);
+
+    RepositoryRefreshOptions _options;
+    std::function<int(std::string sourceName, long remainingMillis)> _refreshFunction;
+    std::mutex _schedulerMutex;
+    unsigned int _nextSourceIndex = 0;
+    unsigned int _failedSourceCount = 0;
+};
+
+#endif // _REPOSITORY_REFRESH_SCHEDULER
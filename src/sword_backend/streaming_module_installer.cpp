@@ -0,0 +1,769 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+
+// Std includes
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <deque>
+#include <thread>
+#include <condition_variable>
+#include <cstdio>
+#include <cctype>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+#if defined(__APPLE__)
+#include <TargetConditionals.h>
+#endif
+
+#if !defined(__ANDROID__) && !TARGET_OS_IOS
+#define STREAMING_INSTALL_SUPPORTED 1
+#include <curl/curl.h>
+#endif
+
+// Sword includes
+#include <installmgr.h>
+#include <remotetrans.h>
+#include <swconfig.h>
+#include <filemgr.h>
+
+// Own includes
+#include "streaming_module_installer.hpp"
+#include "archive_stream_extractor.hpp"
+#include "mods_archive_reader.hpp"
+#include "file_system_helper.hpp"
+#include "sword_file_lock.hpp"
+
+using namespace std;
+using namespace sword;
+
+// curl hands over at most 16 KB per callback, so the queue holds up to 512 KB of compressed data
+#define PIPELINE_MAX_QUEUED_CHUNKS 32
+
+// Internal result of downloadAndExtract: The partial download cannot be continued and has to be started again
+#define PACKAGE_DOWNLOAD_RESTART -3
+
+#define PARTIAL_DOWNLOAD_SECTION "Download"
+
+/**
+ * Bounded queue between the download thread (producer) and the extraction thread (consumer).
+ * The producer blocks while the queue is full, which throttles the download to the extraction speed.
+ */
+class ChunkQueue {
+public:
+    ChunkQueue(size_t maxChunks) : _maxChunks(maxChunks) {}
+
+    // Returns false if the consumer has aborted
+    bool push(string&& chunk)
+    {
+        unique_lock<mutex> lock(this->_queueMutex);
+        this->_notFull.wait(lock, [this]() { return this->_aborted || this->_chunks.size() < this->_maxChunks; });
+
+        if (this->_aborted) {
+            return false;
+        }
+
+        this->_chunks.push_back(std::move(chunk));
+        this->_notEmpty.notify_one();
+        return true;
+    }
+
+    // Returns false once the producer has closed the queue and all chunks have been consumed
+    bool pop(string& chunk)
+    {
+        unique_lock<mutex> lock(this->_queueMutex);
+        this->_notEmpty.wait(lock, [this]() { return this->_closed || !this->_chunks.empty(); });
+
+        if (this->_chunks.empty()) {
+            return false;
+        }
+
+        chunk = std::move(this->_chunks.front());
+        this->_chunks.pop_front();
+        this->_notFull.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        lock_guard<mutex> lock(this->_queueMutex);
+        this->_closed = true;
+        this->_notEmpty.notify_all();
+    }
+
+    void abort()
+    {
+        lock_guard<mutex> lock(this->_queueMutex);
+        this->_aborted = true;
+        this->_chunks.clear();
+        this->_notFull.notify_all();
+    }
+
+private:
+    size_t _maxChunks;
+    deque<string> _chunks;
+    bool _closed = false;
+    bool _aborted = false;
+    mutex _queueMutex;
+    condition_variable _notEmpty;
+    condition_variable _notFull;
+};
+
+#ifdef STREAMING_INSTALL_SUPPORTED
+static once_flag curlInitFlag;
+
+class DownloadContext {
+public:
+    CURL* curl;
+    ChunkQueue* queue;
+    StatusReporter* statusReporter;
+    const atomic<bool>* cancelled;
+    string message;
+    bool preStatusSent = false;
+    bool firstChunk = true;
+
+    // Resumed downloads must be answered with the requested range, otherwise the download starts from the beginning
+    unsigned long long resumeOffset = 0;
+    bool rangeIgnored = false;
+
+    // Validators and range of the current response
+    string etag;
+    string lastModified;
+    long long contentRangeStart = -1;
+
+    // Invoked with the first chunk of a new download, when the response headers are complete
+    std::function<void(const string& etag, const string& lastModified)> downloadStarted;
+};
+
+static bool getHeaderValue(const string& headerLine, const string& headerName, string& value)
+{
+    if (headerLine.size() <= headerName.size() + 1 || headerLine[headerName.size()] != ':') {
+        return false;
+    }
+
+    for (unsigned int i = 0; i < headerName.size(); i++) {
+        if (tolower((unsigned char)headerLine[i]) != headerName[i]) {
+            return false;
+        }
+    }
+
+    size_t start = headerLine.find_first_not_of(" \t", headerName.size() + 1);
+    size_t end = headerLine.find_last_not_of(" \t\r\n");
+    value = (start != string::npos && end != string::npos && end >= start) ? headerLine.substr(start, end - start + 1) : "";
+    return true;
+}
+
+static size_t pipelineHeaderCallback(char* buffer, size_t size, size_t itemCount, void* userData)
+{
+    DownloadContext* context = (DownloadContext*)userData;
+    size_t length = size * itemCount;
+    string headerLine(buffer, length);
+    string value;
+
+    if (headerLine.compare(0, 5, "HTTP/") == 0) {
+        // A new response starts (e.g. after a redirect)
+        context->etag.clear();
+        context->lastModified.clear();
+        context->contentRangeStart = -1;
+    } else if (getHeaderValue(headerLine, "etag", value)) {
+        context->etag = value;
+    } else if (getHeaderValue(headerLine, "last-modified", value)) {
+        context->lastModified = value;
+    } else if (getHeaderValue(headerLine, "content-range", value)) {
+        // Format: bytes <start>-<end>/<size>
+        size_t start = value.find_first_of("0123456789");
+        if (start != string::npos) {
+            context->contentRangeStart = strtoll(value.c_str() + start, 0, 10);
+        }
+    }
+
+    return length;
+}
+
+static size_t pipelineWriteCallback(char* buffer, size_t size, size_t itemCount, void* userData)
+{
+    DownloadContext* context = (DownloadContext*)userData;
+    size_t length = size * itemCount;
+
+    if (context->firstChunk) {
+        context->firstChunk = false;
+
+        if (context->resumeOffset > 0) {
+            long responseCode = 0;
+            curl_easy_getinfo(context->curl, CURLINFO_RESPONSE_CODE, &responseCode);
+
+            if (responseCode != 206 || context->contentRangeStart != (long long)context->resumeOffset) {
+                // The package has changed or the server does not support ranges
+                context->rangeIgnored = true;
+                return 0;
+            }
+        } else if (context->downloadStarted) {
+            context->downloadStarted(context->etag, context->lastModified);
+        }
+    }
+
+    // Returning less than the given length makes curl abort the transfer
+    if (!context->queue->push(string(buffer, length))) {
+        return 0;
+    }
+
+    return length;
+}
+
+static int pipelineProgressCallback(void* userData, double totalBytes, double completedBytes)
+{
+    DownloadContext* context = (DownloadContext*)userData;
+
+    if (*(context->cancelled)) {
+        return 1;
+    }
+
+    if (context->statusReporter != 0 && totalBytes > 0) {
+        // The progress of a resumed download includes the bytes that have been downloaded before
+        totalBytes += context->resumeOffset;
+        completedBytes += context->resumeOffset;
+
+        if (!context->preStatusSent) {
+            context->statusReporter->preStatus((long)totalBytes, 0, context->message.c_str());
+            context->preStatusSent = true;
+        }
+
+        context->statusReporter->update((unsigned long)totalBytes, (unsigned long)completedBytes);
+    }
+
+    return 0;
+}
+
+#if LIBCURL_VERSION_NUM >= 0x072000
+static int pipelineXferInfoCallback(void* userData, curl_off_t totalBytes, curl_off_t completedBytes, curl_off_t, curl_off_t)
+{
+    return pipelineProgressCallback(userData, (double)totalBytes, (double)completedBytes);
+}
+#else
+static int pipelineLegacyProgressCallback(void* userData, double totalBytes, double completedBytes, double, double)
+{
+    return pipelineProgressCallback(userData, totalBytes, completedBytes);
+}
+#endif
+#endif
+
+StreamingModuleInstaller::StreamingModuleInstaller(long timeoutMillis) : _timeoutMillis(timeoutMillis), _installCounter(0)
+{
+}
+
+int StreamingModuleInstaller::installModule(InstallSource* source,
+                                            string moduleName,
+                                            string expectedVersion,
+                                            string swordDir,
+                                            StatusReporter* statusReporter,
+                                            const atomic<bool>& cancelled)
+{
+#ifdef STREAMING_INSTALL_SUPPORTED
+    if (source == 0 || !this->isPackageSupported(source)) {
+        return -1;
+    }
+
+    string url = this->getPackageUrl(source, moduleName);
+    string uniqueSuffix = this->getUniqueDirSuffix();
+    string stagingDir = swordDir + "/.install-" + moduleName + "-" + uniqueSuffix;
+    string sharedDownloadDir = swordDir + "/.download-" + moduleName;
+    string downloadDir = sharedDownloadDir + "-" + uniqueSuffix;
+
+    // An interrupted download is claimed by moving it into the download directory of this installation.
+    // The rename fails if there is no interrupted download or if another installation has claimed it first.
+    rename(sharedDownloadDir.c_str(), downloadDir.c_str());
+
+    PartialDownload partialDownload = this->loadPartialDownload(downloadDir, moduleName, url);
+
+    int result = 0;
+    vector<string> files;
+    string moduleDataDir;
+
+    for (;;) {
+        FileMgr::removeDir(stagingDir.c_str());
+
+        {
+            ArchiveStreamExtractor extractor(ArchiveFormat::zip, stagingDir);
+            result = this->downloadAndExtract(source, url, moduleName, downloadDir, partialDownload, extractor, statusReporter, cancelled);
+            files = extractor.getExtractedFiles();
+        }
+
+        if (result != PACKAGE_DOWNLOAD_RESTART || partialDownload.size == 0) {
+            break;
+        }
+
+        // The partial download cannot be continued, so the package is downloaded again from the beginning
+        FileMgr::removeDir(downloadDir.c_str());
+        partialDownload = PartialDownload();
+    }
+
+    if (result == PACKAGE_DOWNLOAD_RESTART) {
+        result = -1;
+    }
+
+    if (result == 0 && !this->verifyPackage(stagingDir, files, moduleName, expectedVersion, moduleDataDir)) {
+        result = -1;
+    }
+
+    if (result == 0 && !this->commitPackage(stagingDir, files, swordDir, moduleDataDir)) {
+        result = -1;
+    }
+
+    // Interrupted and cancelled downloads are handed back, so that the next installation of the module can resume them.
+    // If another installation has left an interrupted download in the meantime, that one is kept instead.
+    if ((result != STREAMING_INSTALL_INTERRUPTED && result != -9) || rename(downloadDir.c_str(), sharedDownloadDir.c_str()) != 0) {
+        FileMgr::removeDir(downloadDir.c_str());
+    }
+
+    FileMgr::removeDir(stagingDir.c_str());
+    return result;
+#else
+    return -1;
+#endif
+}
+
+bool StreamingModuleInstaller::isPackageSupported(InstallSource* source)
+{
+#ifdef STREAMING_INSTALL_SUPPORTED
+    string type = string(source->type.c_str());
+    if (type != "HTTP" && type != "HTTPS" && type != "FTP") {
+        return false;
+    }
+
+    lock_guard<mutex> lock(this->_sourcesMutex);
+    return (this->_sourcesWithoutPackages.find(this->getSourceKey(source)) == this->_sourcesWithoutPackages.end());
+#else
+    return false;
+#endif
+}
+
+int StreamingModuleInstaller::downloadAndExtract(InstallSource* source,
+                                                 string url,
+                                                 string moduleName,
+                                                 string downloadDir,
+                                                 const PartialDownload& partialDownload,
+                                                 ArchiveStreamExtractor& extractor,
+                                                 StatusReporter* statusReporter,
+                                                 const atomic<bool>& cancelled)
+{
+#ifdef STREAMING_INSTALL_SUPPORTED
+    call_once(curlInitFlag, []() { curl_global_init(CURL_GLOBAL_DEFAULT); });
+
+    CURL* curl = curl_easy_init();
+    if (curl == 0) {
+        return -1;
+    }
+
+    ChunkQueue queue(PIPELINE_MAX_QUEUED_CHUNKS);
+    bool extractionSuccessful = true;
+    bool replaySuccessful = true;
+    string partialFilePath = this->getPartialFilePath(downloadDir, moduleName);
+    unsigned long long resumeOffset = partialDownload.size;
+
+    DownloadContext context;
+    context.curl = curl;
+    context.queue = &queue;
+    context.statusReporter = statusReporter;
+    context.cancelled = &cancelled;
+    context.resumeOffset = resumeOffset;
+    context.message = string((resumeOffset > 0) ? "Resuming " : "Downloading ") + moduleName + ".zip";
+
+    // The manifest identifies the package version of the partial download. It is written as soon as the response headers of a new download are known.
+    context.downloadStarted = [this, &downloadDir, &url](const string& etag, const string& lastModified) {
+        PartialDownload manifest;
+        manifest.url = url;
+        manifest.etag = etag;
+        manifest.lastModified = lastModified;
+        this->storePartialDownload(downloadDir, manifest);
+    };
+
+    string userName = string(source->u.c_str());
+    string password = string(source->p.c_str());
+    string ifRangeHeader = "If-Range: " + (!partialDownload.etag.empty() ? partialDownload.etag : partialDownload.lastModified);
+    struct curl_slist* headers = 0;
+    long lowSpeedTime = this->_timeoutMillis / 1000;
+    if (lowSpeedTime < 1) {
+        lowSpeedTime = 1;
+    }
+
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, this->_timeoutMillis);
+    // Large packages may take long, so only stalled transfers are aborted
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, lowSpeedTime);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, pipelineHeaderCallback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &context);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, pipelineWriteCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &context);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+#if LIBCURL_VERSION_NUM >= 0x072000
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, pipelineXferInfoCallback);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &context);
+#else
+    curl_easy_setopt(curl, CURLOPT_PROGRESSFUNCTION, pipelineLegacyProgressCallback);
+    curl_easy_setopt(curl, CURLOPT_PROGRESSDATA, &context);
+#endif
+
+    if (resumeOffset > 0) {
+        // The server only answers with the requested range if the package is still the same (If-Range), otherwise with the full package
+        curl_easy_setopt(curl, CURLOPT_RESUME_FROM_LARGE, (curl_off_t)resumeOffset);
+        headers = curl_slist_append(headers, ifRangeHeader.c_str());
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    }
+
+    if (!userName.empty()) {
+        curl_easy_setopt(curl, CURLOPT_USERNAME, userName.c_str());
+        curl_easy_setopt(curl, CURLOPT_PASSWORD, password.c_str());
+    }
+
+    FileMgr::createParent(partialFilePath.c_str());
+
+    // The extraction runs on its own thread instead of the ThreadPool, because it blocks while waiting for data
+    // and must not occupy a pool thread that the download itself may be running on.
+    thread extractionThread([&queue, &extractor, &extractionSuccessful, &replaySuccessful, &partialFilePath, resumeOffset]() {
+        // The partial file is accessed with plain file descriptors, since the global FileMgr of SWORD is not thread-safe
+        FileSystemHelper fileSystemHelper;
+
+        // The bytes of an interrupted download are extracted again from disk before the remaining bytes arrive
+        if (resumeOffset > 0) {
+            int partialFile = fileSystemHelper.openFile(partialFilePath, false);
+            vector<char> buffer(1024 * 1024);
+            unsigned long long replayedBytes = 0;
+            long readBytes = 0;
+
+            while (partialFile >= 0 && replayedBytes < resumeOffset && (readBytes = fileSystemHelper.readFile(partialFile, buffer.data(), (long)buffer.size())) > 0) {
+                readBytes = (long)min((unsigned long long)readBytes, resumeOffset - replayedBytes);
+
+                if (!extractor.write(buffer.data(), (size_t)readBytes)) {
+                    break;
+                }
+
+                replayedBytes += readBytes;
+            }
+
+            fileSystemHelper.closeFile(partialFile);
+
+            if (replayedBytes != resumeOffset) {
+                replaySuccessful = false;
+                queue.abort();
+                return;
+            }
+        }
+
+        int partialFile = fileSystemHelper.openFile(partialFilePath, true, (resumeOffset > 0));
+
+        string chunk;
+
+        while (queue.pop(chunk)) {
+            // The partial file is only extended, so that it always contains a valid prefix of the package
+            if (partialFile >= 0) {
+                fileSystemHelper.writeFile(partialFile, chunk.data(), (long)chunk.size());
+            }
+
+            if (!extractor.write(chunk.data(), chunk.size())) {
+                extractionSuccessful = false;
+                queue.abort();
+                break;
+            }
+        }
+
+        fileSystemHelper.closeFile(partialFile);
+    });
+
+    CURLcode curlResult = curl_easy_perform(curl);
+    queue.close();
+    extractionThread.join();
+
+    long responseCode = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responseCode);
+    curl_easy_cleanup(curl);
+
+    if (headers != 0) {
+        curl_slist_free_all(headers);
+    }
+
+    if (cancelled) {
+        return -9;
+    }
+
+    if (!replaySuccessful || context.rangeIgnored) {
+        return PACKAGE_DOWNLOAD_RESTART;
+    }
+
+    if (!extractionSuccessful) {
+        cerr << "Could not extract " << url << ": " << extractor.getLastError() << endl;
+        return (resumeOffset > 0) ? PACKAGE_DOWNLOAD_RESTART : -1;
+    }
+
+    if (curlResult != CURLE_OK) {
+        if (curlResult == CURLE_REMOTE_FILE_NOT_FOUND || responseCode == 404 || responseCode == 410) {
+            // The repository does not publish packages, which does not need to be checked again for other modules
+            lock_guard<mutex> lock(this->_sourcesMutex);
+            this->_sourcesWithoutPackages.insert(this->getSourceKey(source));
+            return -1;
+        }
+
+        if (resumeOffset > 0 && (responseCode == 416 || curlResult == CURLE_RANGE_ERROR)) {
+            // The server has not delivered the requested range, because the package has changed or ranges are not supported
+            return PACKAGE_DOWNLOAD_RESTART;
+        }
+
+        cerr << "Could not download " << url << ": " << curl_easy_strerror(curlResult) << endl;
+
+        // A download that has delivered data can be resumed later
+        PartialDownload interruptedDownload = this->loadPartialDownload(downloadDir, moduleName, url);
+        return (interruptedDownload.isResumable() && string(source->type.c_str()) != "FTP") ? STREAMING_INSTALL_INTERRUPTED : -1;
+    }
+
+    if (!extractor.finish()) {
+        cerr << "Could not extract " << url << ": " << extractor.getLastError() << endl;
+        return (resumeOffset > 0) ? PACKAGE_DOWNLOAD_RESTART : -1;
+    }
+
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+PartialDownload StreamingModuleInstaller::loadPartialDownload(string downloadDir, string moduleName, string url)
+{
+    PartialDownload partialDownload;
+    string manifestPath = downloadDir + "/download.conf";
+    string partialFilePath = this->getPartialFilePath(downloadDir, moduleName);
+
+    if (!FileMgr::existsFile(manifestPath.c_str()) || !FileMgr::existsFile(partialFilePath.c_str())) {
+        return partialDownload;
+    }
+
+    string manifestUrl;
+    string manifestEtag;
+    string manifestLastModified;
+
+    {
+        // SWConfig reads through the FileMgr
+        SwordFileLock fileLock;
+        SWConfig manifest(manifestPath.c_str());
+
+        manifestUrl = string(manifest.getValue(PARTIAL_DOWNLOAD_SECTION, "Url").c_str());
+        manifestEtag = string(manifest.getValue(PARTIAL_DOWNLOAD_SECTION, "ETag").c_str());
+        manifestLastModified = string(manifest.getValue(PARTIAL_DOWNLOAD_SECTION, "LastModified").c_str());
+    }
+
+    // A partial download of another URL (e.g. after a repository change) cannot be continued
+    if (manifestUrl != url) {
+        return partialDownload;
+    }
+
+    partialDownload.url = manifestUrl;
+    partialDownload.etag = manifestEtag;
+    partialDownload.lastModified = manifestLastModified;
+
+    // The size is taken from the file itself, because the file may have been extended after the manifest has been written
+    FileSystemHelper fileSystemHelper;
+    long long size = fileSystemHelper.getFileSize(partialFilePath);
+    partialDownload.size = (size > 0) ? (unsigned long long)size : 0;
+
+    if (!partialDownload.isResumable()) {
+        partialDownload.size = 0;
+    }
+
+    return partialDownload;
+}
+
+void StreamingModuleInstaller::storePartialDownload(string downloadDir, const PartialDownload& partialDownload)
+{
+    string manifestPath = downloadDir + "/download.conf";
+    FileMgr::createParent(manifestPath.c_str());
+
+    SwordFileLock fileLock;
+    SWConfig manifest(manifestPath.c_str());
+    manifest.setValue(PARTIAL_DOWNLOAD_SECTION, "Url", partialDownload.url.c_str());
+    manifest.setValue(PARTIAL_DOWNLOAD_SECTION, "ETag", partialDownload.etag.c_str());
+    manifest.setValue(PARTIAL_DOWNLOAD_SECTION, "LastModified", partialDownload.lastModified.c_str());
+    manifest.save();
+}
+
+string StreamingModuleInstaller::getPartialFilePath(string downloadDir, string moduleName)
+{
+    return downloadDir + "/" + moduleName + ".zip.part";
+}
+
+bool StreamingModuleInstaller::verifyPackage(string stagingDir,
+                                             const vector<string>& files,
+                                             string moduleName,
+                                             string expectedVersion,
+                                             string& moduleDataDir)
+{
+    ModsArchiveReader modsArchiveReader;
+    SWConfig packageConfig;
+
+    for (unsigned int i = 0; i < files.size(); i++) {
+        string fileName = files[i];
+        if (fileName.compare(0, 2, "./") == 0) {
+            fileName = fileName.substr(2);
+        }
+
+        // A module package must not write anything apart from the module configuration and data
+        if (fileName.compare(0, 7, "mods.d/") != 0 && fileName.compare(0, 8, "modules/") != 0) {
+            cerr << "Unexpected file " << fileName << " in package of " << moduleName << endl;
+            return false;
+        }
+
+        if (fileName.compare(0, 7, "mods.d/") == 0 && fileName.size() > 5 && fileName.compare(fileName.size() - 5, 5, ".conf") == 0) {
+            ifstream confFile(stagingDir + "/" + files[i], ios::binary);
+            stringstream confContent;
+            confContent << confFile.rdbuf();
+            modsArchiveReader.parseConf(confContent.str(), packageConfig);
+        }
+    }
+
+    SectionMap::iterator section = packageConfig.getSections().find(moduleName.c_str());
+    if (section == packageConfig.getSections().end()) {
+        cerr << "The package of " << moduleName << " does not contain its module configuration" << endl;
+        return false;
+    }
+
+    // Packages may lag behind the repository index, in which case the module is installed from the repository itself
+    ConfigEntMap::iterator version = section->second.find("Version");
+    string packageVersion = (version != section->second.end()) ? string(version->second.c_str()) : "";
+
+    if (packageVersion != expectedVersion) {
+        cerr << "The package of " << moduleName << " has version '" << packageVersion
+             << "' instead of '" << expectedVersion << "'" << endl;
+        return false;
+    }
+
+    ConfigEntMap::iterator dataPathEntry = section->second.find("DataPath");
+    if (dataPathEntry != section->second.end()) {
+        string dataPath = string(dataPathEntry->second.c_str());
+        if (dataPath.compare(0, 2, "./") == 0) {
+            dataPath = dataPath.substr(2);
+        }
+
+        if (dataPath.find("..") != string::npos) {
+            cerr << "The package of " << moduleName << " has the invalid DataPath " << dataPath << endl;
+            return false;
+        }
+
+        // Like in InstallMgr::removeModule: The DataPath of these drivers ends with a file name prefix instead of a directory
+        ConfigEntMap::iterator modDrvEntry = section->second.find("ModDrv");
+        string modDrv = (modDrvEntry != section->second.end()) ? string(modDrvEntry->second.c_str()) : "";
+        string dataDir = dataPath;
+
+        if (modDrv == "RawLD" || modDrv == "RawLD4" || modDrv == "zLD" || modDrv == "RawGenBook" || modDrv == "zGenBook") {
+            dataDir = dataDir.substr(0, dataDir.find_last_of('/') + 1);
+        }
+
+        while (!dataDir.empty() && dataDir[dataDir.size() - 1] == '/') {
+            dataDir.erase(dataDir.size() - 1);
+        }
+
+        // The data directory is cleared before the package is committed. This is only done for a module specific
+        // directory (modules/<category>/<driver>/<module>), never for a directory shared with other modules.
+        if (dataDir.compare(0, 8, "modules/") == 0 && count(dataDir.begin(), dataDir.end(), '/') >= 3) {
+            moduleDataDir = dataDir;
+        }
+
+        for (unsigned int i = 0; i < files.size(); i++) {
+            string fileName = files[i];
+            if (fileName.compare(0, 2, "./") == 0) {
+                fileName = fileName.substr(2);
+            }
+
+            if (fileName.compare(0, dataPath.size(), dataPath) == 0) {
+                return true;
+            }
+        }
+
+        cerr << "The package of " << moduleName << " does not contain any data below " << dataPath << endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool StreamingModuleInstaller::commitPackage(string stagingDir, const vector<string>& files, string swordDir, string moduleDataDir)
+{
+    // Files of a previously installed version that are not part of the package anymore are removed, like in InstallMgr::removeModule
+    if (!moduleDataDir.empty()) {
+        string targetDataDir = swordDir + "/" + moduleDataDir;
+        FileMgr::removeDir(targetDataDir.c_str());
+    }
+
+    for (unsigned int i = 0; i < files.size(); i++) {
+        string stagedPath = stagingDir + "/" + files[i];
+        string targetPath = swordDir + "/" + files[i];
+
+        FileMgr::createParent(targetPath.c_str());
+        FileMgr::removeFile(targetPath.c_str());
+
+        if (rename(stagedPath.c_str(), targetPath.c_str()) != 0) {
+            cerr << "Could not move " << stagedPath << " to " << targetPath << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+string StreamingModuleInstaller::getUniqueDirSuffix()
+{
+    // The time and a random number distinguish the installations of several processes, the counter those of this process
+    stringstream suffix;
+    random_device randomDevice;
+
+    suffix << hex << chrono::system_clock::now().time_since_epoch().count()
+           << "-" << randomDevice()
+           << "-" << this->_installCounter++;
+
+    return suffix.str();
+}
+
+string StreamingModuleInstaller::getPackageUrl(InstallSource* source, string moduleName)
+{
+    // Mirrors the URL construction of InstallMgr::remoteCopy. The packages are located next to the module directory,
+    // e.g. /pub/sword/raw (modules) and /pub/sword/packages/rawzip (packages).
+    string type = string(source->type.c_str());
+    string url = (type == "HTTP") ? "http://" : (type == "HTTPS") ? "https://" : "ftp://";
+    string directory = string(source->directory.c_str());
+
+    while (!directory.empty() && (directory[directory.size() - 1] == '/' || directory[directory.size() - 1] == '\\')) {
+        directory.erase(directory.size() - 1);
+    }
+
+    size_t lastSeparator = directory.find_last_of("/\\");
+    directory = (lastSeparator != string::npos) ? directory.substr(0, lastSeparator) : "";
+
+    url += string(source->source.c_str());
+    url += directory;
+    url += "/packages/rawzip/" + moduleName + ".zip";
+    return url;
+}
+
+string StreamingModuleInstaller::getSourceKey(InstallSource* source)
+{
+    return string(source->source.c_str()) + string(source->directory.c_str());
+}
@@ -0,0 +1,125 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+
+#ifndef _STREAMING_MODULE_INSTALLER
+#define _STREAMING_MODULE_INSTALLER
+
+#include <string>
+#include <vector>
+#include <set>
+#include <mutex>
+#include <atomic>
+
+namespace sword {
+    class InstallSource;
+    class StatusReporter;
+};
+
+class ArchiveStreamExtractor;
+
+// Result of installModule if the download has been interrupted. The partial download is kept and resumed by the next installation.
+#define STREAMING_INSTALL_INTERRUPTED -2
+
+// An interrupted package download, which is persisted in a manifest next to the partially downloaded package
+class PartialDownload {
+public:
+    std::string url;
+    std::string etag;
+    std::string lastModified;
+    unsigned long long size = 0;
+
+    // A download can only be resumed if a validator proves that the package has not changed in the meantime
+    bool isResumable() const {
+        return (this->size > 0 && (!this->etag.empty() || !this->lastModified.empty()));
+    }
+};
+
+/**
+ * The StreamingModuleInstaller installs a module from its zip package (packages/rawzip/<Module>.zip next to the
+ * module directory of the repository, as published by CrossWire).
+ *
+ * The package is extracted while it is downloaded: the download thread hands the received chunks to the extraction
+ * thread via a bounded queue, so that at most a few hundred KB are buffered and no archive is written to disk.
+ * The files are extracted to a staging directory and only moved into the SWORD directory after the archive has been
+ * verified (zip checksums, module configuration and version matching the repository index).
+ *
+ * If a repository does not publish packages, this is remembered, so that the caller can directly fall back to
+ * InstallMgr::installModule for further modules of that repository.
+ *
+ * The received bytes are also appended to a partial file. If the download is cancelled or interrupted, the partial file
+ * is kept together with a manifest (URL, ETag, Last-Modified). The next installation of the module extracts the partial file
+ * again and requests only the remaining bytes with an HTTP Range request. If-Range makes sure that the server sends the
+ * complete package instead if it has changed in the meantime.
+ *
+ * Every installation works in its own staging and download directory, so that concurrent installations of the same module
+ * (e.g. from two processes sharing the SWORD directory) do not interfere. An interrupted download is handed over between
+ * installations by renaming its directory from and to the common location .download-<Module>.
+ */
+class StreamingModuleInstaller {
+public:
+    StreamingModuleInstaller(long timeoutMillis=20000);
+    virtual ~StreamingModuleInstaller(){}
+
+    // Returns 0 on success, -9 if the installation has been cancelled, STREAMING_INSTALL_INTERRUPTED if the download has been
+    // interrupted and -1 otherwise. The SWORD directory is left unchanged if the installation fails.
+    int installModule(sword::InstallSource* source,
+                      std::string moduleName,
+                      std::string expectedVersion,
+                      std::string swordDir,
+                      sword::StatusReporter* statusReporter,
+                      const std::atomic<bool>& cancelled);
+
+    // Returns false if it is already known that the given source does not publish module packages
+    bool isPackageSupported(sword::InstallSource* source);
+
+    void setTimeoutMillis(long timeoutMillis) { this->_timeoutMillis = timeoutMillis; }
+
+private:
+    int downloadAndExtract(sword::InstallSource* source,
+                           std::string url,
+                           std::string moduleName,
+                           std::string downloadDir,
+                           const PartialDownload& partialDownload,
+                           ArchiveStreamExtractor& extractor,
+                           sword::StatusReporter* statusReporter,
+                           const std::atomic<bool>& cancelled);
+
+    // On success moduleDataDir is set to the data directory of the module (relative to the SWORD directory)
+    bool verifyPackage(std::string stagingDir,
+                       const std::vector<std::string>& files,
+                       std::string moduleName,
+                       std::string expectedVersion,
+                       std::string& moduleDataDir);
+
+    PartialDownload loadPartialDownload(std::string downloadDir, std::string moduleName, std::string url);
+    void storePartialDownload(std::string downloadDir, const PartialDownload& partialDownload);
+    std::string getPartialFilePath(std::string downloadDir, std::string moduleName);
+
+    bool commitPackage(std::string stagingDir, const std::vector<std::string>& files, std::string swordDir, std::string moduleDataDir);
+    std::string getUniqueDirSuffix();
+    std::string getPackageUrl(sword::InstallSource* source, std::string moduleName);
+    std::string getSourceKey(sword::InstallSource* source);
+
+    long _timeoutMillis;
+    std::set<std::string> _sourcesWithoutPackages;
+    std::mutex _sourcesMutex;
+    std::atomic<unsigned int> _installCounter;
+};
+
+#endif // _STREAMING_MODULE_INSTALLER
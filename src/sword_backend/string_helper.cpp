@@ -84,4 +84,52 @@ int StringHelper::numberOfSubstrings(const std::string& str, const std::string&
     }
 
     return count;
-}
\ No newline at end of file
+}
+
+std::string StringHelper::removeTags(const std::string& str) {
+    std::string result;
+    bool insideTag = false;
+
+    for (size_t i = 0; i < str.length(); i++) {
+        if (str[i] == '<') {
+            insideTag = true;
+        } else if (str[i] == '>') {
+            insideTag = false;
+        } else if (!insideTag) {
+            result += str[i];
+        }
+    }
+
+    return result;
+}
+
+std::string StringHelper::foldCase(const std::string& str) {
+    std::string result = str;
+
+    for (size_t i = 0; i < result.length(); i++) {
+        unsigned char c = (unsigned char)result[i];
+
+        if (c >= 'A' && c <= 'Z') {
+            result[i] = (char)(c + 32);
+
+        } else if ((c & 0xE0) == 0xC0 && i + 1 < result.length() && ((unsigned char)result[i + 1] & 0xC0) == 0x80) {
+            unsigned int codePoint = ((c & 0x1F) << 6) | ((unsigned char)result[i + 1] & 0x3F);
+
+            if ((codePoint >= 0xC0 && codePoint <= 0xDE && codePoint != 0xD7) || // Latin-1
+                (codePoint >= 0x391 && codePoint <= 0x3A9 && codePoint != 0x3A2) || // Greek
+                (codePoint >= 0x410 && codePoint <= 0x42F)) { // Cyrillic
+
+                codePoint += 0x20;
+
+            } else if (codePoint >= 0x400 && codePoint <= 0x40F) { // Cyrillic with diacritics
+                codePoint += 0x50;
+            }
+
+            result[i] = (char)(0xC0 | (codePoint >> 6));
+            result[i + 1] = (char)(0x80 | (codePoint & 0x3F));
+            i++;
+        }
+    }
+
+    return result;
+}
@@ -32,6 +32,10 @@ public:
     static bool hasEnding(std::string const &fullString, std::string const &ending);
     static std::vector<std::string> split(std::string str, std::string token);
     static int numberOfSubstrings(const std::string& str, const std::string& sub);
+    static std::string removeTags(const std::string& str);
+
+    // Lower-cases ASCII letters and the upper case letters of Latin-1, Greek and Cyrillic in a UTF-8 string
+    static std::string foldCase(const std::string& str);
 };
 
 #endif // _STRING_HELPER
\ No newline at end of file
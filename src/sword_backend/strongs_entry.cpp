@@ -90,16 +90,9 @@ bool StrongsEntry::isValidStrongsKey(std::string key)
         return false;
     }
 
-    char dictionary = key[0];
-    static const int HEBREW_MAX = 8674;
-    static const int GREEK_MAX = 5624;
-    int maxStrongsNumber;
+    int maxStrongsNumber = StrongsEntry::getMaxStrongsNumber(key[0]);
 
-    if (dictionary == 'H') {
-        maxStrongsNumber = HEBREW_MAX;
-    } else if (dictionary == 'G') {
-        maxStrongsNumber = GREEK_MAX;
-    } else {
+    if (maxStrongsNumber == 0) {
         // Unknown dictionary type
         return false;
     }
@@ -110,6 +103,30 @@ bool StrongsEntry::isValidStrongsKey(std::string key)
             strongsNumber <= maxStrongsNumber);
 }
 
+int StrongsEntry::getMaxStrongsNumber(char dictionary)
+{
+    static const int HEBREW_MAX = 8674;
+    static const int GREEK_MAX = 5624;
+
+    if (dictionary == 'H') {
+        return HEBREW_MAX;
+    } else if (dictionary == 'G') {
+        return GREEK_MAX;
+    } else {
+        return 0;
+    }
+}
+
+string StrongsEntry::getNormalizedStrongsKey(string key)
+{
+    if (key.size() < 2) {
+        return key;
+    }
+
+    unsigned int strongsNumber = atoi(key.substr(1).c_str());
+    return key[0] + to_string(strongsNumber);
+}
+
 StrongsEntry* StrongsEntry::getStrongsEntry(SWModule* module, string key)
 {
     if (module == 0) {
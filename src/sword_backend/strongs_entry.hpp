@@ -30,6 +30,7 @@ class StrongsReference
 {
 public:
     StrongsReference(std::string text);
+    StrongsReference(std::string text, std::string key) : text(text), key(key) {}
     virtual ~StrongsReference(){}
 
     bool hasValidKey();
@@ -45,9 +46,16 @@ class StrongsEntry
 {
 public:
     StrongsEntry(std::string key, std::string rawEntry, std::string moduleVersion);
+
+    // Creates an empty entry, used for entries that have already been parsed (see StrongsTable)
+    StrongsEntry(std::string key) : key(key) {}
     virtual ~StrongsEntry(){}
 
     static bool isValidStrongsKey(std::string key);
+    // Returns 0 for unknown dictionaries (other than H and G)
+    static int getMaxStrongsNumber(char dictionary);
+    // Removes leading zeros from the number of a key (H07225 becomes H7225)
+    static std::string getNormalizedStrongsKey(std::string key);
     static StrongsEntry* getStrongsEntry(sword::SWModule* module, std::string key);
 
     std::string rawEntry;
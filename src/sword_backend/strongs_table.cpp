@@ -0,0 +1,270 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+// Std includes
+#include <iostream>
+#include <cstring>
+#include <stdlib.h>
+
+// Sword includes
+#include <swmodule.h>
+
+// Own includes
+#include "strongs_table.hpp"
+#include "strongs_entry.hpp"
+#include "module_store.hpp"
+#include "thread_pool.hpp"
+#include "sword_file_lock.hpp"
+
+using namespace std;
+using namespace sword;
+
+// Layout of the table file (integers in native byte order):
+//
+// Header:  "NSST", uint32 format version, char dictionary (H or G), uint32 max Strong's number, module version
+// Index:   uint32 record offset for every Strong's number from 0 to the max number (0 if there is no entry)
+// Records: raw entry, transcription, phonetic transcription, definition, uint32 reference count and
+//          the text and key of every reference
+//
+// Strings are stored as uint32 length followed by the string data.
+
+#define STRONGS_TABLE_MAGIC "NSST"
+#define STRONGS_TABLE_VERSION 1
+
+StrongsTable::StrongsTable(string tableFilePath, string moduleVersion)
+    : _tableFilePath(tableFilePath), _moduleVersion(moduleVersion)
+{
+}
+
+bool StrongsTable::open(char dictionary)
+{
+    if (!this->_mappedFile.open(this->_tableFilePath)) {
+        return false;
+    }
+
+    const char* data = this->_mappedFile.getData();
+    unsigned long long offset = 4;
+    unsigned int formatVersion = 0;
+    string tableModuleVersion;
+
+    bool valid = (this->_mappedFile.getSize() > 9 && memcmp(data, STRONGS_TABLE_MAGIC, 4) == 0 &&
+                  this->readUInt32(offset, formatVersion) && formatVersion == STRONGS_TABLE_VERSION &&
+                  data[offset] == dictionary);
+
+    offset += 1;
+
+    valid = (valid &&
+             this->readUInt32(offset, this->_maxNumber) &&
+             this->readString(offset, tableModuleVersion) &&
+             tableModuleVersion == this->_moduleVersion &&
+             offset + ((unsigned long long)this->_maxNumber + 1) * 4 <= this->_mappedFile.getSize());
+
+    if (!valid) {
+        // Tables of other module versions are replaced with the next build
+        this->_mappedFile.close();
+        return false;
+    }
+
+    this->_dictionary = dictionary;
+    this->_indexOffset = offset;
+    this->_ready.store(true);
+    return true;
+}
+
+bool StrongsTable::build(SWModule* module, char dictionary)
+{
+    if (module == 0) {
+        return false;
+    }
+
+    unsigned int maxNumber = (unsigned int)StrongsEntry::getMaxStrongsNumber(dictionary);
+    if (maxNumber == 0) {
+        return false;
+    }
+
+    vector<char> table;
+    vector<unsigned int> index(maxNumber + 1, 0);
+
+    auto appendUInt32 = [&table](unsigned int value) {
+        table.insert(table.end(), (const char*)&value, (const char*)&value + 4);
+    };
+
+    auto appendString = [&table, &appendUInt32](const string& value) {
+        appendUInt32((unsigned int)value.size());
+        table.insert(table.end(), value.begin(), value.end());
+    };
+
+    table.insert(table.end(), STRONGS_TABLE_MAGIC, STRONGS_TABLE_MAGIC + 4);
+    appendUInt32(STRONGS_TABLE_VERSION);
+    table.push_back(dictionary);
+    appendUInt32(maxNumber);
+    appendString(this->_moduleVersion);
+
+    unsigned long long indexOffset = table.size();
+    table.resize(table.size() + index.size() * 4);
+
+    for (unsigned int number = 1; number <= maxNumber; number++) {
+        string key = string(1, dictionary) + to_string(number);
+        StrongsEntry* entry = 0;
+
+        {
+            // Only the read of a single entry holds the file lock, so that the build does not block the API calls
+            SwordFileLock fileLock;
+            entry = StrongsEntry::getStrongsEntry(module, key);
+        }
+
+        if (entry == 0) {
+            continue;
+        }
+
+        index[number] = (unsigned int)table.size();
+
+        appendString(entry->rawEntry);
+        appendString(entry->transcription);
+        appendString(entry->phoneticTranscription);
+        appendString(entry->definition);
+        appendUInt32((unsigned int)entry->references.size());
+
+        for (unsigned int i = 0; i < entry->references.size(); i++) {
+            appendString(entry->references[i].text);
+            appendString(entry->references[i].key);
+        }
+
+        delete entry;
+    }
+
+    memcpy(&table[indexOffset], &index[0], index.size() * 4);
+
+    // The current mapping refers to the file that is replaced
+    this->_mappedFile.close();
+
+    if (!MappedFile::writeFile(this->_tableFilePath, table)) {
+        return false;
+    }
+
+    return this->open(dictionary);
+}
+
+StrongsEntry* StrongsTable::getStrongsEntry(string key)
+{
+    if (!this->_mappedFile.isOpen() || key.size() < 2 || key[0] != this->_dictionary) {
+        return 0;
+    }
+
+    unsigned int number = (unsigned int)atoi(key.substr(1).c_str());
+    if (number == 0 || number > this->_maxNumber) {
+        return 0;
+    }
+
+    unsigned long long indexOffset = this->_indexOffset + (unsigned long long)number * 4;
+    unsigned int recordOffset = 0;
+
+    if (!this->readUInt32(indexOffset, recordOffset) || recordOffset == 0) {
+        return 0;
+    }
+
+    unsigned long long offset = recordOffset;
+    StrongsEntry* entry = new StrongsEntry(key);
+    unsigned int referenceCount = 0;
+
+    bool valid = (this->readString(offset, entry->rawEntry) &&
+                  this->readString(offset, entry->transcription) &&
+                  this->readString(offset, entry->phoneticTranscription) &&
+                  this->readString(offset, entry->definition) &&
+                  this->readUInt32(offset, referenceCount));
+
+    for (unsigned int i = 0; valid && i < referenceCount; i++) {
+        string text;
+        string referenceKey;
+
+        valid = (this->readString(offset, text) && this->readString(offset, referenceKey));
+
+        if (valid) {
+            entry->references.push_back(StrongsReference(text, referenceKey));
+        }
+    }
+
+    if (!valid) {
+        cerr << "StrongsTable: Invalid record for " << key << " in " << this->_tableFilePath << endl;
+        delete entry;
+        return 0;
+    }
+
+    return entry;
+}
+
+bool StrongsTable::readUInt32(unsigned long long& offset, unsigned int& value)
+{
+    if (offset + 4 > this->_mappedFile.getSize()) {
+        return false;
+    }
+
+    memcpy(&value, this->_mappedFile.getData() + offset, 4);
+    offset += 4;
+    return true;
+}
+
+bool StrongsTable::readString(unsigned long long& offset, string& value)
+{
+    unsigned int length = 0;
+
+    if (!this->readUInt32(offset, length) || offset + length > this->_mappedFile.getSize()) {
+        return false;
+    }
+
+    value.assign(this->_mappedFile.getData() + offset, length);
+    offset += length;
+    return true;
+}
+
+shared_ptr<StrongsTable> StrongsTableCache::getTable(SWModule* module, char dictionary)
+{
+    lock_guard<mutex> lock(this->_tablesMutex);
+
+    string moduleName = string(module->getName());
+    const char* moduleVersion = module->getConfigEntry("Version");
+    string currentVersion = (moduleVersion != 0) ? string(moduleVersion) : "";
+    shared_ptr<StrongsTable>& strongsTable = this->_tables[moduleName];
+
+    // A table that is still being built or could not be built is kept as well, so that the build is not repeated
+    if (strongsTable && strongsTable->getModuleVersion() == currentVersion) {
+        return strongsTable->isReady() ? strongsTable : shared_ptr<StrongsTable>();
+    }
+
+    string tableFilePath = this->_moduleStore.getUserSwordDir() + "/." + moduleName + ".table";
+    strongsTable = make_shared<StrongsTable>(tableFilePath, currentVersion);
+
+    if (strongsTable->open(dictionary)) {
+        return strongsTable;
+    }
+
+    // The build reads every entry of the module. It runs in the background on a module of a leased SWMgr,
+    // so that it neither blocks the caller nor moves the cursor of the module used by the API.
+    shared_ptr<StrongsTable> pendingTable = strongsTable;
+    ModuleStore& moduleStore = this->_moduleStore;
+
+    ThreadPool::getInstance().submit<void>(TaskPriority::indexing, [pendingTable, &moduleStore, moduleName, dictionary]() {
+        SwordMgrLease lease = moduleStore.acquireMgr();
+
+        if (!pendingTable->build(lease.getModule(moduleName), dictionary)) {
+            cerr << "Could not build the Strong's table of " << moduleName << endl;
+        }
+    });
+
+    return shared_ptr<StrongsTable>();
+}
@@ -0,0 +1,98 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef _STRONGS_TABLE
+#define _STRONGS_TABLE
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+#include "mapped_file.hpp"
+
+namespace sword {
+    class SWModule;
+};
+
+class StrongsEntry;
+class ModuleStore;
+
+/**
+ * A table of the preparsed entries of a Strong's lexicon module (StrongsHebrew or StrongsGreek).
+ *
+ * The table is built once per module version by parsing every entry of the module and is then stored as a file
+ * that is memory-mapped when it is opened. The entries are indexed by their Strong's number, so a lookup only
+ * needs to copy the fields of one entry and does not touch the module.
+ *
+ * The build may run on another thread. The table must not be used for lookups before isReady() returns true.
+ */
+class StrongsTable {
+public:
+    StrongsTable(std::string tableFilePath, std::string moduleVersion);
+    virtual ~StrongsTable() {}
+
+    // Opens an existing table file of the module version
+    bool open(char dictionary);
+
+    // Builds the table file from the given module and opens it
+    bool build(sword::SWModule* module, char dictionary);
+
+    bool isReady() const { return this->_ready.load(); }
+    std::string getModuleVersion() const { return this->_moduleVersion; }
+
+    // Returns 0 if the key is not part of the table. The caller takes ownership of the returned entry.
+    StrongsEntry* getStrongsEntry(std::string key);
+
+private:
+    bool readUInt32(unsigned long long& offset, unsigned int& value);
+    bool readString(unsigned long long& offset, std::string& value);
+
+    std::string _tableFilePath;
+    std::string _moduleVersion;
+    char _dictionary = 0;
+    unsigned int _maxNumber = 0;
+    unsigned long long _indexOffset = 0;
+    MappedFile _mappedFile;
+    std::atomic<bool> _ready{false};
+};
+
+/**
+ * The Strong's tables of all modules of a module store.
+ *
+ * There must only be one cache per module store (the SharedBackend owns it), since the tables are built into files
+ * of the user SWORD directory and the cache makes sure that every table is only built once.
+ */
+class StrongsTableCache {
+public:
+    StrongsTableCache(ModuleStore& moduleStore) : _moduleStore(moduleStore) {}
+    virtual ~StrongsTableCache() {}
+
+    // Returns the table of the given Strong's module. If there is no table for the module version yet, it is built
+    // in the background and an empty pointer is returned until it is ready.
+    std::shared_ptr<StrongsTable> getTable(sword::SWModule* module, char dictionary);
+
+private:
+    ModuleStore& _moduleStore;
+    std::map<std::string, std::shared_ptr<StrongsTable>> _tables;
+    std::mutex _tablesMutex;
+};
+
+#endif // _STRONGS_TABLE
@@ -0,0 +1,116 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+// Std includes
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+// Own includes
+#include "sword_file_lock.hpp"
+
+using namespace std;
+
+// The FileMgr is global, so is its lock
+static mutex fileLockMutex;
+static condition_variable fileLockReleased;
+static thread::id fileLockOwner;
+static unsigned int fileLockCount = 0;
+
+SwordFileLock::SwordFileLock()
+{
+    SwordFileLock::lock();
+}
+
+SwordFileLock::~SwordFileLock()
+{
+    SwordFileLock::unlock();
+}
+
+void SwordFileLock::lock()
+{
+    SwordFileLock::reacquire(1);
+}
+
+void SwordFileLock::unlock()
+{
+    {
+        lock_guard<mutex> lock(fileLockMutex);
+
+        if (fileLockCount == 0 || fileLockOwner != this_thread::get_id()) {
+            return;
+        }
+
+        fileLockCount--;
+
+        if (fileLockCount > 0) {
+            return;
+        }
+
+        fileLockOwner = thread::id();
+    }
+
+    fileLockReleased.notify_one();
+}
+
+unsigned int SwordFileLock::releaseAll()
+{
+    unsigned int lockCount = 0;
+
+    {
+        lock_guard<mutex> lock(fileLockMutex);
+
+        if (fileLockCount == 0 || fileLockOwner != this_thread::get_id()) {
+            return 0;
+        }
+
+        lockCount = fileLockCount;
+        fileLockCount = 0;
+        fileLockOwner = thread::id();
+    }
+
+    fileLockReleased.notify_one();
+    return lockCount;
+}
+
+void SwordFileLock::reacquire(unsigned int lockCount)
+{
+    if (lockCount == 0) {
+        return;
+    }
+
+    thread::id currentThread = this_thread::get_id();
+    unique_lock<mutex> lock(fileLockMutex);
+
+    while (fileLockCount > 0 && fileLockOwner != currentThread) {
+        fileLockReleased.wait(lock);
+    }
+
+    fileLockOwner = currentThread;
+    fileLockCount += lockCount;
+}
+
+SwordFileUnlock::SwordFileUnlock()
+{
+    this->_lockCount = SwordFileLock::releaseAll();
+}
+
+SwordFileUnlock::~SwordFileUnlock()
+{
+    SwordFileLock::reacquire(this->_lockCount);
+}
@@ -0,0 +1,79 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef _SWORD_FILE_LOCK
+#define _SWORD_FILE_LOCK
+
+/**
+ * The SwordFileLock serializes the access to SWORD's FileMgr within the process.
+ *
+ * The FileMgr is a process-wide singleton that keeps an unsynchronized list of the open files. Module drivers (re)open
+ * their files through it whenever they read and it closes the least recently used files once too many are open. Creating
+ * and deleting modules, managers and SWConfig instances also changes the list. All of this must therefore hold the lock,
+ * even if different SWMgr instances are used. Files that the addon writes itself do not need the lock, as long as they
+ * are written with plain file descriptors instead of the FileMgr.
+ *
+ * Consequently, the file I/O of all SWORD readers is serialized, while the text filtering of the background readers
+ * still runs in parallel. The synchronous API calls hold the lock for the whole call. Background readers only hold it
+ * for a single read step, so that the calls of the JavaScript thread are not blocked for long. Limits: A module search
+ * holds it while SWORD searches the module and only releases it on every progress step. SWORD's own transfers
+ * (the repository list, sources without module archive and the InstallMgr fallback of the installation) write through
+ * the FileMgr and hold the lock for the whole transfer, so the synchronous calls wait for them.
+ *
+ * The lock is recursive. Lock order: the API lock and the manager lock of the module store come first, all other mutexes
+ * of the backend come after the SwordFileLock. So while holding any other mutex, a thread must not wait for this lock.
+ * A thread that holds the lock must not wait for other threads that need it (see SwordFileUnlock).
+ */
+class SwordFileLock
+{
+public:
+    SwordFileLock();
+    ~SwordFileLock();
+
+    static void lock();
+    static void unlock();
+
+private:
+    SwordFileLock(const SwordFileLock&);
+    SwordFileLock& operator=(const SwordFileLock&);
+
+    friend class SwordFileUnlock;
+
+    // Releases all levels held by the current thread and returns their number
+    static unsigned int releaseAll();
+    static void reacquire(unsigned int lockCount);
+};
+
+/**
+ * Releases the SwordFileLock held by the current thread for the lifetime of the object, e.g. while waiting for a network
+ * transfer or for other threads that need the lock. It is taken again when the object is destroyed.
+ */
+class SwordFileUnlock
+{
+public:
+    SwordFileUnlock();
+    ~SwordFileUnlock();
+
+private:
+    SwordFileUnlock(const SwordFileUnlock&);
+    SwordFileUnlock& operator=(const SwordFileUnlock&);
+
+    unsigned int _lockCount;
+};
+
+#endif // _SWORD_FILE_LOCK
@@ -0,0 +1,231 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+// Std includes
+#include <thread>
+#include <iostream>
+
+// Sword includes
+#include <swmgr.h>
+#include <swmodule.h>
+
+// Own includes
+#include "sword_mgr_pool.hpp"
+#include "reloadable_sword_mgr.hpp"
+#include "sword_file_lock.hpp"
+
+using namespace std;
+using namespace sword;
+
+SwordMgrLease::SwordMgrLease(SwordMgrPool* pool, ReloadableSwordMgr* mgr)
+    : _pool(pool), _mgr(mgr)
+{
+}
+
+SwordMgrLease::SwordMgrLease(SwordMgrLease&& other)
+    : _pool(other._pool), _mgr(other._mgr)
+{
+    other._pool = 0;
+    other._mgr = 0;
+}
+
+SwordMgrLease::~SwordMgrLease()
+{
+    this->release();
+}
+
+ReloadableSwordMgr* SwordMgrLease::getMgr()
+{
+    return this->_mgr;
+}
+
+SWModule* SwordMgrLease::getModule(string moduleName)
+{
+    if (this->_mgr == 0) {
+        cerr << "SwordMgrLease::getModule: lease has already been released!" << endl;
+        return 0;
+    }
+
+    // Creating the driver opens the module files
+    SwordFileLock fileLock;
+    return this->_mgr->getOrCreateModule(moduleName);
+}
+
+void SwordMgrLease::release()
+{
+    if (this->_pool != 0 && this->_mgr != 0) {
+        this->_pool->release(this->_mgr);
+    }
+
+    this->_pool = 0;
+    this->_mgr = 0;
+}
+
+SwordMgrPool::SwordMgrPool(function<ReloadableSwordMgr*()> mgrFactory, unsigned int maxSize)
+    : _mgrFactory(mgrFactory), _maxSize(maxSize)
+{
+    if (this->_maxSize == 0) {
+        // hardware_concurrency() may return 0 if the value cannot be determined
+        this->_maxSize = thread::hardware_concurrency();
+
+        if (this->_maxSize < 2) {
+            this->_maxSize = 2;
+        }
+    }
+}
+
+SwordMgrPool::~SwordMgrPool()
+{
+    vector<ReloadableSwordMgr*> discardedMgrs;
+
+    {
+        lock_guard<mutex> lock(this->_poolMutex);
+
+        for (unsigned int i = 0; i < this->_idleMgrs.size(); i++) {
+            this->discardMgr(this->_idleMgrs[i], discardedMgrs);
+        }
+
+        this->_idleMgrs.clear();
+
+        if (this->_mgrGenerations.size() > 0) {
+            cerr << "SwordMgrPool: destroyed while " << this->_mgrGenerations.size() << " SWMgr instance(s) are still leased!" << endl;
+        }
+    }
+
+    this->deleteMgrs(discardedMgrs);
+}
+
+SwordMgrLease SwordMgrPool::acquire()
+{
+    // The leases that we may wait for are only returned once their holders got the file lock for their current step
+    SwordFileUnlock fileUnlock;
+    ReloadableSwordMgr* mgr = 0;
+
+    {
+        unique_lock<mutex> lock(this->_poolMutex);
+
+        while (this->_idleMgrs.size() == 0 &&
+               (this->_mgrGenerations.size() + this->_pendingCreations) >= this->_maxSize) {
+            this->_mgrReturned.wait(lock);
+        }
+
+        if (this->_idleMgrs.size() > 0) {
+            mgr = this->_idleMgrs.back();
+            this->_idleMgrs.pop_back();
+        } else {
+            // Reserve the slot before creating the SWMgr outside of the lock, since this may take a while.
+            this->_pendingCreations++;
+        }
+    }
+
+    if (mgr == 0) {
+        ReloadableSwordMgr* newMgr = 0;
+
+        {
+            // Loading the configuration of the new instance goes through the FileMgr
+            SwordFileLock fileLock;
+            newMgr = this->_mgrFactory();
+        }
+
+        lock_guard<mutex> lock(this->_poolMutex);
+        this->_pendingCreations--;
+        this->_mgrGenerations[newMgr] = this->_generation;
+        mgr = newMgr;
+    }
+
+    return SwordMgrLease(this, mgr);
+}
+
+void SwordMgrPool::release(ReloadableSwordMgr* mgr)
+{
+    vector<ReloadableSwordMgr*> discardedMgrs;
+
+    {
+        lock_guard<mutex> lock(this->_poolMutex);
+
+        map<ReloadableSwordMgr*, unsigned int>::iterator it = this->_mgrGenerations.find(mgr);
+        if (it == this->_mgrGenerations.end()) {
+            cerr << "SwordMgrPool::release: SWMgr does not belong to this pool!" << endl;
+            return;
+        }
+
+        if (it->second != this->_generation) {
+            // The module set changed while this instance was leased, so we do not recycle it.
+            this->discardMgr(mgr, discardedMgrs);
+        } else {
+            this->_idleMgrs.push_back(mgr);
+        }
+    }
+
+    this->_mgrReturned.notify_one();
+    this->deleteMgrs(discardedMgrs);
+}
+
+void SwordMgrPool::invalidate()
+{
+    vector<ReloadableSwordMgr*> discardedMgrs;
+
+    {
+        lock_guard<mutex> lock(this->_poolMutex);
+        this->_generation++;
+
+        for (unsigned int i = 0; i < this->_idleMgrs.size(); i++) {
+            this->discardMgr(this->_idleMgrs[i], discardedMgrs);
+        }
+
+        this->_idleMgrs.clear();
+    }
+
+    this->_mgrReturned.notify_all();
+    this->deleteMgrs(discardedMgrs);
+}
+
+unsigned int SwordMgrPool::getMaxSize()
+{
+    return this->_maxSize;
+}
+
+unsigned int SwordMgrPool::getSize()
+{
+    lock_guard<mutex> lock(this->_poolMutex);
+    return (unsigned int)this->_mgrGenerations.size() + this->_pendingCreations;
+}
+
+void SwordMgrPool::discardMgr(ReloadableSwordMgr* mgr, vector<ReloadableSwordMgr*>& discardedMgrs)
+{
+    // Must be called with _poolMutex held
+    this->_mgrGenerations.erase(mgr);
+    discardedMgrs.push_back(mgr);
+}
+
+void SwordMgrPool::deleteMgrs(vector<ReloadableSwordMgr*>& discardedMgrs)
+{
+    if (discardedMgrs.size() == 0) {
+        return;
+    }
+
+    // Must be called without _poolMutex, since the SwordFileLock comes first in the lock order.
+    // Deleting the SWMgr closes the module files.
+    SwordFileLock fileLock;
+
+    for (unsigned int i = 0; i < discardedMgrs.size(); i++) {
+        delete discardedMgrs[i];
+    }
+
+    discardedMgrs.clear();
+}
@@ -0,0 +1,98 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef _SWORD_MGR_POOL
+#define _SWORD_MGR_POOL
+
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+
+namespace sword {
+    class SWModule;
+};
+
+class ReloadableSwordMgr;
+class SwordMgrPool;
+
+/**
+ * A SwordMgrLease gives the holder exclusive access to one SWMgr of a SwordMgrPool.
+ * Since every read changes the cursor of the SWModule being read, each concurrent reader needs its own lease.
+ * The SWMgr is handed back to the pool when the lease goes out of scope.
+ * getModule creates the driver of a deferred module on first access, so use it instead of SWMgr::getModule.
+ */
+class SwordMgrLease
+{
+public:
+    SwordMgrLease(SwordMgrPool* pool, ReloadableSwordMgr* mgr);
+    SwordMgrLease(SwordMgrLease&& other);
+    ~SwordMgrLease();
+
+    ReloadableSwordMgr* getMgr();
+    sword::SWModule* getModule(std::string moduleName);
+    void release();
+
+private:
+    SwordMgrLease(const SwordMgrLease&);
+    SwordMgrLease& operator=(const SwordMgrLease&);
+
+    SwordMgrPool* _pool;
+    ReloadableSwordMgr* _mgr;
+};
+
+/**
+ * A bounded pool of ReloadableSwordMgr instances. Instances are created lazily via the given factory function
+ * and recycled when a lease is released. If all instances are leased, acquire() blocks until one is returned.
+ * Instances are created and deleted under the SwordFileLock, but never while holding the pool mutex.
+ */
+class SwordMgrPool
+{
+public:
+    SwordMgrPool(std::function<ReloadableSwordMgr*()> mgrFactory, unsigned int maxSize=0);
+    virtual ~SwordMgrPool();
+
+    SwordMgrLease acquire();
+    void release(ReloadableSwordMgr* mgr);
+
+    // Discards all idle instances. Leased instances are discarded when they are returned.
+    // This needs to be called whenever the set of installed modules changes.
+    void invalidate();
+
+    unsigned int getMaxSize();
+    unsigned int getSize();
+
+private:
+    void discardMgr(ReloadableSwordMgr* mgr, std::vector<ReloadableSwordMgr*>& discardedMgrs);
+    void deleteMgrs(std::vector<ReloadableSwordMgr*>& discardedMgrs);
+
+    std::function<ReloadableSwordMgr*()> _mgrFactory;
+    unsigned int _maxSize;
+    unsigned int _generation = 0;
+    unsigned int _pendingCreations = 0;
+
+    std::vector<ReloadableSwordMgr*> _idleMgrs;
+    std::map<ReloadableSwordMgr*, unsigned int> _mgrGenerations;
+
+    std::mutex _poolMutex;
+    std::condition_variable _mgrReturned;
+};
+
+#endif // _SWORD_MGR_POOL
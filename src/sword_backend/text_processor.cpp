@@ -21,6 +21,7 @@
 #include <string>
 #include <regex>
 #include <iomanip>
+#include <cctype>
 
 #if defined(__APPLE__)
 #include <TargetConditionals.h>
@@ -39,12 +40,15 @@
 #include "module_helper.hpp"
 #include "string_helper.hpp"
 #include "strongs_entry.hpp"
+#include "strongs_table.hpp"
+#include "versification_mapping.hpp"
+#include "sword_file_lock.hpp"
 
 using namespace std;
 using namespace sword;
 
-TextProcessor::TextProcessor(ModuleStore& moduleStore, ModuleHelper& moduleHelper)
-    : _moduleStore(moduleStore), _moduleHelper(moduleHelper)
+TextProcessor::TextProcessor(ModuleStore& moduleStore, ModuleHelper& moduleHelper, StrongsTableCache& strongsTableCache)
+    : _moduleStore(moduleStore), _moduleHelper(moduleHelper), _strongsTableCache(strongsTableCache)
 {
     this->_markupEnabled = false;
     this->_strongsWithNbspEnabled = false;
@@ -320,7 +324,12 @@ string TextProcessor::getCurrentVerseText(sword::SWModule* module, bool hasStron
         int currentChapter = currentVerseKey.getChapter();
         int currentVerseNr = currentVerseKey.getVerse();
         
-        verseText = string(module->getRawEntry());
+        {
+            // Only the read needs the file lock, the filtering below may run in parallel with other readers
+            SwordFileLock fileLock;
+            verseText = string(module->getRawEntry());
+        }
+
         StringHelper::trim(verseText);
         filteredText = verseText;
 
@@ -328,7 +337,11 @@ string TextProcessor::getCurrentVerseText(sword::SWModule* module, bool hasStron
             filteredText = this->getFilteredText(verseText, currentChapter, currentVerseNr, hasStrongs, hasInconsistentClosingEndDivs, moduleFileUrl, hasThMLVariants);
         }
     } else {
-        verseText = string(module->stripText());
+        {
+            SwordFileLock fileLock;
+            verseText = string(module->stripText());
+        }
+
         StringHelper::trim(verseText);
         filteredText = verseText;
     }
@@ -343,12 +356,16 @@ vector<Verse> TextProcessor::getBibleText(string moduleName)
 
 Verse TextProcessor::getReferenceText(std::string moduleName, std::string reference)
 {
-    SWModule* module = this->_moduleStore.getLocalModule(moduleName);
+    return this->getReferenceText(this->_moduleStore.getLocalModule(moduleName), reference);
+}
+
+Verse TextProcessor::getReferenceText(SWModule* module, std::string reference)
+{
     module->setKey(reference.c_str());
     bool entryExisting = module->hasEntry(module->getKey());
 
     if (entryExisting) {
-        vector<Verse> verses = this->getText(moduleName, reference, QueryLimit::book, -1, 1);
+        vector<Verse> verses = this->getText(module, reference, QueryLimit::book, -1, 1);
         verses[0].absoluteVerseNumber = -1;
         return verses[0];
     } else {
@@ -369,6 +386,15 @@ vector<Verse> TextProcessor::getBookText(string moduleName, string bookCode, int
     return this->getText(moduleName, key.str(), QueryLimit::book, startVerseNumber, verseCount);
 }
 
+vector<Verse> TextProcessor::getBookText(SWModule* module, string bookCode, int startVerseNumber, int verseCount)
+{
+    stringstream key;
+    key << bookCode;
+    key << " 1:1";
+
+    return this->getText(module, key.str(), QueryLimit::book, startVerseNumber, verseCount);
+}
+
 vector<Verse> TextProcessor::getChapterText(string moduleName, string bookCode, int chapter)
 {
     stringstream key;
@@ -377,6 +403,14 @@ vector<Verse> TextProcessor::getChapterText(string moduleName, string bookCode,
     return this->getText(moduleName, key.str(), QueryLimit::chapter);
 }
 
+vector<Verse> TextProcessor::getChapterText(SWModule* module, string bookCode, int chapter)
+{
+    stringstream key;
+    key << bookCode << " " << chapter << ":1";
+
+    return this->getText(module, key.str(), QueryLimit::chapter);
+}
+
 string TextProcessor::getBookFromReference(string reference)
 {
     VerseKey key(reference.c_str());
@@ -400,9 +434,14 @@ vector<string> TextProcessor::getBookListFromReferences(vector<string>& referenc
 }
 
 vector<Verse> TextProcessor::getVersesFromReferences(string moduleName, vector<string>& references)
+{
+    return this->getVersesFromReferences(this->_moduleStore.getLocalModule(moduleName), references);
+}
+
+vector<Verse> TextProcessor::getVersesFromReferences(SWModule* module, vector<string>& references)
 {
     vector<Verse> verses;
-    SWModule* module = this->_moduleStore.getLocalModule(moduleName);
+    string moduleName = string(module->getName());
     vector<string> bookList = this->getBookListFromReferences(references);
     map<string, int> absoluteVerseNumbers = this->_moduleHelper.getAbsoluteVerseNumberMap(module, bookList);
     bool moduleMarkupIsBroken = this->_moduleHelper.isBrokenMarkupModule(moduleName);
@@ -452,6 +491,18 @@ vector<string> TextProcessor::getReferencesFromReferenceRange(std::string refere
 vector<Verse> TextProcessor::getText(string moduleName, string key, QueryLimit queryLimit, int startVerseNumber, int verseCount)
 {
     SWModule* module = this->_moduleStore.getLocalModule(moduleName);
+
+    if (module == 0) {
+        cerr << "getLocalModule returned zero pointer for " << moduleName << endl;
+        return vector<Verse>();
+    }
+
+    return this->getText(module, key, queryLimit, startVerseNumber, verseCount);
+}
+
+vector<Verse> TextProcessor::getText(SWModule* module, string key, QueryLimit queryLimit, int startVerseNumber, int verseCount)
+{
+    string moduleName = string(module->getName());
     string lastKey;
     int index = 0;
     string lastBookName = "";
@@ -463,85 +514,81 @@ vector<Verse> TextProcessor::getText(string moduleName, string key, QueryLimit q
     // This holds the text that we will return
     vector<Verse> text;
 
-    if (module == 0) {
-        cerr << "getLocalModule returned zero pointer for " << moduleName << endl;
-    } else {
-        bool hasStrongs = this->_moduleHelper.moduleHasGlobalOption(module, "Strongs");
-        bool hasThMLVariants = this->_moduleHelper.moduleHasGlobalOption(module, "ThMLVariants");
+    bool hasStrongs = this->_moduleHelper.moduleHasGlobalOption(module, "Strongs");
+    bool hasThMLVariants = this->_moduleHelper.moduleHasGlobalOption(module, "ThMLVariants");
 
-        // Compute file URL once for the entire module
-        string moduleFileUrl = this->getFileUrl(this->_moduleStore.getModuleDataPath(module));
+    // Compute file URL once for the entire module
+    string moduleFileUrl = this->getFileUrl(this->_moduleStore.getModuleDataPath(module));
 
-        module->setKey(key.c_str());
+    module->setKey(key.c_str());
 
-        if (startVerseNumber >= 1) {
-          module->increment(startVerseNumber - 1);
-        } else {
-          startVerseNumber = 1;
+    if (startVerseNumber >= 1) {
+      module->increment(startVerseNumber - 1);
+    } else {
+      startVerseNumber = 1;
+    }
+    
+    for (;;) {
+        VerseKey currentVerseKey(module->getKey());
+        string currentBookName(currentVerseKey.getBookAbbrev());
+        int currentChapter = currentVerseKey.getChapter();
+        bool firstVerseInBook = false;
+        bool firstVerseInChapter = (currentVerseKey.getVerse() == 1);
+        string verseText = "";
+        string currentKey(module->getKey()->getShortText());
+
+        // Stop, once the newly read key is the same as the previously read key
+        if (currentKey == lastKey) { break; }
+        // Stop, once the newly ready key is a different book than the previously read key
+        if (queryLimit == QueryLimit::book && (index > 0) && (currentBookName != lastBookName)) { break; }
+        // Stop, once the newly ready key is a different chapter than the previously read key
+        if (queryLimit == QueryLimit::chapter && (index > 0) && (currentChapter != lastChapter)) { break; }
+        // Stop once the maximum number of verses is reached
+        if (startVerseNumber >= 1 && verseCount >= 1 && (index == verseCount)) { break; }
+
+        if (currentBookName != lastBookName) {
+            currentBookExisting = true;
+            firstVerseInBook = true;
         }
-        
-        for (;;) {
-            VerseKey currentVerseKey(module->getKey());
-            string currentBookName(currentVerseKey.getBookAbbrev());
-            int currentChapter = currentVerseKey.getChapter();
-            bool firstVerseInBook = false;
-            bool firstVerseInChapter = (currentVerseKey.getVerse() == 1);
-            string verseText = "";
-            string currentKey(module->getKey()->getShortText());
-
-            // Stop, once the newly read key is the same as the previously read key
-            if (currentKey == lastKey) { break; }
-            // Stop, once the newly ready key is a different book than the previously read key
-            if (queryLimit == QueryLimit::book && (index > 0) && (currentBookName != lastBookName)) { break; }
-            // Stop, once the newly ready key is a different chapter than the previously read key
-            if (queryLimit == QueryLimit::chapter && (index > 0) && (currentChapter != lastChapter)) { break; }
-            // Stop once the maximum number of verses is reached
-            if (startVerseNumber >= 1 && verseCount >= 1 && (index == verseCount)) { break; }
-
-            if (currentBookName != lastBookName) {
-                currentBookExisting = true;
-                firstVerseInBook = true;
-            }
 
-            // Chapter heading
-            // We only add it when we're looking at the first verse of a chapter
-            // and if the module markup is not broken
-            // and if the requested verse count is more than one or the default (-1 / all verses).
-            if (firstVerseInChapter && !moduleMarkupIsBroken && (verseCount > 1 || verseCount == -1)) {
-                string chapterHeading = this->getCurrentChapterHeading(module, moduleFileUrl, hasThMLVariants);
-                verseText += chapterHeading;
-            }
-            
-            // Current verse text
-            verseText += this->getCurrentVerseText(module,
-                                                   hasStrongs,
-                                                   hasInconsistentClosingEndDivs,
-                                                   // Note that if markup is broken this will enforce
-                                                   // the usage of the "stripped" / non-markup variant of the text
-                                                   moduleMarkupIsBroken,
-                                                   moduleFileUrl,
-                                                   hasThMLVariants);
-
-            // If the current verse does not have any content and if it is the first verse in this book
-            // we assume that the book is not existing.
-            if (verseText.length() == 0 && firstVerseInBook) { currentBookExisting = false; }
-
-            if (currentBookExisting) {
-                Verse currentVerse;
-                currentVerse.reference = module->getKey()->getShortText();
-                currentVerse.absoluteVerseNumber = startVerseNumber + index;
-                currentVerse.content = verseText;
-                text.push_back(currentVerse);
-            }
-
-            lastKey = currentKey;
-            lastBookName = currentBookName;
-            lastChapter = currentChapter;
-            
-            module->increment();
-            
-            index++;
+        // Chapter heading
+        // We only add it when we're looking at the first verse of a chapter
+        // and if the module markup is not broken
+        // and if the requested verse count is more than one or the default (-1 / all verses).
+        if (firstVerseInChapter && !moduleMarkupIsBroken && (verseCount > 1 || verseCount == -1)) {
+            string chapterHeading = this->getCurrentChapterHeading(module, moduleFileUrl, hasThMLVariants);
+            verseText += chapterHeading;
+        }
+        
+        // Current verse text
+        verseText += this->getCurrentVerseText(module,
+                                               hasStrongs,
+                                               hasInconsistentClosingEndDivs,
+                                               // Note that if markup is broken this will enforce
+                                               // the usage of the "stripped" / non-markup variant of the text
+                                               moduleMarkupIsBroken,
+                                               moduleFileUrl,
+                                               hasThMLVariants);
+
+        // If the current verse does not have any content and if it is the first verse in this book
+        // we assume that the book is not existing.
+        if (verseText.length() == 0 && firstVerseInBook) { currentBookExisting = false; }
+
+        if (currentBookExisting) {
+            Verse currentVerse;
+            currentVerse.reference = module->getKey()->getShortText();
+            currentVerse.absoluteVerseNumber = startVerseNumber + index;
+            currentVerse.content = verseText;
+            text.push_back(currentVerse);
         }
+
+        lastKey = currentKey;
+        lastBookName = currentBookName;
+        lastChapter = currentChapter;
+        
+        module->increment();
+        
+        index++;
     }
 
     return text;
@@ -549,74 +596,81 @@ vector<Verse> TextProcessor::getText(string moduleName, string key, QueryLimit q
 
 string TextProcessor::getBookIntroduction(string moduleName, string bookCode)
 {
-    string bookIntroText = "";
-    string filteredText = "";
     SWModule* module = this->_moduleStore.getLocalModule(moduleName);
 
     if (module == 0) {
         cerr << "getLocalModule returned zero pointer for " << moduleName << endl;
-    } else {
-        // Get module data path BEFORE manipulating the module key
-        string moduleDataPath = this->_moduleStore.getModuleDataPath(module);
-        string moduleFileUrl = this->getFileUrl(moduleDataPath);
+        return "";
+    }
 
-        module->setKeyText(bookCode.c_str());
-        
-        // Create a local VerseKey copy to avoid pointer invalidation issues
-        VerseKey verseKey = module->getKey();
+    return this->getBookIntroduction(module, bookCode);
+}
 
-        // Include chapter/book/testament/module intros
-        verseKey.setIntros(true);
-        
-        // Get book intro from chapter 0, verse 0
-        // This may contain testament intro for first books (Genesis, Matthew)
-        verseKey.setChapter(0);
-        verseKey.setVerse(0);
-        module->setKey(verseKey);
-
-        bookIntroText = string(module->getRawEntry());
-        StringHelper::trim(bookIntroText);
-
-        // Also fetch chapter 1:0 content and append it
-        // Many modules store book-level intro content (images, titles) in chapter 1:0
-        // We always include this to handle both cases:
-        // - Modules where 0:0 is empty and 1:0 has book intro
-        // - First books of testaments where 0:0 has testament intro and 1:0 has book intro
-        verseKey.setChapter(1);
-        verseKey.setVerse(0);
-        module->setKey(verseKey);
-
-        string chapter1Intro = string(module->getRawEntry());
-        StringHelper::trim(chapter1Intro);
-        
-        if (!chapter1Intro.empty()) {
-            if (!bookIntroText.empty()) {
-                bookIntroText += "\n";
-            }
-            bookIntroText += chapter1Intro;
-        }
+string TextProcessor::getBookIntroduction(SWModule* module, string bookCode)
+{
+    string bookIntroText = "";
+    string filteredText = "";
 
-        static regex titleStartElementFilter = regex("<title");
-        static regex titleEndElementFilter = regex("</title>");
-        static regex noteStartElementFilter = regex("<note");
-        static regex noteEndElementFilter = regex("</note>");
-        static regex headStartElementFilter = regex("<head");
-        static regex headEndElementFilter = regex("</head>");
-        static regex chapterDivFilter = regex("<div type=\"chapter\" n=\"[0-9]{1}\" id=\"[-A-Z0-9]{1,8}\">");
+    // Get module data path BEFORE manipulating the module key
+    string moduleDataPath = this->_moduleStore.getModuleDataPath(module);
+    string moduleFileUrl = this->getFileUrl(moduleDataPath);
 
-        filteredText = bookIntroText;
-        filteredText = regex_replace(filteredText, titleStartElementFilter, "<div class=\"sword-markup sword-book-title\"");
-        filteredText = regex_replace(filteredText, titleEndElementFilter, "</div>");
-        filteredText = regex_replace(filteredText, noteStartElementFilter, "<div class=\"sword-markup sword-note\"");
-        filteredText = regex_replace(filteredText, noteEndElementFilter, "</div>");
-        filteredText = regex_replace(filteredText, headStartElementFilter, "<div class=\"sword-markup sword-head\"");
-        filteredText = regex_replace(filteredText, headEndElementFilter, "</div>");
-        filteredText = regex_replace(filteredText, chapterDivFilter, "");
+    module->setKeyText(bookCode.c_str());
+    
+    // Create a local VerseKey copy to avoid pointer invalidation issues
+    VerseKey verseKey = module->getKey();
 
-        // Prefix img src attributes starting with "/" with the module file URL
-        this->processImageUrls(filteredText, moduleFileUrl);
+    // Include chapter/book/testament/module intros
+    verseKey.setIntros(true);
+    
+    // Get book intro from chapter 0, verse 0
+    // This may contain testament intro for first books (Genesis, Matthew)
+    verseKey.setChapter(0);
+    verseKey.setVerse(0);
+    module->setKey(verseKey);
+
+    bookIntroText = string(module->getRawEntry());
+    StringHelper::trim(bookIntroText);
+
+    // Also fetch chapter 1:0 content and append it
+    // Many modules store book-level intro content (images, titles) in chapter 1:0
+    // We always include this to handle both cases:
+    // - Modules where 0:0 is empty and 1:0 has book intro
+    // - First books of testaments where 0:0 has testament intro and 1:0 has book intro
+    verseKey.setChapter(1);
+    verseKey.setVerse(0);
+    module->setKey(verseKey);
+
+    string chapter1Intro = string(module->getRawEntry());
+    StringHelper::trim(chapter1Intro);
+    
+    if (!chapter1Intro.empty()) {
+        if (!bookIntroText.empty()) {
+            bookIntroText += "\n";
+        }
+        bookIntroText += chapter1Intro;
     }
 
+    static regex titleStartElementFilter = regex("<title");
+    static regex titleEndElementFilter = regex("</title>");
+    static regex noteStartElementFilter = regex("<note");
+    static regex noteEndElementFilter = regex("</note>");
+    static regex headStartElementFilter = regex("<head");
+    static regex headEndElementFilter = regex("</head>");
+    static regex chapterDivFilter = regex("<div type=\"chapter\" n=\"[0-9]{1}\" id=\"[-A-Z0-9]{1,8}\">");
+
+    filteredText = bookIntroText;
+    filteredText = regex_replace(filteredText, titleStartElementFilter, "<div class=\"sword-markup sword-book-title\"");
+    filteredText = regex_replace(filteredText, titleEndElementFilter, "</div>");
+    filteredText = regex_replace(filteredText, noteStartElementFilter, "<div class=\"sword-markup sword-note\"");
+    filteredText = regex_replace(filteredText, noteEndElementFilter, "</div>");
+    filteredText = regex_replace(filteredText, headStartElementFilter, "<div class=\"sword-markup sword-head\"");
+    filteredText = regex_replace(filteredText, headEndElementFilter, "</div>");
+    filteredText = regex_replace(filteredText, chapterDivFilter, "");
+
+    // Prefix img src attributes starting with "/" with the module file URL
+    this->processImageUrls(filteredText, moduleFileUrl);
+
     return filteredText;
 }
 
@@ -712,14 +766,13 @@ bool TextProcessor::isModuleReadable(sword::SWModule* module, std::string key)
     return verseText.size() > 0;
 }
 
-StrongsEntry* TextProcessor::getStrongsEntry(string key)
+SWModule* TextProcessor::getStrongsModule(char dictionary)
 {
     SWModule* module = 0;
-    char strongsType = key[0];
 
-    if (strongsType == 'H') {
+    if (dictionary == 'H') {
         module = this->_moduleStore.getLocalModule("StrongsHebrew");
-    } else if (strongsType == 'G') {
+    } else if (dictionary == 'G') {
         module = this->_moduleStore.getLocalModule("StrongsGreek");
     } else {
         return 0;
@@ -727,13 +780,222 @@ StrongsEntry* TextProcessor::getStrongsEntry(string key)
 
     if (module == 0) {
         cerr << "No valid Strong's module available!" << endl;
+    }
+
+    return module;
+}
+
+StrongsEntry* TextProcessor::getStrongsEntry(string key)
+{
+    char strongsType = key[0];
+    SWModule* module = this->getStrongsModule(strongsType);
+
+    if (module == 0) {
         return 0;
     }
 
+    if (!StrongsEntry::isValidStrongsKey(key)) {
+        return 0;
+    }
+
+    shared_ptr<StrongsTable> strongsTable = this->_strongsTableCache.getTable(module, strongsType);
+
+    if (strongsTable) {
+        StrongsEntry* entry = strongsTable->getStrongsEntry(key);
+        if (entry != 0) {
+            return entry;
+        }
+    }
+
+    // Fall back to parsing the entry if the table is not available
     StrongsEntry* entry = StrongsEntry::getStrongsEntry(module, key);
     return entry;
 }
 
+vector<StrongsEntry*> TextProcessor::getStrongsEntries(const vector<string>& keys)
+{
+    vector<StrongsEntry*> entries;
+    set<string> knownKeys;
+
+    // The module and the table are only resolved once per dictionary
+    SWModule* modules[2] = { 0, 0 };
+    shared_ptr<StrongsTable> strongsTables[2];
+    bool resolved[2] = { false, false };
+
+    for (unsigned int i = 0; i < keys.size(); i++) {
+        string key = StrongsEntry::getNormalizedStrongsKey(keys[i]);
+
+        if (!StrongsEntry::isValidStrongsKey(key) || !knownKeys.insert(key).second) {
+            continue;
+        }
+
+        char dictionary = key[0];
+        int dictionaryIndex = (dictionary == 'H') ? 0 : 1;
+
+        if (!resolved[dictionaryIndex]) {
+            modules[dictionaryIndex] = this->getStrongsModule(dictionary);
+
+            if (modules[dictionaryIndex] != 0) {
+                strongsTables[dictionaryIndex] = this->_strongsTableCache.getTable(modules[dictionaryIndex], dictionary);
+            }
+
+            resolved[dictionaryIndex] = true;
+        }
+
+        if (modules[dictionaryIndex] == 0) {
+            continue;
+        }
+
+        StrongsEntry* entry = 0;
+
+        if (strongsTables[dictionaryIndex]) {
+            entry = strongsTables[dictionaryIndex]->getStrongsEntry(key);
+        }
+
+        if (entry == 0) {
+            entry = StrongsEntry::getStrongsEntry(modules[dictionaryIndex], key);
+        }
+
+        if (entry != 0) {
+            entries.push_back(entry);
+        }
+    }
+
+    return entries;
+}
+
+vector<string> TextProcessor::getChapterStrongsKeys(string moduleName, string bookCode, int chapter)
+{
+    vector<string> strongsKeys;
+    set<string> knownKeys;
+    SWModule* module = this->_moduleStore.getLocalModule(moduleName);
+
+    if (module == 0) {
+        cerr << "getLocalModule returned zero pointer for " << moduleName << endl;
+        return strongsKeys;
+    }
+
+    stringstream key;
+    key << bookCode << " " << chapter << ":1";
+    module->setKey(key.str().c_str());
+
+    VerseKey startVerseKey(module->getKey());
+    char book = startVerseKey.getBook();
+    char markup = module->getMarkup();
+    char defaultPrefix = (startVerseKey.getTestament() == 1) ? 'H' : 'G';
+    string lastKey;
+
+    for (;;) {
+        VerseKey currentVerseKey(module->getKey());
+        string currentKey(module->getKey()->getShortText());
+
+        // Stop at the end of the module or once the key has left the chapter
+        if (currentKey == lastKey ||
+            currentVerseKey.getBook() != book ||
+            currentVerseKey.getChapter() != chapter) {
+            break;
+        }
+
+        // The lemmas are read from the raw entry, so the verse text does not need to be rendered or filtered
+        string verseText = string(module->getRawEntry());
+        this->addStrongsKeysFromText(verseText, markup, defaultPrefix, strongsKeys, knownKeys);
+
+        lastKey = currentKey;
+        module->increment();
+    }
+
+    return strongsKeys;
+}
+
+void TextProcessor::addStrongsKeysFromText(const string& text,
+                                           char markup,
+                                           char defaultPrefix,
+                                           vector<string>& strongsKeys,
+                                           set<string>& knownKeys)
+{
+    if (markup == FMT_GBF) {
+        // A Strong's number follows a word as a tag of its own, like <WH0853> or <WG2316>
+        static const string gbfPrefix = "<W";
+        size_t position = text.find(gbfPrefix);
+
+        while (position != string::npos) {
+            size_t keyStart = position + gbfPrefix.size();
+            size_t keyEnd = keyStart + 1;
+
+            if (keyStart < text.size() && (text[keyStart] == 'H' || text[keyStart] == 'G')) {
+                while (keyEnd < text.size() && isdigit((unsigned char)text[keyEnd])) {
+                    keyEnd++;
+                }
+
+                if (keyEnd > keyStart + 1) {
+                    this->addStrongsKey(text.substr(keyStart, keyEnd - keyStart), strongsKeys, knownKeys);
+                }
+            }
+
+            position = text.find(gbfPrefix, keyEnd);
+        }
+
+    } else if (markup == FMT_THML) {
+        // Like <sync type="Strongs" value="H1234"/>. Some modules omit the prefix, like <sync type="Strongs" value="1234"/>.
+        static const string syncStart = "<sync ";
+        static const string valueAttribute = "value=\"";
+        size_t position = text.find(syncStart);
+
+        while (position != string::npos) {
+            size_t tagEnd = text.find('>', position);
+            if (tagEnd == string::npos) {
+                break;
+            }
+
+            string syncTag = text.substr(position, tagEnd - position);
+            size_t valueStart = syncTag.find(valueAttribute);
+
+            if (syncTag.find("type=\"Strongs\"") != string::npos && valueStart != string::npos) {
+                valueStart += valueAttribute.size();
+                size_t valueEnd = syncTag.find('"', valueStart);
+                string value = syncTag.substr(valueStart, (valueEnd != string::npos) ? valueEnd - valueStart : string::npos);
+
+                if (!value.empty() && isdigit((unsigned char)value[0])) {
+                    value = string(1, defaultPrefix) + value;
+                }
+
+                this->addStrongsKey(value, strongsKeys, knownKeys);
+            }
+
+            position = text.find(syncStart, tagEnd);
+        }
+
+    } else {
+        // A lemma attribute may contain several keys, like lemma="strong:H0853 strong:H01254"
+        static const string strongsPrefix = "strong:";
+        size_t position = text.find(strongsPrefix);
+
+        while (position != string::npos) {
+            size_t keyStart = position + strongsPrefix.size();
+            size_t keyEnd = keyStart + 1;
+
+            while (keyEnd < text.size() && isdigit((unsigned char)text[keyEnd])) {
+                keyEnd++;
+            }
+
+            if (keyEnd > keyStart + 1) {
+                this->addStrongsKey(text.substr(keyStart, keyEnd - keyStart), strongsKeys, knownKeys);
+            }
+
+            position = text.find(strongsPrefix, keyEnd);
+        }
+    }
+}
+
+void TextProcessor::addStrongsKey(const string& key, vector<string>& strongsKeys, set<string>& knownKeys)
+{
+    string strongsKey = StrongsEntry::getNormalizedStrongsKey(key);
+
+    if (StrongsEntry::isValidStrongsKey(strongsKey) && knownKeys.insert(strongsKey).second) {
+        strongsKeys.push_back(strongsKey);
+    }
+}
+
 unsigned int TextProcessor::findAndReplaceAll(std::string & data, std::string toSearch, std::string replaceStr)
 {
     unsigned int count = 0;
@@ -923,65 +1185,128 @@ void TextProcessor::removePbElementsWithSpace(std::string& data)
     }
 }
 
-string TextProcessor::mapVerseReference(string sourceOsisRef, string sourceModuleName, string targetModuleName, bool allowRange)
+string TextProcessor::getModuleVersification(string moduleName)
 {
-    // Look up both modules to read their versification systems
-    SWModule* sourceModule = this->_moduleStore.getLocalModule(sourceModuleName);
-    SWModule* targetModule = this->_moduleStore.getLocalModule(targetModuleName);
+    return this->getModuleVersification(this->_moduleStore.getLocalModule(moduleName));
+}
 
-    // Determine versification system names (default to KJV if not specified)
-    string sourceV11n = "KJV";
-    string targetV11n = "KJV";
+string TextProcessor::getModuleVersification(SWModule* module)
+{
+    // Default to KJV if not specified
+    string v11n = "KJV";
 
-    if (sourceModule != 0) {
-        const char* v11nEntry = sourceModule->getConfigEntry("Versification");
+    if (module != 0) {
+        const char* v11nEntry = module->getConfigEntry("Versification");
         if (v11nEntry != 0) {
-            sourceV11n = v11nEntry;
+            v11n = v11nEntry;
         }
     }
 
-    if (targetModule != 0) {
-        const char* v11nEntry = targetModule->getConfigEntry("Versification");
-        if (v11nEntry != 0) {
-            targetV11n = v11nEntry;
-        }
+    return v11n;
+}
+
+shared_ptr<VersificationMappingTable> TextProcessor::getMappingTable(string sourceV11n, string targetV11n)
+{
+    lock_guard<mutex> lock(this->_mappingTablesMutex);
+
+    string mappingKey = sourceV11n + "\n" + targetV11n;
+    auto existingTable = this->_mappingTables.find(mappingKey);
+
+    if (existingTable != this->_mappingTables.end()) {
+        return existingTable->second;
     }
 
-    // If both modules use the same versification, no mapping is needed
-    if (sourceV11n == targetV11n) {
-        return sourceOsisRef;
+    shared_ptr<VersificationMappingTable> mappingTable = make_shared<VersificationMappingTable>(sourceV11n, targetV11n);
+
+    // Unknown versification systems are cached as a null table
+    if (!mappingTable->build()) {
+        mappingTable.reset();
     }
 
-    // Get the versification systems from VersificationMgr
-    VersificationMgr* vMgr = VersificationMgr::getSystemVersificationMgr();
-    const VersificationMgr::System* sourceSys = vMgr->getVersificationSystem(sourceV11n.c_str());
-    const VersificationMgr::System* targetSys = vMgr->getVersificationSystem(targetV11n.c_str());
+    this->_mappingTables[mappingKey] = mappingTable;
+    return mappingTable;
+}
+
+string TextProcessor::mapVerseReference(string sourceOsisRef, string sourceModuleName, string targetModuleName, bool allowRange)
+{
+    vector<string> sourceOsisRefs = { sourceOsisRef };
+    return this->mapVerseReferences(sourceOsisRefs, sourceModuleName, targetModuleName, allowRange)[0];
+}
+
+string TextProcessor::mapVerseReference(string sourceOsisRef, SWModule* sourceModule, SWModule* targetModule, bool allowRange)
+{
+    vector<string> sourceOsisRefs = { sourceOsisRef };
+    return this->mapVerseReferencesByVersification(sourceOsisRefs,
+                                                   this->getModuleVersification(sourceModule),
+                                                   this->getModuleVersification(targetModule),
+                                                   allowRange)[0];
+}
 
-    if (sourceSys == 0 || targetSys == 0) {
-        return sourceOsisRef;
+vector<string> TextProcessor::mapVerseReferences(const vector<string>& sourceOsisRefs, string sourceModuleName, string targetModuleName, bool allowRange)
+{
+    return this->mapVerseReferencesByVersification(sourceOsisRefs,
+                                                   this->getModuleVersification(sourceModuleName),
+                                                   this->getModuleVersification(targetModuleName),
+                                                   allowRange);
+}
+
+vector<string> TextProcessor::mapVerseReferencesByVersification(const vector<string>& sourceOsisRefs,
+                                                                 const string& sourceV11n,
+                                                                 const string& targetV11n,
+                                                                 bool allowRange)
+{
+    // If both modules use the same versification or one of the systems is unknown, no mapping is needed
+    shared_ptr<VersificationMappingTable> mappingTable;
+
+    if (sourceV11n != targetV11n) {
+        mappingTable = this->getMappingTable(sourceV11n, targetV11n);
+    }
+
+    if (!mappingTable) {
+        return sourceOsisRefs;
     }
 
-    // Parse the source OSIS reference using a VerseKey with the source versification
-    VerseKey sourceKey;
-    sourceKey.setVersificationSystem(sourceV11n.c_str());
-    sourceKey.setText(sourceOsisRef.c_str());
+    vector<string> targetOsisRefs;
+    targetOsisRefs.reserve(sourceOsisRefs.size());
 
-    // Extract the components for translateVerse
-    const char* book = sourceKey.getOSISBookName();
-    int chapter = sourceKey.getChapter();
-    int verse = sourceKey.getVerse();
-    int verseEnd = verse;
+    for (unsigned int i = 0; i < sourceOsisRefs.size(); i++) {
+        targetOsisRefs.push_back(mappingTable->mapReference(sourceOsisRefs[i], allowRange));
+    }
 
-    // Perform the mapping
-    sourceSys->translateVerse(targetSys, &book, &chapter, &verse, &verseEnd);
+    return targetOsisRefs;
+}
+
+vector<pair<string, string>> TextProcessor::mapChapterVerseReferences(string sourceModuleName,
+                                                                      string targetModuleName,
+                                                                      string bookCode,
+                                                                      int chapter,
+                                                                      bool allowRange)
+{
+    vector<pair<string, string>> chapterMapping;
+    string sourceV11n = this->getModuleVersification(sourceModuleName);
+
+    // The verses of the chapter are taken from the source versification
+    const VersificationMgr::System* sourceSys = VersificationMgr::getSystemVersificationMgr()->getVersificationSystem(sourceV11n.c_str());
+    int bookNumber = (sourceSys != 0) ? sourceSys->getBookNumberByOSISName(bookCode.c_str()) : -1;
+
+    if (bookNumber < 0) {
+        return chapterMapping;
+    }
+
+    int verseCount = sourceSys->getBook(bookNumber)->getVerseMax(chapter);
+    vector<string> sourceOsisRefs;
+
+    for (int verse = 1; verse <= verseCount; verse++) {
+        stringstream sourceOsisRef;
+        sourceOsisRef << bookCode << "." << chapter << "." << verse;
+        sourceOsisRefs.push_back(sourceOsisRef.str());
+    }
 
-    // Build the mapped OSIS reference
-    stringstream result;
-    result << book << "." << chapter << "." << verse;
+    vector<string> targetOsisRefs = this->mapVerseReferences(sourceOsisRefs, sourceModuleName, targetModuleName, allowRange);
 
-    if (allowRange && verseEnd > verse) {
-        result << "-" << book << "." << chapter << "." << verseEnd;
+    for (unsigned int i = 0; i < sourceOsisRefs.size(); i++) {
+        chapterMapping.push_back(make_pair(sourceOsisRefs[i], targetOsisRefs[i]));
     }
 
-    return result.str();
+    return chapterMapping;
 }
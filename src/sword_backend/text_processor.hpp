@@ -19,6 +19,11 @@
 #ifndef _TEXT_PROCESSOR
 #define _TEXT_PROCESSOR
 
+#include <map>
+#include <set>
+#include <memory>
+#include <mutex>
+
 #include "common_defs.hpp"
 
 namespace sword {
@@ -28,11 +33,14 @@ namespace sword {
 class ModuleStore;
 class ModuleHelper;
 class StrongsEntry;
+class StrongsTable;
+class StrongsTableCache;
+class VersificationMappingTable;
 
 class TextProcessor
 {
 public:
-    TextProcessor(ModuleStore& moduleStore, ModuleHelper& moduleHelper);
+    TextProcessor(ModuleStore& moduleStore, ModuleHelper& moduleHelper, StrongsTableCache& strongsTableCache);
     virtual ~TextProcessor() {}
 
     void enableMarkup() { this->_markupEnabled = true; }
@@ -49,8 +57,22 @@ public:
     std::string getCurrentVerseText(sword::SWModule* module, bool hasStrongs, bool hasInconsistentClosingEndDivs=false, bool forceNoMarkup=false);
     std::string getBookIntroduction(std::string moduleName, std::string bookCode);
 
+    // Variants for callers that have already resolved the module (e.g. the BatchRequestProcessor)
+    Verse getReferenceText(sword::SWModule* module, std::string reference);
+    std::vector<Verse> getBookText(sword::SWModule* module, std::string bookCode, int startVerseNumber=-1, int verseCount=-1);
+    std::vector<Verse> getChapterText(sword::SWModule* module, std::string bookCode, int chapter);
+    std::vector<Verse> getVersesFromReferences(sword::SWModule* module, std::vector<std::string>& references);
+    std::string getBookIntroduction(sword::SWModule* module, std::string bookCode);
+
     StrongsEntry* getStrongsEntry(std::string key);
 
+    // Returns the entries for the given keys. Duplicate and invalid keys are skipped and the keys of the returned
+    // entries are normalized (see StrongsEntry::getNormalizedStrongsKey). The caller takes ownership of the entries.
+    std::vector<StrongsEntry*> getStrongsEntries(const std::vector<std::string>& keys);
+
+    // Returns the normalized, distinct Strong's keys of the lemmas of a chapter in the order of their first occurrence
+    std::vector<std::string> getChapterStrongsKeys(std::string moduleName, std::string bookCode, int chapter);
+
     void processImageUrls(std::string& text, const std::string& moduleFileUrl);
     void processImageUrls(std::string& text, sword::SWModule* module);
 
@@ -60,6 +82,20 @@ public:
     bool isModuleReadable(sword::SWModule* module, std::string key="John 1:1");
 
     std::string mapVerseReference(std::string sourceOsisRef, std::string sourceModuleName, std::string targetModuleName, bool allowRange = false);
+    std::string mapVerseReference(std::string sourceOsisRef, sword::SWModule* sourceModule, sword::SWModule* targetModule, bool allowRange = false);
+
+    // Maps several references at once. The mapping table of the two versification systems is built on first use.
+    std::vector<std::string> mapVerseReferences(const std::vector<std::string>& sourceOsisRefs,
+                                                std::string sourceModuleName,
+                                                std::string targetModuleName,
+                                                bool allowRange = false);
+
+    // Maps all verses of a chapter of the source module and returns pairs of source and target references
+    std::vector<std::pair<std::string, std::string>> mapChapterVerseReferences(std::string sourceModuleName,
+                                                                               std::string targetModuleName,
+                                                                               std::string bookCode,
+                                                                               int chapter,
+                                                                               bool allowRange = false);
 
 private:
     std::vector<Verse> getText(std::string moduleName,
@@ -68,6 +104,12 @@ private:
                                int startVerseNr=-1,
                                int verseCount=-1);
 
+    std::vector<Verse> getText(sword::SWModule* module,
+                               std::string key,
+                               QueryLimit queryLimit=QueryLimit::none,
+                               int startVerseNr=-1,
+                               int verseCount=-1);
+
     std::string getCurrentChapterHeading(sword::SWModule* module, const std::string& moduleFileUrl, bool hasThMLVariants);
     std::string getCurrentVerseText(sword::SWModule* module, bool hasStrongs, bool hasInconsistentClosingEndDivs, bool forceNoMarkup, const std::string& moduleFileUrl, bool hasThMLVariants);
     std::string getFilteredText(const std::string& text, int chapter, int verseNr, bool hasStrongs, bool hasInconsistentClosingEndDivs, const std::string& moduleFileUrl, bool hasThMLVariants);
@@ -85,14 +127,35 @@ private:
     void normalizeVariantClasses(std::string& data);
     void removePbElementsWithSpace(std::string& data);
 
+    sword::SWModule* getStrongsModule(char dictionary);
+    // Supports the Strong's markup of OSIS (lemma="strong:H1234"), GBF (<WH1234>) and ThML (<sync type="Strongs" value="H1234"/>).
+    // ThML values without H/G prefix get the given default prefix.
+    void addStrongsKeysFromText(const std::string& text,
+                                char markup,
+                                char defaultPrefix,
+                                std::vector<std::string>& strongsKeys,
+                                std::set<std::string>& knownKeys);
+    void addStrongsKey(const std::string& key, std::vector<std::string>& strongsKeys, std::set<std::string>& knownKeys);
+
+    std::string getModuleVersification(std::string moduleName);
+    std::string getModuleVersification(sword::SWModule* module);
+    std::vector<std::string> mapVerseReferencesByVersification(const std::vector<std::string>& sourceOsisRefs,
+                                                               const std::string& sourceV11n,
+                                                               const std::string& targetV11n,
+                                                               bool allowRange);
+    std::shared_ptr<VersificationMappingTable> getMappingTable(std::string sourceV11n, std::string targetV11n);
+
     std::string getBookFromReference(std::string reference);
     std::vector<std::string> getBookListFromReferences(std::vector<std::string>& references);
 
     ModuleStore& _moduleStore;
     ModuleHelper& _moduleHelper;
+    StrongsTableCache& _strongsTableCache;
     bool _markupEnabled;
     bool _rawMarkupEnabled;
     bool _strongsWithNbspEnabled;
+    std::map<std::string, std::shared_ptr<VersificationMappingTable>> _mappingTables;
+    std::mutex _mappingTablesMutex;
 };
 
 #endif // _TEXT_PROCESSOR
\ No newline at end of file
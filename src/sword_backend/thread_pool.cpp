@@ -0,0 +1,296 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+// Std includes
+#include <iostream>
+#include <iterator>
+
+// Own includes
+#include "thread_pool.hpp"
+
+using namespace std;
+
+// Index of the current worker within its pool, -1 for threads that do not belong to a pool
+static thread_local int currentWorkerIndex = -1;
+static thread_local ThreadPool* currentPool = 0;
+
+ThreadPool& ThreadPool::getInstance()
+{
+    // The pool is intentionally never destroyed. Its threads may still be blocked in network operations
+    // when the process exits and joining them from a static destructor would hang the shutdown.
+    static ThreadPool* instance = new ThreadPool();
+    return *instance;
+}
+
+ThreadPool::ThreadPool() : _maxLongRunningTaskCount(1), _runningLongRunningTaskCount(0)
+{
+    for (int i = 0; i < TASK_PRIORITY_COUNT; i++) {
+        this->_pendingTaskCounts[i] = 0;
+    }
+
+    // hardware_concurrency() may return 0 if the value cannot be determined
+    this->_workerCount = thread::hardware_concurrency();
+
+    if (this->_workerCount < 2) {
+        this->_workerCount = 2;
+    }
+}
+
+bool ThreadPool::setWorkerCount(unsigned int workerCount)
+{
+    lock_guard<mutex> lock(this->_poolMutex);
+
+    if (this->_started) {
+        cerr << "ThreadPool::setWorkerCount: the pool has already been started!" << endl;
+        return false;
+    }
+
+    if (workerCount == 0) {
+        cerr << "ThreadPool::setWorkerCount: the worker count must be at least 1!" << endl;
+        return false;
+    }
+
+    this->_workerCount = workerCount;
+    return true;
+}
+
+unsigned int ThreadPool::getWorkerCount()
+{
+    lock_guard<mutex> lock(this->_poolMutex);
+    return this->_workerCount;
+}
+
+bool ThreadPool::isPoolThread()
+{
+    return (currentPool == this);
+}
+
+void ThreadPool::start()
+{
+    // Must be called with _poolMutex held
+    for (unsigned int i = 0; i < this->_workerCount; i++) {
+        this->_localQueues.push_back(new WorkerQueue());
+    }
+
+    // One worker is kept free for interactive tasks (unless there is only one)
+    this->_maxLongRunningTaskCount = (this->_workerCount > 1) ? this->_workerCount - 1 : 1;
+
+    for (unsigned int i = 0; i < this->_workerCount; i++) {
+        this->_workers.push_back(thread(&ThreadPool::workerLoop, this, i));
+    }
+
+    this->_started = true;
+}
+
+void ThreadPool::enqueue(TaskPriority priority, function<void()> function)
+{
+    Task task;
+    task.priority = priority;
+    task.function = function;
+
+    {
+        lock_guard<mutex> lock(this->_poolMutex);
+
+        if (!this->_started) {
+            this->start();
+        }
+
+        // Incremented with _poolMutex held and before the task becomes visible to other threads. Otherwise sleeping
+        // workers could miss the wakeup or a thief could decrement the counter before it has been incremented.
+        this->_pendingTaskCounts[(int)priority]++;
+
+        if (!this->isPoolThread()) {
+            this->_globalQueues[(int)priority].push_back(task);
+        }
+    }
+
+    if (this->isPoolThread()) {
+        WorkerQueue* localQueue = this->_localQueues[currentWorkerIndex];
+        lock_guard<mutex> queueLock(localQueue->queueMutex);
+        localQueue->tasks.push_back(task);
+    }
+
+    this->_taskAvailable.notify_one();
+}
+
+void ThreadPool::workerLoop(unsigned int workerIndex)
+{
+    currentPool = this;
+    currentWorkerIndex = workerIndex;
+
+    for (;;) {
+        Task task;
+
+        if (this->popTask(workerIndex, task)) {
+            task.function();
+
+            if (ThreadPool::isLongRunning(task.priority)) {
+                this->releaseLongRunningSlot();
+            }
+        } else {
+            unique_lock<mutex> lock(this->_poolMutex);
+            this->_taskAvailable.wait(lock, [this]() { return this->hasRunnableTask(); });
+        }
+    }
+}
+
+bool ThreadPool::runLocalTask()
+{
+    Task task;
+
+    // The local tasks belong to the waiting task, so they are run regardless of the limit of long-running tasks
+    for (int i = 0; i < TASK_PRIORITY_COUNT; i++) {
+        if (this->popLocalTask(currentWorkerIndex, (TaskPriority)i, task)) {
+            task.function();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool ThreadPool::popTask(unsigned int workerIndex, Task& task)
+{
+    // The priority classes are tried in order. Within a class our own local work comes first, then the global queue.
+    // Stealing from other workers is the last resort.
+    for (int i = 0; i < TASK_PRIORITY_COUNT; i++) {
+        TaskPriority priority = (TaskPriority)i;
+
+        if (this->_pendingTaskCounts[i] == 0) {
+            continue;
+        }
+
+        bool longRunning = ThreadPool::isLongRunning(priority);
+        if (longRunning && !this->reserveLongRunningSlot()) {
+            continue;
+        }
+
+        if (this->popLocalTask(workerIndex, priority, task) ||
+            this->popGlobalTask(priority, task) ||
+            this->stealTask(workerIndex, priority, task)) {
+
+            return true;
+        }
+
+        if (longRunning) {
+            this->releaseLongRunningSlot();
+        }
+    }
+
+    return false;
+}
+
+bool ThreadPool::popGlobalTask(TaskPriority priority, Task& task)
+{
+    lock_guard<mutex> lock(this->_poolMutex);
+    deque<Task>& queue = this->_globalQueues[(int)priority];
+
+    if (queue.empty()) {
+        return false;
+    }
+
+    task = queue.front();
+    queue.pop_front();
+    this->_pendingTaskCounts[(int)priority]--;
+    return true;
+}
+
+bool ThreadPool::popLocalTask(unsigned int workerIndex, TaskPriority priority, Task& task)
+{
+    WorkerQueue* localQueue = this->_localQueues[workerIndex];
+    lock_guard<mutex> queueLock(localQueue->queueMutex);
+
+    // The owner takes the most recently pushed task, which is most likely to still be hot in the cache
+    for (deque<Task>::reverse_iterator it = localQueue->tasks.rbegin(); it != localQueue->tasks.rend(); ++it) {
+        if (it->priority == priority) {
+            task = *it;
+            localQueue->tasks.erase(next(it).base());
+            this->_pendingTaskCounts[(int)priority]--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool ThreadPool::stealTask(unsigned int thiefIndex, TaskPriority priority, Task& task)
+{
+    unsigned int queueCount = (unsigned int)this->_localQueues.size();
+
+    for (unsigned int i = 1; i < queueCount; i++) {
+        WorkerQueue* victimQueue = this->_localQueues[(thiefIndex + i) % queueCount];
+        lock_guard<mutex> queueLock(victimQueue->queueMutex);
+
+        // Thieves take the oldest task, which is typically the largest remaining chunk of work
+        for (deque<Task>::iterator it = victimQueue->tasks.begin(); it != victimQueue->tasks.end(); ++it) {
+            if (it->priority == priority) {
+                task = *it;
+                victimQueue->tasks.erase(it);
+                this->_pendingTaskCounts[(int)priority]--;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool ThreadPool::isLongRunning(TaskPriority priority)
+{
+    return (priority == TaskPriority::indexing || priority == TaskPriority::network);
+}
+
+bool ThreadPool::reserveLongRunningSlot()
+{
+    unsigned int runningCount = this->_runningLongRunningTaskCount.load();
+
+    while (runningCount < this->_maxLongRunningTaskCount) {
+        if (this->_runningLongRunningTaskCount.compare_exchange_weak(runningCount, runningCount + 1)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::releaseLongRunningSlot()
+{
+    {
+        // Decremented with _poolMutex held, so that a worker waiting for a free slot cannot miss the wakeup
+        lock_guard<mutex> lock(this->_poolMutex);
+        this->_runningLongRunningTaskCount--;
+    }
+
+    this->_taskAvailable.notify_one();
+}
+
+bool ThreadPool::hasRunnableTask()
+{
+    // Must be called with _poolMutex held
+    for (int i = 0; i < TASK_PRIORITY_COUNT; i++) {
+        if (this->_pendingTaskCounts[i] == 0) {
+            continue;
+        }
+
+        if (!ThreadPool::isLongRunning((TaskPriority)i) || this->_runningLongRunningTaskCount < this->_maxLongRunningTaskCount) {
+            return true;
+        }
+    }
+
+    return false;
+}
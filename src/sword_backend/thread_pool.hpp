@@ -0,0 +1,141 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef _THREAD_POOL
+#define _THREAD_POOL
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <future>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+
+// Tasks with a lower value are picked first. Indexing and network tasks may run for a long time,
+// so they never occupy all workers at once (see ThreadPool).
+enum class TaskPriority {
+    interactive = 0,
+    search = 1,
+    indexing = 2,
+    network = 3
+};
+
+#define TASK_PRIORITY_COUNT 4
+
+/**
+ * The ThreadPool is the work-stealing scheduler that is shared by all background operations of the addon.
+ *
+ * Tasks submitted from outside the pool are queued by priority. Tasks submitted from a pool thread are pushed
+ * to the local queue of that thread, from which idle threads steal. The worker threads are started lazily
+ * when the first task is submitted.
+ *
+ * Workers pick the task with the best priority among their local queue, the global queues and the queues of the
+ * other workers. At most workerCount - 1 indexing and network tasks run at the same time, so that one worker
+ * is always left for interactive tasks and searches. Tasks that waitFor runs on the waiting thread do not count.
+ */
+class ThreadPool
+{
+public:
+    static ThreadPool& getInstance();
+
+    // The worker count can only be changed before the first task has been submitted.
+    bool setWorkerCount(unsigned int workerCount);
+    unsigned int getWorkerCount();
+
+    template<typename R>
+    std::future<R> submit(TaskPriority priority, std::function<R()> task)
+    {
+        std::shared_ptr<std::packaged_task<R()>> packagedTask = std::make_shared<std::packaged_task<R()>>(task);
+        std::future<R> result = packagedTask->get_future();
+        this->enqueue(priority, [packagedTask]() { (*packagedTask)(); });
+        return result;
+    }
+
+    // Waits for the given future. When called from a pool thread, the tasks in the local queue of that thread
+    // are executed while waiting, so that nested submissions cannot exhaust the pool. Only the own local queue
+    // is used, since it only holds tasks submitted by the current thread. Unrelated tasks are never run on the
+    // stack of a waiting task.
+    template<typename R>
+    R waitFor(std::future<R>& result)
+    {
+        if (!this->isPoolThread()) {
+            result.wait();
+        } else {
+            while (result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                if (!this->runLocalTask()) {
+                    // The remaining tasks have been stolen and are running on other threads
+                    result.wait();
+                }
+            }
+        }
+
+        return result.get();
+    }
+
+    bool isPoolThread();
+
+private:
+    class Task {
+    public:
+        TaskPriority priority;
+        std::function<void()> function;
+    };
+
+    class WorkerQueue {
+    public:
+        std::deque<Task> tasks;
+        std::mutex queueMutex;
+    };
+
+    ThreadPool();
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+
+    void start();
+    void enqueue(TaskPriority priority, std::function<void()> function);
+    void workerLoop(unsigned int workerIndex);
+    bool runLocalTask();
+    bool popTask(unsigned int workerIndex, Task& task);
+    bool popGlobalTask(TaskPriority priority, Task& task);
+    bool popLocalTask(unsigned int workerIndex, TaskPriority priority, Task& task);
+    bool stealTask(unsigned int thiefIndex, TaskPriority priority, Task& task);
+
+    static bool isLongRunning(TaskPriority priority);
+    bool reserveLongRunningSlot();
+    void releaseLongRunningSlot();
+    bool hasRunnableTask();
+
+    unsigned int _workerCount;
+    unsigned int _maxLongRunningTaskCount;
+    bool _started = false;
+    std::atomic<unsigned int> _pendingTaskCounts[TASK_PRIORITY_COUNT];
+    std::atomic<unsigned int> _runningLongRunningTaskCount;
+
+    std::vector<std::thread> _workers;
+    std::vector<WorkerQueue*> _localQueues;
+    std::deque<Task> _globalQueues[TASK_PRIORITY_COUNT];
+
+    std::mutex _poolMutex;
+    std::condition_variable _taskAvailable;
+};
+
+#endif // _THREAD_POOL
@@ -0,0 +1,182 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+// Std includes
+#include <sstream>
+#include <stdlib.h>
+
+// Sword includes
+#include <versificationmgr.h>
+#include <versekey.h>
+
+// Own includes
+#include "versification_mapping.hpp"
+
+using namespace std;
+using namespace sword;
+
+VersificationMappingTable::VersificationMappingTable(string sourceV11n, string targetV11n)
+    : _sourceV11n(sourceV11n), _targetV11n(targetV11n)
+{
+}
+
+bool VersificationMappingTable::build()
+{
+    VersificationMgr* vMgr = VersificationMgr::getSystemVersificationMgr();
+    const VersificationMgr::System* sourceSys = vMgr->getVersificationSystem(this->_sourceV11n.c_str());
+    const VersificationMgr::System* targetSys = vMgr->getVersificationSystem(this->_targetV11n.c_str());
+
+    if (sourceSys == 0 || targetSys == 0) {
+        return false;
+    }
+
+    map<string, unsigned short> targetBookIndexes;
+
+    for (int bookIndex = 0; bookIndex < sourceSys->getBookCount(); bookIndex++) {
+        const VersificationMgr::Book* sourceBook = sourceSys->getBook(bookIndex);
+        string bookName = string(sourceBook->getOSISName());
+        vector<unsigned int> chapterOffsets;
+
+        this->_sourceBooks[bookName] = (unsigned int)this->_chapterOffsets.size();
+
+        for (int chapter = 1; chapter <= sourceBook->getChapterMax(); chapter++) {
+            chapterOffsets.push_back((unsigned int)this->_entries.size());
+
+            for (int verse = 1; verse <= sourceBook->getVerseMax(chapter); verse++) {
+                const char* targetBookName = sourceBook->getOSISName();
+                int targetChapter = chapter;
+                int targetVerse = verse;
+                int targetVerseEnd = verse;
+
+                sourceSys->translateVerse(targetSys, &targetBookName, &targetChapter, &targetVerse, &targetVerseEnd);
+
+                auto targetBookIndex = targetBookIndexes.find(targetBookName);
+
+                if (targetBookIndex == targetBookIndexes.end()) {
+                    targetBookIndex = targetBookIndexes.insert(make_pair(string(targetBookName),
+                                                                         (unsigned short)this->_targetBooks.size())).first;
+                    this->_targetBooks.push_back(targetBookName);
+                }
+
+                Entry entry;
+                entry.targetBook = targetBookIndex->second;
+                entry.chapter = (unsigned short)targetChapter;
+                entry.verse = (unsigned short)targetVerse;
+                entry.verseEnd = (unsigned short)targetVerseEnd;
+                this->_entries.push_back(entry);
+            }
+        }
+
+        chapterOffsets.push_back((unsigned int)this->_entries.size());
+        this->_chapterOffsets.push_back(chapterOffsets);
+    }
+
+    return true;
+}
+
+const VersificationMappingTable::Entry* VersificationMappingTable::getEntry(const string& book, int chapter, int verse) const
+{
+    auto sourceBook = this->_sourceBooks.find(book);
+
+    if (sourceBook == this->_sourceBooks.end() || chapter < 1 || verse < 1) {
+        return 0;
+    }
+
+    const vector<unsigned int>& chapterOffsets = this->_chapterOffsets[sourceBook->second];
+
+    if ((unsigned int)chapter >= chapterOffsets.size()) {
+        return 0;
+    }
+
+    unsigned int entryIndex = chapterOffsets[chapter - 1] + (unsigned int)(verse - 1);
+
+    if (entryIndex >= chapterOffsets[chapter]) {
+        return 0;
+    }
+
+    return &(this->_entries[entryIndex]);
+}
+
+string VersificationMappingTable::mapReference(const string& sourceOsisRef, bool allowRange) const
+{
+    // OSIS references (Book.Chapter.Verse) are looked up in the table without parsing them with a VerseKey
+    size_t verseSeparator = sourceOsisRef.rfind('.');
+    size_t chapterSeparator = (verseSeparator != string::npos && verseSeparator > 0) ?
+                              sourceOsisRef.rfind('.', verseSeparator - 1) : string::npos;
+
+    if (chapterSeparator != string::npos && chapterSeparator > 0) {
+        string book = sourceOsisRef.substr(0, chapterSeparator);
+        string chapterString = sourceOsisRef.substr(chapterSeparator + 1, verseSeparator - chapterSeparator - 1);
+        string verseString = sourceOsisRef.substr(verseSeparator + 1);
+
+        bool isNumeric = (chapterString.size() > 0 && verseString.size() > 0 &&
+                          chapterString.find_first_not_of("0123456789") == string::npos &&
+                          verseString.find_first_not_of("0123456789") == string::npos);
+
+        const Entry* entry = isNumeric ? this->getEntry(book, atoi(chapterString.c_str()), atoi(verseString.c_str())) : 0;
+
+        if (entry != 0) {
+            return formatReference(this->_targetBooks[entry->targetBook].c_str(),
+                                   entry->chapter,
+                                   entry->verse,
+                                   entry->verseEnd,
+                                   allowRange);
+        }
+    }
+
+    return this->translateReference(sourceOsisRef, allowRange);
+}
+
+string VersificationMappingTable::translateReference(const string& sourceOsisRef, bool allowRange) const
+{
+    VersificationMgr* vMgr = VersificationMgr::getSystemVersificationMgr();
+    const VersificationMgr::System* sourceSys = vMgr->getVersificationSystem(this->_sourceV11n.c_str());
+    const VersificationMgr::System* targetSys = vMgr->getVersificationSystem(this->_targetV11n.c_str());
+
+    if (sourceSys == 0 || targetSys == 0) {
+        return sourceOsisRef;
+    }
+
+    // Parse the source OSIS reference using a VerseKey with the source versification
+    VerseKey sourceKey;
+    sourceKey.setVersificationSystem(this->_sourceV11n.c_str());
+    sourceKey.setText(sourceOsisRef.c_str());
+
+    // Extract the components for translateVerse
+    const char* book = sourceKey.getOSISBookName();
+    int chapter = sourceKey.getChapter();
+    int verse = sourceKey.getVerse();
+    int verseEnd = verse;
+
+    // Perform the mapping
+    sourceSys->translateVerse(targetSys, &book, &chapter, &verse, &verseEnd);
+
+    return formatReference(book, chapter, verse, verseEnd, allowRange);
+}
+
+string VersificationMappingTable::formatReference(const char* book, int chapter, int verse, int verseEnd, bool allowRange)
+{
+    stringstream result;
+    result << book << "." << chapter << "." << verse;
+
+    if (allowRange && verseEnd > verse) {
+        result << "-" << book << "." << chapter << "." << verseEnd;
+    }
+
+    return result.str();
+}
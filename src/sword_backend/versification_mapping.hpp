@@ -0,0 +1,64 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of 
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef _VERSIFICATION_MAPPING
+#define _VERSIFICATION_MAPPING
+
+#include <string>
+#include <vector>
+#include <map>
+
+/**
+ * A precomputed mapping of every verse of a source versification system to a target versification system.
+ *
+ * The table is built with one translateVerse call per verse of the source system. References that are not
+ * covered by the table (like verse 0 or references that are not in OSIS format) are translated directly.
+ */
+class VersificationMappingTable {
+public:
+    VersificationMappingTable(std::string sourceV11n, std::string targetV11n);
+    virtual ~VersificationMappingTable() {}
+
+    // Returns false if one of the versification systems is unknown
+    bool build();
+
+    std::string mapReference(const std::string& sourceOsisRef, bool allowRange) const;
+
+private:
+    class Entry {
+    public:
+        unsigned short targetBook;
+        unsigned short chapter;
+        unsigned short verse;
+        unsigned short verseEnd;
+    };
+
+    const Entry* getEntry(const std::string& book, int chapter, int verse) const;
+    std::string translateReference(const std::string& sourceOsisRef, bool allowRange) const;
+    static std::string formatReference(const char* book, int chapter, int verse, int verseEnd, bool allowRange);
+
+    std::string _sourceV11n;
+    std::string _targetV11n;
+    std::map<std::string, unsigned int> _sourceBooks;
+    // Index of the first entry of every chapter per source book, followed by the end of the book's entries
+    std::vector<std::vector<unsigned int>> _chapterOffsets;
+    std::vector<Entry> _entries;
+    std::vector<std::string> _targetBooks;
+};
+
+#endif // _VERSIFICATION_MAPPING
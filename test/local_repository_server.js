@@ -0,0 +1,439 @@
+/* This file is part of node-sword-interface.
+
+   Copyright (C) 2019 - 2026 Tobias Klein <contact@tklein.info>
+
+   node-sword-interface is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 2 of the License, or
+   (at your option) any later version.
+
+   node-sword-interface is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with node-sword-interface. See the file COPYING.
+   If not, see <http://www.gnu.org/licenses/>. */
+
+const http = require('http');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const zlib = require('zlib');
+
+const crcTable = [];
+
+for (let n = 0; n < 256; n++) {
+  let c = n;
+
+  for (let k = 0; k < 8; k++) {
+    c = (c & 1) ? (0xEDB88320 ^ (c >>> 1)) : (c >>> 1);
+  }
+
+  crcTable.push(c >>> 0);
+}
+
+function crc32(buffer) {
+  let crc = 0xFFFFFFFF;
+
+  for (let i = 0; i < buffer.length; i++) {
+    crc = crcTable[(crc ^ buffer[i]) & 0xFF] ^ (crc >>> 8);
+  }
+
+  return (crc ^ 0xFFFFFFFF) >>> 0;
+}
+
+/**
+ * Creates a gzip compressed ustar archive with the given files ({ fileName: content }).
+ */
+function createTarGz(files) {
+  const blocks = [];
+
+  for (const [fileName, content] of Object.entries(files)) {
+    const data = Buffer.from(content);
+    const header = Buffer.alloc(512);
+
+    header.write(fileName, 0, 100);
+    header.write('0000644\0', 100);
+    header.write('0000000\0', 108);
+    header.write('0000000\0', 116);
+    header.write(data.length.toString(8).padStart(11, '0') + '\0', 124);
+    header.write(Math.floor(Date.now() / 1000).toString(8).padStart(11, '0') + '\0', 136);
+    header.write('        ', 148);
+    header.write('0', 156);
+    header.write('ustar\0', 257);
+    header.write('00', 263);
+
+    let checksum = 0;
+    for (let i = 0; i < 512; i++) {
+      checksum += header[i];
+    }
+
+    header.write(checksum.toString(8).padStart(6, '0') + '\0 ', 148);
+
+    blocks.push(header);
+    blocks.push(data);
+    blocks.push(Buffer.alloc((512 - (data.length % 512)) % 512));
+  }
+
+  blocks.push(Buffer.alloc(1024));
+  return zlib.gzipSync(Buffer.concat(blocks));
+}
+
+/**
+ * Creates a zip archive with the given files ({ fileName: content }). The entries are stored without compression.
+ */
+function createZip(files) {
+  const localParts = [];
+  const centralParts = [];
+  let offset = 0;
+
+  for (const [fileName, content] of Object.entries(files)) {
+    const name = Buffer.from(fileName);
+    const data = Buffer.from(content);
+    const crc = crc32(data);
+
+    const localHeader = Buffer.alloc(30);
+    localHeader.writeUInt32LE(0x04034b50, 0);
+    localHeader.writeUInt16LE(10, 4);
+    localHeader.writeUInt32LE(crc, 14);
+    localHeader.writeUInt32LE(data.length, 18);
+    localHeader.writeUInt32LE(data.length, 22);
+    localHeader.writeUInt16LE(name.length, 26);
+
+    const centralHeader = Buffer.alloc(46);
+    centralHeader.writeUInt32LE(0x02014b50, 0);
+    centralHeader.writeUInt16LE(20, 4);
+    centralHeader.writeUInt16LE(10, 6);
+    centralHeader.writeUInt32LE(crc, 16);
+    centralHeader.writeUInt32LE(data.length, 20);
+    centralHeader.writeUInt32LE(data.length, 24);
+    centralHeader.writeUInt16LE(name.length, 28);
+    centralHeader.writeUInt32LE(offset, 42);
+
+    localParts.push(localHeader, name, data);
+    centralParts.push(centralHeader, name);
+    offset += localHeader.length + name.length + data.length;
+  }
+
+  const centralDirectory = Buffer.concat(centralParts);
+  const endRecord = Buffer.alloc(22);
+  endRecord.writeUInt32LE(0x06054b50, 0);
+  endRecord.writeUInt16LE(Object.keys(files).length, 8);
+  endRecord.writeUInt16LE(Object.keys(files).length, 10);
+  endRecord.writeUInt32LE(centralDirectory.length, 12);
+  endRecord.writeUInt32LE(offset, 16);
+
+  return Buffer.concat([...localParts, centralDirectory, endRecord]);
+}
+
+/**
+ * Returns the files of a minimal Bible module, whose data is padded to the given size,
+ * so that a download of its package can be interrupted midway.
+ */
+function createTestModuleFiles(moduleName, version, dataSize) {
+  const lowerCaseName = moduleName.toLowerCase();
+  const dataPath = `./modules/texts/rawtext/${lowerCaseName}/`;
+
+  const conf = `[${moduleName}]\n` +
+               `DataPath=${dataPath}\n` +
+               `ModDrv=RawText\n` +
+               `Encoding=UTF-8\n` +
+               `Lang=en\n` +
+               `Description=${moduleName} test module\n` +
+               `Version=${version}\n`;
+
+  const files = {};
+  files[`mods.d/${lowerCaseName}.conf`] = conf;
+  files[`modules/texts/rawtext/${lowerCaseName}/ot`] = '';
+  files[`modules/texts/rawtext/${lowerCaseName}/ot.vss`] = '';
+  files[`modules/texts/rawtext/${lowerCaseName}/nt`] = Buffer.alloc(dataSize, 'x');
+  files[`modules/texts/rawtext/${lowerCaseName}/nt.vss`] = '';
+
+  return { conf, files };
+}
+
+/**
+ * Returns the data and the verse index of a RawText testament whose first book starts with the given verses.
+ * The first four index entries are the module header, the testament heading and the book and chapter introductions.
+ * The index covers all other entries of the testament (KJV versification) with empty entries, so that the whole module can be read.
+ */
+function createRawTextTestament(verses) {
+  const entryCount = 24200;
+  const index = Buffer.alloc(Math.max(4 + verses.length, entryCount) * 6);
+  const dataParts = [];
+  let offset = 0;
+
+  verses.forEach((verse, i) => {
+    const verseData = Buffer.from(verse, 'utf8');
+    index.writeUInt32LE(offset, (4 + i) * 6);
+    index.writeUInt16LE(verseData.length, (4 + i) * 6 + 4);
+    dataParts.push(verseData);
+    offset += verseData.length;
+  });
+
+  return { data: Buffer.concat(dataParts), index };
+}
+
+/**
+ * Returns the files of a Bible module (KJV versification) with the given verses of Genesis 1 and Matthew 1
+ * in the markup of the given source type (OSIS, GBF or ThML). Additional configuration lines may be appended.
+ */
+function createTestBibleModuleFiles(moduleName, sourceType, genesisVerses, matthewVerses, additionalConf='') {
+  const lowerCaseName = moduleName.toLowerCase();
+  const dataPath = `./modules/texts/rawtext/${lowerCaseName}/`;
+
+  const conf = `[${moduleName}]\n` +
+               `DataPath=${dataPath}\n` +
+               `ModDrv=RawText\n` +
+               `SourceType=${sourceType}\n` +
+               `Encoding=UTF-8\n` +
+               `Lang=en\n` +
+               `Description=${moduleName} test module\n` +
+               `Version=1.0\n` +
+               additionalConf;
+
+  const oldTestament = createRawTextTestament(genesisVerses);
+  const newTestament = createRawTextTestament(matthewVerses);
+
+  const files = {};
+  files[`mods.d/${lowerCaseName}.conf`] = conf;
+  files[`modules/texts/rawtext/${lowerCaseName}/ot`] = oldTestament.data;
+  files[`modules/texts/rawtext/${lowerCaseName}/ot.vss`] = oldTestament.index;
+  files[`modules/texts/rawtext/${lowerCaseName}/nt`] = newTestament.data;
+  files[`modules/texts/rawtext/${lowerCaseName}/nt.vss`] = newTestament.index;
+
+  return { conf, files };
+}
+
+/**
+ * Writes the given module files to the SWORD directory.
+ */
+function writeModuleFiles(swordDir, files) {
+  for (const [fileName, content] of Object.entries(files)) {
+    fs.mkdirSync(path.dirname(path.join(swordDir, fileName)), { recursive: true });
+    fs.writeFileSync(path.join(swordDir, fileName), content);
+  }
+}
+
+/**
+ * Copies the configuration and the data of a module that is installed in the SWORD directory of the user
+ * to another SWORD directory.
+ */
+function copyInstalledModule(moduleName, targetSwordDir) {
+  const sourceSwordDir = getSwordDir(os.homedir());
+  const confFile = `mods.d/${moduleName.toLowerCase()}.conf`;
+  const conf = fs.readFileSync(path.join(sourceSwordDir, confFile), 'utf8');
+  const dataPath = conf.match(/^DataPath=(.*)$/m)[1].trim();
+
+  // The DataPath of dictionaries and commentaries includes the prefix of the data files
+  const dataDir = dataPath.endsWith('/') ? dataPath : path.posix.dirname(dataPath);
+
+  fs.mkdirSync(path.join(targetSwordDir, 'mods.d'), { recursive: true });
+  fs.writeFileSync(path.join(targetSwordDir, confFile), conf);
+  fs.cpSync(path.join(sourceSwordDir, dataDir), path.join(targetSwordDir, dataDir), { recursive: true });
+}
+
+/**
+ * A local stand-in for a SWORD repository (HTTP only). It serves the module index (/raw/mods.d.tar.gz)
+ * and the module packages (/packages/rawzip/<Module>.zip) with ETag and Range support.
+ * Failures can be injected to test retries, deadlines and resumed downloads. All requests are recorded.
+ */
+class LocalRepositoryServer {
+  constructor() {
+    this.requests = [];
+    this.index = null;
+    this.indexEtag = '';
+    this.packages = {};
+
+    // Number of upcoming index downloads that are dropped before any data has been sent
+    this.failingIndexDownloads = 0;
+
+    // If true, index downloads are never answered
+    this.hangingIndexDownloads = false;
+
+    // If > 0, the next package download is dropped after this number of bytes
+    this.dropPackageAfterBytes = 0;
+
+    // If set, range requests for packages are answered with this status (e.g. 416)
+    this.forcedRangeStatus = 0;
+
+    this._sockets = new Set();
+    this._server = http.createServer((request, response) => this._handleRequest(request, response));
+    this._server.on('connection', (socket) => {
+      this._sockets.add(socket);
+      socket.on('close', () => this._sockets.delete(socket));
+    });
+  }
+
+  async start() {
+    await new Promise((resolve) => this._server.listen(0, '127.0.0.1', resolve));
+    this.port = this._server.address().port;
+    return this.port;
+  }
+
+  async stop() {
+    for (const socket of this._sockets) {
+      socket.destroy();
+    }
+
+    await new Promise((resolve) => this._server.close(resolve));
+  }
+
+  setModules(modules) {
+    const indexFiles = {};
+
+    for (const module of modules) {
+      indexFiles[`mods.d/${module.name.toLowerCase()}.conf`] = module.conf;
+    }
+
+    this.index = createTarGz(indexFiles);
+    this.indexEtag = `"index-${crc32(this.index).toString(16)}"`;
+  }
+
+  setPackage(moduleName, files, etag=undefined) {
+    const data = createZip(files);
+    this.packages[moduleName] = { data, etag: etag || `"package-${crc32(data).toString(16)}"` };
+  }
+
+  getRequests(urlPath, method='GET') {
+    return this.requests.filter((request) => request.url == urlPath && request.method == method);
+  }
+
+  /**
+   * Writes an InstallMgr configuration into the given home directory, which only contains this server as repository.
+   */
+  writeInstallMgrConf(homeDir, repositoryName) {
+    const installMgrDir = path.join(getSwordDir(homeDir), 'InstallMgr');
+    fs.mkdirSync(installMgrDir, { recursive: true });
+
+    const conf = '[General]\nPassiveFTP=true\n\n' +
+                 `[Sources]\nHTTPSource=${repositoryName}|127.0.0.1:${this.port}|/raw|||local-test-${this.port}\n`;
+
+    fs.writeFileSync(path.join(installMgrDir, 'InstallMgr.conf'), conf);
+  }
+
+  _handleRequest(request, response) {
+    const record = { method: request.method, url: request.url, range: request.headers['range'], status: 0 };
+    this.requests.push(record);
+
+    if (request.url == '/raw/mods.d.tar.gz' && this.index != null) {
+      this._sendIndex(request, response, record);
+      return;
+    }
+
+    const packageMatch = request.url.match(/^\/packages\/rawzip\/(.+)\.zip$/);
+    if (packageMatch != null && this.packages[packageMatch[1]] !== undefined) {
+      this._sendPackage(request, response, record, this.packages[packageMatch[1]]);
+      return;
+    }
+
+    record.status = 404;
+    response.writeHead(404);
+    response.end();
+  }
+
+  _sendIndex(request, response, record) {
+    const headers = {
+      'Content-Type': 'application/gzip',
+      'Content-Length': this.index.length,
+      'ETag': this.indexEtag
+    };
+
+    if (request.method == 'HEAD') {
+      record.status = 200;
+      response.writeHead(200, headers);
+      response.end();
+      return;
+    }
+
+    if (this.hangingIndexDownloads) {
+      // The request is neither answered nor closed
+      return;
+    }
+
+    if (this.failingIndexDownloads > 0) {
+      this.failingIndexDownloads--;
+      record.status = -1;
+      request.socket.destroy();
+      return;
+    }
+
+    record.status = 200;
+    response.writeHead(200, headers);
+    response.end(this.index);
+  }
+
+  _sendPackage(request, response, record, modulePackage) {
+    const totalSize = modulePackage.data.length;
+    const rangeMatch = (request.headers['range'] || '').match(/^bytes=(\d+)-$/);
+    const ifRange = request.headers['if-range'];
+    let start = 0;
+    let status = 200;
+
+    if (rangeMatch != null && this.forcedRangeStatus != 0) {
+      record.status = this.forcedRangeStatus;
+      response.writeHead(this.forcedRangeStatus, { 'Content-Range': `bytes */${totalSize}` });
+      response.end();
+      return;
+    }
+
+    // Like a real server, the range is only honoured if the package has not changed (If-Range)
+    if (rangeMatch != null && (ifRange === undefined || ifRange == modulePackage.etag)) {
+      start = parseInt(rangeMatch[1]);
+      status = 206;
+    }
+
+    const headers = {
+      'Content-Type': 'application/zip',
+      'Content-Length': totalSize - start,
+      'Accept-Ranges': 'bytes',
+      'ETag': modulePackage.etag
+    };
+
+    if (status == 206) {
+      headers['Content-Range'] = `bytes ${start}-${totalSize - 1}/${totalSize}`;
+    }
+
+    record.status = status;
+    response.writeHead(status, headers);
+
+    if (this.dropPackageAfterBytes > 0) {
+      const sentBytes = this.dropPackageAfterBytes;
+      this.dropPackageAfterBytes = 0;
+
+      // The connection drops after a part of the package has been delivered
+      response.write(modulePackage.data.subarray(start, start + sentBytes), () => {
+        setTimeout(() => request.socket.destroy(), 100);
+      });
+
+      return;
+    }
+
+    response.end(modulePackage.data.subarray(start));
+  }
+}
+
+/**
+ * Returns the user SWORD directory within the given home directory.
+ */
+function getSwordDir(homeDir) {
+  const swordDirName = (process.platform === 'win32') ? 'sword' : '.sword';
+  return path.join(homeDir, swordDirName);
+}
+
+function createTempHomeDir() {
+  return fs.mkdtempSync(path.join(os.tmpdir(), 'node-sword-interface-test-'));
+}
+
+module.exports = {
+  LocalRepositoryServer,
+  createTestModuleFiles,
+  createTestBibleModuleFiles,
+  writeModuleFiles,
+  copyInstalledModule,
+  createTempHomeDir,
+  getSwordDir,
+  createZip
+};
@@ -17,6 +17,11 @@
    If not, see <http://www.gnu.org/licenses/>. */
 
 const NodeSwordInterface = require('../index.js');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { LocalRepositoryServer, createTestModuleFiles, createTestBibleModuleFiles, writeModuleFiles, copyInstalledModule,
+        createTempHomeDir, getSwordDir, createZip } = require('./local_repository_server.js');
 
 describe('NodeSwordInterface', () => {
   let nsi;
@@ -54,4 +59,623 @@ describe('NodeSwordInterface', () => {
     const search_results = await firstResult; // Wait for the first result to resolve
     expect(search_results.length).toBeGreaterThan(0);
   });
+
+  test('should return the same results for module searches running in parallel on several instances', async () => {
+    const moduleCode = 'KJV';
+    const searchTerm = 'faith';
+
+    const expectedResults = await nsi.getModuleSearchResults(moduleCode, searchTerm);
+    expect(expectedResults.length).toBeGreaterThan(0);
+
+    const instances = [];
+    for (let i = 0; i < 4; i++) {
+      instances.push(new NodeSwordInterface());
+    }
+
+    const parallelResults = await Promise.all(instances.map((instance) => {
+      return instance.getModuleSearchResults(moduleCode, searchTerm);
+    }));
+
+    for (const results of parallelResults) {
+      expect(results).toEqual(expectedResults);
+    }
+  });
+
+  test('should return the results and errors of a mixed batch in the order of the operations', () => {
+    const results = nsi.executeBatch([
+      { operation: 'getChapterText', args: ['KJV', 'John', 3] },
+      { operation: 'getVersesFromReferences', args: ['KJV', ['Gen.1.1', 42]] },
+      { operation: 'getVersesFromReferences', args: ['KJV', ['Gen.1.1', 'John.3.16']] },
+      { operation: 'unknownOperation', args: [] },
+      'no operation object'
+    ]);
+
+    expect(results.length).toBe(5);
+
+    expect(results[0].error).toBeUndefined();
+    expect(results[0].result.length).toBe(36);
+    expect(results[0].result).toEqual(nsi.getChapterText('KJV', 'John', 3));
+
+    expect(results[1].result).toBeUndefined();
+    expect(results[1].error).toBe('String expected for reference 2');
+
+    expect(results[2].error).toBeUndefined();
+    expect(results[2].result).toEqual(nsi.getVersesFromReferences('KJV', ['Gen.1.1', 'John.3.16']));
+
+    expect(results[3].result).toBeUndefined();
+    expect(results[3].error).toBe("Unknown batch operation 'unknownOperation'");
+
+    expect(results[4].error).toBe('Batch operation must be an object!');
+  });
+});
+
+describe("Strong's entries", () => {
+  let nsi;
+  let localNsi;
+
+  beforeAll(async () => {
+    nsi = new NodeSwordInterface();
+
+    for (const moduleCode of ['KJV', 'StrongsHebrew', 'StrongsGreek']) {
+      if (!nsi.getLocalModule(moduleCode)) {
+        console.log(`${moduleCode} module not found, installing ...`);
+        await nsi.installModule('CrossWire', moduleCode);
+      }
+    }
+
+    // The GBF and ThML modules are created locally and use copies of the installed Strong's modules
+    const homeDir = createTempHomeDir();
+    const swordDir = getSwordDir(homeDir);
+    copyInstalledModule('StrongsHebrew', swordDir);
+    copyInstalledModule('StrongsGreek', swordDir);
+
+    const gbfModule = createTestBibleModuleFiles('GbfStrongs', 'GBF',
+      ['In the beginning<WH07225> God<WH0430> created<WH01254> the heaven<WH08064> and the earth<WH0776>.',
+       'And the Spirit<WH07307> of God<WH0430> moved<WH07363> upon the face of the waters.'],
+      ['The book<WG976> of the generation<WG1078> of Jesus<WG2424> Christ<WG5547>.'],
+      'GlobalOptionFilter=GBFStrongs\nFeature=StrongsNumbers\n');
+
+    // ThML modules may omit the prefix of the Strong's numbers, which then depends on the testament
+    const thmlModule = createTestBibleModuleFiles('ThmlStrongs', 'ThML',
+      ['In the beginning<sync type="Strongs" value="H07225"/> God<sync type="Strongs" value="0430"/> created'],
+      ['The book<sync type="Strongs" value="976"/> of the generation<sync type="Strongs" value="G1078"/>',
+       'Abraham<sync type="Strongs" value="11"/> begat<sync type="Strongs" value="1080"/> Isaac<sync type="Strongs" value="2464"/>'],
+      'GlobalOptionFilter=ThMLStrongs\nFeature=StrongsNumbers\n');
+
+    writeModuleFiles(swordDir, gbfModule.files);
+    writeModuleFiles(swordDir, thmlModule.files);
+    localNsi = new NodeSwordInterface(homeDir);
+  }, 120000);
+
+  test('should normalize the keys of getStrongsEntries', () => {
+    const entries = nsi.getStrongsEntries(['H07225', 'G02316', 'H0430']);
+
+    expect(Object.keys(entries).sort()).toEqual(['G2316', 'H430', 'H7225']);
+    expect(entries['H7225']).toEqual(nsi.getStrongsEntry('H7225'));
+    expect(entries['G2316']).toEqual(nsi.getStrongsEntry('G2316'));
+    expect(entries['H430']).toEqual(nsi.getStrongsEntry('H430'));
+  });
+
+  test('should skip duplicate and invalid keys in getStrongsEntries', () => {
+    const entries = nsi.getStrongsEntries(['H7225', 'H07225', 'H007225', 'G2316', 'G2316', 'X1', 'H0', 'H99999', '']);
+    expect(Object.keys(entries).sort()).toEqual(['G2316', 'H7225']);
+  });
+
+  test('should return the normalized and unique lemmas of an OSIS chapter', () => {
+    const entries = nsi.getChapterStrongsEntries('KJV', 'Gen', 1);
+    const keys = Object.keys(entries);
+
+    expect(keys).toEqual(expect.arrayContaining(['H7225', 'H430', 'H1254', 'H8064', 'H776']));
+    expect(new Set(keys).size).toBe(keys.length);
+
+    for (const key of keys) {
+      expect(key).toMatch(/^H[1-9][0-9]*$/);
+    }
+
+    expect(entries['H430']).toEqual(nsi.getStrongsEntry('H430'));
+  });
+
+  test('should extract the lemmas of a GBF chapter', () => {
+    const otEntries = localNsi.getChapterStrongsEntries('GbfStrongs', 'Gen', 1);
+    expect(Object.keys(otEntries).sort()).toEqual(['H1254', 'H430', 'H7225', 'H7307', 'H7363', 'H776', 'H8064'].sort());
+    expect(otEntries['H430'].rawEntry).toBe(nsi.getStrongsEntry('H430').rawEntry);
+
+    const ntEntries = localNsi.getChapterStrongsEntries('GbfStrongs', 'Matt', 1);
+    expect(Object.keys(ntEntries).sort()).toEqual(['G1078', 'G2424', 'G5547', 'G976'].sort());
+  });
+
+  test('should extract the lemmas of a ThML chapter with and without prefix', () => {
+    const otEntries = localNsi.getChapterStrongsEntries('ThmlStrongs', 'Gen', 1);
+    expect(Object.keys(otEntries).sort()).toEqual(['H430', 'H7225']);
+
+    const ntEntries = localNsi.getChapterStrongsEntries('ThmlStrongs', 'Matt', 1);
+    expect(Object.keys(ntEntries).sort()).toEqual(['G1078', 'G1080', 'G11', 'G2464', 'G976'].sort());
+    expect(ntEntries['G976'].rawEntry).toBe(nsi.getStrongsEntry('G976').rawEntry);
+  });
+});
+
+describe('Lemma statistics', () => {
+  let nsi;
+
+  beforeAll(() => {
+    const homeDir = createTempHomeDir();
+
+    const osisModule = createTestBibleModuleFiles('OsisStrongs', 'OSIS',
+      ['<w lemma="strong:H07225">In the beginning</w> <w lemma="strong:H0430">God</w> <w lemma="strong:H01254 strong:H0853">created</w>',
+       'And the Spirit of <w lemma="strong:H0430">God</w> moved',
+       'And <w lemma="strong:H0430">Elohim</w> said'],
+      ['The book of <w lemma="strong:G2316">God</w>',
+       'The <w lemma="strong:G2316">God</w> of Abraham'],
+      'GlobalOptionFilter=OSISStrongs\nFeature=StrongsNumbers\n');
+
+    writeModuleFiles(getSwordDir(homeDir), osisModule.files);
+    nsi = new NodeSwordInterface(homeDir);
+  });
+
+  test('should count the occurrences, books and surface forms of a Strong\'s number', async () => {
+    const statistics = await nsi.getLemmaStatistics('OsisStrongs', 'H430');
+
+    expect(statistics.strongsKey).toBe('H430');
+    expect(statistics.occurrences).toBe(3);
+    expect(statistics.bookOccurrences).toEqual({ Gen: 3 });
+    expect(statistics.surfaceForms).toEqual([{ text: 'God', occurrences: 2 }, { text: 'Elohim', occurrences: 1 }]);
+
+    const greekStatistics = await nsi.getLemmaStatistics('OsisStrongs', 'G2316');
+    expect(greekStatistics.occurrences).toBe(2);
+    expect(greekStatistics.bookOccurrences).toEqual({ Matt: 2 });
+  }, 20000);
+
+  test('should normalize the key and count every key of a lemma attribute', async () => {
+    expect(await nsi.getLemmaStatistics('OsisStrongs', 'H0430')).toEqual(await nsi.getLemmaStatistics('OsisStrongs', 'H430'));
+
+    const statistics = await nsi.getLemmaStatistics('OsisStrongs', 'H0853');
+    expect(statistics.strongsKey).toBe('H853');
+    expect(statistics.occurrences).toBe(1);
+    expect(statistics.surfaceForms).toEqual([{ text: 'created', occurrences: 1 }]);
+  }, 20000);
+
+  test('should return empty statistics for a key that does not occur in the module', async () => {
+    const statistics = await nsi.getLemmaStatistics('OsisStrongs', 'H8000');
+
+    expect(statistics).toEqual({ strongsKey: 'H8000', occurrences: 0, bookOccurrences: {}, surfaceForms: [] });
+  }, 20000);
+
+  test('should reject the statistics of an unknown module', async () => {
+    await expect(nsi.getLemmaStatistics('UnknownModule', 'H430')).rejects.toThrow();
+  });
+});
+
+describe('Verse reference mapping', () => {
+  let nsi;
+
+  // Psalms are numbered differently in the Synodal versification, so most of the references below are changed by the mapping.
+  // The verse 0 references and the references that are not OSIS references use the fallbacks of the mapping.
+  const sourceReferences = ['Gen.1.1', 'Ps.23.1', 'Ps.51.1', 'Ps.51.19', 'Mal.4.6', 'Rom.16.25', 'Ps.51.0', 'Gen.1.0',
+                            'Ps.51.1-Ps.51.3', 'Ps 51:1', 'Gen', 'NoBook.1.1', ''];
+
+  beforeAll(() => {
+    const homeDir = createTempHomeDir();
+    const swordDir = getSwordDir(homeDir);
+
+    writeModuleFiles(swordDir, createTestBibleModuleFiles('KjvV11n', 'OSIS', ['In the beginning'], ['The book']).files);
+    writeModuleFiles(swordDir, createTestBibleModuleFiles('SynodalV11n', 'OSIS', ['In the beginning'], ['The book'], 'Versification=Synodal\n').files);
+    nsi = new NodeSwordInterface(homeDir);
+  });
+
+  test('should map a list of references like the single references', () => {
+    expect(nsi.mapVerseReference('Ps.51.1', 'KjvV11n', 'SynodalV11n')).not.toBe('Ps.51.1');
+
+    for (const allowRange of [false, true]) {
+      for (const [sourceModule, targetModule] of [['KjvV11n', 'SynodalV11n'], ['SynodalV11n', 'KjvV11n']]) {
+        const expectedReferences = sourceReferences.map((reference) => {
+          return nsi.mapVerseReference(reference, sourceModule, targetModule, allowRange);
+        });
+
+        expect(nsi.mapVerseReferences(sourceReferences, sourceModule, targetModule, allowRange)).toEqual(expectedReferences);
+      }
+    }
+  });
+
+  test('should map the verses of a chapter like the single references', () => {
+    for (const allowRange of [false, true]) {
+      const chapterMapping = nsi.mapChapterVerseReferences('KjvV11n', 'SynodalV11n', 'Ps', 51, allowRange);
+      const sourceChapterReferences = Object.keys(chapterMapping);
+
+      expect(sourceChapterReferences.length).toBe(19);
+      expect(sourceChapterReferences[0]).toBe('Ps.51.1');
+
+      for (const reference of sourceChapterReferences) {
+        expect(chapterMapping[reference]).toBe(nsi.mapVerseReference(reference, 'KjvV11n', 'SynodalV11n', allowRange));
+      }
+    }
+  });
+
+  test('should keep the references if both modules use the same versification', () => {
+    expect(nsi.mapVerseReferences(sourceReferences, 'KjvV11n', 'KjvV11n')).toEqual(sourceReferences);
+  });
+});
+
+describe('Repository refresh', () => {
+  const repositoryName = 'Local';
+  let server;
+  let nsi;
+
+  beforeEach(async () => {
+    const testModule = createTestModuleFiles('TestMod', '1.0', 1000);
+
+    server = new LocalRepositoryServer();
+    server.setModules([{ name: 'TestMod', conf: testModule.conf }]);
+    await server.start();
+
+    const homeDir = createTempHomeDir();
+    server.writeInstallMgrConf(homeDir, repositoryName);
+    nsi = new NodeSwordInterface(homeDir);
+  });
+
+  afterEach(async () => {
+    await server.stop();
+  });
+
+  test('should retry a repository after transient failures', async () => {
+    server.failingIndexDownloads = 2;
+    nsi.setRepositoryRefreshOptions(1, 2);
+
+    const isSuccessful = await nsi.updateSingleRepositoryConfig(repositoryName);
+
+    expect(isSuccessful).toBe(true);
+    expect(server.getRequests('/raw/mods.d.tar.gz').length).toBe(3);
+    expect(nsi.getAllRepoModules(repositoryName).map((module) => module.name)).toEqual(['TestMod']);
+  }, 20000);
+
+  test('should give up on a repository once the retries are used up', async () => {
+    server.failingIndexDownloads = 10;
+    nsi.setRepositoryRefreshOptions(1, 1);
+
+    const isSuccessful = await nsi.updateSingleRepositoryConfig(repositoryName);
+
+    expect(isSuccessful).toBe(false);
+    expect(server.getRequests('/raw/mods.d.tar.gz').length).toBe(2);
+  }, 20000);
+
+  test('should abort a hanging transfer once the deadline of the repository is reached', async () => {
+    server.hangingIndexDownloads = true;
+    nsi.setRepositoryRefreshOptions(1, 5, 1500);
+
+    const startTime = Date.now();
+    const isSuccessful = await nsi.updateSingleRepositoryConfig(repositoryName);
+    const duration = Date.now() - startTime;
+
+    expect(isSuccessful).toBe(false);
+    expect(duration).toBeLessThan(5000);
+    expect(server.getRequests('/raw/mods.d.tar.gz').length).toBe(1);
+  }, 20000);
+
+  test('should only download the module index again after it has changed', async () => {
+    expect(await nsi.updateSingleRepositoryConfig(repositoryName)).toBe(true);
+    expect(server.getRequests('/raw/mods.d.tar.gz').length).toBe(1);
+
+    // The validators of the server still match, so only the HEAD request is sent
+    expect(await nsi.updateSingleRepositoryConfig(repositoryName)).toBe(true);
+    expect(server.getRequests('/raw/mods.d.tar.gz').length).toBe(1);
+    expect(server.getRequests('/raw/mods.d.tar.gz', 'HEAD').length).toBe(2);
+
+    const otherModule = createTestModuleFiles('OtherMod', '1.0', 1000);
+    const testModule = createTestModuleFiles('TestMod', '1.1', 1000);
+    server.setModules([{ name: 'OtherMod', conf: otherModule.conf }, { name: 'TestMod', conf: testModule.conf }]);
+
+    expect(await nsi.updateSingleRepositoryConfig(repositoryName)).toBe(true);
+    expect(server.getRequests('/raw/mods.d.tar.gz').length).toBe(2);
+    expect(nsi.getAllRepoModules(repositoryName).map((module) => module.name).sort()).toEqual(['OtherMod', 'TestMod']);
+    expect(nsi.getRepoModule(repositoryName, 'TestMod').version).toBe('1.1');
+  }, 20000);
+});
+
+describe('Repository catalog', () => {
+  const repositoryName = 'Local';
+  let server;
+  let nsi;
+
+  function createLanguageModule(moduleName, version, language) {
+    const module = createTestModuleFiles(moduleName, version, 100);
+    module.conf = module.conf.replace('Lang=en', `Lang=${language}`);
+    module.files[`mods.d/${moduleName.toLowerCase()}.conf`] = module.conf;
+    return module;
+  }
+
+  function setServerModules(modules) {
+    server.setModules(modules.map((module) => ({ name: module.conf.match(/^\[(.*)\]$/m)[1], conf: module.conf })));
+  }
+
+  // All queries of the catalog have to agree with the module list of the repository
+  function expectConsistentCatalog(expectedModuleNames) {
+    const modules = nsi.getAllRepoModules(repositoryName);
+    expect(modules.map((module) => module.name).sort()).toEqual(expectedModuleNames.slice().sort());
+
+    for (const module of modules) {
+      expect(nsi.isModuleAvailableInRepo(module.name, repositoryName)).toBe(true);
+      expect(nsi.isModuleAvailableInRepo(module.name)).toBe(true);
+      expect(nsi.getRepoModule(repositoryName, module.name)).toEqual(module);
+      expect(nsi.getRepoModule('all', module.name)).toEqual(module);
+    }
+
+    const expectedLanguages = [...new Set(modules.map((module) => module.language))].sort();
+    expect(nsi.getRepoLanguages(repositoryName).slice().sort()).toEqual(expectedLanguages);
+  }
+
+  beforeEach(async () => {
+    server = new LocalRepositoryServer();
+    await server.start();
+
+    const homeDir = createTempHomeDir();
+    server.writeInstallMgrConf(homeDir, repositoryName);
+    nsi = new NodeSwordInterface(homeDir);
+  });
+
+  afterEach(async () => {
+    await server.stop();
+  });
+
+  test('should return consistent results after every refresh', async () => {
+    setServerModules([createLanguageModule('TestMod', '1.0', 'en'), createLanguageModule('GermanMod', '1.0', 'de')]);
+    expect(await nsi.updateSingleRepositoryConfig(repositoryName)).toBe(true);
+
+    expectConsistentCatalog(['GermanMod', 'TestMod']);
+    expect(nsi.getRepoModule(repositoryName, 'TestMod').version).toBe('1.0');
+    expect(nsi.getRepoLanguages(repositoryName).sort()).toEqual(['de', 'en']);
+
+    // Removed modules and languages must disappear from all queries, updated modules must be replaced
+    setServerModules([createLanguageModule('TestMod', '1.1', 'en'), createLanguageModule('FrenchMod', '1.0', 'fr')]);
+    expect(await nsi.updateSingleRepositoryConfig(repositoryName)).toBe(true);
+
+    expectConsistentCatalog(['FrenchMod', 'TestMod']);
+    expect(nsi.getRepoModule(repositoryName, 'TestMod').version).toBe('1.1');
+    expect(nsi.getRepoLanguages(repositoryName).sort()).toEqual(['en', 'fr']);
+    expect(nsi.isModuleAvailableInRepo('GermanMod')).toBe(false);
+    expect(nsi.isModuleAvailableInRepo('GermanMod', repositoryName)).toBe(false);
+    expect(() => nsi.getRepoModule(repositoryName, 'GermanMod')).toThrow();
+    expect(() => nsi.getRepoModule('all', 'GermanMod')).toThrow();
+  }, 20000);
+
+  test('should return consistent results after the catalog has been invalidated by an installation', async () => {
+    const testModule = createLanguageModule('TestMod', '1.0', 'en');
+    setServerModules([testModule, createLanguageModule('GermanMod', '1.0', 'de')]);
+    server.setPackage('TestMod', testModule.files);
+    expect(await nsi.updateSingleRepositoryConfig(repositoryName)).toBe(true);
+    expectConsistentCatalog(['GermanMod', 'TestMod']);
+
+    await nsi.installModule(repositoryName, 'TestMod');
+    expect(nsi.getLocalModule('TestMod')).toBeDefined();
+    expectConsistentCatalog(['GermanMod', 'TestMod']);
+
+    await nsi.uninstallModule('TestMod');
+    expectConsistentCatalog(['GermanMod', 'TestMod']);
+  }, 20000);
+
+  test('should not report the modules of a repository that does not exist', async () => {
+    setServerModules([createLanguageModule('TestMod', '1.0', 'en')]);
+    expect(await nsi.updateSingleRepositoryConfig(repositoryName)).toBe(true);
+
+    expect(nsi.isModuleAvailableInRepo('TestMod', 'Unknown')).toBe(false);
+    expect(() => nsi.getRepoModule('Unknown', 'TestMod')).toThrow();
+    expect(nsi.getRepoLanguages('Unknown')).toEqual([]);
+  }, 20000);
+});
+
+describe('Resumable module downloads', () => {
+  const repositoryName = 'Local';
+  const packageUrl = '/packages/rawzip/TestMod.zip';
+  const interruptedBytes = 300000;
+  let server;
+  let nsi;
+  let testModule;
+  let swordDir;
+
+  beforeEach(async () => {
+    testModule = createTestModuleFiles('TestMod', '1.0', 1000000);
+
+    server = new LocalRepositoryServer();
+    server.setModules([{ name: 'TestMod', conf: testModule.conf }]);
+    server.setPackage('TestMod', testModule.files);
+    await server.start();
+
+    const homeDir = createTempHomeDir();
+    server.writeInstallMgrConf(homeDir, repositoryName);
+    swordDir = getSwordDir(homeDir);
+    nsi = new NodeSwordInterface(homeDir);
+
+    expect(await nsi.updateSingleRepositoryConfig(repositoryName)).toBe(true);
+
+    // The first download is interrupted after a part of the package has been delivered
+    server.dropPackageAfterBytes = interruptedBytes;
+    await expect(nsi.installModule(repositoryName, 'TestMod')).rejects.toBe(-1);
+    expect(nsi.getLocalModule('TestMod')).toBeUndefined();
+  }, 20000);
+
+  afterEach(async () => {
+    await server.stop();
+  });
+
+  test('should resume an interrupted download with a range request', async () => {
+    await nsi.installModule(repositoryName, 'TestMod');
+
+    const packageRequests = server.getRequests(packageUrl);
+    expect(packageRequests.length).toBe(2);
+    expect(packageRequests[1].range).toBe(`bytes=${interruptedBytes}-`);
+    expect(packageRequests[1].status).toBe(206);
+    expect(nsi.getLocalModule('TestMod')).toBeDefined();
+  }, 20000);
+
+  test('should restart the download if the package has changed in the meantime', async () => {
+    server.setPackage('TestMod', testModule.files, '"changed"');
+
+    await nsi.installModule(repositoryName, 'TestMod');
+
+    const packageRequests = server.getRequests(packageUrl);
+    expect(packageRequests[1].range).toBe(`bytes=${interruptedBytes}-`);
+    expect(packageRequests[1].status).toBe(200);
+    expect(packageRequests[packageRequests.length - 1].range).toBeUndefined();
+    expect(packageRequests[packageRequests.length - 1].status).toBe(200);
+    expect(nsi.getLocalModule('TestMod')).toBeDefined();
+  }, 20000);
+
+  test('should restart the download if the server cannot deliver the range', async () => {
+    server.forcedRangeStatus = 416;
+
+    await nsi.installModule(repositoryName, 'TestMod');
+
+    const packageRequests = server.getRequests(packageUrl);
+    expect(packageRequests.length).toBe(3);
+    expect(packageRequests[1].status).toBe(416);
+    expect(packageRequests[2].range).toBeUndefined();
+    expect(packageRequests[2].status).toBe(200);
+    expect(nsi.getLocalModule('TestMod')).toBeDefined();
+  }, 20000);
+
+  test('should hand the interrupted download over to the next installation', async () => {
+    const installationDirs = () => fs.readdirSync(swordDir).filter((name) => name.startsWith('.install-') || name.startsWith('.download-'));
+
+    // Only the interrupted download is left at its shared location, the directories of the installation are gone
+    expect(installationDirs()).toEqual(['.download-TestMod']);
+
+    await nsi.installModule(repositoryName, 'TestMod');
+
+    expect(server.getRequests(packageUrl)[1].status).toBe(206);
+    expect(installationDirs()).toEqual([]);
+  }, 20000);
+});
+
+describe('Module package installation', () => {
+  const repositoryName = 'Local';
+  let server;
+  let nsi;
+  let swordDir;
+
+  beforeEach(async () => {
+    server = new LocalRepositoryServer();
+    await server.start();
+
+    const homeDir = createTempHomeDir();
+    server.writeInstallMgrConf(homeDir, repositoryName);
+    swordDir = getSwordDir(homeDir);
+    nsi = new NodeSwordInterface(homeDir);
+  });
+
+  afterEach(async () => {
+    await server.stop();
+  });
+
+  test('should remove the files of the previous version when updating a module', async () => {
+    const oldModule = createTestModuleFiles('TestMod', '1.0', 1000);
+    const obsoleteFile = 'modules/texts/rawtext/testmod/obsolete';
+    oldModule.files[obsoleteFile] = 'Only part of version 1.0';
+
+    server.setModules([{ name: 'TestMod', conf: oldModule.conf }]);
+    server.setPackage('TestMod', oldModule.files);
+    expect(await nsi.updateSingleRepositoryConfig(repositoryName)).toBe(true);
+    await nsi.installModule(repositoryName, 'TestMod');
+    expect(fs.existsSync(path.join(swordDir, obsoleteFile))).toBe(true);
+
+    const newModule = createTestModuleFiles('TestMod', '1.1', 2000);
+    server.setModules([{ name: 'TestMod', conf: newModule.conf }]);
+    server.setPackage('TestMod', newModule.files);
+    expect(await nsi.updateSingleRepositoryConfig(repositoryName)).toBe(true);
+    await nsi.installModule(repositoryName, 'TestMod');
+
+    expect(fs.existsSync(path.join(swordDir, obsoleteFile))).toBe(false);
+    expect(fs.statSync(path.join(swordDir, 'modules/texts/rawtext/testmod/nt')).size).toBe(2000);
+    expect(fs.readFileSync(path.join(swordDir, 'mods.d/testmod.conf'), 'utf8')).toContain('Version=1.1');
+  }, 20000);
+});
+
+describe('Archive extraction', () => {
+  let nsi;
+  let tempDir;
+
+  beforeEach(() => {
+    tempDir = createTempHomeDir();
+    nsi = new NodeSwordInterface(tempDir);
+  });
+
+  test('should extract all entries of a zip file', async () => {
+    const zipPath = path.join(tempDir, 'module.zip');
+    const destPath = path.join(tempDir, 'extracted');
+    fs.writeFileSync(zipPath, createZip({ 'mods.d/test.conf': '[Test]\n', 'modules/texts/test/nt': 'data' }));
+
+    expect(await nsi.unZipAsync(zipPath, destPath)).toBe(true);
+    expect(fs.readFileSync(path.join(destPath, 'modules/texts/test/nt'), 'utf8')).toBe('data');
+  });
+
+  test('should reject zip entries outside of the destination path', async () => {
+    const zipPath = path.join(tempDir, 'unsafe.zip');
+    const destPath = path.join(tempDir, 'extracted');
+    fs.writeFileSync(zipPath, createZip({ 'mods.d/test.conf': '[Test]\n', '../outside': 'data' }));
+
+    expect(await nsi.unZipAsync(zipPath, destPath)).toBe(false);
+    expect(nsi.unZip(zipPath, destPath)).toBe(false);
+    expect(fs.existsSync(path.join(tempDir, 'outside'))).toBe(false);
+  });
+});
+
+describe('Module configuration snapshot', () => {
+  let homeDir;
+  let swordDir;
+
+  function writeModule(description) {
+    const module = createTestModuleFiles('TestMod', '1.0', 100);
+    module.files['mods.d/testmod.conf'] = module.conf.replace('TestMod test module', description);
+
+    for (const [fileName, content] of Object.entries(module.files)) {
+      fs.mkdirSync(path.dirname(path.join(swordDir, fileName)), { recursive: true });
+      fs.writeFileSync(path.join(swordDir, fileName), content);
+    }
+
+    // Same timestamp for every version of the configuration, like on a file system with coarse timestamps
+    const modificationTime = new Date('2024-01-01T00:00:00Z');
+    fs.utimesSync(path.join(swordDir, 'mods.d/testmod.conf'), modificationTime, modificationTime);
+  }
+
+  beforeEach(() => {
+    homeDir = createTempHomeDir();
+    swordDir = getSwordDir(homeDir);
+  });
+
+  test('should reload a configuration that changed without changing its size or modification time', () => {
+    writeModule('Version A');
+    const nsi = new NodeSwordInterface(homeDir);
+    expect(nsi.getLocalModule('TestMod').description).toBe('Version A');
+
+    writeModule('Version B');
+    nsi.refreshLocalModules();
+    expect(nsi.getLocalModule('TestMod').description).toBe('Version B');
+  });
+
+  test('should ignore a snapshot written with another byte order', () => {
+    writeModule('Version A');
+
+    // A valid empty snapshot, except for the byte order marker, which has been written in the foreign byte order
+    const nativeLittleEndian = (os.endianness() == 'LE');
+    const header = Buffer.alloc(28);
+    header.write('NSCS', 0);
+
+    if (nativeLittleEndian) {
+      header.writeUInt32LE(2, 4);
+      header.writeUInt32BE(0x01020304, 8);
+      header.writeBigUInt64LE(28n, 20);
+    } else {
+      header.writeUInt32BE(2, 4);
+      header.writeUInt32LE(0x01020304, 8);
+      header.writeBigUInt64BE(28n, 20);
+    }
+
+    const snapshotPath = path.join(swordDir, '.mods.d.snapshot');
+    fs.writeFileSync(snapshotPath, header);
+
+    const nsi = new NodeSwordInterface(homeDir);
+    expect(nsi.getLocalModule('TestMod').description).toBe('Version A');
+
+    // The snapshot has been replaced with one in the native byte order
+    const snapshot = fs.readFileSync(snapshotPath);
+    const byteOrderMarker = nativeLittleEndian ? snapshot.readUInt32LE(8) : snapshot.readUInt32BE(8);
+    expect(byteOrderMarker).toBe(0x01020304);
+  });
 });